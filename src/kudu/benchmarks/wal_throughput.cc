@@ -0,0 +1,186 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Measures the throughput and latency of appends to the WAL with fsync
+// enabled, for a range of batch sizes, with and without pipelining the
+// group commit fsync (see --log_pipelined_sync).
+//
+// Like wal_hiccup, it writes to --file_path (or the cwd), so point it at the
+// device of interest.
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/common/schema.h"
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/log.h"
+#include "kudu/consensus/opid_util.h"
+#include "kudu/consensus/ref_counted_replicate.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/async_util.h"
+#include "kudu/util/env.h"
+#include "kudu/util/hdr_histogram.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/path_util.h"
+#include "kudu/util/status.h"
+#include "kudu/util/thread.h"
+
+DEFINE_string(batch_sizes, "128,1024,8192,65536",
+              "comma-separated list of payload sizes, in bytes, of the appended batches");
+DEFINE_int32(num_writers, 16, "number of threads appending to the WAL concurrently");
+DEFINE_int32(seconds_per_setup, 10, "number of seconds to run each setup for");
+DEFINE_string(file_path, "", "path where the WAL is written; defaults to cwd");
+
+DECLARE_bool(log_force_fsync_all);
+DECLARE_bool(log_pipelined_sync);
+
+using kudu::consensus::ReplicateRefPtr;
+using kudu::consensus::make_scoped_refptr_replicate;
+using kudu::log::Log;
+using kudu::log::LogOptions;
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+class WalThroughputBenchmarker {
+ public:
+  WalThroughputBenchmarker()
+    : payload_size_(0),
+      next_index_(1) {
+  }
+
+  void Run();
+
+ private:
+  // Runs a single setup, returning the number of batches appended per second.
+  double RunOnce(const string& name, HdrHistogram* histo);
+
+  void WriterThread(MonoTime deadline, HdrHistogram* histo);
+
+  int payload_size_;
+
+  // Protects 'next_index_' and keeps appends in index order.
+  simple_spinlock lock_;
+  int64_t next_index_;
+  scoped_refptr<Log> log_;
+};
+
+void WalThroughputBenchmarker::WriterThread(MonoTime deadline, HdrHistogram* histo) {
+  const string payload(payload_size_, 'x');
+  while (MonoTime::Now() < deadline) {
+    ReplicateRefPtr replicate = make_scoped_refptr_replicate(new consensus::ReplicateMsg());
+    replicate->get()->set_op_type(consensus::NO_OP);
+    replicate->get()->mutable_noop_request()->set_payload_for_tests(payload);
+
+    MonoTime start = MonoTime::Now();
+    Synchronizer s;
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      replicate->get()->mutable_id()->CopyFrom(consensus::MakeOpId(1, next_index_));
+      replicate->get()->set_timestamp(next_index_);
+      next_index_++;
+      CHECK_OK(log_->AsyncAppendReplicates({ replicate }, s.AsStatusCallback()));
+    }
+    CHECK_OK(s.Wait());
+    histo->Increment((MonoTime::Now() - start).ToMicroseconds());
+  }
+}
+
+double WalThroughputBenchmarker::RunOnce(const string& name, HdrHistogram* histo) {
+  string root = name;
+  if (!FLAGS_file_path.empty()) {
+    root = JoinPathSegments(FLAGS_file_path, root);
+  }
+  Env* env = Env::Default();
+  if (env->FileExists(root)) {
+    CHECK_OK(env->DeleteRecursively(root));
+  }
+  FsManager fs_manager(env, root);
+  CHECK_OK(fs_manager.CreateInitialFileSystemLayout());
+  CHECK_OK(fs_manager.Open());
+
+  Schema schema({ ColumnSchema("key", INT32) }, 1);
+  CHECK_OK(Log::Open(LogOptions(), &fs_manager, "wal-bench", SchemaBuilder(schema).Build(),
+                     0, nullptr, &log_));
+
+  const MonoTime start = MonoTime::Now();
+  const MonoTime deadline = start + MonoDelta::FromSeconds(FLAGS_seconds_per_setup);
+  vector<scoped_refptr<Thread>> threads;
+  for (int i = 0; i < FLAGS_num_writers; i++) {
+    scoped_refptr<Thread> thr;
+    CHECK_OK(Thread::Create("test", "writer", &WalThroughputBenchmarker::WriterThread,
+                            this, deadline, histo, &thr));
+    threads.push_back(thr);
+  }
+  for (const auto& thr : threads) {
+    thr->Join();
+  }
+  const double elapsed = (MonoTime::Now() - start).ToSeconds();
+  CHECK_OK(log_->Close());
+  log_.reset();
+  CHECK_OK(env->DeleteRecursively(root));
+  return histo->TotalCount() / elapsed;
+}
+
+void WalThroughputBenchmarker::Run() {
+  vector<string> sizes = strings::Split(FLAGS_batch_sizes, ",", strings::SkipEmpty());
+  for (const string& size : sizes) {
+    CHECK(safe_strto32(size, &payload_size_)) << "invalid batch size: " << size;
+    for (bool pipelined : { false, true }) {
+      FLAGS_log_pipelined_sync = pipelined;
+      HdrHistogram histo(60 * 1000 * 1000, 4);
+      double batches_per_sec = RunOnce(Substitute("wal-bench-$0", payload_size_), &histo);
+
+      LOG(INFO) << "----------------------------------------------------------------------";
+      LOG(INFO) << "Test results for batch size " << payload_size_
+                << (pipelined ? " with" : " without") << " pipelined sync:";
+      LOG(INFO) << "batches/sec: " << batches_per_sec;
+      LOG(INFO) << "MB/sec: " << batches_per_sec * payload_size_ / (1024 * 1024);
+      LOG(INFO) << "p50: " << histo.ValueAtPercentile(50.0) << "us";
+      LOG(INFO) << "p99: " << histo.ValueAtPercentile(99.0) << "us";
+      LOG(INFO) << "p99.9: " << histo.ValueAtPercentile(99.9) << "us";
+      LOG(INFO) << "max: " << histo.MaxValue() << "us";
+      LOG(INFO) << "----------------------------------------------------------------------";
+    }
+  }
+}
+
+} // namespace kudu
+
+int main(int argc, char* argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  kudu::InitGoogleLoggingSafe(argv[0]);
+  FLAGS_log_force_fsync_all = true;
+
+  kudu::WalThroughputBenchmarker benchmarker;
+  benchmarker.Run();
+
+  return 0;
+}
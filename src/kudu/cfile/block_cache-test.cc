@@ -21,6 +21,7 @@
 #include <memory>
 #include <ostream>
 
+#include <gflags/gflags.h>
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
@@ -29,6 +30,7 @@
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/slice.h"
 
+DECLARE_double(block_cache_compressed_ratio);
 DECLARE_double(cache_memtracker_approximation_ratio);
 
 namespace kudu {
@@ -85,6 +87,47 @@ TEST(TestBlockCache, TestBasics) {
   ASSERT_FALSE(cache.Lookup(key1, Cache::EXPECT_IN_CACHE, &retrieved_handle));
 }
 
+TEST(TestBlockCache, TestCompressedTier) {
+  google::FlagSaver saver;
+  FLAGS_block_cache_compressed_ratio = 0.5;
+  const size_t kCapacity = 16 * 1024 * 1024;
+  BlockCache cache(kCapacity);
+  ASSERT_TRUE(cache.has_compressed_tier());
+  ASSERT_EQ(kCapacity / 2, cache.compressed_capacity());
+
+  size_t data_size = strlen(DATA_TO_CACHE) + 1;
+  BlockCache::CacheKey key(BlockCache::FileId(1234), 1);
+  BlockCache::PendingEntry data = cache.AllocateCompressed(key, data_size);
+  memcpy(data.val_ptr(), DATA_TO_CACHE, data_size);
+  BlockCacheHandle inserted_handle;
+  cache.Insert(&data, &inserted_handle);
+
+  // The block is only in the compressed tier.
+  BlockCacheHandle handle;
+  ASSERT_FALSE(cache.Lookup(key, Cache::EXPECT_IN_CACHE, &handle));
+  ASSERT_TRUE(cache.LookupCompressed(key, Cache::EXPECT_IN_CACHE, &handle));
+  ASSERT_EQ(0, memcmp(handle.data().data(), DATA_TO_CACHE, data_size));
+  handle.Release();
+
+  // Hitting only the compressed tier moves capacity to it.
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_TRUE(cache.LookupCompressed(key, Cache::EXPECT_IN_CACHE, &handle));
+    handle.Release();
+  }
+  ASSERT_GT(cache.compressed_capacity(), kCapacity / 2);
+}
+
+TEST(TestBlockCache, TestCompressedRatioValidation) {
+  google::FlagSaver saver;
+  ASSERT_FALSE(google::SetCommandLineOption("block_cache_compressed_ratio", "0").empty());
+  ASSERT_FALSE(google::SetCommandLineOption("block_cache_compressed_ratio", "0.05").empty());
+  ASSERT_FALSE(google::SetCommandLineOption("block_cache_compressed_ratio", "0.95").empty());
+  // Each tier must keep at least 5% of the capacity.
+  ASSERT_TRUE(google::SetCommandLineOption("block_cache_compressed_ratio", "0.01").empty());
+  ASSERT_TRUE(google::SetCommandLineOption("block_cache_compressed_ratio", "0.99").empty());
+  ASSERT_TRUE(google::SetCommandLineOption("block_cache_compressed_ratio", "-0.5").empty());
+}
+
 
 } // namespace cfile
 } // namespace kudu
@@ -17,10 +17,13 @@
 
 #include "kudu/cfile/block_cache.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -31,6 +34,8 @@
 #include "kudu/util/cache.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/process_memory.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/string_case.h"
@@ -49,11 +54,64 @@ TAG_FLAG(force_block_cache_capacity, hidden);
 
 DEFINE_string(block_cache_type, "DRAM",
               "Which type of block cache to use for caching data. "
-              "Valid choices are 'DRAM' or 'NVM'. DRAM, the default, "
+              "Valid choices are 'DRAM', 'NVM' or 'SSD'. DRAM, the default, "
               "caches data in regular memory. 'NVM' caches data "
-              "in a memory-mapped file using the NVML library.");
+              "in a memory-mapped file using the NVML library. 'SSD' caches "
+              "data in regular memory, and demotes the blocks evicted from "
+              "memory to a file on local storage (see --ssd_cache_path).");
 TAG_FLAG(block_cache_type, experimental);
 
+DEFINE_string(block_cache_eviction_policy, "LRU",
+              "Which eviction policy the block cache uses. Valid choices are 'LRU', "
+              "'SLRU' or 'CLOCK'. 'SLRU' (segmented LRU) protects blocks which were "
+              "read more than once from being evicted by large scans which read many "
+              "blocks only once. 'CLOCK' approximates LRU, but lets concurrent cache "
+              "hits proceed without contending on a lock. Not supported with the "
+              "NVM block cache type.");
+TAG_FLAG(block_cache_eviction_policy, experimental);
+
+DEFINE_double(block_cache_compressed_ratio, 0,
+              "The fraction of the block cache capacity initially given to a tier "
+              "caching the blocks of compressed CFiles as they are on disk. Such blocks "
+              "are cached compressed when first read, and are decompressed into the rest "
+              "of the block cache once hit in the compressed tier. 0 disables the "
+              "compressed tier, otherwise it must be between 0.05 and 0.95. Not "
+              "supported with the NVM block cache type.");
+TAG_FLAG(block_cache_compressed_ratio, experimental);
+
+DEFINE_bool(block_cache_compressed_adaptive, true,
+            "Whether to adjust the split of the block cache capacity between its "
+            "compressed and decompressed tiers based on their hit rates.");
+TAG_FLAG(block_cache_compressed_adaptive, experimental);
+
+DEFINE_bool(block_cache_warmup, false,
+            "Whether to track the blocks hit in the block cache, periodically save "
+            "their keys to the metadata directory, and read them back into the block "
+            "cache in the background after a restart.");
+TAG_FLAG(block_cache_warmup, experimental);
+
+DEFINE_int32(block_cache_warmup_max_keys, 65536,
+             "The maximum number of keys of recently hit blocks tracked by the block "
+             "cache for --block_cache_warmup. Each takes 16 bytes of memory.");
+TAG_FLAG(block_cache_warmup_max_keys, experimental);
+
+METRIC_DEFINE_counter(server, block_cache_compressed_hits,
+                      "Block Cache Compressed Tier Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that found a block in the compressed tier of "
+                      "the block cache");
+METRIC_DEFINE_gauge_uint64(server, block_cache_compressed_capacity,
+                           "Block Cache Compressed Tier Capacity", kudu::MetricUnit::kBytes,
+                           "Current capacity of the compressed tier of the block cache");
+METRIC_DEFINE_counter(server, block_cache_warmup_lookups,
+                      "Block Cache Lookups During Warm-up", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of blocks which were expected to be in the "
+                      "block cache, made while the block cache was being warmed up after "
+                      "a restart. Lookups made to warm up the cache are not counted.");
+METRIC_DEFINE_counter(server, block_cache_warmup_hits,
+                      "Block Cache Hits During Warm-up", kudu::MetricUnit::kBlocks,
+                      "Number of lookups counted in block_cache_warmup_lookups which "
+                      "found the block in the block cache");
+
 using strings::Substitute;
 
 template <class T> class scoped_refptr;
@@ -66,9 +124,48 @@ namespace cfile {
 
 namespace {
 
+// The number of lookups between adjustments of the split of the capacity
+// between the compressed and decompressed tiers.
+const int64_t kSplitAdjustmentInterval = 100000;
+// The fraction of the capacity moved from one tier to the other by an
+// adjustment.
+const double kSplitAdjustmentStep = 0.05;
+// The fraction of the capacity each tier keeps, whatever its hit rate.
+const double kMinTierRatio = 0.05;
+
+// The number of words in a slot of the hot keys table.
+const int kHotKeySlotWords = 4;
+
+// The hash stored along with a hot key, to detect torn slots.
+uint64_t HotKeyCheck(uint64_t file_id, uint64_t offset, uint64_t size) {
+  const uint64_t words[] = { file_id, offset, size };
+  return HashUtil::MurmurHash2_64(words, sizeof(words), /*seed=*/1);
+}
+
+// Whether the current thread is warming up the cache.
+__thread bool tls_is_warmup_thread = false;
+
 Cache* CreateCache(int64_t capacity) {
   CacheType t = BlockCache::GetConfiguredCacheTypeOrDie();
-  return NewLRUCache(t, capacity, "block_cache");
+  CacheEvictionPolicy policy = BlockCache::GetConfiguredEvictionPolicyOrDie();
+  return NewCache(t, policy, capacity, "block_cache");
+}
+
+Cache* CreateCompressedCache(int64_t capacity) {
+  CHECK_NE(NVM_CACHE, BlockCache::GetConfiguredCacheTypeOrDie())
+      << "The compressed block cache tier is not supported with the NVM block cache";
+  CacheEvictionPolicy policy = BlockCache::GetConfiguredEvictionPolicyOrDie();
+  return NewCache(DRAM_CACHE, policy, capacity, "block_cache_compressed");
+}
+
+// Each tier keeps at least kMinTierRatio of the capacity, from the start.
+bool ValidateCompressedRatio(const char* flagname, double value) {
+  if (value != 0 && (value < kMinTierRatio || value > 1 - kMinTierRatio)) {
+    LOG(ERROR) << Substitute("$0 must be 0 or in [$1, $2]: $3",
+                             flagname, kMinTierRatio, 1 - kMinTierRatio, value);
+    return false;
+  }
+  return true;
 }
 
 // Validates the block cache capacity won't permit the cache to grow large enough
@@ -102,6 +199,7 @@ bool ValidateBlockCacheCapacity() {
 } // anonymous namespace
 
 GROUP_FLAG_VALIDATOR(block_cache_capacity_mb, ValidateBlockCacheCapacity);
+DEFINE_validator(block_cache_compressed_ratio, &ValidateCompressedRatio);
 
 CacheType BlockCache::GetConfiguredCacheTypeOrDie() {
     ToUpperCase(FLAGS_block_cache_type, &FLAGS_block_cache_type);
@@ -111,9 +209,29 @@ CacheType BlockCache::GetConfiguredCacheTypeOrDie() {
   if (FLAGS_block_cache_type == "DRAM") {
     return DRAM_CACHE;
   }
+  if (FLAGS_block_cache_type == "SSD") {
+    return SSD_CACHE;
+  }
 
   LOG(FATAL) << "Unknown block cache type: '" << FLAGS_block_cache_type
-             << "' (expected 'DRAM' or 'NVM')";
+             << "' (expected 'DRAM', 'NVM' or 'SSD')";
+  __builtin_unreachable();
+}
+
+CacheEvictionPolicy BlockCache::GetConfiguredEvictionPolicyOrDie() {
+  ToUpperCase(FLAGS_block_cache_eviction_policy, &FLAGS_block_cache_eviction_policy);
+  if (FLAGS_block_cache_eviction_policy == "LRU") {
+    return LRU_EVICTION;
+  }
+  if (FLAGS_block_cache_eviction_policy == "SLRU") {
+    return SLRU_EVICTION;
+  }
+  if (FLAGS_block_cache_eviction_policy == "CLOCK") {
+    return CLOCK_EVICTION;
+  }
+
+  LOG(FATAL) << "Unknown block cache eviction policy: '"
+             << FLAGS_block_cache_eviction_policy << "' (expected 'LRU', 'SLRU' or 'CLOCK')";
   __builtin_unreachable();
 }
 
@@ -122,7 +240,21 @@ BlockCache::BlockCache()
 }
 
 BlockCache::BlockCache(size_t capacity)
-  : cache_(CreateCache(capacity)) {
+  : capacity_(capacity),
+    compressed_capacity_(capacity * FLAGS_block_cache_compressed_ratio),
+    lookups_(0),
+    hits_(0),
+    compressed_hits_(0),
+    num_hot_key_slots_(FLAGS_block_cache_warmup ? FLAGS_block_cache_warmup_max_keys : 0),
+    hot_keys_(new std::atomic<uint64_t>[num_hot_key_slots_ * kHotKeySlotWords]()),
+    warming_up_(false) {
+  cache_.reset(CreateCache(capacity - compressed_capacity_));
+  if (compressed_capacity_ > 0) {
+    compressed_cache_.reset(CreateCompressedCache(compressed_capacity_));
+  }
+}
+
+BlockCache::~BlockCache() {
 }
 
 BlockCache::PendingEntry BlockCache::Allocate(const CacheKey& key, size_t block_size) {
@@ -137,17 +269,167 @@ bool BlockCache::Lookup(const CacheKey& key, Cache::CacheBehavior behavior,
   if (h != nullptr) {
     handle->SetHandle(cache_.get(), h);
   }
+  if (compressed_cache_) {
+    RecordLookup(/*compressed_tier=*/false, h != nullptr);
+  }
+  if (behavior == Cache::EXPECT_IN_CACHE) {
+    RecordWarmupLookup(h != nullptr);
+  }
   return h != nullptr;
 }
 
 void BlockCache::Insert(BlockCache::PendingEntry* entry, BlockCacheHandle* inserted) {
-  Cache::Handle *h = cache_->Insert(entry->handle_, /* eviction_callback= */ nullptr);
+  Cache::Handle *h = entry->cache_->Insert(entry->handle_, /* eviction_callback= */ nullptr);
   entry->handle_ = nullptr;
-  inserted->SetHandle(cache_.get(), h);
+  inserted->SetHandle(entry->cache_, h);
+}
+
+bool BlockCache::LookupCompressed(const CacheKey& key, Cache::CacheBehavior behavior,
+                                  BlockCacheHandle* handle) {
+  DCHECK(compressed_cache_);
+  Cache::Handle *h = compressed_cache_->Lookup(
+      Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)), behavior);
+  if (h != nullptr) {
+    handle->SetHandle(compressed_cache_.get(), h);
+    if (compressed_hits_metric_) {
+      compressed_hits_metric_->Increment();
+    }
+    // The lookup was counted when it missed in the decompressed tier.
+    if (behavior == Cache::EXPECT_IN_CACHE && warming_up_ && !tls_is_warmup_thread &&
+        warmup_hits_metric_) {
+      warmup_hits_metric_->Increment();
+    }
+  }
+  RecordLookup(/*compressed_tier=*/true, h != nullptr);
+  return h != nullptr;
+}
+
+void BlockCache::EraseCompressed(const CacheKey& key) {
+  DCHECK(compressed_cache_);
+  compressed_cache_->Erase(Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)));
+}
+
+BlockCache::PendingEntry BlockCache::AllocateCompressed(const CacheKey& key,
+                                                        size_t block_size) {
+  DCHECK(compressed_cache_);
+  Slice key_slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key));
+  return PendingEntry(compressed_cache_.get(),
+                      compressed_cache_->Allocate(key_slice, block_size));
+}
+
+void BlockCache::RecordLookup(bool compressed_tier, bool hit) {
+  if (hit) {
+    (compressed_tier ? compressed_hits_ : hits_).fetch_add(1, std::memory_order_relaxed);
+  }
+  if (lookups_.fetch_add(1, std::memory_order_relaxed) % kSplitAdjustmentInterval ==
+      kSplitAdjustmentInterval - 1) {
+    AdjustSplit();
+  }
+}
+
+void BlockCache::AdjustSplit() {
+  if (!FLAGS_block_cache_compressed_adaptive) {
+    return;
+  }
+  std::unique_lock<simple_spinlock> l(split_lock_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    return;
+  }
+  const int64_t hits = hits_.exchange(0);
+  const int64_t compressed_hits = compressed_hits_.exchange(0);
+  const size_t compressed_capacity = compressed_capacity_;
+  const double hits_per_byte = static_cast<double>(hits) / (capacity_ - compressed_capacity);
+  const double compressed_hits_per_byte = static_cast<double>(compressed_hits) /
+      compressed_capacity;
+
+  const size_t step = capacity_ * kSplitAdjustmentStep;
+  const size_t min_capacity = capacity_ * kMinTierRatio;
+  // Only move capacity if one tier is clearly making better use of its memory.
+  size_t new_compressed_capacity = compressed_capacity;
+  if (compressed_hits_per_byte > hits_per_byte * 1.1) {
+    new_compressed_capacity = std::min(compressed_capacity + step, capacity_ - min_capacity);
+  } else if (hits_per_byte > compressed_hits_per_byte * 1.1) {
+    new_compressed_capacity = std::max(compressed_capacity, min_capacity + step) - step;
+  }
+  if (new_compressed_capacity == compressed_capacity) {
+    return;
+  }
+  VLOG(1) << Substitute("Changing the capacity of the compressed block cache tier "
+                        "from $0 to $1 bytes", compressed_capacity, new_compressed_capacity);
+  compressed_capacity_ = new_compressed_capacity;
+  cache_->SetCapacity(capacity_ - new_compressed_capacity);
+  compressed_cache_->SetCapacity(new_compressed_capacity);
+  if (compressed_capacity_metric_) {
+    compressed_capacity_metric_->set_value(new_compressed_capacity);
+  }
+}
+
+void BlockCache::RecordHotKey(const CacheKey& key, uint32_t size) {
+  if (num_hot_key_slots_ == 0) {
+    return;
+  }
+  const uint64_t check = HotKeyCheck(key.file_id_, key.offset_, size);
+  size_t slot = HashUtil::MurmurHash2_64(&key, sizeof(key), 0) % num_hot_key_slots_;
+  std::atomic<uint64_t>* words = &hot_keys_[slot * kHotKeySlotWords];
+  // Only write to the slot if it holds another block, so that repeated hits on
+  // the same block don't bounce the slot's cache line between CPUs. Concurrent
+  // hits may tear the words, but then they don't match their hash anymore.
+  if (words[3].load(std::memory_order_relaxed) != check) {
+    words[0].store(key.file_id_, std::memory_order_relaxed);
+    words[1].store(key.offset_, std::memory_order_relaxed);
+    words[2].store(size, std::memory_order_relaxed);
+    words[3].store(check, std::memory_order_relaxed);
+  }
+}
+
+void BlockCache::RecordWarmupLookup(bool hit) {
+  if (PREDICT_TRUE(!warming_up_.load(std::memory_order_relaxed)) ||
+      tls_is_warmup_thread || !warmup_lookups_metric_) {
+    return;
+  }
+  warmup_lookups_metric_->Increment();
+  if (hit) {
+    warmup_hits_metric_->Increment();
+  }
+}
+
+void BlockCache::GetHotKeys(std::vector<HotKey>* keys) const {
+  keys->clear();
+  for (size_t slot = 0; slot < num_hot_key_slots_; slot++) {
+    const std::atomic<uint64_t>* words = &hot_keys_[slot * kHotKeySlotWords];
+    uint64_t file_id = words[0].load(std::memory_order_relaxed);
+    uint64_t offset = words[1].load(std::memory_order_relaxed);
+    uint64_t size = words[2].load(std::memory_order_relaxed);
+    uint64_t check = words[3].load(std::memory_order_relaxed);
+    // Blocks never start at offset 0 of a CFile, where its header is, so an
+    // empty slot can't be mistaken for a key. A slot torn by concurrent hits
+    // is skipped, since the warm-up reads exactly the saved block.
+    if (offset != 0 && check == HotKeyCheck(file_id, offset, size)) {
+      keys->push_back({ CacheKey(BlockId(file_id), offset), static_cast<uint32_t>(size) });
+    }
+  }
+}
+
+BlockCache::ScopedWarmupThread::ScopedWarmupThread() {
+  DCHECK(!tls_is_warmup_thread);
+  tls_is_warmup_thread = true;
+}
+
+BlockCache::ScopedWarmupThread::~ScopedWarmupThread() {
+  tls_is_warmup_thread = false;
 }
 
 void BlockCache::StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity) {
   cache_->SetMetrics(metric_entity);
+  if (compressed_cache_) {
+    compressed_hits_metric_ = METRIC_block_cache_compressed_hits.Instantiate(metric_entity);
+    compressed_capacity_metric_ = METRIC_block_cache_compressed_capacity.Instantiate(
+        metric_entity, compressed_capacity_);
+  }
+  if (num_hot_key_slots_ > 0) {
+    warmup_lookups_metric_ = METRIC_block_cache_warmup_lookups.Instantiate(metric_entity);
+    warmup_hits_metric_ = METRIC_block_cache_warmup_hits.Instantiate(metric_entity);
+  }
 }
 
 } // namespace cfile
@@ -17,9 +17,12 @@
 #ifndef KUDU_CFILE_BLOCK_CACHE_H
 #define KUDU_CFILE_BLOCK_CACHE_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
@@ -30,15 +33,20 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/singleton.h"
 #include "kudu/util/cache.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/slice.h"
 
+DECLARE_bool(block_cache_warmup);
 DECLARE_string(block_cache_type);
 
 template <class T> class scoped_refptr;
 
 namespace kudu {
 
+class Counter;
 class MetricEntity;
+template<typename T>
+class AtomicGauge;
 
 namespace cfile {
 
@@ -46,12 +54,22 @@ class BlockCacheHandle;
 
 // Wrapper around kudu::Cache specifically for caching blocks of CFiles.
 // Provides a singleton and LRU cache for CFile blocks.
+//
+// Optionally (see --block_cache_compressed_ratio), part of the capacity is
+// set aside for a compressed tier, which holds the blocks of compressed
+// CFiles as they are on disk. Blocks go into the compressed tier when first
+// read, and are moved into the main, decompressed tier when hit there.
+// The split of the capacity between the tiers follows their hit rates.
 class BlockCache {
  public:
   // Parse the gflag which configures the block cache. FATALs if the flag is
   // invalid.
   static CacheType GetConfiguredCacheTypeOrDie();
 
+  // Parse the gflag which configures the block cache's eviction policy.
+  // FATALs if the flag is invalid.
+  static CacheEvictionPolicy GetConfiguredEvictionPolicyOrDie();
+
   // BlockId refers to the unique identifier for a Kudu block, that is, for an
   // entire CFile. This is different than the block cache's notion of a block,
   // which is just a portion of a CFile.
@@ -122,6 +140,7 @@ class BlockCache {
   }
 
   explicit BlockCache(size_t capacity);
+  ~BlockCache();
 
   // Lookup the given block in the cache.
   //
@@ -160,17 +179,120 @@ class BlockCache {
   // Allocate a new entry to be inserted into the cache.
   PendingEntry Allocate(const CacheKey& key, size_t block_size);
 
-  // Insert the given block into the cache. 'inserted' is set to refer to the
-  // entry in the cache.
+  // Insert the given block into the cache, or into the tier it was allocated
+  // from. 'inserted' is set to refer to the entry in the cache.
   void Insert(PendingEntry* entry, BlockCacheHandle* inserted);
 
+  // Compressed tier
+  // --------------------
+  // Return true if the cache has a compressed tier. If not, the following
+  // methods must not be called.
+  bool has_compressed_tier() const {
+    return compressed_cache_ != nullptr;
+  }
+
+  // Like Lookup(), but in the compressed tier.
+  bool LookupCompressed(const CacheKey& key, Cache::CacheBehavior behavior,
+                        BlockCacheHandle* handle);
+
+  // Like Allocate(), but the entry goes into the compressed tier.
+  PendingEntry AllocateCompressed(const CacheKey& key, size_t block_size);
+
+  // Erase the entry of the given key from the compressed tier, e.g. once it
+  // was decompressed into the rest of the cache.
+  void EraseCompressed(const CacheKey& key);
+
+  // The current capacity of the compressed tier, in bytes.
+  size_t compressed_capacity() const {
+    return compressed_capacity_;
+  }
+
+  // Warm-up
+  // --------------------
+  // With --block_cache_warmup, the cache tracks the keys of recently hit
+  // blocks, so that they can be saved and read back into the cache after a
+  // restart (see BlockCacheWarmer).
+
+  // A recently hit block: its key, and its size on disk, as in its
+  // BlockPointer.
+  struct HotKey {
+    CacheKey key;
+    uint32_t size;
+  };
+
+  // Tracks a hit on the block of 'key', whose size on disk is 'size'. The
+  // cache doesn't know the sizes of the blocks, so this is called by its
+  // readers rather than by the lookups themselves.
+  void RecordHotKey(const CacheKey& key, uint32_t size);
+
+  // Sets 'keys' to the recently hit blocks, in no particular order.
+  void GetHotKeys(std::vector<HotKey>* keys) const;
+
+  // While set, lookups are also counted in the warm-up metrics, except those
+  // made by threads within a ScopedWarmupThread.
+  void set_warming_up(bool warming_up) {
+    warming_up_ = warming_up;
+  }
+
+  // Marks the current thread as the one warming up the cache for the
+  // lifetime of the object, so that its lookups don't skew the warm-up hit
+  // rate.
+  class ScopedWarmupThread {
+   public:
+    ScopedWarmupThread();
+    ~ScopedWarmupThread();
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(ScopedWarmupThread);
+  };
+
  private:
   friend class Singleton<BlockCache>;
   BlockCache();
 
+  // Counts a lookup in one of the tiers, and adjusts the split of the
+  // capacity between the tiers every so often.
+  void RecordLookup(bool compressed_tier, bool hit);
+
+  // Moves some capacity to the tier which had more hits per byte since the
+  // last adjustment.
+  void AdjustSplit();
+
+  // Counts a lookup in the warm-up metrics if warming up.
+  void RecordWarmupLookup(bool hit);
+
   DISALLOW_COPY_AND_ASSIGN(BlockCache);
 
+  const size_t capacity_;
+
   gscoped_ptr<Cache> cache_;
+
+  // The compressed tier, or null if disabled.
+  gscoped_ptr<Cache> compressed_cache_;
+
+  std::atomic<size_t> compressed_capacity_;
+
+  // The number of lookups and hits in each tier since the last adjustment of
+  // the split.
+  std::atomic<int64_t> lookups_;
+  std::atomic<int64_t> hits_;
+  std::atomic<int64_t> compressed_hits_;
+
+  // Held while adjusting the split.
+  simple_spinlock split_lock_;
+
+  scoped_refptr<Counter> compressed_hits_metric_;
+  scoped_refptr<AtomicGauge<uint64_t>> compressed_capacity_metric_;
+
+  // A lossy table of recently hit blocks: a hit stores the key and the size
+  // of the block, followed by a hash of them, as four words in the slot the
+  // key's hash maps to. Empty if keys aren't tracked.
+  const size_t num_hot_key_slots_;
+  std::unique_ptr<std::atomic<uint64_t>[]> hot_keys_;
+
+  std::atomic<bool> warming_up_;
+  scoped_refptr<Counter> warmup_lookups_metric_;
+  scoped_refptr<Counter> warmup_hits_metric_;
 };
 
 // Scoped reference to a block from the block cache.
@@ -0,0 +1,237 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/block_cache_warmer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/fs/block_id.h"
+#include "kudu/fs/block_manager.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/fs/io_context.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/env.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/pb_util.h"
+#include "kudu/util/scoped_cleanup.h"
+#include "kudu/util/thread.h"
+#include "kudu/util/throttler.h"
+
+DEFINE_int32(block_cache_warmup_save_interval_secs, 300,
+             "How often the keys of the blocks recently hit in the block cache are "
+             "saved for --block_cache_warmup.");
+TAG_FLAG(block_cache_warmup_save_interval_secs, experimental);
+
+DEFINE_int32(block_cache_warmup_max_mb_per_sec, 16,
+             "The maximum rate at which blocks are read from disk to warm up the block "
+             "cache after a restart. 0 means unlimited.");
+TAG_FLAG(block_cache_warmup_max_mb_per_sec, experimental);
+
+METRIC_DEFINE_gauge_uint64(server, block_cache_warmup_keys_total,
+                           "Block Cache Warm-up Keys", kudu::MetricUnit::kBlocks,
+                           "Number of saved block cache keys to read back into the "
+                           "block cache after a restart");
+METRIC_DEFINE_counter(server, block_cache_warmup_keys_processed,
+                      "Block Cache Warm-up Keys Processed", kudu::MetricUnit::kBlocks,
+                      "Number of saved block cache keys processed so far while warming "
+                      "up the block cache after a restart, including those whose blocks "
+                      "no longer exist");
+METRIC_DEFINE_counter(server, block_cache_warmup_blocks_read,
+                      "Block Cache Warm-up Blocks Read", kudu::MetricUnit::kBlocks,
+                      "Number of blocks read into the block cache while warming it up "
+                      "after a restart");
+
+using kudu::fs::IOContext;
+using kudu::fs::ReadableBlock;
+using std::map;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+BlockCacheWarmer::BlockCacheWarmer(FsManager* fs_manager,
+                                   const scoped_refptr<MetricEntity>& metric_entity)
+    : fs_manager_(fs_manager),
+      stop_latch_(1),
+      warmed_up_(false) {
+  keys_total_metric_ = METRIC_block_cache_warmup_keys_total.Instantiate(metric_entity, 0);
+  keys_processed_metric_ = METRIC_block_cache_warmup_keys_processed.Instantiate(metric_entity);
+  blocks_read_metric_ = METRIC_block_cache_warmup_blocks_read.Instantiate(metric_entity);
+}
+
+BlockCacheWarmer::~BlockCacheWarmer() {
+  Shutdown();
+}
+
+Status BlockCacheWarmer::Start() {
+  return Thread::Create("block cache", "warmer", &BlockCacheWarmer::Run, this, &thread_);
+}
+
+void BlockCacheWarmer::Shutdown() {
+  if (!thread_) {
+    return;
+  }
+  stop_latch_.CountDown();
+  CHECK_OK(ThreadJoiner(thread_.get()).Join());
+  thread_.reset();
+  if (warmed_up_) {
+    WARN_NOT_OK(SaveHotKeys(), "Failed to save the keys of hot block cache entries");
+  }
+}
+
+void BlockCacheWarmer::Run() {
+  Status s = WarmUp();
+  if (s.IsAborted()) {
+    return;
+  }
+  WARN_NOT_OK(s, "Failed to warm up the block cache");
+  warmed_up_ = true;
+  while (!stop_latch_.WaitFor(
+      MonoDelta::FromSeconds(FLAGS_block_cache_warmup_save_interval_secs))) {
+    WARN_NOT_OK(SaveHotKeys(), "Failed to save the keys of hot block cache entries");
+  }
+}
+
+Status BlockCacheWarmer::SaveHotKeys() {
+  if (fs_manager_->read_only()) {
+    return Status::OK();
+  }
+  vector<BlockCache::HotKey> keys;
+  BlockCache::GetSingleton()->GetHotKeys(&keys);
+  BlockCacheKeysPB pb;
+  for (const auto& key : keys) {
+    BlockCacheKeysPB::KeyPB* key_pb = pb.add_keys();
+    key_pb->set_block_id(key.key.file_id_);
+    key_pb->set_offset(key.key.offset_);
+    key_pb->set_size(key.size);
+  }
+  VLOG(1) << Substitute("Saving $0 block cache keys", keys.size());
+  return pb_util::WritePBContainerToPath(fs_manager_->env(),
+                                         fs_manager_->GetBlockCacheKeysPath(), pb,
+                                         pb_util::OVERWRITE, pb_util::NO_SYNC);
+}
+
+Status BlockCacheWarmer::WarmUp() {
+  const string path = fs_manager_->GetBlockCacheKeysPath();
+  if (!fs_manager_->env()->FileExists(path)) {
+    return Status::OK();
+  }
+  BlockCacheKeysPB pb;
+  RETURN_NOT_OK_PREPEND(pb_util::ReadPBContainerFromPath(fs_manager_->env(), path, &pb),
+                        "could not read the saved block cache keys");
+
+  // Read the blocks file by file, in the order of their offsets.
+  map<uint64_t, map<uint64_t, uint32_t>> sizes_by_file;
+  for (const auto& key_pb : pb.keys()) {
+    sizes_by_file[key_pb.block_id()].emplace(key_pb.offset(), key_pb.size());
+  }
+  keys_total_metric_->set_value(pb.keys_size());
+  LOG(INFO) << Substitute("Warming up the block cache with $0 blocks from $1 files",
+                          pb.keys_size(), sizes_by_file.size());
+  const MonoTime start = MonoTime::Now();
+
+  BlockCache* cache = BlockCache::GetSingleton();
+  BlockCache::ScopedWarmupThread warmup_thread;
+  cache->set_warming_up(true);
+  auto stop_warming_up = MakeScopedCleanup([&]() {
+    cache->set_warming_up(false);
+  });
+
+  // Allow bursts of up to a second's worth of reads, so that blocks larger
+  // than what a single refill period allows can still be read.
+  const uint64_t bytes_per_sec =
+      static_cast<uint64_t>(FLAGS_block_cache_warmup_max_mb_per_sec) * 1024 * 1024;
+  Throttler throttler(start, 0, bytes_per_sec,
+                      MonoTime::kMicrosecondsPerSecond / Throttler::kRefillPeriodMicros);
+  // Corruption found while warming up isn't attributed to any tablet.
+  IOContext io_context;
+  int64_t blocks_read = 0;
+  for (const auto& file : sizes_by_file) {
+    const map<uint64_t, uint32_t>& sizes = file.second;
+    unique_ptr<ReadableBlock> block;
+    Status s = fs_manager_->OpenBlock(BlockId(file.first), &block);
+    if (s.IsNotFound()) {
+      // The block was deleted since, e.g. by a compaction.
+      keys_processed_metric_->IncrementBy(sizes.size());
+      continue;
+    }
+    RETURN_NOT_OK(s);
+
+    ReaderOptions opts;
+    opts.io_context = &io_context;
+    unique_ptr<CFileReader> reader;
+    s = CFileReader::Open(std::move(block), std::move(opts), &reader);
+    if (!s.ok()) {
+      // Don't give up on the other files.
+      LOG(WARNING) << Substitute("Could not warm up the block cache with blocks of $0: $1",
+                                 BlockId(file.first).ToString(), s.ToString());
+      keys_processed_metric_->IncrementBy(sizes.size());
+      continue;
+    }
+
+    for (const auto& e : sizes) {
+      BlockPointer ptr(e.first, e.second);
+      // ReadBlock() CHECKs that the block is within the file.
+      if (PREDICT_FALSE(ptr.offset() == 0 || ptr.offset() + ptr.size() >= reader->file_size())) {
+        LOG(WARNING) << Substitute("Saved block cache key $0 $1 is out of the file's bounds",
+                                   BlockId(file.first).ToString(), ptr.ToString());
+        keys_processed_metric_->Increment();
+        continue;
+      }
+      while (!throttler.Take(MonoTime::Now(), 0,
+                             std::min<uint64_t>(ptr.size(), bytes_per_sec))) {
+        if (stop_latch_.WaitFor(MonoDelta::FromMilliseconds(10))) {
+          return Status::Aborted("shutting down");
+        }
+      }
+      if (stop_latch_.count() == 0) {
+        return Status::Aborted("shutting down");
+      }
+      BlockHandle handle;
+      RETURN_NOT_OK(reader->ReadBlock(&io_context, ptr, CFileReader::CACHE_BLOCK, &handle));
+      keys_processed_metric_->Increment();
+      blocks_read_metric_->Increment();
+      blocks_read++;
+    }
+  }
+  LOG(INFO) << Substitute("Warmed up the block cache with $0 blocks in $1",
+                          blocks_read, (MonoTime::Now() - start).ToString());
+  return Status::OK();
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef KUDU_CFILE_BLOCK_CACHE_WARMER_H
+#define KUDU_CFILE_BLOCK_CACHE_WARMER_H
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class FsManager;
+class Thread;
+
+namespace cfile {
+
+// Warms up the block cache after a restart, with --block_cache_warmup.
+//
+// While the server runs, the keys and sizes of the blocks recently hit in the
+// block cache are periodically saved to the metadata directory. When the
+// server starts again, a background thread reads exactly the saved blocks back
+// into the block cache, at a bounded rate so as not to starve the I/O of
+// tablet bootstrap and of clients.
+class BlockCacheWarmer {
+ public:
+  BlockCacheWarmer(FsManager* fs_manager,
+                   const scoped_refptr<MetricEntity>& metric_entity);
+  ~BlockCacheWarmer();
+
+  // Starts the thread which warms up the block cache and then periodically
+  // saves the hot keys.
+  Status Start();
+
+  // Stops the thread, interrupting the warm-up if still in progress, and
+  // saves the hot keys one last time if the warm-up had completed.
+  void Shutdown();
+
+  // Saves the keys of the blocks recently hit in the block cache.
+  Status SaveHotKeys();
+
+  // Reads the blocks whose keys were last saved into the block cache. Blocks
+  // which no longer exist are skipped. Returns Aborted if Shutdown() is called
+  // meanwhile.
+  Status WarmUp();
+
+ private:
+  void Run();
+
+  FsManager* fs_manager_;
+
+  // Counted down when shutting down.
+  CountDownLatch stop_latch_;
+
+  scoped_refptr<Thread> thread_;
+
+  // Whether WarmUp() completed. Until it does, the hot keys don't cover the
+  // blocks which were hot before the restart, so aren't saved.
+  bool warmed_up_;
+
+  scoped_refptr<AtomicGauge<uint64_t>> keys_total_metric_;
+  scoped_refptr<Counter> keys_processed_metric_;
+  scoped_refptr<Counter> blocks_read_metric_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockCacheWarmer);
+};
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
@@ -19,14 +19,18 @@
 #define KUDU_CFILE_BLOCK_ENCODINGS_H
 
 #include <algorithm>
+#include <cstring>
 #include <stdint.h>
 #include <glog/logging.h>
 
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -158,6 +162,10 @@ class BlockDecoder {
   // the predicate. Mark the row in the view into the selection vector. This
   // view denotes the current location in the CFile.
   //
+  // Decoders which support evaluation only need to copy the values of the
+  // rows which remain selected into 'dst'; the cells of the rows they
+  // deselect, or which were already deselected on entry, are left undefined.
+  //
   // Modifies *n to contain the number of values fetched.
   //
   // POSTCONDITION: ctx->decoder_eval_supported_ is not kNotSet. State must
@@ -190,6 +198,35 @@ class BlockDecoder {
   virtual rowid_t GetFirstRowId() const = 0;
 
   virtual ~BlockDecoder() {}
+
+ protected:
+  // Helper for the CopyNextAndEval() of decoders of fixed-width types which
+  // have the block's values laid out contiguously at 'src'.
+  //
+  // Evaluates 'pred' against the first 'n' values at 'src', skipping the rows
+  // already deselected in 'sel'. The values which satisfy the predicate are
+  // copied to the same index in 'dst', and the rows of those which don't are
+  // deselected. 'src' may be unaligned, and may be the same as 'dst'.
+  template<DataType Type>
+  static void EvalAndCopyMatching(const ColumnPredicate& pred,
+                                  const uint8_t* src,
+                                  size_t n,
+                                  SelectionVectorView* sel,
+                                  uint8_t* dst) {
+    typedef typename TypeTraits<Type>::cpp_type CppType;
+    for (size_t i = 0; i < n; i++, src += sizeof(CppType), dst += sizeof(CppType)) {
+      if (!sel->TestBit(i)) {
+        continue;
+      }
+      CppType val = UnalignedLoad<CppType>(src);
+      if (pred.EvaluateCell<TypeTraits<Type>::physical_type>(&val)) {
+        memcpy(dst, &val, sizeof(CppType));
+      } else {
+        sel->ClearBit(i);
+      }
+    }
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(BlockDecoder);
 };
@@ -328,6 +328,36 @@ class BShufBlockDecoder final : public BlockDecoder {
     return CopyNextValuesToArray(n, dst->data());
   }
 
+  // Evaluates the predicate against the unshuffled values, only copying the
+  // ones which satisfy it.
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    ctx->SetDecoderEvalSupported();
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    if (PREDICT_FALSE(size_of_elem_ != size_of_type)) {
+      // The values must be expanded to their full width before they can be
+      // evaluated, so do so in place in 'dst'.
+      RETURN_NOT_OK(CopyNextValuesToArray(n, dst->data()));
+      EvalAndCopyMatching<Type>(*ctx->pred(), dst->data(), *n, sel, dst->data());
+      return Status::OK();
+    }
+
+    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    EvalAndCopyMatching<Type>(*ctx->pred(), &decoded_[cur_idx_ * size_of_type],
+                              max_fetch, sel, dst->data());
+    *n = max_fetch;
+    cur_idx_ += max_fetch;
+    return Status::OK();
+  }
+
   // Copy the codewords to a temporary buffer.
   // This API provides a more convenient way for the dictionary decoder to copy out
   // integer codewords and then look up the strings. If we use the CopyNextValuesToArray()
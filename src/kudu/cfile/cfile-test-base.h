@@ -355,7 +355,8 @@ class CFileTestBase : public KuduTest {
   enum Flags {
     NO_FLAGS = 0,
     WRITE_VALIDX = 1,
-    SMALL_BLOCKSIZE = 1 << 1
+    SMALL_BLOCKSIZE = 1 << 1,
+    WRITE_ZONE_MAP = 1 << 2
   };
 
   template<class DataGeneratorType>
@@ -378,6 +379,9 @@ class CFileTestBase : public KuduTest {
       // Use a smaller block size to exercise multi-level indexing.
       opts.storage_attributes.cfile_block_size = 1024;
     }
+    if (flags & WRITE_ZONE_MAP) {
+      opts.write_zone_map = true;
+    }
 
     opts.storage_attributes.encoding = encoding;
     opts.storage_attributes.compression = compression;
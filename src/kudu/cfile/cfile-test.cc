@@ -32,6 +32,7 @@
 #include <gtest/gtest.h>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_cache_warmer.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_pointer.h"
 #include "kudu/cfile/cfile-test-base.h"
@@ -41,7 +42,9 @@
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
+#include "kudu/cfile/zone_map.h"
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
@@ -70,21 +73,27 @@
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_double(block_cache_compressed_ratio);
+DECLARE_bool(block_cache_warmup);
 DECLARE_bool(cfile_write_checksums);
 DECLARE_bool(cfile_verify_checksums);
+DECLARE_string(ssd_cache_path);
 
 #if defined(__linux__)
 DECLARE_string(nvm_cache_path);
 DECLARE_bool(nvm_cache_simulate_allocation_failure);
 #endif
 
+METRIC_DECLARE_counter(block_cache_compressed_hits);
 METRIC_DECLARE_counter(block_cache_hits_caching);
+METRIC_DECLARE_counter(block_cache_warmup_blocks_read);
 
 METRIC_DECLARE_entity(server);
 
@@ -394,8 +403,8 @@ class TestCFile : public CFileTestBase {
 };
 
 // Subclass of TestCFile which is parameterized on the block cache type.
-// Tests that use TEST_P(TestCFileBothCacheTypes, ...) will run twice --
-// once for each cache type (DRAM, NVM).
+// Tests that use TEST_P(TestCFileBothCacheTypes, ...) will run
+// once for each cache type (DRAM, NVM, SSD).
 class TestCFileBothCacheTypes : public TestCFile,
                                 public ::testing::WithParamInterface<CacheType> {
  public:
@@ -413,6 +422,10 @@ class TestCFileBothCacheTypes : public TestCFile,
       case DRAM_CACHE:
         FLAGS_block_cache_type = "DRAM";
         break;
+      case SSD_CACHE:
+        FLAGS_block_cache_type = "SSD";
+        FLAGS_ssd_cache_path = GetTestPath("ssd-cache");
+        break;
 #if defined(HAVE_LIB_VMEM)
       case NVM_CACHE:
         FLAGS_block_cache_type = "NVM";
@@ -431,9 +444,10 @@ class TestCFileBothCacheTypes : public TestCFile,
 
 #if defined(__linux__)
 INSTANTIATE_TEST_CASE_P(CacheTypes, TestCFileBothCacheTypes,
-                        ::testing::Values(DRAM_CACHE, NVM_CACHE));
+                        ::testing::Values(DRAM_CACHE, NVM_CACHE, SSD_CACHE));
 #else
-INSTANTIATE_TEST_CASE_P(CacheTypes, TestCFileBothCacheTypes, ::testing::Values(DRAM_CACHE));
+INSTANTIATE_TEST_CASE_P(CacheTypes, TestCFileBothCacheTypes,
+                        ::testing::Values(DRAM_CACHE, SSD_CACHE));
 #endif
 
 template<DataType type>
@@ -991,6 +1005,60 @@ TEST_P(TestCFileBothCacheTypes, TestLazyInit) {
   ASSERT_EQ(bytes_read_after_init, bytes_read);
 }
 
+// Tests that the zone map describes every data block, and that it's used to
+// deselect the rows of the blocks which can't match a predicate.
+TEST_P(TestCFileBothCacheTypes, TestZoneMap) {
+  const int kNumRows = 10000;
+  BlockId block_id;
+  UInt32DataGenerator<false> generator;
+  WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows,
+                SMALL_BLOCKSIZE | WRITE_ZONE_MAP, &block_id);
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  ASSERT_TRUE(reader->has_zone_map());
+  ASSERT_TRUE(reader->footer().compatible_features() & CompatibleFeatures::ZONE_MAP);
+
+  const ZoneMap* zone_map;
+  ASSERT_OK(reader->GetZoneMap(nullptr, &zone_map));
+  ASSERT_GT(zone_map->num_blocks(), 10);
+  rowid_t next_row = 0;
+  for (size_t i = 0; i < zone_map->num_blocks(); i++) {
+    ASSERT_EQ(next_row, zone_map->first_row(i));
+    next_row += zone_map->num_rows(i);
+  }
+  ASSERT_EQ(kNumRows, next_row);
+
+  // Row i holds the value i * 10, so only the block holding rows [2000, 2010)
+  // and perhaps the next one can match.
+  ColumnSchema col("c", UINT32);
+  uint32_t lower = 20000;
+  uint32_t upper = 20100;
+  auto pred = ColumnPredicate::Range(col, &lower, &upper);
+  gscoped_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK, nullptr));
+  SelectionVector sel(kNumRows);
+  sel.SetAllTrue();
+  ASSERT_OK(iter->DeselectUnmatchedRows(0, kNumRows, pred, &sel));
+  for (int i = 2000; i < 2010; i++) {
+    ASSERT_TRUE(sel.IsRowSelected(i));
+  }
+  ASSERT_FALSE(sel.IsRowSelected(0));
+  ASSERT_FALSE(sel.IsRowSelected(kNumRows - 1));
+  ASSERT_GE(iter->io_statistics().blocks_skipped,
+            static_cast<int64_t>(zone_map->num_blocks()) - 2);
+  ASSERT_EQ(0, iter->io_statistics().blocks_read);
+
+  // The blocks of a non-nullable column can't hold NULLs.
+  ColumnSchema nullable_col("c", UINT32, true);
+  sel.SetAllTrue();
+  ASSERT_OK(iter->DeselectUnmatchedRows(0, kNumRows, ColumnPredicate::IsNull(nullable_col),
+                                        &sel));
+  ASSERT_FALSE(sel.AnySelected());
+}
+
 // Tests that the block cache keys used by CFileReaders are stable. That is,
 // different reader instances operating on the same block should use the same
 // block cache keys.
@@ -1034,6 +1102,122 @@ TEST_P(TestCFileBothCacheTypes, TestCacheKeysAreStable) {
   }
 }
 
+// Tests that, with a compressed block cache tier, blocks of compressed CFiles
+// are first cached compressed, and then promoted once hit.
+TEST_F(TestCFile, TestCompressedCacheTier) {
+  FLAGS_block_cache_compressed_ratio = 0.25;
+  Singleton<BlockCache>::UnsafeReset();
+  auto reset_cache = MakeScopedCleanup([]() {
+    Singleton<BlockCache>::UnsafeReset();
+  });
+
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity(METRIC_ENTITY_server.Instantiate(&registry, "test_entity"));
+  BlockCache* cache = BlockCache::GetSingleton();
+  ASSERT_TRUE(cache->has_compressed_tier());
+  cache->StartInstrumentation(entity);
+  auto hits = [&]() {
+    return down_cast<Counter*>(
+        entity->FindOrNull(METRIC_block_cache_hits_caching).get())->value();
+  };
+  auto compressed_hits = [&]() {
+    return down_cast<Counter*>(
+        entity->FindOrNull(METRIC_block_cache_compressed_hits).get())->value();
+  };
+
+  BlockId block_id;
+  {
+    StringDataGenerator<false> generator("hello %04d");
+    WriteTestFile(&generator, PLAIN_ENCODING, LZ4, 1000, SMALL_BLOCKSIZE, &block_id);
+  }
+  unique_ptr<ReadableBlock> source;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+  gscoped_ptr<IndexTreeIterator> iter;
+  iter.reset(IndexTreeIterator::Create(nullptr, reader.get(), reader->posidx_root()));
+  ASSERT_OK(iter->SeekToFirst());
+  BlockPointer blk_ptr = iter->GetCurrentBlockPointer();
+
+  // The first read misses in both tiers, the second hits in the compressed
+  // tier, and the third in the decompressed tier.
+  string first_data;
+  for (int i = 0; i < 3; i++) {
+    int64_t hits_before = hits();
+    int64_t compressed_hits_before = compressed_hits();
+    BlockHandle bh;
+    ASSERT_OK(reader->ReadBlock(nullptr, blk_ptr, CFileReader::CACHE_BLOCK, &bh));
+    if (i == 0) {
+      first_data = bh.data().ToString();
+    } else {
+      ASSERT_EQ(first_data, bh.data().ToString());
+    }
+    ASSERT_EQ(i == 1 ? 1 : 0, compressed_hits() - compressed_hits_before);
+    ASSERT_EQ(i == 2 ? 1 : 0, hits() - hits_before);
+  }
+
+  // Once promoted, the block is no longer in the compressed tier.
+  BlockCacheHandle handle;
+  ASSERT_FALSE(cache->LookupCompressed(BlockCache::CacheKey(block_id, blk_ptr.offset()),
+                                       Cache::NO_EXPECT_IN_CACHE, &handle));
+}
+
+// Tests that the blocks hit in the block cache are read back into it by a
+// warm-up after the cache is emptied, e.g. by a restart.
+TEST_F(TestCFile, TestBlockCacheWarmup) {
+  FLAGS_block_cache_warmup = true;
+  Singleton<BlockCache>::UnsafeReset();
+  auto reset_cache = MakeScopedCleanup([]() {
+    Singleton<BlockCache>::UnsafeReset();
+  });
+
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity(METRIC_ENTITY_server.Instantiate(&registry, "test_entity"));
+  BlockCache::GetSingleton()->StartInstrumentation(entity);
+  auto hits = [&]() {
+    return down_cast<Counter*>(
+        entity->FindOrNull(METRIC_block_cache_hits_caching).get())->value();
+  };
+
+  BlockId block_id;
+  {
+    StringDataGenerator<false> generator("hello %04d");
+    WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, 1000, SMALL_BLOCKSIZE,
+                  &block_id);
+  }
+  unique_ptr<ReadableBlock> source;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+  gscoped_ptr<IndexTreeIterator> iter;
+  iter.reset(IndexTreeIterator::Create(nullptr, reader.get(), reader->posidx_root()));
+  ASSERT_OK(iter->SeekToFirst());
+  ASSERT_TRUE(iter->HasNext());
+  ASSERT_OK(iter->Next());
+  BlockPointer blk_ptr = iter->GetCurrentBlockPointer();
+
+  // Make the block hot: only hits are tracked.
+  for (int i = 0; i < 2; i++) {
+    BlockHandle bh;
+    ASSERT_OK(reader->ReadBlock(nullptr, blk_ptr, CFileReader::CACHE_BLOCK, &bh));
+  }
+  BlockCacheWarmer warmer(fs_manager_.get(), entity);
+  ASSERT_OK(warmer.SaveHotKeys());
+
+  // Empty the cache, then warm it up.
+  Singleton<BlockCache>::UnsafeReset();
+  BlockCache::GetSingleton()->StartInstrumentation(entity);
+  ASSERT_OK(warmer.WarmUp());
+  // Exactly the hot block is read, using its saved size.
+  ASSERT_EQ(1, down_cast<Counter*>(
+      entity->FindOrNull(METRIC_block_cache_warmup_blocks_read).get())->value());
+
+  int64_t hits_before = hits();
+  BlockHandle bh;
+  ASSERT_OK(reader->ReadBlock(nullptr, blk_ptr, CFileReader::CACHE_BLOCK, &bh));
+  ASSERT_EQ(1, hits() - hits_before);
+}
+
 #if defined(HAVE_LIB_VMEM)
 // Inject failures in nvm allocation and ensure that we can still read a file.
 TEST_P(TestCFileBothCacheTypes, TestNvmAllocationFailure) {
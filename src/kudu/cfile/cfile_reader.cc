@@ -36,6 +36,7 @@
 #include "kudu/cfile/cfile_writer.h" // for kMagicString
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
+#include "kudu/cfile/zone_map.h"
 #include "kudu/common/column_materialization_context.h"
 #include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
@@ -103,6 +104,10 @@ const char* CFILE_CACHE_HIT_BYTES_METRIC_NAME = "cfile_cache_hit_bytes";
 static const size_t kMagicAndLengthSize = 12;
 static const size_t kMaxHeaderFooterPBSize = 64*1024;
 
+// When materializing only the selected rows of a batch, runs of deselected
+// rows shorter than this are decoded rather than seeked past.
+static const size_t kMinDeselectedRowsToSkip = 16;
+
 static Status ParseMagicAndLength(const Slice &data,
                                   uint8_t* cfile_version,
                                   uint32_t *parsed_len) {
@@ -141,6 +146,9 @@ CFileReader::CFileReader(ReaderOptions options,
                    memory_footprint()) {
 }
 
+CFileReader::~CFileReader() {
+}
+
 Status CFileReader::Open(unique_ptr<ReadableBlock> block,
                          ReaderOptions options,
                          unique_ptr<CFileReader>* reader) {
@@ -328,6 +336,35 @@ bool CFileReader::has_checksums() const {
   return footer_->incompatible_features() & IncompatibleFeatures::CHECKSUM;
 }
 
+Status CFileReader::ReadAndParseZoneMap(const IOContext* io_context) {
+  TRACE_EVENT1("io", "CFileReader::ReadAndParseZoneMap",
+               "cfile", ToString());
+  // The parsed zone map is kept for the lifetime of the reader, so there's no
+  // need to also keep the raw block in the cache.
+  BlockHandle handle;
+  RETURN_NOT_OK_PREPEND(ReadBlock(io_context, BlockPointer(footer_->zone_map_block_ptr()),
+                                  DONT_CACHE_BLOCK, &handle),
+                        "couldn't read zone map block");
+  RETURN_NOT_OK_HANDLE_CORRUPTION(ZoneMap::Parse(type_info_, handle.data(), &zone_map_),
+                                  HandleCorruption(io_context));
+
+  // The zone map has been allocated; memory consumption has changed.
+  mem_consumption_.Reset(memory_footprint());
+  return Status::OK();
+}
+
+Status CFileReader::GetZoneMap(const IOContext* io_context, const ZoneMap** zone_map) {
+  RETURN_NOT_OK(Init(io_context));
+  DCHECK(has_zone_map());
+  RETURN_NOT_OK_PREPEND(zone_map_once_.Init([this, io_context] {
+                          return ReadAndParseZoneMap(io_context);
+                        }),
+                        Substitute("failed to read zone map of CFile block $0",
+                                   block_id().ToString()));
+  *zone_map = zone_map_.get();
+  return Status::OK();
+}
+
 Status CFileReader::VerifyChecksum(ArrayView<const Slice> data, const Slice& checksum) const {
   uint32_t expected_checksum = DecodeFixed32(checksum.data());
   uint32_t checksum_value = 0;
@@ -368,13 +405,13 @@ class ScratchMemory {
     }
   }
 
-  // Try to allocate 'size' bytes from the cache. If the cache has
-  // no capacity and cannot evict to make room, this will fall back
-  // to allocating from the heap. In that case, IsFromCache() will
-  // return false.
-  void TryAllocateFromCache(BlockCache* cache, const BlockCache::CacheKey& key, int size) {
+  // Try to use 'entry', of 'size' bytes, allocated from one of the tiers of
+  // the cache. If the cache has no capacity and cannot evict to make room,
+  // this will fall back to allocating from the heap. In that case,
+  // IsFromCache() will return false.
+  void TryAllocateFromCache(BlockCache::PendingEntry entry, int size) {
     DCHECK(!ptr_);
-    from_cache_ = cache->Allocate(key, size);
+    from_cache_ = std::move(entry);
     if (!from_cache_.valid()) {
       AllocateFromHeap(size);
       return;
@@ -443,6 +480,7 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
   BlockCache* cache = BlockCache::GetSingleton();
   BlockCache::CacheKey key(block_->id(), ptr.offset());
   if (cache->Lookup(key, cache_behavior, &bc_handle)) {
+    cache->RecordHotKey(key, ptr.size());
     TRACE_COUNTER_INCREMENT("cfile_cache_hit", 1);
     TRACE_COUNTER_INCREMENT(CFILE_CACHE_HIT_BYTES_METRIC_NAME, ptr.size());
     *ret = BlockHandle::WithDataFromCache(&bc_handle);
@@ -459,44 +497,75 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
   TRACE_COUNTER_INCREMENT("cfile_cache_miss", 1);
   TRACE_COUNTER_INCREMENT(CFILE_CACHE_MISS_BYTES_METRIC_NAME, ptr.size());
 
-  uint32_t data_size = ptr.size();
-  if (has_checksums()) {
-    if (PREDICT_FALSE(kChecksumSize > data_size)) {
-      return Status::Corruption("invalid data size for block pointer",
-                                ptr.ToString());
-    }
-    data_size -= kChecksumSize;
-  }
+  // With a compressed tier, compressed blocks are first cached as read from
+  // disk, and only cached decompressed once they're hit in the compressed tier.
+  const bool use_compressed_tier = codec_ != nullptr && cache_control == CACHE_BLOCK &&
+      cache->has_compressed_tier();
+  bool cache_decompressed = cache_control == CACHE_BLOCK;
+  bool compressed_hit = false;
+  BlockCacheHandle compressed_handle;
 
   ScratchMemory scratch;
-  // If we are reading uncompressed data and plan to cache the result,
-  // then we should allocate our scratch memory directly from the cache.
-  // This avoids an extra memory copy in the case of an NVM cache.
-  if (codec_ == nullptr && cache_control == CACHE_BLOCK) {
-    scratch.TryAllocateFromCache(cache, key, data_size);
+  uint8_t* buf = nullptr;
+  Slice block;
+  if (use_compressed_tier &&
+      cache->LookupCompressed(key, cache_behavior, &compressed_handle)) {
+    cache->RecordHotKey(key, ptr.size());
+    TRACE_COUNTER_INCREMENT("cfile_compressed_cache_hit", 1);
+    compressed_hit = true;
+    block = compressed_handle.data();
   } else {
-    scratch.AllocateFromHeap(data_size);
-  }
-  uint8_t* buf = scratch.get();
-  Slice block(buf, data_size);
-  uint8_t checksum_scratch[kChecksumSize];
-  Slice checksum(checksum_scratch, kChecksumSize);
+    if (use_compressed_tier) {
+      cache_decompressed = false;
+    }
+    uint32_t data_size = ptr.size();
+    if (has_checksums()) {
+      if (PREDICT_FALSE(kChecksumSize > data_size)) {
+        return Status::Corruption("invalid data size for block pointer",
+                                  ptr.ToString());
+      }
+      data_size -= kChecksumSize;
+    }
 
-  // Read the data and checksum if needed.
-  Slice results_backing[] = { block, checksum };
-  bool read_checksum = has_checksums() && FLAGS_cfile_verify_checksums;
-  ArrayView<Slice> results(results_backing, read_checksum ? 2 : 1);
-  RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
-                        Substitute("failed to read CFile block $0 at $1",
-                                   block_id().ToString(), ptr.ToString()));
+    // If we are reading uncompressed data and plan to cache the result,
+    // then we should allocate our scratch memory directly from the cache.
+    // This avoids an extra memory copy in the case of an NVM cache. The same
+    // goes for compressed data which goes into the compressed tier.
+    if (codec_ == nullptr && cache_control == CACHE_BLOCK) {
+      scratch.TryAllocateFromCache(cache->Allocate(key, data_size), data_size);
+    } else if (use_compressed_tier) {
+      scratch.TryAllocateFromCache(cache->AllocateCompressed(key, data_size), data_size);
+    } else {
+      scratch.AllocateFromHeap(data_size);
+    }
+    buf = scratch.get();
+    block = Slice(buf, data_size);
+    uint8_t checksum_scratch[kChecksumSize];
+    Slice checksum(checksum_scratch, kChecksumSize);
+
+    // Read the data and checksum if needed.
+    Slice results_backing[] = { block, checksum };
+    bool read_checksum = has_checksums() && FLAGS_cfile_verify_checksums;
+    ArrayView<Slice> results(results_backing, read_checksum ? 2 : 1);
+    RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
+                          Substitute("failed to read CFile block $0 at $1",
+                                     block_id().ToString(), ptr.ToString()));
+
+    if (has_checksums() && FLAGS_cfile_verify_checksums) {
+      Status s = VerifyChecksum(ArrayView<const Slice>(&block, 1), checksum);
+      if (!s.ok()) {
+        RETURN_NOT_OK_HANDLE_CORRUPTION(
+            s.CloneAndPrepend(Substitute("checksum error on CFile block $0 at $1",
+                                         block_id().ToString(), ptr.ToString())),
+            HandleCorruption(io_context));
+      }
+    }
 
-  if (has_checksums() && FLAGS_cfile_verify_checksums) {
-    Status s = VerifyChecksum(ArrayView<const Slice>(&block, 1), checksum);
-    if (!s.ok()) {
-      RETURN_NOT_OK_HANDLE_CORRUPTION(
-          s.CloneAndPrepend(Substitute("checksum error on CFile block $0 at $1",
-                                       block_id().ToString(), ptr.ToString())),
-          HandleCorruption(io_context));
+    if (use_compressed_tier && scratch.IsFromCache()) {
+      cache->Insert(scratch.mutable_pending_entry(), &compressed_handle);
+      // The compressed tier now owns the memory.
+      ignore_result(scratch.release());
+      block = compressed_handle.data();
     }
   }
 
@@ -516,8 +585,9 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
     // If we plan to put the uncompressed block in the cache, we should
     // decompress directly into the cache's memory (to avoid a memcpy for NVM).
     ScratchMemory decompressed_scratch;
-    if (cache_control == CACHE_BLOCK) {
-      decompressed_scratch.TryAllocateFromCache(cache, key, uncompressed_size);
+    if (cache_decompressed) {
+      decompressed_scratch.TryAllocateFromCache(cache->Allocate(key, uncompressed_size),
+                                                uncompressed_size);
     } else {
       decompressed_scratch.AllocateFromHeap(uncompressed_size);
     }
@@ -535,6 +605,7 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
     scratch.Swap(&decompressed_scratch);
 
     // Set the result block to our decompressed data.
+    buf = scratch.get();
     block = Slice(buf, uncompressed_size);
   } else {
     // Some of the File implementations from LevelDB attempt to be tricky
@@ -548,9 +619,15 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
   // failed, in which case we don't insert it into the cache regardless
   // of what the user requested. The scratch memory includes both the
   // generated key and the data read from disk.
-  if (cache_control == CACHE_BLOCK && scratch.IsFromCache()) {
+  if (cache_decompressed && scratch.IsFromCache()) {
     cache->Insert(scratch.mutable_pending_entry(), &bc_handle);
     *ret = BlockHandle::WithDataFromCache(&bc_handle);
+    if (compressed_hit) {
+      // The block was promoted to the decompressed tier, so don't keep its
+      // compressed copy around as well. 'compressed_handle' keeps the copy
+      // alive until it's released.
+      cache->EraseCompressed(key);
+    }
   } else {
     // We get here by either not intending to cache the block or
     // if the entry could not be allocated from the block cache.
@@ -606,6 +683,7 @@ size_t CFileReader::memory_footprint() const {
   size_t size = kudu_malloc_usable_size(this);
   size += block_->memory_footprint();
   size += init_once_.memory_footprint_excluding_this();
+  size += zone_map_once_.memory_footprint_excluding_this();
 
   // SpaceUsed() uses sizeof() instead of malloc_usable_size() to account for
   // the size of base objects (recursively too), thus not accounting for
@@ -616,6 +694,9 @@ size_t CFileReader::memory_footprint() const {
   if (footer_) {
     size += footer_->SpaceUsed();
   }
+  if (zone_map_) {
+    size += zone_map_->memory_footprint();
+  }
   return size;
 }
 
@@ -689,6 +770,7 @@ CFileIterator::CFileIterator(CFileReader* reader,
     cache_control_(cache_control),
     last_prepare_idx_(-1),
     last_prepare_count_(-1),
+    last_skipped_block_(-1),
     io_context_(io_context) {
 }
 
@@ -1090,6 +1172,37 @@ Status CFileIterator::FinishBatch() {
   return Status::OK();
 }
 
+Status CFileIterator::DeselectUnmatchedRows(rowid_t first_row,
+                                            size_t n,
+                                            const ColumnPredicate& pred,
+                                            SelectionVector* sel) {
+  RETURN_NOT_OK(reader_->Init(io_context_));
+  if (!reader_->has_zone_map()) {
+    return Status::OK();
+  }
+  const ZoneMap* zone_map;
+  RETURN_NOT_OK(reader_->GetZoneMap(io_context_, &zone_map));
+
+  size_t idx;
+  if (n == 0 || !zone_map->FindBlock(first_row, &idx)) {
+    return Status::OK();
+  }
+  const rowid_t end_row = first_row + n;
+  for (; idx < zone_map->num_blocks() && zone_map->first_row(idx) < end_row; idx++) {
+    if (zone_map->MayMatch(idx, pred)) {
+      continue;
+    }
+    rowid_t start = std::max(first_row, zone_map->first_row(idx));
+    rowid_t end = std::min<rowid_t>(end_row, zone_map->first_row(idx) + zone_map->num_rows(idx));
+    BitmapChangeBits(sel->mutable_bitmap(), start - first_row, end - start, false);
+    if (static_cast<int64_t>(idx) != last_skipped_block_) {
+      io_stats_.blocks_skipped++;
+      last_skipped_block_ = idx;
+    }
+  }
+  return Status::OK();
+}
+
 Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
   CHECK(seeked_) << "not seeked";
 
@@ -1122,10 +1235,26 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
       // that might be more efficient (allowing the decoder to save internal state
       // instead of having to reconstruct it)
     }
+    size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
+    size_t first_selected;
+    if (ctx->materialize_selected_rows_only() &&
+        !remaining_sel.FindFirst(0, nrows, true, &first_selected)) {
+      // None of this block's rows in the batch are selected, so seek past them
+      // without decoding them.
+      SeekToPositionInBlock(pb, pb->idx_in_block_ + nrows);
+      pb->needs_rewind_ = true;
+      rem -= nrows;
+      remaining_dst.Advance(nrows);
+      remaining_sel.Advance(nrows);
+      if (rem == 0) {
+        break;
+      }
+      continue;
+    }
+
     if (reader_->is_nullable()) {
       DCHECK(ctx->block()->is_nullable());
 
-      size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
       // Fill column bitmap
       size_t count = nrows;
       while (count > 0) {
@@ -1139,14 +1268,7 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
         }
         size_t this_batch = nblock;
         if (not_null) {
-          if (ctx->DecoderEvalNotDisabled()) {
-            RETURN_NOT_OK(pb->dblk_->CopyNextAndEval(&this_batch,
-                                                     ctx,
-                                                     &remaining_sel,
-                                                     &remaining_dst));
-          } else {
-            RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
-          }
+          RETURN_NOT_OK(CopyNonNullValues(pb, ctx, &this_batch, &remaining_sel, &remaining_dst));
           DCHECK_EQ(nblock, this_batch);
           pb->needs_rewind_ = true;
         } else {
@@ -1171,13 +1293,9 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
       }
     } else {
       // Fetch as many as we can from the current datablock.
-      size_t this_batch = rem;
-
-      if (ctx->DecoderEvalNotDisabled()) {
-        RETURN_NOT_OK(pb->dblk_->CopyNextAndEval(&this_batch, ctx, &remaining_sel, &remaining_dst));
-      } else {
-        RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
-      }
+      size_t this_batch = nrows;
+      RETURN_NOT_OK(CopyNonNullValues(pb, ctx, &this_batch, &remaining_sel, &remaining_dst));
+      DCHECK_EQ(nrows, this_batch);
       pb->needs_rewind_ = true;
       DCHECK_LE(this_batch, rem);
 
@@ -1195,7 +1313,7 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
     // If we didn't fetch as many as requested, then it should
     // be because the current data block ran out.
     if (rem > 0) {
-      DCHECK_EQ(pb->dblk_->Count(), pb->dblk_->GetCurrentIndex()) <<
+      DCHECK_EQ(pb->num_rows_in_block_, pb->idx_in_block_) <<
         "dblk stopped yielding values before it was empty.";
     } else {
       break;
@@ -1206,6 +1324,71 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
   return Status::OK();
 }
 
+Status CFileIterator::CopyNonNullValues(PreparedBlock* pb,
+                                        ColumnMaterializationContext* ctx,
+                                        size_t* n,
+                                        SelectionVectorView* sel,
+                                        ColumnDataView* dst) {
+  if (!ctx->materialize_selected_rows_only()) {
+    return CopyNextValuesFromBlock(pb, ctx, n, sel, dst);
+  }
+
+  // Decode the runs of selected rows, seeking past the runs of deselected
+  // rows in between. Short runs of deselected rows are cheaper to decode
+  // along with the surrounding rows than to seek past.
+  const size_t nrows = *n;
+  size_t idx = 0;
+  while (idx < nrows) {
+    size_t start;
+    if (!sel->FindFirst(idx, nrows - idx, true, &start)) {
+      start = nrows;
+    }
+    if (start > idx) {
+      int nskip = start - idx;
+      pb->dblk_->SeekForward(&nskip);
+      DCHECK_EQ(start - idx, nskip);
+    }
+    if (start == nrows) {
+      break;
+    }
+
+    size_t end = start;
+    while (true) {
+      if (!sel->FindFirst(end, nrows - end, false, &end)) {
+        end = nrows;
+        break;
+      }
+      size_t next_selected;
+      if (!sel->FindFirst(end, nrows - end, true, &next_selected) ||
+          next_selected - end >= kMinDeselectedRowsToSkip) {
+        break;
+      }
+      end = next_selected;
+    }
+
+    size_t count = end - start;
+    SelectionVectorView run_sel(*sel);
+    run_sel.Advance(start);
+    ColumnDataView run_dst(*dst);
+    run_dst.Advance(start);
+    RETURN_NOT_OK(CopyNextValuesFromBlock(pb, ctx, &count, &run_sel, &run_dst));
+    DCHECK_EQ(end - start, count);
+    idx = end;
+  }
+  return Status::OK();
+}
+
+Status CFileIterator::CopyNextValuesFromBlock(PreparedBlock* pb,
+                                              ColumnMaterializationContext* ctx,
+                                              size_t* n,
+                                              SelectionVectorView* sel,
+                                              ColumnDataView* dst) {
+  if (ctx->DecoderEvalNotDisabled()) {
+    return pb->dblk_->CopyNextAndEval(n, ctx, sel, dst);
+  }
+  return pb->dblk_->CopyNextValues(n, dst);
+}
+
 Status CFileIterator::CopyNextValues(size_t* n, ColumnMaterializationContext* ctx) {
   RETURN_NOT_OK(PrepareBatch(n));
   RETURN_NOT_OK(Scan(ctx));
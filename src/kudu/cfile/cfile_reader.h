@@ -49,10 +49,13 @@
 
 namespace kudu {
 
+class ColumnDataView;
 class ColumnMaterializationContext;
+class ColumnPredicate;
 class CompressionCodec;
 class EncodedKey;
 class SelectionVector;
+class SelectionVectorView;
 class TypeInfo;
 
 namespace fs {
@@ -67,6 +70,7 @@ class BinaryPlainBlockDecoder;
 class CFileIterator;
 class IndexTreeIterator;
 class TypeEncodingInfo;
+class ZoneMap;
 struct ReaderOptions;
 
 class CFileReader {
@@ -88,6 +92,8 @@ class CFileReader {
                            ReaderOptions options,
                            std::unique_ptr<CFileReader>* reader);
 
+  ~CFileReader();
+
   // Fully opens a previously lazily opened cfile, parsing and validating
   // its contents.
   //
@@ -189,6 +195,14 @@ class CFileReader {
   // Returns true if the file has checksums on the header, footer, and data blocks.
   bool has_checksums() const;
 
+  // Return true if there is a zone map of per-data-block statistics.
+  bool has_zone_map() const { return footer().has_zone_map_block_ptr(); }
+
+  // Sets '*zone_map' to the file's zone map, reading and parsing it on the
+  // first call. Requires has_zone_map(). The zone map lives as long as this
+  // reader.
+  Status GetZoneMap(const fs::IOContext* io_context, const ZoneMap** zone_map);
+
   // Can be called before Init().
   std::string ToString() const { return block_->id().ToString(); }
 
@@ -208,6 +222,9 @@ class CFileReader {
 
   Status ReadAndParseHeader();
   Status ReadAndParseFooter();
+
+  // Callback used in 'zone_map_once_' to read and parse the zone map.
+  Status ReadAndParseZoneMap(const fs::IOContext* io_context);
   Status VerifyChecksum(ArrayView<const Slice> data, const Slice& checksum) const;
 
   // Returns the memory usage of the object including the object itself.
@@ -229,6 +246,9 @@ class CFileReader {
 
   KuduOnceLambda init_once_;
 
+  std::unique_ptr<ZoneMap> zone_map_;
+  KuduOnceLambda zone_map_once_;
+
   ScopedTrackedConsumption mem_consumption_;
 };
 
@@ -285,6 +305,20 @@ class ColumnIterator {
   // batch left off.
   virtual Status FinishBatch() = 0;
 
+  // Deselects in 'sel' those of the 'n' rows starting at ordinal 'first_row'
+  // which the statistics of the underlying data show can't satisfy 'pred',
+  // e.g. the rows of CFile data blocks whose zone map bounds don't overlap
+  // a range predicate. May deselect nothing.
+  //
+  // This may be called before the iterator is seeked or prepared; the values
+  // of the deselected rows need not be read at all afterwards.
+  virtual Status DeselectUnmatchedRows(rowid_t /*first_row*/,
+                                       size_t /*n*/,
+                                       const ColumnPredicate& /*pred*/,
+                                       SelectionVector* /*sel*/) {
+    return Status::OK();
+  }
+
   virtual const IteratorStats& io_statistics() const = 0;
 };
 
@@ -389,6 +423,14 @@ class CFileIterator : public ColumnIterator {
   // batch left off.
   Status FinishBatch() OVERRIDE;
 
+  // Deselects the rows of the data blocks whose zone map entries show that
+  // none of their cells can satisfy 'pred'. A no-op if the file has no zone
+  // map.
+  Status DeselectUnmatchedRows(rowid_t first_row,
+                               size_t n,
+                               const ColumnPredicate& pred,
+                               SelectionVector* sel) override;
+
   // Return true if the next call to PrepareBatch will return at least one row.
   bool HasNext() const;
 
@@ -457,6 +499,28 @@ class CFileIterator : public ColumnIterator {
   // Seek the given PreparedBlock to the given index within it.
   void SeekToPositionInBlock(PreparedBlock *pb, uint32_t idx_in_block);
 
+  // Copies the next '*n' values from the data block of 'pb' into 'dst',
+  // evaluating the predicate of 'ctx' if decoder-level evaluation is enabled.
+  // All of the rows must be non-null.
+  //
+  // If the context only requires the selected rows to be materialized, the
+  // runs of rows which are deselected in 'sel' are seeked past rather than
+  // decoded.
+  Status CopyNonNullValues(PreparedBlock* pb,
+                           ColumnMaterializationContext* ctx,
+                           size_t* n,
+                           SelectionVectorView* sel,
+                           ColumnDataView* dst);
+
+  // Copies the next '*n' values from the data block of 'pb' into 'dst' with
+  // CopyNextAndEval() or CopyNextValues(), depending on whether decoder-level
+  // evaluation is enabled.
+  Status CopyNextValuesFromBlock(PreparedBlock* pb,
+                                 ColumnMaterializationContext* ctx,
+                                 size_t* n,
+                                 SelectionVectorView* sel,
+                                 ColumnDataView* dst);
+
   // Read the data block currently pointed to by idx_iter_
   // into the given PreparedBlock structure.
   //
@@ -512,6 +576,11 @@ class CFileIterator : public ColumnIterator {
 
   IteratorStats io_stats_;
 
+  // The index in the zone map of the last data block whose rows were
+  // deselected by DeselectUnmatchedRows(), so that a block spanning several
+  // batches is only counted once in io_stats_.blocks_skipped.
+  int64_t last_skipped_block_;
+
   const fs::IOContext* io_context_;
 
   // a temporary buffer for encoding
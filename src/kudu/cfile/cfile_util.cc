@@ -46,6 +46,7 @@ WriterOptions::WriterOptions()
     block_restart_interval(16),
     write_posidx(false),
     write_validx(false),
+    write_zone_map(false),
     optimize_index_keys(true),
     validx_key_encoder(boost::none) {
 }
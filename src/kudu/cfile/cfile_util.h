@@ -52,6 +52,12 @@ enum IncompatibleFeatures {
   SUPPORTED = NONE | CHECKSUM
 };
 
+// Used to set the CFileFooterPB bitset tracking compatible features
+enum CompatibleFeatures {
+  // Per-data-block statistics are stored in a zone map block
+  ZONE_MAP = 1 << 0
+};
+
 typedef std::function<void(const void*, faststring*)> ValidxKeyEncoder;
 
 struct WriterOptions {
@@ -75,6 +81,9 @@ struct WriterOptions {
   // Whether the file needs a value index
   bool write_validx;
 
+  // Whether the file needs a zone map of per-data-block statistics.
+  bool write_zone_map;
+
   // Whether to optimize index keys by storing shortest separating prefixes
   // instead of entire keys.
   bool optimize_index_keys;
@@ -60,6 +60,11 @@ DEFINE_bool(cfile_write_checksums, true,
             "Write CRC32 checksums for each block");
 TAG_FLAG(cfile_write_checksums, evolving);
 
+DEFINE_bool(cfile_write_zone_maps, true,
+            "Write a zone map of per-block min/max statistics to each cfile, "
+            "letting scans skip the blocks which can't match their predicates.");
+TAG_FLAG(cfile_write_zone_maps, experimental);
+
 using google::protobuf::RepeatedPtrField;
 using kudu::fs::BlockCreationTransaction;
 using kudu::fs::BlockManager;
@@ -131,6 +136,11 @@ CFileWriter::CFileWriter(WriterOptions options,
     posidx_builder_.reset(new IndexTreeBuilder(&options_, this));
   }
 
+  if (options_.write_zone_map) {
+    block_stats_.reset(new CellStatsAccumulator(typeinfo_));
+    file_stats_.reset(new CellStatsAccumulator(typeinfo_));
+  }
+
   if (options_.write_validx) {
     if (!options_.validx_key_encoder) {
       auto key_encoder = &GetKeyEncoder<faststring>(typeinfo_);
@@ -220,6 +230,16 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
     incompatible_features |= IncompatibleFeatures::CHECKSUM;
   }
 
+  uint32_t compatible_features = 0;
+  BlockPointer zone_map_ptr;
+  if (block_stats_) {
+    faststring zone_map_str;
+    pb_util::SerializeToString(zone_map_, &zone_map_str);
+    RETURN_NOT_OK_PREPEND(AddBlock({ Slice(zone_map_str) }, &zone_map_ptr, "zone map"),
+                          "Couldn't write zone map");
+    compatible_features |= CompatibleFeatures::ZONE_MAP;
+  }
+
   // Start preparing the footer.
   CFileFooterPB footer;
   footer.set_data_type(typeinfo_->type());
@@ -228,6 +248,10 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
   footer.set_num_values(value_count_);
   footer.set_compression(compression_);
   footer.set_incompatible_features(incompatible_features);
+  footer.set_compatible_features(compatible_features);
+  if (block_stats_) {
+    zone_map_ptr.CopyToPB(footer.mutable_zone_map_block_ptr());
+  }
 
   // Write out any pending positional index blocks.
   if (options_.write_posidx) {
@@ -274,6 +298,17 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
   return Status::OK();
 }
 
+bool CFileWriter::GetFileStats(ZoneMapEntryPB* stats) const {
+  DCHECK_EQ(state_, kWriterFinished);
+  if (!file_stats_) {
+    return false;
+  }
+  file_stats_->ToPB(stats);
+  stats->set_first_row(0);
+  stats->set_num_rows(value_count_);
+  return true;
+}
+
 void CFileWriter::AddMetadataPair(const Slice &key, const Slice &value) {
   CHECK_NE(state_, kWriterFinished);
 
@@ -311,6 +346,9 @@ Status CFileWriter::AppendEntries(const void *entries, size_t count) {
     int n = data_block_->Add(ptr, rem);
     DCHECK_GE(n, 0);
 
+    if (block_stats_) {
+      block_stats_->AddValues(ptr, n);
+    }
     ptr += typeinfo_->size() * n;
     rem -= n;
     value_count_ += n;
@@ -342,6 +380,9 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
         DCHECK_GE(n, 0);
 
         null_bitmap_builder_->AddRun(true, n);
+        if (block_stats_) {
+          block_stats_->AddValues(ptr, n);
+        }
         ptr += n * typeinfo_->size();
         value_count_ += n;
         rem -= n;
@@ -353,6 +394,9 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
       } while (rem > 0);
     } else {
       null_bitmap_builder_->AddRun(false, nblock);
+      if (block_stats_) {
+        block_stats_->AddNulls(nblock);
+      }
       ptr += nblock * typeinfo_->size();
       value_count_ += nblock;
     }
@@ -408,6 +452,14 @@ Status CFileWriter::FinishCurDataBlock() {
     null_bitmap_builder_->Reset();
   }
 
+  if (block_stats_) {
+    ZoneMapEntryPB* entry = zone_map_.add_entries();
+    entry->set_first_row(first_elem_ord);
+    entry->set_num_rows(num_elems_in_block);
+    file_stats_->Merge(*block_stats_);
+    block_stats_->FinishToPB(entry);
+  }
+
   if (validx_builder_ != nullptr) {
     RETURN_NOT_OK(data_block_->GetLastKey(key_tmp_space));
     (*options_.validx_key_encoder)(key_tmp_space, &last_key_);
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "kudu/cfile/cfile_util.h"
+#include "kudu/cfile/zone_map.h"
 #include "kudu/common/rowid.h"
 #include "kudu/fs/block_id.h"
 #include "kudu/fs/block_manager.h"
@@ -175,6 +176,13 @@ class CFileWriter {
     return value_count_;
   }
 
+  // Sets 'stats' to the statistics of all the cells written to the file,
+  // with 'num_rows' set to the number of cells. Returns false if the writer
+  // isn't writing a zone map, in which case no statistics are gathered.
+  //
+  // Only valid once the file has been finished.
+  bool GetFileStats(ZoneMapEntryPB* stats) const;
+
   std::string ToString() const { return block_->id().ToString(); }
 
   fs::WritableBlock* block() const { return block_.get(); }
@@ -239,6 +247,13 @@ class CFileWriter {
   gscoped_ptr<NullBitmapBuilder> null_bitmap_builder_;
   gscoped_ptr<CompressedBlockBuilder> block_compressor_;
 
+  // Statistics of the current data block and of the whole file, and the zone
+  // map entries of the blocks written so far. Only set if the writer is
+  // writing a zone map.
+  gscoped_ptr<CellStatsAccumulator> block_stats_;
+  gscoped_ptr<CellStatsAccumulator> file_stats_;
+  ZoneMapPB zone_map_;
+
   enum State {
     kWriterInitialized,
     kWriterWriting,
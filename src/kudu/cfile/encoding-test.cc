@@ -40,8 +40,11 @@
 #include "kudu/cfile/plain_bitmap_block.h"
 #include "kudu/cfile/plain_block.h"
 #include "kudu/cfile/rle_block.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -677,6 +680,52 @@ class TestEncoding : public KuduTest {
     }
   }
 
+  // Test evaluating 'pred' while decoding a block of 'count' 'values' with
+  // CopyNextAndEval(), in randomly sized batches, with every seventh row
+  // deselected beforehand.
+  template <class BuilderType, class DecoderType, DataType Type>
+  void TestCopyNextAndEval(const typename TypeTraits<Type>::cpp_type* values,
+                           size_t count,
+                           const ColumnPredicate& pred) {
+    typedef typename TypeTraits<Type>::cpp_type CppType;
+    unique_ptr<WriterOptions> opts(NewWriterOptions());
+    BuilderType builder(opts.get());
+    builder.Add(reinterpret_cast<const uint8_t*>(values), count);
+    Slice s = builder.Finish(0);
+
+    DecoderType decoder(s);
+    ASSERT_OK(decoder.ParseHeader());
+
+    unique_ptr<CppType[]> decoded(new CppType[count]);
+    ColumnBlock dst_block(GetTypeInfo(Type), nullptr, decoded.get(), count, &arena_);
+    SelectionVector sel(count);
+    sel.SetAllTrue();
+    for (size_t i = 0; i < count; i += 7) {
+      sel.SetRowUnselected(i);
+    }
+    ColumnMaterializationContext ctx(0, &pred, &dst_block, &sel);
+    SelectionVectorView sel_view(&sel);
+
+    size_t dec_count = 0;
+    while (decoder.HasNext()) {
+      size_t n = std::min(count - dec_count, static_cast<size_t>((random() % 300) + 1));
+      ColumnDataView dst_data(&dst_block, dec_count);
+      ASSERT_OK_FAST(decoder.CopyNextAndEval(&n, &ctx, &sel_view, &dst_data));
+      ASSERT_FALSE(ctx.DecoderEvalNotSupported());
+      dec_count += n;
+      sel_view.Advance(n);
+    }
+    ASSERT_EQ(count, dec_count);
+
+    for (size_t i = 0; i < count; i++) {
+      bool expected = i % 7 != 0 && pred.EvaluateCell(Type, &values[i]);
+      ASSERT_EQ(expected, sel.IsRowSelected(i)) << "row " << i;
+      if (expected) {
+        ASSERT_EQ(values[i], decoded[i]) << "row " << i;
+      }
+    }
+  }
+
   Arena arena_;
 };
 
@@ -783,6 +832,18 @@ TEST_F(TestEncoding, TestRleBitMapRoundTrip) {
   TestBoolBlockRoundTrip<RleBitMapBlockBuilder, RleBitMapBlockDecoder>();
 }
 
+TEST_F(TestEncoding, TestRleBitMapCopyNextAndEval) {
+  const size_t kSize = 10000;
+  unique_ptr<bool[]> values(new bool[kSize]);
+  for (size_t i = 0; i < kSize; i++) {
+    values[i] = (i / 50) % 3 == 0;
+  }
+  bool val = true;
+  ColumnPredicate pred = ColumnPredicate::Equality(ColumnSchema("c", BOOL), &val);
+  TestCopyNextAndEval<RleBitMapBlockBuilder, RleBitMapBlockDecoder, BOOL>(
+      values.get(), kSize, pred);
+}
+
 // Test seeking to a value in a small block.
 // Regression test for a bug seen in development where this would
 // infinite loop when there are no 'restarts' in a given block.
@@ -882,6 +943,24 @@ class IntEncodingTest : public TestEncoding {
     }
   }
 
+  // Evaluates a range predicate over a low-cardinality block, with runs of
+  // identical values, while decoding it.
+  template <DataType IntType>
+  void DoIntCopyNextAndEvalTest() {
+    typedef typename TestTraits::template Classes<IntType>::encoder_type encoder_type;
+    typedef typename TestTraits::template Classes<IntType>::decoder_type decoder_type;
+    typedef typename TypeTraits<IntType>::cpp_type CppType;
+
+    vector<CppType> values;
+    for (int i = 0; i < 10000; i++) {
+      values.push_back(random() % 3 == 0 ? random() % 10 : (i / 40) % 10);
+    }
+    CppType lower = 3;
+    CppType upper = 7;
+    ColumnPredicate pred = ColumnPredicate::Range(ColumnSchema("c", IntType), &lower, &upper);
+    TestCopyNextAndEval<encoder_type, decoder_type, IntType>(&values[0], values.size(), pred);
+  }
+
   template <DataType IntType>
   void DoIntRoundTripTest() {
     typedef typename TestTraits::template Classes<IntType>::encoder_type encoder_type;
@@ -933,6 +1012,15 @@ TYPED_TEST(IntEncodingTest, TestRoundTrip) {
   // this->template DoIntRoundTripTest<INT128>();
 }
 
+TYPED_TEST(IntEncodingTest, TestCopyNextAndEval) {
+  this->template DoIntCopyNextAndEvalTest<UINT8>();
+  this->template DoIntCopyNextAndEvalTest<INT8>();
+  this->template DoIntCopyNextAndEvalTest<INT16>();
+  this->template DoIntCopyNextAndEvalTest<INT32>();
+  this->template DoIntCopyNextAndEvalTest<UINT32>();
+  this->template DoIntCopyNextAndEvalTest<INT64>();
+}
+
 #ifdef NDEBUG
 TYPED_TEST(IntEncodingTest, IntSeekBenchmark) {
   this->template DoIntSeekTest<INT32>(32768, 10000, false);
@@ -209,6 +209,31 @@ class PlainBlockDecoder final : public BlockDecoder {
     return Status::OK();
   }
 
+  // Evaluates the predicate directly against the values in the block, only
+  // copying the ones which satisfy it.
+  virtual Status CopyNextAndEval(size_t* n,
+                                 ColumnMaterializationContext* ctx,
+                                 SelectionVectorView* sel,
+                                 ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    ctx->SetDecoderEvalSupported();
+
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    EvalAndCopyMatching<Type>(*ctx->pred(),
+                              &data_[kPlainBlockHeaderSize + cur_idx_ * size_of_type],
+                              max_fetch, sel, dst->data());
+    cur_idx_ += max_fetch;
+    *n = max_fetch;
+    return Status::OK();
+  }
+
   virtual bool HasNext() const OVERRIDE {
     return cur_idx_ < num_elems_;
   }
@@ -24,7 +24,11 @@
 #include "kudu/gutil/port.h"
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/cfile_util.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/coding-inl.h"
 #include "kudu/util/hexdump.h"
@@ -42,6 +46,34 @@ enum {
   kRleBitmapBlockHeaderSize = 8
 };
 
+// Decodes the next 'n' values from 'decoder' a run at a time, evaluating
+// 'pred' once per run. The values of the runs which satisfy the predicate are
+// written to 'dst', and the rows of the runs which don't are deselected in
+// 'sel'.
+template<DataType Type>
+Status EvalRuns(const ColumnPredicate& pred,
+                RleDecoder<typename TypeTraits<Type>::cpp_type>* decoder,
+                size_t n,
+                SelectionVectorView* sel,
+                typename TypeTraits<Type>::cpp_type* dst) {
+  size_t idx = 0;
+  while (idx < n) {
+    typename TypeTraits<Type>::cpp_type val;
+    size_t run = decoder->GetNextRun(&val, n - idx);
+    if (PREDICT_FALSE(run == 0)) {
+      return Status::Corruption(strings::Substitute(
+          "unexpected end of RLE block: expected $0 more values", n - idx));
+    }
+    if (pred.EvaluateCell<TypeTraits<Type>::physical_type>(&val)) {
+      std::fill(dst + idx, dst + idx + run, val);
+    } else {
+      sel->ClearBits(idx, run);
+    }
+    idx += run;
+  }
+  return Status::OK();
+}
+
 //
 // RLE encoder for the BOOL datatype: uses an RLE-encoded bitmap to
 // represent a bool column.
@@ -192,6 +224,29 @@ class RleBitMapBlockDecoder final : public BlockDecoder {
     return Status::OK();
   }
 
+  // Evaluates the predicate once per run of identical values, only copying
+  // the runs which satisfy it.
+  virtual Status CopyNextAndEval(size_t* n,
+                                 ColumnMaterializationContext* ctx,
+                                 SelectionVectorView* sel,
+                                 ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(bool));
+    ctx->SetDecoderEvalSupported();
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    RETURN_NOT_OK(EvalRuns<BOOL>(*ctx->pred(), &rle_decoder_, to_fetch, sel,
+                                 reinterpret_cast<bool*>(dst->data())));
+    cur_idx_ += to_fetch;
+    *n = to_fetch;
+    return Status::OK();
+  }
+
   virtual Status SeekAtOrAfterValue(const void *value,
                                     bool *exact_match) OVERRIDE {
     return Status::NotSupported("BOOL keys are not supported!");
@@ -423,6 +478,29 @@ class RleIntBlockDecoder final : public BlockDecoder {
     return Status::OK();
   }
 
+  // Evaluates the predicate once per run of identical values, only copying
+  // the runs which satisfy it.
+  virtual Status CopyNextAndEval(size_t* n,
+                                 ColumnMaterializationContext* ctx,
+                                 SelectionVectorView* sel,
+                                 ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    ctx->SetDecoderEvalSupported();
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    RETURN_NOT_OK(EvalRuns<IntType>(*ctx->pred(), &rle_decoder_, to_fetch, sel,
+                                    reinterpret_cast<CppType*>(dst->data())));
+    cur_idx_ += to_fetch;
+    *n = to_fetch;
+    return Status::OK();
+  }
+
   virtual bool HasNext() const OVERRIDE {
     return cur_idx_ < num_elems_;
   }
@@ -0,0 +1,223 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/zone_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include <glog/logging.h>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/pb_util.h"
+
+using std::string;
+using std::unique_ptr;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+// Binary bounds longer than this aren't stored verbatim: a lower bound is
+// truncated to a prefix, which is still a lower bound, and an upper bound is
+// left out.
+static const size_t kMaxBinaryBoundLength = 64;
+
+CellStatsAccumulator::CellStatsAccumulator(const TypeInfo* type_info)
+    : type_info_(type_info),
+      is_binary_(type_info->physical_type() == BINARY),
+      is_floating_point_(type_info->physical_type() == FLOAT ||
+                         type_info->physical_type() == DOUBLE) {
+  DCHECK_LE(type_info->size(), sizeof(min_));
+  Reset();
+}
+
+void CellStatsAccumulator::Reset() {
+  has_values_ = false;
+  bounds_unknown_ = false;
+  null_count_ = 0;
+}
+
+void CellStatsAccumulator::SetBound(const void* cell, uint8_t* bound, faststring* data) {
+  if (is_binary_) {
+    const Slice* s = reinterpret_cast<const Slice*>(cell);
+    data->assign_copy(s->data(), s->size());
+    Slice copy(*data);
+    memcpy(bound, &copy, sizeof(copy));
+  } else {
+    memcpy(bound, cell, type_info_->size());
+  }
+}
+
+void CellStatsAccumulator::AddValues(const void* cells, size_t count) {
+  if (count == 0 || bounds_unknown_) return;
+  const uint8_t* cell = reinterpret_cast<const uint8_t*>(cells);
+  const size_t size = type_info_->size();
+  for (size_t i = 0; i < count; i++, cell += size) {
+    // NaN compares equal to every value, so a block holding one has no
+    // meaningful bounds.
+    if (is_floating_point_ &&
+        (type_info_->physical_type() == FLOAT ?
+         std::isnan(*reinterpret_cast<const float*>(cell)) :
+         std::isnan(*reinterpret_cast<const double*>(cell)))) {
+      bounds_unknown_ = true;
+      return;
+    }
+    if (!has_values_) {
+      SetBound(cell, min_, &min_data_);
+      SetBound(cell, max_, &max_data_);
+      has_values_ = true;
+      continue;
+    }
+    if (type_info_->Compare(cell, min_) < 0) {
+      SetBound(cell, min_, &min_data_);
+    } else if (type_info_->Compare(cell, max_) > 0) {
+      SetBound(cell, max_, &max_data_);
+    }
+  }
+}
+
+bool CellStatsAccumulator::EncodeBound(const uint8_t* bound, bool is_min, string* value) const {
+  if (!is_binary_) {
+    value->assign(reinterpret_cast<const char*>(bound), type_info_->size());
+    return true;
+  }
+  const Slice* s = reinterpret_cast<const Slice*>(bound);
+  if (s->size() > kMaxBinaryBoundLength) {
+    if (!is_min) return false;
+    value->assign(reinterpret_cast<const char*>(s->data()), kMaxBinaryBoundLength);
+    return true;
+  }
+  value->assign(reinterpret_cast<const char*>(s->data()), s->size());
+  return true;
+}
+
+void CellStatsAccumulator::Merge(const CellStatsAccumulator& other) {
+  DCHECK_EQ(type_info_, other.type_info_);
+  null_count_ += other.null_count_;
+  if (other.bounds_unknown_) {
+    bounds_unknown_ = true;
+  } else if (other.has_values_) {
+    AddValues(other.min_, 1);
+    AddValues(other.max_, 1);
+  }
+}
+
+void CellStatsAccumulator::ToPB(ZoneMapEntryPB* pb) const {
+  pb->set_null_count(null_count_);
+  if (has_values_ && !bounds_unknown_) {
+    if (!EncodeBound(min_, true, pb->mutable_min_value())) {
+      pb->clear_min_value();
+    }
+    if (!EncodeBound(max_, false, pb->mutable_max_value())) {
+      pb->clear_max_value();
+    }
+  }
+}
+
+Status ZoneMap::Parse(const TypeInfo* type_info,
+                      const Slice& data,
+                      unique_ptr<ZoneMap>* zone_map) {
+  unique_ptr<ZoneMap> zm(new ZoneMap());
+  if (!zm->pb_.ParseFromArray(data.data(), data.size())) {
+    return Status::Corruption("unable to parse zone map");
+  }
+
+  const bool is_binary = type_info->physical_type() == BINARY;
+  const size_t cell_size = is_binary ? sizeof(Slice) : type_info->size();
+  const int num_entries = zm->pb_.entries_size();
+  zm->cells_size_ = 2 * cell_size * num_entries;
+  zm->cells_.reset(new uint8_t[zm->cells_size_]);
+  zm->blocks_.reserve(num_entries);
+  uint8_t* next_cell = zm->cells_.get();
+
+  // Points 'bound' at a cell in 'cells_' holding the contents of 'value'.
+  auto decode_bound = [&](const string& value, const void** bound) {
+    if (is_binary) {
+      Slice s(value);
+      memcpy(next_cell, &s, sizeof(s));
+    } else {
+      if (value.size() != cell_size) {
+        return Status::Corruption(Substitute("zone map bound of $0 bytes for a $1 column",
+                                             value.size(), type_info->name()));
+      }
+      memcpy(next_cell, value.data(), cell_size);
+    }
+    *bound = next_cell;
+    next_cell += cell_size;
+    return Status::OK();
+  };
+
+  rowid_t next_row = 0;
+  for (const ZoneMapEntryPB& entry : zm->pb_.entries()) {
+    if (entry.first_row() < next_row || entry.null_count() > entry.num_rows()) {
+      return Status::Corruption("invalid zone map entry",
+                                pb_util::SecureShortDebugString(entry));
+    }
+    Block block;
+    block.first_row = entry.first_row();
+    block.num_rows = entry.num_rows();
+    block.null_count = entry.null_count();
+    block.min = nullptr;
+    block.max = nullptr;
+    if (entry.has_min_value()) {
+      RETURN_NOT_OK(decode_bound(entry.min_value(), &block.min));
+    }
+    if (entry.has_max_value()) {
+      RETURN_NOT_OK(decode_bound(entry.max_value(), &block.max));
+    }
+    zm->blocks_.push_back(block);
+    next_row = block.first_row + block.num_rows;
+  }
+  *zone_map = std::move(zm);
+  return Status::OK();
+}
+
+bool ZoneMap::FindBlock(rowid_t row, size_t* idx) const {
+  auto it = std::upper_bound(blocks_.begin(), blocks_.end(), row,
+                             [](rowid_t r, const Block& b) { return r < b.first_row; });
+  if (it == blocks_.begin()) return false;
+  --it;
+  if (row >= it->first_row + it->num_rows) return false;
+  *idx = it - blocks_.begin();
+  return true;
+}
+
+bool ZoneMap::MayMatch(size_t idx, const ColumnPredicate& pred) const {
+  const Block& block = blocks_[idx];
+  switch (pred.predicate_type()) {
+    case PredicateType::IsNull:
+      return block.null_count > 0;
+    case PredicateType::IsNotNull:
+      return block.null_count < block.num_rows;
+    default:
+      if (block.null_count == block.num_rows) return false;
+      return pred.MayBeSatisfiedByRange(block.min, block.max);
+  }
+}
+
+size_t ZoneMap::memory_footprint() const {
+  return sizeof(*this) + pb_.SpaceUsed() + blocks_.capacity() * sizeof(Block) +
+      cells_size_;
+}
+
+} // namespace cfile
+} // namespace kudu
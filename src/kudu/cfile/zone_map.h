@@ -0,0 +1,160 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_ZONE_MAP_H
+#define KUDU_CFILE_ZONE_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ColumnPredicate;
+class TypeInfo;
+
+namespace cfile {
+
+// Accumulates the lowest and highest values and the number of NULLs among
+// a set of cells, e.g. those of a single data block.
+class CellStatsAccumulator {
+ public:
+  explicit CellStatsAccumulator(const TypeInfo* type_info);
+
+  // Folds the 'count' non-NULL cells at 'cells' into the statistics.
+  void AddValues(const void* cells, size_t count);
+
+  // Folds 'count' NULL cells into the statistics.
+  void AddNulls(size_t count) {
+    null_count_ += count;
+  }
+
+  // Folds the statistics gathered by 'other', which must describe cells of
+  // the same type, into these statistics.
+  void Merge(const CellStatsAccumulator& other);
+
+  // Writes the statistics to 'pb', leaving out bounds which are unknown or
+  // too long to store.
+  void ToPB(ZoneMapEntryPB* pb) const;
+
+  // Like ToPB(), but also resets the accumulator.
+  void FinishToPB(ZoneMapEntryPB* pb) {
+    ToPB(pb);
+    Reset();
+  }
+
+ private:
+  void Reset();
+
+  // Replaces 'bound' with 'cell', copying any indirect data into 'data'.
+  void SetBound(const void* cell, uint8_t* bound, faststring* data);
+
+  // Writes 'bound' to 'value', or returns false if it can't be stored.
+  bool EncodeBound(const uint8_t* bound, bool is_min, std::string* value) const;
+
+  const TypeInfo* const type_info_;
+  const bool is_binary_;
+  const bool is_floating_point_;
+
+  // Whether any non-NULL cell has been added.
+  bool has_values_;
+
+  // Whether the bounds are unknown, e.g. because a NaN was added.
+  bool bounds_unknown_;
+
+  size_t null_count_;
+
+  // The lowest and highest cells seen so far. For binary columns, these hold
+  // Slices pointing into 'min_data_' and 'max_data_' respectively.
+  alignas(16) uint8_t min_[16];
+  alignas(16) uint8_t max_[16];
+  faststring min_data_;
+  faststring max_data_;
+
+  DISALLOW_COPY_AND_ASSIGN(CellStatsAccumulator);
+};
+
+// The parsed zone map of a CFile: per-data-block statistics which let a
+// reader skip blocks none of whose cells can satisfy a predicate.
+//
+// This class is immutable, and thus thread-safe.
+class ZoneMap {
+ public:
+  // Parses a serialized ZoneMapPB describing cells of 'type_info'.
+  static Status Parse(const TypeInfo* type_info,
+                      const Slice& data,
+                      std::unique_ptr<ZoneMap>* zone_map);
+
+  // Finds the block containing the row with ordinal 'row', setting '*idx' to
+  // its index. Returns false if no block contains the row.
+  bool FindBlock(rowid_t row, size_t* idx) const;
+
+  // Returns false if none of the cells of the block at index 'idx' can
+  // satisfy 'pred', which must be a predicate on this file's column.
+  bool MayMatch(size_t idx, const ColumnPredicate& pred) const;
+
+  size_t num_blocks() const {
+    return blocks_.size();
+  }
+
+  rowid_t first_row(size_t idx) const {
+    return blocks_[idx].first_row;
+  }
+
+  uint32_t num_rows(size_t idx) const {
+    return blocks_[idx].num_rows;
+  }
+
+  size_t memory_footprint() const;
+
+ private:
+  struct Block {
+    rowid_t first_row;
+    uint32_t num_rows;
+    uint32_t null_count;
+
+    // The bounds of the block's non-NULL cells, or null if unknown. For
+    // binary columns these point to Slices in 'cells_'.
+    const void* min;
+    const void* max;
+  };
+
+  ZoneMap() {}
+
+  ZoneMapPB pb_;
+  std::vector<Block> blocks_;
+
+  // Backing storage for the bounds of the blocks: the cells of fixed-length
+  // columns, or Slices into 'pb_' for binary columns.
+  std::unique_ptr<uint8_t[]> cells_;
+  size_t cells_size_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ZoneMap);
+};
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
@@ -28,6 +28,7 @@
 #include <utility>
 #include <vector>
 
+#include <boost/bind.hpp> // IWYU pragma: keep
 #include <glog/logging.h>
 
 #include "kudu/client/callbacks.h"
@@ -92,6 +93,7 @@ using rpc::ResponseCallback;
 using rpc::RetriableRpc;
 using rpc::RetriableRpcStatus;
 using rpc::Rpc;
+using rpc::RequestIdPB;
 using rpc::RpcController;
 using rpc::ServerPicker;
 using tserver::WriteRequestPB;
@@ -181,8 +183,9 @@ struct InFlightOp {
     // it will enter this state.
     //
     // OWNERSHIP: when entering this state, the op is removed from 'per_tablet_ops' map
-    // and ownership is transfered to a WriteRPC's 'ops_' vector. The op still
-    // remains in the 'ops_' set.
+    // and ownership is transfered to a WriteRPC's 'ops_' vector, or to a
+    // MultiWriteRpc which later hands it over to a WriteRpc if its batch needs
+    // to be retried. The op still remains in the 'ops_' set.
     kRequestSent
   };
   State state;
@@ -227,6 +230,14 @@ class WriteRpc : public RetriableRpc<RemoteTabletServer, WriteRequestPB, WriteRe
   virtual ~WriteRpc();
   string ToString() const override;
 
+  // Fills in 'req' with a write of 'ops' to the given tablet, moving the ops
+  // to the kRequestSent state.
+  static void EncodeRequest(const Batcher& batcher,
+                            const string& tablet_id,
+                            const vector<InFlightOp*>& ops,
+                            uint64_t propagated_timestamp,
+                            WriteRequestPB* req);
+
   const KuduTable* table() const {
     // All of the ops for a given tablet obviously correspond to the same table,
     // so we'll just grab the table from the first.
@@ -255,50 +266,49 @@ class WriteRpc : public RetriableRpc<RemoteTabletServer, WriteRequestPB, WriteRe
   string tablet_id_;
 };
 
-WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
-                   const scoped_refptr<MetaCacheServerPicker>& replica_picker,
-                   const scoped_refptr<RequestTracker>& request_tracker,
-                   vector<InFlightOp*> ops,
-                   const MonoTime& deadline,
-                   shared_ptr<Messenger> messenger,
-                   const string& tablet_id,
-                   uint64_t propagated_timestamp)
-    : RetriableRpc(replica_picker, request_tracker, deadline, std::move(messenger)),
-      batcher_(batcher),
-      ops_(std::move(ops)),
-      tablet_id_(tablet_id) {
-  const Schema* schema = table()->schema().schema_;
-
-  req_.set_tablet_id(tablet_id_);
-  switch (batcher->external_consistency_mode()) {
+void WriteRpc::EncodeRequest(const Batcher& batcher,
+                             const string& tablet_id,
+                             const vector<InFlightOp*>& ops,
+                             uint64_t propagated_timestamp,
+                             WriteRequestPB* req) {
+  // All of the ops for a given tablet obviously correspond to the same table,
+  // so we'll just grab the table from the first.
+  const KuduTable* table = ops[0]->write_op->table();
+  const Schema* schema = table->schema().schema_;
+
+  req->set_tablet_id(tablet_id);
+  switch (batcher.external_consistency_mode()) {
     case kudu::client::KuduSession::CLIENT_PROPAGATED:
-      req_.set_external_consistency_mode(kudu::CLIENT_PROPAGATED);
+      req->set_external_consistency_mode(kudu::CLIENT_PROPAGATED);
       break;
     case kudu::client::KuduSession::COMMIT_WAIT:
-      req_.set_external_consistency_mode(kudu::COMMIT_WAIT);
+      req->set_external_consistency_mode(kudu::COMMIT_WAIT);
       break;
     default:
-      LOG(FATAL) << "Unsupported consistency mode: " << batcher->external_consistency_mode();
+      LOG(FATAL) << "Unsupported consistency mode: " << batcher.external_consistency_mode();
 
   }
   // If set, propagate the latest observed timestamp.
   if (PREDICT_TRUE(propagated_timestamp != KuduClient::kNoTimestamp)) {
-    req_.set_propagated_timestamp(propagated_timestamp);
+    req->set_propagated_timestamp(propagated_timestamp);
+  }
+  if (batcher.bulk_load()) {
+    req->set_bulk_load(true);
   }
 
   // Set up schema
-  CHECK_OK(SchemaToPB(*schema, req_.mutable_schema(),
+  CHECK_OK(SchemaToPB(*schema, req->mutable_schema(),
                       SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES | SCHEMA_PB_WITHOUT_IDS));
 
-  RowOperationsPB* requested = req_.mutable_row_operations();
+  RowOperationsPB* requested = req->mutable_row_operations();
 
   // Add the rows
   int ctr = 0;
   RowOperationsPBEncoder enc(requested);
-  for (InFlightOp* op : ops_) {
+  for (InFlightOp* op : ops) {
 #ifndef NDEBUG
     const Partition& partition = op->tablet->partition();
-    const PartitionSchema& partition_schema = table()->partition_schema();
+    const PartitionSchema& partition_schema = table->partition_schema();
     const KuduPartialRow& row = op->write_op->row();
     bool partition_contains_row;
     CHECK(partition_schema.PartitionContainsRow(partition, row, &partition_contains_row).ok());
@@ -318,10 +328,25 @@ WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
   }
 
   if (VLOG_IS_ON(3)) {
-    VLOG(3) << "Created batch for " << tablet_id << ":\n" << SecureShortDebugString(req_);
+    VLOG(3) << "Created batch for " << tablet_id << ":\n" << SecureShortDebugString(*req);
   }
 }
 
+WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
+                   const scoped_refptr<MetaCacheServerPicker>& replica_picker,
+                   const scoped_refptr<RequestTracker>& request_tracker,
+                   vector<InFlightOp*> ops,
+                   const MonoTime& deadline,
+                   shared_ptr<Messenger> messenger,
+                   const string& tablet_id,
+                   uint64_t propagated_timestamp)
+    : RetriableRpc(replica_picker, request_tracker, deadline, std::move(messenger)),
+      batcher_(batcher),
+      ops_(std::move(ops)),
+      tablet_id_(tablet_id) {
+  EncodeRequest(*batcher.get(), tablet_id_, ops_, propagated_timestamp, &req_);
+}
+
 WriteRpc::~WriteRpc() {
   STLDeleteElements(&ops_);
 }
@@ -347,7 +372,7 @@ void WriteRpc::Finish(const Status& status) {
                    ops_.size(), tablet_id_, num_attempts()));
     KLOG_EVERY_N_SECS(WARNING, 1) << final_status.ToString();
   }
-  batcher_->ProcessWriteResponse(*this, final_status);
+  batcher_->ProcessWriteResponse(tablet_id_, ops_, resp_, final_status);
 }
 
 RetriableRpcStatus WriteRpc::AnalyzeResponse(const Status& rpc_cb_status) {
@@ -367,12 +392,14 @@ RetriableRpcStatus WriteRpc::AnalyzeResponse(const Status& rpc_cb_status) {
         (err->code() == ErrorStatusPB::ERROR_SERVER_TOO_BUSY ||
          err->code() == ErrorStatusPB::ERROR_UNAVAILABLE)) {
       result.result = RetriableRpcStatus::SERVICE_UNAVAILABLE;
+      batcher_->MarkHadBackpressure();
       return result;
     }
   }
 
   if (result.status.IsServiceUnavailable()) {
     result.result = RetriableRpcStatus::SERVICE_UNAVAILABLE;
+    batcher_->MarkHadBackpressure();
     return result;
   }
 
@@ -452,21 +479,186 @@ bool WriteRpc::GetNewAuthnTokenAndRetry() {
   return true;
 }
 
+// A MultiWrite RPC carrying the ops for several tablets whose leader replicas
+// are hosted by the same tablet server, one write batch per tablet.
+//
+// Each batch is sent with a request id of its own, so that the tablet server
+// tracks its result just as if it had been sent in a WriteRpc. The RPC itself
+// isn't retried: a batch which doesn't come back successfully is handed over
+// to a WriteRpc under the same sequence number, which then goes through the
+// usual leader lookup and retry logic. Batches which were applied are thus
+// never applied twice.
+//
+// Keeps a reference on the owning batcher while alive.
+class MultiWriteRpc : public Rpc {
+ public:
+  // The ops for one tablet, and the sequence number of their batch.
+  struct TabletOps {
+    RemoteTablet* tablet;
+    vector<InFlightOp*> ops;
+    RequestTracker::SequenceNumber seq_no;
+  };
+
+  MultiWriteRpc(const scoped_refptr<Batcher>& batcher,
+                RemoteTabletServer* ts,
+                const scoped_refptr<RequestTracker>& request_tracker,
+                vector<TabletOps> tablet_ops,
+                const MonoTime& deadline,
+                shared_ptr<Messenger> messenger,
+                uint64_t propagated_timestamp);
+  virtual ~MultiWriteRpc();
+
+  void SendRpc() override;
+  string ToString() const override;
+
+ private:
+  // Called once the proxy to the tablet server is set up.
+  void InitProxyCb(const Status& status);
+
+  void SendRpcCb(const Status& status) override;
+
+  // Pointer back to the batcher. Processes the write responses when the RPC
+  // completes, regardless of success or failure.
+  scoped_refptr<Batcher> batcher_;
+
+  // The tablet server hosting the leader replicas of the tablets.
+  RemoteTabletServer* const ts_;
+
+  scoped_refptr<RequestTracker> request_tracker_;
+
+  // The ops for each tablet, in the order of the batches in 'req_'.
+  // These operations are in kRequestSent state.
+  vector<TabletOps> tablet_ops_;
+
+  tserver::MultiWriteRequestPB req_;
+  tserver::MultiWriteResponsePB resp_;
+};
+
+MultiWriteRpc::MultiWriteRpc(const scoped_refptr<Batcher>& batcher,
+                             RemoteTabletServer* ts,
+                             const scoped_refptr<RequestTracker>& request_tracker,
+                             vector<TabletOps> tablet_ops,
+                             const MonoTime& deadline,
+                             shared_ptr<Messenger> messenger,
+                             uint64_t propagated_timestamp)
+    : Rpc(deadline, std::move(messenger)),
+      batcher_(batcher),
+      ts_(ts),
+      request_tracker_(request_tracker),
+      tablet_ops_(std::move(tablet_ops)) {
+  for (TabletOps& t : tablet_ops_) {
+    CHECK_OK(request_tracker_->NewSeqNo(&t.seq_no));
+    tserver::MultiWriteRequestPB::TabletWritePB* write = req_.add_writes();
+    WriteRpc::EncodeRequest(*batcher.get(), t.tablet->tablet_id(), t.ops,
+                            propagated_timestamp, write->mutable_request());
+    RequestIdPB* request_id = write->mutable_request_id();
+    request_id->set_client_id(request_tracker_->client_id());
+    request_id->set_seq_no(t.seq_no);
+    request_id->set_attempt_no(0);
+  }
+}
+
+MultiWriteRpc::~MultiWriteRpc() {
+  for (TabletOps& t : tablet_ops_) {
+    STLDeleteElements(&t.ops);
+  }
+}
+
+string MultiWriteRpc::ToString() const {
+  return Substitute("MultiWrite(tablet server: $0, num_tablets: $1)",
+                    ts_->ToString(), tablet_ops_.size());
+}
+
+void MultiWriteRpc::SendRpc() {
+  ts_->InitProxy(batcher_->client_, Bind(&MultiWriteRpc::InitProxyCb, Unretained(this)));
+}
+
+void MultiWriteRpc::InitProxyCb(const Status& status) {
+  if (PREDICT_FALSE(!status.ok())) {
+    SendRpcCb(status);
+    return;
+  }
+  // Set the watermark of incomplete requests only now, right before sending,
+  // as a WriteRpc does.
+  const RequestTracker::SequenceNumber first_incomplete = request_tracker_->FirstIncomplete();
+  for (auto& write : *req_.mutable_writes()) {
+    write.mutable_request_id()->set_first_incomplete_seq_no(first_incomplete);
+  }
+  RpcController* controller = mutable_retrier()->mutable_controller();
+  controller->RequireServerFeature(tserver::TabletServerFeatures::MULTI_WRITE);
+  VLOG(2) << "Writing batches for " << tablet_ops_.size() << " tablets to "
+          << ts_->ToString();
+  ts_->proxy()->MultiWriteAsync(req_, &resp_, controller,
+                                boost::bind(&MultiWriteRpc::SendRpcCb, this, Status::OK()));
+}
+
+void MultiWriteRpc::SendRpcCb(const Status& status) {
+  unique_ptr<MultiWriteRpc> this_instance(this);
+  Status s = status;
+  if (s.ok()) {
+    s = retrier().controller().status();
+  }
+  if (s.IsRemoteError()) {
+    const ErrorStatusPB* err = retrier().controller().error_response();
+    if (err && err->unsupported_feature_flags_size() > 0) {
+      // Don't bother the server with MultiWrite RPCs again.
+      ts_->MarkMultiWriteUnsupported();
+    } else if (err && err->has_code() &&
+               (err->code() == ErrorStatusPB::ERROR_SERVER_TOO_BUSY ||
+                err->code() == ErrorStatusPB::ERROR_UNAVAILABLE)) {
+      batcher_->MarkHadBackpressure();
+    }
+  }
+  if (s.ok() && resp_.responses_size() != static_cast<int>(tablet_ops_.size())) {
+    s = Status::Corruption(Substitute("MultiWrite response has $0 batches, expected $1",
+                                      resp_.responses_size(), tablet_ops_.size()));
+  }
+  if (!s.ok()) {
+    VLOG(1) << ToString() << " failed, retrying its batches separately: " << s.ToString();
+  }
+
+  for (size_t i = 0; i < tablet_ops_.size(); i++) {
+    TabletOps& t = tablet_ops_[i];
+    if (s.ok() && !resp_.responses(i).has_error()) {
+      request_tracker_->RpcCompleted(t.seq_no);
+      batcher_->ProcessWriteResponse(t.tablet->tablet_id(), t.ops, resp_.responses(i),
+                                     Status::OK());
+      STLDeleteElements(&t.ops);
+      continue;
+    }
+    if (s.ok()) {
+      const tserver::TabletServerErrorPB& error = resp_.responses(i).error();
+      if (error.code() == tserver::TabletServerErrorPB::THROTTLED ||
+          StatusFromPB(error.status()).IsServiceUnavailable()) {
+        batcher_->MarkHadBackpressure();
+      }
+    }
+    // The WriteRpc takes over the ops.
+    batcher_->FlushBuffer(t.tablet, t.ops, t.seq_no);
+    t.ops.clear();
+  }
+}
+
 Batcher::Batcher(KuduClient* client,
                  scoped_refptr<ErrorCollector> error_collector,
                  sp::weak_ptr<KuduSession> session,
-                 kudu::client::KuduSession::ExternalConsistencyMode consistency_mode)
+                 kudu::client::KuduSession::ExternalConsistencyMode consistency_mode,
+                 bool bulk_load,
+                 bool coalesce_writes)
   : state_(kGatheringOps),
     client_(client),
     weak_session_(std::move(session)),
     consistency_mode_(consistency_mode),
+    bulk_load_(bulk_load),
+    coalesce_writes_(coalesce_writes),
     error_collector_(std::move(error_collector)),
     had_errors_(false),
     flush_callback_(nullptr),
     next_op_sequence_number_(0),
     timeout_(client->default_rpc_timeout()),
     outstanding_lookups_(0),
-    buffer_bytes_used_(0) {
+    buffer_bytes_used_(0),
+    had_backpressure_(false) {
 }
 
 void Batcher::Abort() {
@@ -562,6 +754,7 @@ void Batcher::FlushAsync(KuduStatusCallback* cb) {
     CHECK_EQ(state_, kGatheringOps);
     state_ = kFlushing;
     flush_callback_ = cb;
+    flush_start_time_ = MonoTime::Now();
     deadline_ = ComputeDeadlineUnlocked();
   }
 
@@ -738,7 +931,41 @@ void Batcher::FlushBuffersIfReady() {
     ops_copy.swap(per_tablet_ops_);
   }
 
-  // Now flush the ops for each tablet.
+  // If coalescing writes, group the tablets by the tablet server believed to
+  // host their leader replica.
+  unordered_map<RemoteTabletServer*, vector<MultiWriteRpc::TabletOps>> ops_per_ts;
+  if (coalesce_writes_) {
+    for (auto it = ops_copy.begin(); it != ops_copy.end();) {
+      RemoteTabletServer* ts = it->first->LeaderTServer();
+      if (ts && ts->MaySupportMultiWrite()) {
+        ops_per_ts[ts].push_back({ it->first, std::move(it->second),
+                                   RequestTracker::kNoSeqNo });
+        it = ops_copy.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (auto& e : ops_per_ts) {
+    vector<MultiWriteRpc::TabletOps>& tablet_ops = e.second;
+    if (tablet_ops.size() == 1) {
+      // Nothing to coalesce.
+      InsertOrDie(&ops_copy, tablet_ops[0].tablet, std::move(tablet_ops[0].ops));
+      continue;
+    }
+    VLOG(3) << "FlushBuffersIfReady: sending a MultiWrite for "
+            << tablet_ops.size() << " tablets to tablet server " << e.first->ToString();
+    MultiWriteRpc* rpc = new MultiWriteRpc(this,
+                                           e.first,
+                                           client_->data_->request_tracker_,
+                                           std::move(tablet_ops),
+                                           deadline_,
+                                           client_->data_->messenger_,
+                                           client_->data_->GetLatestObservedTimestamp());
+    rpc->SendRpc();
+  }
+
+  // Now flush the ops for each remaining tablet.
   for (const OpsMap::value_type& e : ops_copy) {
     RemoteTablet* tablet = e.first;
     const vector<InFlightOp*>& ops = e.second;
@@ -749,7 +976,8 @@ void Batcher::FlushBuffersIfReady() {
   }
 }
 
-void Batcher::FlushBuffer(RemoteTablet* tablet, const vector<InFlightOp*>& ops) {
+void Batcher::FlushBuffer(RemoteTablet* tablet, const vector<InFlightOp*>& ops,
+                          RequestTracker::SequenceNumber seq_no) {
   CHECK(!ops.empty());
 
   // Create and send an RPC that aggregates the ops. The RPC is freed when
@@ -772,10 +1000,16 @@ void Batcher::FlushBuffer(RemoteTablet* tablet, const vector<InFlightOp*>& ops)
                                client_->data_->messenger_,
                                tablet->tablet_id(),
                                client_->data_->GetLatestObservedTimestamp());
+  if (seq_no != RequestTracker::kNoSeqNo) {
+    // The batch was sent once already, in a MultiWrite RPC.
+    rpc->AdoptSequenceNumber(seq_no, 1);
+  }
   rpc->SendRpc();
 }
 
-void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
+void Batcher::ProcessWriteResponse(const string& tablet_id,
+                                   const vector<InFlightOp*>& ops,
+                                   const WriteResponsePB& resp,
                                    const Status& s) {
   // TODO: there is a potential race here -- if the Batcher gets destructed while
   // RPCs are in-flight, then accessing state_ will crash. We probably need to keep
@@ -784,12 +1018,12 @@ void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
   CHECK_EQ(state_, kFlushing);
 
   if (s.ok()) {
-    if (rpc.resp().has_timestamp()) {
-      client_->data_->UpdateLatestObservedTimestamp(rpc.resp().timestamp());
+    if (resp.has_timestamp()) {
+      client_->data_->UpdateLatestObservedTimestamp(resp.timestamp());
     }
   } else {
     // Mark each of the rows in the write op as failed, since the whole RPC failed.
-    for (InFlightOp* op : rpc.ops()) {
+    for (InFlightOp* op : ops) {
       unique_ptr<KuduError> error(new KuduError(op->write_op.release(), s));
       error_collector_->AddError(std::move(error));
     }
@@ -798,19 +1032,19 @@ void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
   }
 
   // Check individual row errors.
-  for (const WriteResponsePB_PerRowErrorPB& err_pb : rpc.resp().per_row_errors()) {
+  for (const WriteResponsePB_PerRowErrorPB& err_pb : resp.per_row_errors()) {
     // TODO(todd): handle case where we get one of the more specific TS errors
     // like the tablet not being hosted?
 
-    if (err_pb.row_index() >= rpc.ops().size()) {
+    if (err_pb.row_index() >= ops.size()) {
       LOG(ERROR) << "Received a per_row_error for an out-of-bound op index "
                  << err_pb.row_index() << " (sent only "
-                 << rpc.ops().size() << " ops)";
-      LOG(ERROR) << "Response from tablet " << rpc.tablet_id() << ":\n"
-                 << SecureDebugString(rpc.resp());
+                 << ops.size() << " ops)";
+      LOG(ERROR) << "Response from tablet " << tablet_id << ":\n"
+                 << SecureDebugString(resp);
       continue;
     }
-    gscoped_ptr<KuduWriteOperation> op = std::move(rpc.ops()[err_pb.row_index()]->write_op);
+    gscoped_ptr<KuduWriteOperation> op = std::move(ops[err_pb.row_index()]->write_op);
     VLOG(2) << "Error on op " << op->ToString() << ": "
             << SecureShortDebugString(err_pb.error());
     Status op_status = StatusFromPB(err_pb.error());
@@ -840,7 +1074,7 @@ void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
   //     from which the Flush() is being called.
   {
     std::lock_guard<simple_spinlock> l(lock_);
-    for (InFlightOp* op : rpc.ops()) {
+    for (InFlightOp* op : ops) {
       CHECK_EQ(1, ops_.erase(op))
             << "Could not remove op " << op->ToString()
             << " from in-flight list";
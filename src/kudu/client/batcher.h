@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -30,12 +31,18 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/rpc/request_tracker.h"
 #include "kudu/util/atomic.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
+
+namespace tserver {
+class WriteResponsePB;
+} // namespace tserver
+
 namespace client {
 
 class KuduStatusCallback;
@@ -45,7 +52,9 @@ namespace internal {
 struct InFlightOp;
 
 class ErrorCollector;
+class MultiWriteRpc;
 class RemoteTablet;
+class RemoteTabletServer;
 class WriteRpc;
 
 // A Batcher is the class responsible for collecting row operations, routing them to the
@@ -66,10 +75,15 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   // is to break circular dependencies (a session keeps a reference to its
   // current batcher) and make it possible to call notify a session
   // (if it's around) from a batcher which does its job using other threads.
+  //
+  // If 'coalesce_writes' is true, the ops for tablets whose leader replicas
+  // are hosted by the same tablet server are sent in a single RPC.
   Batcher(KuduClient* client,
           scoped_refptr<ErrorCollector> error_collector,
           client::sp::weak_ptr<KuduSession> session,
-          kudu::client::KuduSession::ExternalConsistencyMode consistency_mode);
+          kudu::client::KuduSession::ExternalConsistencyMode consistency_mode,
+          bool bulk_load,
+          bool coalesce_writes);
 
   // Abort the current batch. Any writes that were buffered and not yet sent are
   // discarded. Those that were sent may still be delivered.  If there is a pending Flush
@@ -110,6 +124,11 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
     return consistency_mode_;
   }
 
+  // Returns whether the session asked for this batch to be sent as a bulk load.
+  bool bulk_load() const {
+    return bulk_load_;
+  }
+
   // Get time of the first operation in the batch.  If no operations are in
   // there yet, the returned MonoTime object is not initialized
   // (i.e. MonoTime::Initialized() returns false).
@@ -118,12 +137,25 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
     return first_op_time_;
   }
 
+  // Get the time FlushAsync() was called. If the batcher hasn't been flushed
+  // yet, the returned MonoTime object is not initialized.
+  MonoTime flush_start_time() const {
+    std::lock_guard<simple_spinlock> l(lock_);
+    return flush_start_time_;
+  }
+
   // Return the total size (number of bytes) of all pending write operations
   // accumulated by the batcher.
   int64_t buffer_bytes_used() const {
     return buffer_bytes_used_.Load();
   }
 
+  // Returns whether any tablet server asked the batcher's writes to back off,
+  // i.e. rejected a write because it was throttling writes or was too busy.
+  bool had_backpressure() const {
+    return had_backpressure_.Load();
+  }
+
   // Compute in-buffer size for the given write operation.
   static int64_t GetOperationSizeInBuffer(KuduWriteOperation* write_op) {
     return write_op->SizeInBuffer();
@@ -131,6 +163,7 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
 
  private:
   friend class RefCountedThreadSafe<Batcher>;
+  friend class MultiWriteRpc;
   friend class WriteRpc;
 
   ~Batcher();
@@ -154,13 +187,25 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   void MarkInFlightOpFailed(InFlightOp* op, const Status& s);
   void MarkInFlightOpFailedUnlocked(InFlightOp* op, const Status& s);
 
+  // Records that a tablet server asked the batcher's writes to back off.
+  void MarkHadBackpressure() {
+    had_backpressure_.Store(true);
+  }
+
   void CheckForFinishedFlush();
   void FlushBuffersIfReady();
-  void FlushBuffer(RemoteTablet* tablet, const std::vector<InFlightOp*>& ops);
 
-  // Cleans up an RPC response, scooping out any errors and passing them up
-  // to the batcher.
-  void ProcessWriteResponse(const WriteRpc& rpc, const Status& s);
+  // Sends 'ops' to 'tablet' in a WriteRpc. If 'seq_no' is set, the RPC is a
+  // retry of a write batch which was sent once under that sequence number.
+  void FlushBuffer(RemoteTablet* tablet, const std::vector<InFlightOp*>& ops,
+                   rpc::RequestTracker::SequenceNumber seq_no = rpc::RequestTracker::kNoSeqNo);
+
+  // Cleans up the response to a write of 'ops' to the given tablet, scooping
+  // out any errors and passing them up to the batcher.
+  void ProcessWriteResponse(const std::string& tablet_id,
+                            const std::vector<InFlightOp*>& ops,
+                            const tserver::WriteResponsePB& resp,
+                            const Status& s);
 
   // Async Callbacks.
   void TabletLookupFinished(InFlightOp* op, const Status& s);
@@ -186,6 +231,13 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   // The consistency mode set in the session.
   kudu::client::KuduSession::ExternalConsistencyMode consistency_mode_;
 
+  // Whether the write requests are sent as bulk loads, as set in the session.
+  const bool bulk_load_;
+
+  // Whether the writes to tablets with the same leader tablet server are sent
+  // in a single RPC.
+  const bool coalesce_writes_;
+
   // Errors are reported into this error collector.
   scoped_refptr<ErrorCollector> error_collector_;
 
@@ -222,6 +274,10 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   // After flushing, the absolute deadline for all in-flight ops.
   MonoTime deadline_;
 
+  // The time FlushAsync() was called.
+  // Protected by lock_.
+  MonoTime flush_start_time_;
+
   // Number of outstanding lookups across all in-flight ops.
   //
   // Note: _not_ protected by lock_!
@@ -230,6 +286,9 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   // The number of bytes used in the buffer for pending operations.
   AtomicInt<int64_t> buffer_bytes_used_;
 
+  // Whether a tablet server asked the batcher's writes to back off.
+  AtomicBool had_backpressure_;
+
   DISALLOW_COPY_AND_ASSIGN(Batcher);
 };
 
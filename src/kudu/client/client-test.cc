@@ -45,6 +45,7 @@
 #include "kudu/client/client-test-util.h"
 #include "kudu/client/client.h"
 #include "kudu/client/client.pb.h"
+#include "kudu/client/columnar_scan_batch.h"
 #include "kudu/client/error_collector.h"
 #include "kudu/client/meta_cache.h"
 #include "kudu/client/resource_metrics.h"
@@ -81,6 +82,9 @@
 #include "kudu/master/mini_master.h"
 #include "kudu/mini-cluster/internal_mini_cluster.h"
 #include "kudu/rpc/messenger.h"
+#include "kudu/rpc/request_tracker.h"
+#include "kudu/rpc/result_tracker.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/service_pool.h"
 #include "kudu/security/tls_context.h"
 #include "kudu/security/token.pb.h"
@@ -95,6 +99,7 @@
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/async_util.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/locks.h"  // IWYU pragma: keep
 #include "kudu/util/metrics.h"
@@ -113,6 +118,7 @@ DECLARE_bool(allow_unsafe_replication_factor);
 DECLARE_bool(fail_dns_resolution);
 DECLARE_bool(log_inject_latency);
 DECLARE_bool(master_support_connect_to_master_rpc);
+DECLARE_bool(multi_write_inject_response_failure);
 DECLARE_bool(rpc_trace_negotiation);
 DECLARE_int32(flush_threshold_mb);
 DECLARE_int32(flush_threshold_secs);
@@ -129,16 +135,20 @@ DECLARE_int32(scanner_inject_latency_on_each_batch_ms);
 DECLARE_int32(scanner_max_batch_size_bytes);
 DECLARE_int32(scanner_ttl_ms);
 DECLARE_int32(table_locations_ttl_ms);
+DECLARE_int32(tablet_bulk_load_min_rows);
 DECLARE_string(superuser_acl);
 DECLARE_string(user_acl);
 DEFINE_int32(test_scan_num_rows, 1000, "Number of rows to insert and scan");
 
 METRIC_DECLARE_counter(block_manager_total_bytes_read);
+METRIC_DECLARE_counter(rows_inserted);
 METRIC_DECLARE_counter(rpcs_queue_overflow);
 METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetMasterRegistration);
 METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetTableLocations);
 METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetTabletLocations);
+METRIC_DECLARE_histogram(handler_latency_kudu_tserver_TabletServerService_MultiWrite);
 METRIC_DECLARE_histogram(handler_latency_kudu_tserver_TabletServerService_Scan);
+METRIC_DECLARE_histogram(handler_latency_kudu_tserver_TabletServerService_Write);
 
 using std::bind;
 using std::function;
@@ -164,6 +174,9 @@ using master::CatalogManager;
 using master::GetTableLocationsRequestPB;
 using master::GetTableLocationsResponsePB;
 using master::TabletLocationsPB;
+using rpc::RequestIdPB;
+using rpc::RequestTracker;
+using rpc::ResultTracker;
 using sp::shared_ptr;
 using tablet::TabletReplica;
 using tserver::MiniTabletServer;
@@ -1143,6 +1156,167 @@ TEST_F(ClientTest, TestScanEmptyProjection) {
   }
 }
 
+// Test scanning with the COLUMNAR_LAYOUT row format flag, and that the
+// columnar buffers hold the same data as the row-wise results would.
+TEST_F(ClientTest, TestScanColumnarLayout) {
+  const int kNumRows = 1000;
+  NO_FATALS(InsertTestRows(client_table_.get(), kNumRows));
+
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.SetProjectedColumnNames({ "key", "string_val" }));
+  ASSERT_OK(scanner.SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+  ASSERT_OK(scanner.Open());
+
+  // Row-wise batches can't be fetched from a columnar scanner.
+  KuduScanBatch rowwise_batch;
+  Status s = scanner.NextBatch(&rowwise_batch);
+  ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+
+  KuduColumnarScanBatch batch;
+  int total_rows = 0;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    Slice keys;
+    ASSERT_OK(batch.GetFixedLengthColumn(0, &keys));
+    ASSERT_EQ(batch.NumRows() * sizeof(int32_t), keys.size());
+    Slice offsets, strings, non_null;
+    ASSERT_OK(batch.GetVariableLengthColumn(1, &offsets, &strings));
+    ASSERT_OK(batch.GetNonNullBitmapForColumn(1, &non_null));
+
+    // Accessors check the column type and index.
+    Slice unused;
+    ASSERT_TRUE(batch.GetFixedLengthColumn(1, &unused).IsInvalidArgument());
+    ASSERT_TRUE(batch.GetVariableLengthColumn(0, &unused, &unused).IsInvalidArgument());
+    ASSERT_TRUE(batch.GetFixedLengthColumn(2, &unused).IsInvalidArgument());
+
+    const int32_t* key_cells = reinterpret_cast<const int32_t*>(keys.data());
+    const uint32_t* string_offsets = reinterpret_cast<const uint32_t*>(offsets.data());
+    for (int i = 0; i < batch.NumRows(); i++) {
+      ASSERT_TRUE(BitmapTest(non_null.data(), i));
+      Slice str(strings.data() + string_offsets[i], string_offsets[i + 1] - string_offsets[i]);
+      ASSERT_EQ(StringPrintf("hello %d", key_cells[i]), str.ToString());
+    }
+    total_rows += batch.NumRows();
+  }
+  ASSERT_EQ(kNumRows, total_rows);
+}
+
+// Test a columnar scan whose predicate leaves some batches empty, e.g. the
+// continuation batches which follow the last matching rows of a tablet.
+TEST_F(ClientTest, TestScanColumnarLayoutEmptyBatches) {
+  const int kNumRows = 1000;
+  NO_FATALS(InsertTestRows(client_table_.get(), kNumRows));
+
+  // Only rows 100 to 109 match.
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.SetProjectedColumnNames({ "key", "int_val" }));
+  ASSERT_OK(scanner.SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+  ASSERT_OK(scanner.SetBatchSizeBytes(1));
+  ASSERT_OK(scanner.AddConjunctPredicate(client_table_->NewComparisonPredicate(
+      "int_val", KuduPredicate::GREATER_EQUAL, KuduValue::FromInt(200))));
+  ASSERT_OK(scanner.AddConjunctPredicate(client_table_->NewComparisonPredicate(
+      "int_val", KuduPredicate::LESS_EQUAL, KuduValue::FromInt(218))));
+  ASSERT_OK(scanner.Open());
+
+  KuduColumnarScanBatch batch;
+  int total_rows = 0;
+  int empty_batches = 0;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    if (batch.NumRows() == 0) {
+      empty_batches++;
+      continue;
+    }
+    Slice keys;
+    ASSERT_OK(batch.GetFixedLengthColumn(0, &keys));
+    const int32_t* key_cells = reinterpret_cast<const int32_t*>(keys.data());
+    for (int i = 0; i < batch.NumRows(); i++) {
+      ASSERT_EQ(100 + total_rows + i, key_cells[i]);
+    }
+    total_rows += batch.NumRows();
+  }
+  ASSERT_EQ(10, total_rows);
+  ASSERT_GT(empty_batches, 0);
+}
+
+// Test scanning with an empty projection and the COLUMNAR_LAYOUT row format
+// flag: the batches have no columns, but the proper number of rows.
+TEST_F(ClientTest, TestScanColumnarLayoutEmptyProjection) {
+  const int kNumRows = 1000;
+  NO_FATALS(InsertTestRows(client_table_.get(), kNumRows));
+
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.SetProjectedColumnNames({}));
+  ASSERT_OK(scanner.SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+  ASSERT_OK(scanner.Open());
+
+  KuduColumnarScanBatch batch;
+  int64_t total_rows = 0;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    total_rows += batch.NumRows();
+  }
+  ASSERT_EQ(kNumRows, total_rows);
+}
+
+// Test that aggregates are evaluated by the tablet servers, and that the
+// partial aggregates of all tablets combine into the expected results.
+TEST_F(ClientTest, TestScanAggregates) {
+  const int kNumRows = 1000;
+  NO_FATALS(InsertTestRows(client_table_.get(), kNumRows));
+
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.AddAggregate(KuduScanner::COUNT, ""));
+  ASSERT_OK(scanner.AddAggregate(KuduScanner::SUM, "int_val"));
+  ASSERT_OK(scanner.AddAggregate(KuduScanner::MIN, "string_val"));
+  ASSERT_OK(scanner.AddAggregate(KuduScanner::MAX, "key"));
+  Status s = scanner.AddAggregate(KuduScanner::SUM, "string_val");
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  s = scanner.SetProjectedColumnNames({ "key" });
+  ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+
+  KuduSchema schema = scanner.GetProjectionSchema();
+  ASSERT_EQ(4, schema.num_columns());
+  ASSERT_EQ("count(*)", schema.Column(0).name());
+  ASSERT_EQ("sum(int_val)", schema.Column(1).name());
+  ASSERT_EQ(KuduColumnSchema::INT64, schema.Column(1).type());
+
+  ASSERT_OK(scanner.Open());
+  int64_t count = 0;
+  int64_t sum = 0;
+  string min_str;
+  int32_t max_key = -1;
+  int num_partials = 0;
+  KuduScanBatch batch;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    for (const KuduScanBatch::RowPtr& row : batch) {
+      num_partials++;
+      int64_t partial_count;
+      ASSERT_OK(row.GetInt64(0, &partial_count));
+      count += partial_count;
+      if (partial_count == 0) continue;
+      int64_t partial_sum;
+      ASSERT_OK(row.GetInt64(1, &partial_sum));
+      sum += partial_sum;
+      Slice partial_min;
+      ASSERT_OK(row.GetString(2, &partial_min));
+      if (min_str.empty() || partial_min.ToString() < min_str) {
+        min_str = partial_min.ToString();
+      }
+      int32_t partial_max;
+      ASSERT_OK(row.GetInt32(3, &partial_max));
+      max_key = std::max(max_key, partial_max);
+    }
+  }
+  // Each tablet returns one row of partial aggregates.
+  ASSERT_EQ(2, num_partials);
+  ASSERT_EQ(kNumRows, count);
+  ASSERT_EQ(static_cast<int64_t>(kNumRows) * (kNumRows - 1), sum);
+  ASSERT_EQ("hello 0", min_str);
+  ASSERT_EQ(kNumRows - 1, max_key);
+}
+
 TEST_F(ClientTest, TestProjectInvalidColumn) {
   KuduScanner scanner(client_table_.get());
   Status s = scanner.SetProjectedColumns({ "column-doesnt-exist" });
@@ -2231,6 +2405,177 @@ TEST_F(ClientTest, TestScannerKeepAlive) {
   ASSERT_EQ(sum, 499500);
 }
 
+// Test that a session in bulk load mode gets its rows written straight into
+// on-disk rowsets, and that the mode can't change while writes are buffered.
+TEST_F(ClientTest, TestBulkLoad) {
+  FLAGS_tablet_bulk_load_min_rows = 10;
+  const int kNumRows = 1000;
+  shared_ptr<KuduTable> table;
+  NO_FATALS(CreateTable("bulk_load_table", 1, {}, {}, &table));
+
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  session->SetTimeoutMillis(60000);
+  ASSERT_OK(session->SetBulkLoad(true));
+  NO_FATALS(InsertTestRows(table.get(), session.get(), kNumRows));
+  Status s = session->SetBulkLoad(false);
+  ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+  FlushSessionOrDie(session);
+
+  ASSERT_EQ(kNumRows, CountRowsFromClient(table.get()));
+  const string tablet_id = GetFirstTabletId(table.get());
+  int num_replicas = 0;
+  for (int i = 0; i < cluster_->num_tablet_servers(); i++) {
+    scoped_refptr<TabletReplica> tablet_replica;
+    if (cluster_->mini_tablet_server(i)->server()->tablet_manager()->LookupTablet(
+            tablet_id, &tablet_replica)) {
+      ASSERT_EQ(1, tablet_replica->tablet()->num_rowsets());
+      num_replicas++;
+    }
+  }
+  ASSERT_EQ(1, num_replicas);
+}
+
+// Test that with adaptive batching, the writes to the tablets hosted by the
+// same tablet server go out in one RPC, and that all of the rows get written.
+TEST_F(ClientTest, TestAdaptiveBatching) {
+  const auto& write_rpcs = METRIC_handler_latency_kudu_tserver_TabletServerService_Write
+      .Instantiate(cluster_->mini_tablet_server(0)->server()->metric_entity());
+  const auto& multi_write_rpcs =
+      METRIC_handler_latency_kudu_tserver_TabletServerService_MultiWrite
+      .Instantiate(cluster_->mini_tablet_server(0)->server()->metric_entity());
+
+  // Both of the table's tablets are hosted by the only tablet server, so a
+  // manual flush sends a single MultiWrite RPC.
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  session->SetTimeoutMillis(60000);
+  ASSERT_OK(session->SetAdaptiveBatching(true));
+  NO_FATALS(InsertTestRows(client_table_.get(), session.get(), 100));
+  Status s = session->SetAdaptiveBatching(false);
+  ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+  FlushSessionOrDie(session);
+  ASSERT_EQ(100, CountRowsFromClient(client_table_.get()));
+  ASSERT_EQ(0, write_rpcs->TotalCount());
+  ASSERT_EQ(1, multi_write_rpcs->TotalCount());
+
+  // Row errors are reported as usual.
+  NO_FATALS(InsertTestRows(client_table_.get(), session.get(), 10));
+  s = session->Flush();
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  ASSERT_EQ(10, session->CountPendingErrors());
+  ASSERT_EQ(0, write_rpcs->TotalCount());
+
+  // In AUTO_FLUSH_BACKGROUND mode, batches are sized adaptively.
+  session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+  session->SetTimeoutMillis(60000);
+  ASSERT_OK(session->SetAdaptiveBatching(true));
+  NO_FATALS(InsertTestRows(client_table_.get(), session.get(), 10000, 100));
+  FlushSessionOrDie(session);
+  ASSERT_EQ(10100, CountRowsFromClient(client_table_.get()));
+}
+
+// Test that the write batches of a MultiWrite RPC whose response is lost are
+// applied exactly once: the client retries each of them as a Write RPC under
+// the batch's sequence number, and the tablet server replays the result it
+// recorded for that sequence number rather than applying the batch again.
+TEST_F(ClientTest, TestAdaptiveBatchingRetriesExactlyOnce) {
+  MiniTabletServer* mts = cluster_->mini_tablet_server(0);
+  const auto& write_rpcs = METRIC_handler_latency_kudu_tserver_TabletServerService_Write
+      .Instantiate(mts->server()->metric_entity());
+  const auto& multi_write_rpcs =
+      METRIC_handler_latency_kudu_tserver_TabletServerService_MultiWrite
+      .Instantiate(mts->server()->metric_entity());
+
+  // The MultiWrite's batches take the next two sequence numbers, one per
+  // tablet of the table.
+  const scoped_refptr<RequestTracker>& request_tracker = client_->data_->request_tracker_;
+  RequestTracker::SequenceNumber seq_no;
+  ASSERT_OK(request_tracker->NewSeqNo(&seq_no));
+  request_tracker->RpcCompleted(seq_no);
+
+  FLAGS_multi_write_inject_response_failure = true;
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  session->SetTimeoutMillis(60000);
+  ASSERT_OK(session->SetAdaptiveBatching(true));
+  NO_FATALS(InsertTestRows(client_table_.get(), session.get(), 100));
+  // Had a batch been applied twice, its retry would have failed with
+  // AlreadyPresent errors.
+  FlushSessionOrDie(session);
+  ASSERT_EQ(1, multi_write_rpcs->TotalCount());
+  ASSERT_EQ(2, write_rpcs->TotalCount());
+  ASSERT_EQ(100, CountRowsFromClient(client_table_.get()));
+
+  int64_t rows_inserted = 0;
+  vector<scoped_refptr<TabletReplica>> replicas;
+  mts->server()->tablet_manager()->GetTabletReplicas(&replicas);
+  for (const auto& replica : replicas) {
+    if (replica->tablet_metadata()->table_id() == client_table_->id()) {
+      rows_inserted += METRIC_rows_inserted.Instantiate(
+          replica->tablet()->GetMetricEntity())->value();
+    }
+  }
+  ASSERT_EQ(100, rows_inserted);
+
+  // The result tracker holds the completed results of both batches, which the
+  // retries were answered with.
+  const scoped_refptr<ResultTracker>& result_tracker = mts->server()->result_tracker();
+  for (int i = 1; i <= 2; i++) {
+    RequestIdPB request_id;
+    request_id.set_client_id(request_tracker->client_id());
+    request_id.set_seq_no(seq_no + i);
+    request_id.set_first_incomplete_seq_no(seq_no + 1);
+    request_id.set_attempt_no(0);
+    ASSERT_EQ(ResultTracker::RpcState::COMPLETED,
+              result_tracker->TrackRpcOrChangeDriver(request_id));
+  }
+}
+
+// Test that scans which prefetch batches return every row exactly once, and
+// that scanners can be closed with batches left in their buffers.
+TEST_F(ClientTest, TestScanWithPrefetch) {
+  ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(), 1000));
+
+  for (int depth : { 1, 4 }) {
+    SCOPED_TRACE(depth);
+    KuduScanner scanner(client_table_.get());
+    // Make sure each tablet is scanned in many batches.
+    ASSERT_OK(scanner.SetBatchSizeBytes(100));
+    ASSERT_OK(scanner.SetPrefetchDepth(depth));
+    ASSERT_OK(scanner.Open());
+
+    KuduScanBatch batch;
+    set<int32_t> keys;
+    while (scanner.HasMoreRows()) {
+      ASSERT_OK(scanner.NextBatch(&batch));
+      for (const KuduScanBatch::RowPtr& row : batch) {
+        int32_t key;
+        ASSERT_OK(row.GetInt32(0, &key));
+        ASSERT_TRUE(keys.insert(key).second) << key;
+      }
+    }
+    ASSERT_EQ(1000, keys.size());
+    ASSERT_EQ(0, *keys.begin());
+    ASSERT_EQ(999, *keys.rbegin());
+  }
+
+  {
+    KuduScanner scanner(client_table_.get());
+    ASSERT_OK(scanner.SetBatchSizeBytes(100));
+    ASSERT_OK(scanner.SetPrefetchDepth(4));
+    ASSERT_OK(scanner.Open());
+    KuduScanBatch batch;
+    ASSERT_OK(scanner.NextBatch(&batch));
+    ASSERT_OK(scanner.NextBatch(&batch));
+    scanner.Close();
+  }
+
+  KuduScanner scanner(client_table_.get());
+  ASSERT_TRUE(scanner.SetPrefetchDepth(-1).IsInvalidArgument());
+}
+
 // Test cleanup of scanners on the server side when closed.
 TEST_F(ClientTest, TestCloseScanner) {
   ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(), 10));
@@ -34,6 +34,7 @@
 #include "kudu/client/client-internal.h"
 #include "kudu/client/client.pb.h"
 #include "kudu/client/client_builder-internal.h"
+#include "kudu/client/columnar_scan_batch.h"
 #include "kudu/client/error-internal.h"
 #include "kudu/client/error_collector.h"
 #include "kudu/client/meta_cache.h"
@@ -913,6 +914,20 @@ KuduPredicate* KuduTable::NewInListPredicate(const Slice& col_name,
   });
 }
 
+KuduPredicate* KuduTable::NewInBloomFilterPredicate(const Slice& col_name,
+                                                    vector<KuduBloomFilter*>* bloom_filters) {
+  // We always take ownership of the filters; this ensures cleanup if the
+  // predicate is invalid.
+  auto cleanup = MakeScopedCleanup([&]() {
+    STLDeleteElements(bloom_filters);
+  });
+  return data_->MakePredicate(col_name, [&](const ColumnSchema& col_schema) {
+    // Ownership of the filters is passed to the valid returned predicate.
+    cleanup.cancel();
+    return new KuduPredicate(new InBloomFilterPredicateData(col_schema, bloom_filters));
+  });
+}
+
 KuduPredicate* KuduTable::NewIsNotNullPredicate(const Slice& col_name) {
   return data_->MakePredicate(col_name, [&](const ColumnSchema& col_schema) {
     return new KuduPredicate(new IsNotNullPredicateData(col_schema));
@@ -990,6 +1005,14 @@ Status KuduSession::SetExternalConsistencyMode(ExternalConsistencyMode m) {
   return data_->SetExternalConsistencyMode(m);
 }
 
+Status KuduSession::SetBulkLoad(bool enable) {
+  return data_->SetBulkLoad(enable);
+}
+
+Status KuduSession::SetAdaptiveBatching(bool enable) {
+  return data_->SetAdaptiveBatching(enable);
+}
+
 Status KuduSession::SetMutationBufferSpace(size_t size) {
   return data_->SetBufferBytesLimit(size);
 }
@@ -1240,6 +1263,9 @@ Status KuduScanner::SetProjectedColumnNames(const vector<string>& col_names) {
   if (data_->open_) {
     return Status::IllegalState("Projection must be set before Open()");
   }
+  if (data_->configuration().has_aggregates()) {
+    return Status::IllegalState("Projection can't be set on a scan with aggregates");
+  }
   return data_->mutable_configuration()->SetProjectedColumnNames(col_names);
 }
 
@@ -1247,6 +1273,9 @@ Status KuduScanner::SetProjectedColumnIndexes(const vector<int>& col_indexes) {
   if (data_->open_) {
     return Status::IllegalState("Projection must be set before Open()");
   }
+  if (data_->configuration().has_aggregates()) {
+    return Status::IllegalState("Projection can't be set on a scan with aggregates");
+  }
   return data_->mutable_configuration()->SetProjectedColumnIndexes(col_indexes);
 }
 
@@ -1254,6 +1283,13 @@ Status KuduScanner::SetBatchSizeBytes(uint32_t batch_size) {
   return data_->mutable_configuration()->SetBatchSizeBytes(batch_size);
 }
 
+Status KuduScanner::SetPrefetchDepth(int depth) {
+  if (data_->open_) {
+    return Status::IllegalState("Prefetch depth must be set before Open()");
+  }
+  return data_->mutable_configuration()->SetPrefetchDepth(depth);
+}
+
 Status KuduScanner::SetReadMode(ReadMode read_mode) {
   if (data_->open_) {
     return Status::IllegalState("Read mode must be set before Open()");
@@ -1356,13 +1392,14 @@ Status KuduScanner::SetCacheBlocks(bool cache_blocks) {
 }
 
 KuduSchema KuduScanner::GetProjectionSchema() const {
-  return KuduSchema(*data_->configuration().projection());
+  return KuduSchema(*data_->configuration().result_schema());
 }
 
 Status KuduScanner::SetRowFormatFlags(uint64_t flags) {
   switch (flags) {
     case NO_FLAGS:
     case PAD_UNIXTIME_MICROS_TO_16_BYTES:
+    case COLUMNAR_LAYOUT:
       break;
     default:
       return Status::InvalidArgument(Substitute("Invalid row format flags: $0", flags));
@@ -1381,6 +1418,13 @@ Status KuduScanner::SetLimit(int64_t limit) {
   return data_->mutable_configuration()->SetLimit(limit);
 }
 
+Status KuduScanner::AddAggregate(AggregateFunction function, const string& col_name) {
+  if (data_->open_) {
+    return Status::IllegalState("Aggregates must be added before Open()");
+  }
+  return data_->mutable_configuration()->AddAggregate(function, col_name);
+}
+
 const ResourceMetrics& KuduScanner::GetResourceMetrics() const {
   return data_->resource_metrics_;
 }
@@ -1414,6 +1458,13 @@ string KuduScanner::ToString() const {
 Status KuduScanner::Open() {
   CHECK(!data_->open_) << "Scanner already open";
 
+  if (data_->configuration().has_aggregates() &&
+      (data_->configuration().is_fault_tolerant() ||
+       data_->configuration().spec().has_limit())) {
+    return Status::InvalidArgument(
+        "Aggregates can't be combined with a limit or a fault-tolerant scan");
+  }
+
   data_->mutable_configuration()->OptimizeScanSpec();
   data_->partition_pruner_.Init(*data_->table_->schema().schema_,
                                 data_->table_->partition_schema(),
@@ -1461,6 +1512,9 @@ void KuduScanner::Close() {
 
   VLOG(2) << "Ending " << data_->DebugString();
 
+  // Let any prefetch request complete before reusing the request.
+  data_->StopPrefetching();
+
   // Close the scanner on the server-side, if necessary.
   //
   // If the scan did not match any rows, the tserver will not assign a scanner ID.
@@ -1502,14 +1556,28 @@ Status KuduScanner::NextBatch(vector<KuduRowResult>* rows) {
 }
 
 Status KuduScanner::NextBatch(KuduScanBatch* batch) {
-  // TODO: do some double-buffering here -- when we return this batch
-  // we should already have fired off the RPC for the next batch, but
-  // need to do some swapping of the response objects around to avoid
-  // stomping on the memory the user is looking at.
+  if (PREDICT_FALSE(data_->configuration().row_format_flags() & COLUMNAR_LAYOUT)) {
+    return Status::IllegalState(
+        "Cannot fetch row-wise batches: the COLUMNAR_LAYOUT row format flag was selected");
+  }
+  return NextBatch(batch->data_);
+}
+
+Status KuduScanner::NextBatch(KuduColumnarScanBatch* batch) {
+  if (PREDICT_FALSE(!(data_->configuration().row_format_flags() & COLUMNAR_LAYOUT))) {
+    return Status::IllegalState(
+        "Cannot fetch columnar batches: the COLUMNAR_LAYOUT row format flag was not selected");
+  }
+  return NextBatch(batch->data_);
+}
+
+Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
+  // If prefetching is enabled, the next batches are requested in the
+  // background into separate response objects, and swapped in here.
   CHECK(data_->open_);
   CHECK(data_->proxy_);
 
-  batch->data_->Clear();
+  batch_data->Clear();
 
   if (data_->short_circuit_) {
     return Status::OK();
@@ -1519,12 +1587,13 @@ Status KuduScanner::NextBatch(KuduScanBatch* batch) {
     // We have data from a previous scan.
     VLOG(2) << "Extracting data from " << data_->DebugString();
     data_->data_in_open_ = false;
-    return batch->data_->Reset(&data_->controller_,
-                               data_->configuration().projection(),
-                               data_->configuration().client_projection(),
-                               data_->configuration().row_format_flags(),
-                               unique_ptr<RowwiseRowBlockPB>(
-                                   data_->last_response_.release_data()));
+    RETURN_NOT_OK(batch_data->Reset(&data_->controller_,
+                                    data_->configuration().result_schema(),
+                                    data_->configuration().client_projection(),
+                                    data_->configuration().row_format_flags(),
+                                    &data_->last_response_));
+    data_->MaybePrefetch();
+    return Status::OK();
   }
 
   if (data_->last_response_.has_more_results()) {
@@ -1532,24 +1601,29 @@ Status KuduScanner::NextBatch(KuduScanBatch* batch) {
     VLOG(2) << "Continuing " << data_->DebugString();
 
     MonoTime batch_deadline = MonoTime::Now() + data_->configuration().timeout();
-    data_->PrepareRequest(KuduScanner::Data::CONTINUE);
+    bool allow_time_for_failover = data_->configuration().is_fault_tolerant();
+    ScanRpcStatus result;
+    if (data_->configuration().prefetch_depth() > 0) {
+      result = data_->TakePrefetchedResponse(batch_deadline);
+    } else {
+      data_->PrepareRequest(KuduScanner::Data::CONTINUE);
+      result = data_->SendScanRpc(batch_deadline, allow_time_for_failover);
+    }
 
     while (true) {
-      bool allow_time_for_failover = data_->configuration().is_fault_tolerant();
-      ScanRpcStatus result = data_->SendScanRpc(batch_deadline, allow_time_for_failover);
-
       // Success case.
       if (result.result == ScanRpcStatus::OK) {
         if (data_->last_response_.has_last_primary_key()) {
           data_->last_primary_key_ = data_->last_response_.last_primary_key();
         }
         data_->scan_attempts_ = 0;
-        return batch->data_->Reset(&data_->controller_,
-                                   data_->configuration().projection(),
-                                   data_->configuration().client_projection(),
-                                   data_->configuration().row_format_flags(),
-                                   unique_ptr<RowwiseRowBlockPB>(
-                                       data_->last_response_.release_data()));
+        RETURN_NOT_OK(batch_data->Reset(&data_->controller_,
+                                        data_->configuration().result_schema(),
+                                        data_->configuration().client_projection(),
+                                        data_->configuration().row_format_flags(),
+                                        &data_->last_response_));
+        data_->MaybePrefetch();
+        return Status::OK();
       }
 
       data_->scan_attempts_++;
@@ -1572,6 +1646,7 @@ Status KuduScanner::NextBatch(KuduScanBatch* batch) {
 
       if (blacklist.empty() && !needs_reopen) {
         // If we didn't blacklist the current server, we can just retry again.
+        result = data_->SendScanRpc(batch_deadline, allow_time_for_failover);
         continue;
       }
       // If we blacklisted the current server, and it's not fault-tolerant, we can't
@@ -67,6 +67,7 @@ std::string GetMasterAddresses(const client::KuduClient&);
 
 namespace client {
 
+class KuduColumnarScanBatch;
 class KuduDelete;
 class KuduInsert;
 class KuduLoggingCallback;
@@ -93,6 +94,7 @@ class MetaCache;
 class RemoteTablet;
 class RemoteTabletServer;
 class ReplicaController;
+class ScanBatchDataInterface;
 class WriteRpc;
 } // namespace internal
 
@@ -589,6 +591,7 @@ class KUDU_EXPORT KuduClient : public sp::enable_shared_from_this<KuduClient> {
   friend std::string tools::GetMasterAddresses(const client::KuduClient&);
 
   FRIEND_TEST(kudu::ClientStressTest, TestUniqueClientIds);
+  FRIEND_TEST(ClientTest, TestAdaptiveBatchingRetriesExactlyOnce);
   FRIEND_TEST(ClientTest, TestGetSecurityInfoFromMaster);
   FRIEND_TEST(ClientTest, TestGetTabletServerBlacklist);
   FRIEND_TEST(ClientTest, TestMasterDown);
@@ -1012,6 +1015,30 @@ class KUDU_EXPORT KuduTable : public sp::enable_shared_from_this<KuduTable> {
   KuduPredicate* NewInListPredicate(const Slice& col_name,
                                     std::vector<KuduValue*>* values);
 
+  /// Create a new IN BLOOM FILTER predicate which can be used for scanners on
+  /// this table.
+  ///
+  /// The IN BLOOM FILTER predicate filters out the rows whose value of the
+  /// column is definitely not contained in every one of the bloom filters.
+  /// Because of false positives, some rows whose value was not inserted into
+  /// the filters may still be returned. The predicate may be combined with
+  /// comparison or IN list predicates on the same column, which the tablet
+  /// servers evaluate before probing the filters.
+  ///
+  /// @param [in] col_name
+  ///   Name of the column to which the predicate applies.
+  /// @param [in] bloom_filters
+  ///   Vector of bloom filters, with the values encoded as described in
+  ///   KuduBloomFilter::Insert(). Must not be empty.
+  /// @return Raw pointer to an IN BLOOM FILTER predicate. The caller owns the
+  ///   predicate until it is passed into KuduScanner::AddConjunctPredicate().
+  ///   The returned predicate takes ownership of the bloom_filters vector
+  ///   and its elements. In the case of an error (e.g. an invalid column
+  ///   name), a non-NULL value is still returned. The error will be returned
+  ///   when attempting to add this predicate to a KuduScanner.
+  KuduPredicate* NewInBloomFilterPredicate(const Slice& col_name,
+                                           std::vector<KuduBloomFilter*>* bloom_filters);
+
   /// Create a new IS NOT NULL predicate which can be used for scanners on this
   /// table.
   ///
@@ -1458,6 +1485,48 @@ class KUDU_EXPORT KuduSession : public sp::enable_shared_from_this<KuduSession>
   Status SetExternalConsistencyMode(ExternalConsistencyMode m)
     WARN_UNUSED_RESULT;
 
+  /// Set whether the session's writes should be applied as bulk loads.
+  ///
+  /// In bulk load mode, a batch of inserts for a tablet is written straight
+  /// into new on-disk rowsets on the tablet server, bypassing the in-memory
+  /// store and the flush that would later rewrite the rows. Batches which
+  /// contain anything other than inserts of new rows, or are too small to be
+  /// worth a rowset of their own, are applied as regular writes.
+  ///
+  /// This mode is meant for the initial load of large amounts of data into a
+  /// table. For best results, use a large mutation buffer and insert rows in
+  /// primary key order, so that each batch covers a narrow key range.
+  ///
+  /// By default, bulk load mode is disabled.
+  ///
+  /// @param [in] enable
+  ///   Whether to enable bulk load mode.
+  /// @return Operation result status. Returns Status::IllegalState if there
+  ///   are buffered write operations.
+  Status SetBulkLoad(bool enable) WARN_UNUSED_RESULT;
+
+  /// Set whether the session's write batches are sized and sent adaptively.
+  ///
+  /// With adaptive batching, the session:
+  /// @li sends the operations for all tablets whose leader replicas are
+  ///   hosted by the same tablet server in a single RPC, rather than in one
+  ///   RPC per tablet;
+  /// @li in AUTO_FLUSH_BACKGROUND mode, sizes its batches after the rate at
+  ///   which operations are applied and the time it takes to flush a batch,
+  ///   rather than always waiting for the buffer flush watermark to be
+  ///   reached. Batches grow when tablet servers push back by throttling
+  ///   writes. The buffer flush watermark (see
+  ///   SetMutationBufferFlushWatermark()) remains the upper bound on the size
+  ///   of a batch.
+  ///
+  /// By default, adaptive batching is disabled.
+  ///
+  /// @param [in] enable
+  ///   Whether to enable adaptive batching.
+  /// @return Operation result status. Returns Status::IllegalState if there
+  ///   are buffered write operations.
+  Status SetAdaptiveBatching(bool enable) WARN_UNUSED_RESULT;
+
   /// Set the amount of buffer space used by this session for outbound writes.
   ///
   /// The effect of the buffer size varies based on the flush mode of
@@ -1824,6 +1893,22 @@ class KUDU_EXPORT KuduScanner {
     ORDERED
   };
 
+  /// Aggregate functions which the tablet servers can evaluate over
+  /// the scanned rows. See AddAggregate().
+  enum AggregateFunction {
+    /// The number of rows, or of non-NULL cells of a column.
+    COUNT,
+
+    /// The sum of an integer or floating point column.
+    SUM,
+
+    /// The lowest value of a column.
+    MIN,
+
+    /// The highest value of a column.
+    MAX
+  };
+
   /// Default scanner timeout.
   /// This is set to 3x the default RPC timeout returned by
   /// KuduClientBuilder::default_rpc_timeout().
@@ -2015,6 +2100,19 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status NextBatch(KuduScanBatch* batch);
 
+  /// Fetch the next batch of columnar results for this scanner.
+  ///
+  /// This variant may only be used when the scanner is configured with the
+  /// COLUMNAR_LAYOUT row format flag.
+  ///
+  /// A single KuduColumnarScanBatch object may be reused. Each subsequent call
+  /// replaces the data from the previous call, and invalidates any slices
+  /// previously obtained from the batch.
+  /// @param [out] batch
+  ///   Placeholder for the result.
+  /// @return Operation result status.
+  Status NextBatch(KuduColumnarScanBatch* batch);
+
   /// Get the KuduTabletServer that is currently handling the scan.
   ///
   /// More concretely, this is the server that handled the most recent
@@ -2036,6 +2134,22 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status SetBatchSizeBytes(uint32_t batch_size);
 
+  /// Fetch batches ahead of the caller, so that the tablet servers go on
+  /// scanning while the caller processes the batches already returned.
+  ///
+  /// Up to @c depth batches, and roughly @c depth times the batch size in
+  /// bytes (see SetBatchSizeBytes()), are buffered in the client. Once the
+  /// buffer is full, no further batch is requested until NextBatch()
+  /// consumes one. At most one request per scanner is in flight at a time,
+  /// since a tablet server processes a scanner's requests in order.
+  ///
+  /// Prefetching is disabled by default.
+  ///
+  /// @param [in] depth
+  ///   The number of batches to fetch ahead, or 0 to disable prefetching.
+  /// @return Operation result status.
+  Status SetPrefetchDepth(int depth) WARN_UNUSED_RESULT;
+
   /// Set the replica selection policy while scanning.
   ///
   /// @param [in] selection
@@ -2122,6 +2236,12 @@ class KUDU_EXPORT KuduScanner {
   ///   data for further decoding. Using KuduScanBatch::Row() might yield incorrect/corrupt
   ///   results and might even cause the client to crash.
   static const uint64_t PAD_UNIXTIME_MICROS_TO_16_BYTES = 1 << 0;
+  /// Makes the server return the results column by column, with each
+  /// projected column in its own set of buffers, rather than row by row.
+  /// @note If this flag is enabled, the results must be fetched with
+  ///   NextBatch(KuduColumnarScanBatch*). It can't be combined with any
+  ///   other flag.
+  static const uint64_t COLUMNAR_LAYOUT = 1 << 1;
   /// Optionally set row format modifier flags.
   ///
   /// If flags is RowFormatFlags::NO_FLAGS, then no modifications will be made to the row
@@ -2155,6 +2275,35 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status SetLimit(int64_t limit) WARN_UNUSED_RESULT;
 
+  /// Have the tablet servers aggregate the scanned rows instead of
+  /// returning them.
+  ///
+  /// Once an aggregate is added, each scanned tablet returns a single row
+  /// of partial aggregates, with one column per call to this method, in
+  /// order. The caller combines the rows of all tablets: COUNT and SUM
+  /// partials are added up, and MIN and MAX partials are folded with MIN
+  /// and MAX respectively. Use GetProjectionSchema() for the schema of
+  /// the rows:
+  ///   @li COUNT columns are INT64, and never NULL.
+  ///   @li SUM columns are INT64 for integer columns and DOUBLE for
+  ///     floating point columns. Integer sums wrap around on overflow.
+  ///   @li MIN and MAX columns have the type of the aggregated column.
+  ///
+  /// SUM, MIN and MAX partials are NULL if the tablet had no matching
+  /// non-NULL cell.
+  ///
+  /// Aggregates replace the projection, and can't be combined with
+  /// SetLimit() or with fault-tolerant scans.
+  ///
+  /// @param [in] function
+  ///   The aggregate function.
+  /// @param [in] col_name
+  ///   Name of the aggregated column. May be empty only for COUNT,
+  ///   to count rows.
+  /// @return Operation result status.
+  Status AddAggregate(AggregateFunction function, const std::string& col_name)
+      WARN_UNUSED_RESULT;
+
   /// @return String representation of this scan.
   ///
   /// @internal
@@ -2165,6 +2314,10 @@ class KUDU_EXPORT KuduScanner {
  private:
   class KUDU_NO_EXPORT Data;
 
+  // Fetches the next batch of results into 'batch', in whichever layout the
+  // scanner was configured with.
+  Status NextBatch(internal::ScanBatchDataInterface* batch);
+
   friend class KuduScanToken;
   FRIEND_TEST(ClientTest, TestScanCloseProxy);
   FRIEND_TEST(ClientTest, TestScanFaultTolerance);
@@ -0,0 +1,79 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/client/columnar_scan_batch.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "kudu/client/scanner-internal.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+
+using strings::Substitute;
+
+namespace kudu {
+namespace client {
+
+KuduColumnarScanBatch::KuduColumnarScanBatch() : data_(new Data()) {}
+
+KuduColumnarScanBatch::~KuduColumnarScanBatch() {
+  delete data_;
+}
+
+int KuduColumnarScanBatch::NumRows() const {
+  return data_->num_rows();
+}
+
+const KuduSchema* KuduColumnarScanBatch::projection_schema() const {
+  return data_->client_projection_;
+}
+
+Status KuduColumnarScanBatch::GetFixedLengthColumn(int idx, Slice* data) const {
+  RETURN_NOT_OK(data_->CheckColumnIndex(idx));
+  const ColumnSchema& col = data_->projection_->column(idx);
+  if (PREDICT_FALSE(col.type_info()->physical_type() == BINARY)) {
+    return Status::InvalidArgument(Substitute(
+        "column $0 is of variable-length type $1", col.name(), col.type_info()->name()));
+  }
+  *data = data_->columns_[idx].data;
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::GetVariableLengthColumn(int idx, Slice* offsets,
+                                                      Slice* data) const {
+  RETURN_NOT_OK(data_->CheckColumnIndex(idx));
+  const ColumnSchema& col = data_->projection_->column(idx);
+  if (PREDICT_FALSE(col.type_info()->physical_type() != BINARY)) {
+    return Status::InvalidArgument(Substitute(
+        "column $0 is of fixed-length type $1", col.name(), col.type_info()->name()));
+  }
+  *offsets = data_->columns_[idx].data;
+  *data = data_->columns_[idx].varlen_data;
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::GetNonNullBitmapForColumn(int idx, Slice* bitmap) const {
+  RETURN_NOT_OK(data_->CheckColumnIndex(idx));
+  *bitmap = data_->columns_[idx].non_null_bitmap;
+  return Status::OK();
+}
+
+} // namespace client
+} // namespace kudu
@@ -0,0 +1,128 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CLIENT_COLUMNAR_SCAN_BATCH_H
+#define KUDU_CLIENT_COLUMNAR_SCAN_BATCH_H
+
+// NOTE: using stdint.h instead of cstdint because this file is supposed
+//       to be processed by a compiler lacking C++11 support.
+#include <stdint.h>
+
+#ifdef KUDU_HEADERS_NO_STUBS
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
+#else
+#include "kudu/client/stubs.h"
+#endif
+
+#include "kudu/util/kudu_export.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace client {
+
+class KuduSchema;
+
+/// @brief A batch of columnar data returned from a scanner.
+///
+/// Every call to KuduScanner::NextBatch(KuduColumnarScanBatch*) returns a
+/// batch of zero or more rows, laid out column by column. This allows callers
+/// to process the data without transposing it from rows, e.g. with vectorized
+/// code.
+///
+/// The data for each projected column is provided as a set of buffers which
+/// point directly into the RPC response, so no copying is involved:
+///
+/// - Fixed-length columns: a buffer holding the cells of the column back to
+///   back, with NumRows() * <cell size> bytes. The cells are in the same
+///   format as the values of the corresponding getters of
+///   KuduScanBatch::RowPtr. The contents of NULL cells are zeroed.
+///
+/// - Variable-length (STRING and BINARY) columns: a buffer of NumRows() + 1
+///   uint32_t offsets and a buffer of concatenated values. The value of row
+///   'i' spans the bytes [offsets[i], offsets[i + 1]) of the values buffer.
+///
+/// - Nullable columns: in addition, a bitmap in which bit 'i' is set iff
+///   the cell of row 'i' is not NULL. Bit 'i' is in byte i / 8, at position
+///   i % 8 starting from the least significant bit.
+///
+/// @note This class is returned only by scanners that were configured with
+///   the KuduScanner::COLUMNAR_LAYOUT row format flag.
+class KUDU_EXPORT KuduColumnarScanBatch {
+ public:
+  KuduColumnarScanBatch();
+  ~KuduColumnarScanBatch();
+
+  /// @return The number of rows in this batch.
+  int NumRows() const;
+
+  /// @return The projection schema for this batch.
+  const KuduSchema* projection_schema() const;
+
+  /// Get the raw data of the given fixed-length column.
+  ///
+  /// @note The returned Slice is only valid for the lifetime of the
+  ///   KuduColumnarScanBatch, or until the next call to
+  ///   KuduScanner::NextBatch() using it.
+  ///
+  /// @param [in] idx
+  ///   The index of the column in the projection.
+  /// @param [out] data
+  ///   The cells of the column.
+  /// @return Operation result status. Returns a bad Status if the column
+  ///   index is out of range or the column is of a variable-length type.
+  Status GetFixedLengthColumn(int idx, Slice* data) const WARN_UNUSED_RESULT;
+
+  /// Get the raw data of the given variable-length column.
+  ///
+  /// @note The same lifetime restrictions apply as for GetFixedLengthColumn().
+  ///
+  /// @param [in] idx
+  ///   The index of the column in the projection.
+  /// @param [out] offsets
+  ///   NumRows() + 1 uint32_t offsets into 'data'.
+  /// @param [out] data
+  ///   The concatenated values of the column.
+  /// @return Operation result status. Returns a bad Status if the column
+  ///   index is out of range or the column is of a fixed-length type.
+  Status GetVariableLengthColumn(int idx, Slice* offsets, Slice* data) const WARN_UNUSED_RESULT;
+
+  /// Get the non-null bitmap of the given column.
+  ///
+  /// @note The same lifetime restrictions apply as for GetFixedLengthColumn().
+  ///
+  /// @param [in] idx
+  ///   The index of the column in the projection.
+  /// @param [out] bitmap
+  ///   The bitmap, with a set bit for each non-null cell. If the column is
+  ///   not nullable, this is an empty Slice.
+  /// @return Operation result status. Returns a bad Status if the column
+  ///   index is out of range.
+  Status GetNonNullBitmapForColumn(int idx, Slice* bitmap) const WARN_UNUSED_RESULT;
+
+ private:
+  class KUDU_NO_EXPORT Data;
+  friend class KuduScanner;
+
+  Data* data_;
+  DISALLOW_COPY_AND_ASSIGN(KuduColumnarScanBatch);
+};
+
+} // namespace client
+} // namespace kudu
+
+#endif
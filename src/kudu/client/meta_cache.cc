@@ -87,7 +87,8 @@ namespace client {
 namespace internal {
 
 RemoteTabletServer::RemoteTabletServer(const master::TSInfoPB& pb)
-  : uuid_(pb.permanent_uuid()) {
+  : uuid_(pb.permanent_uuid()),
+    multi_write_unsupported_(false) {
 
   Update(pb);
 }
@@ -161,6 +162,16 @@ const string& RemoteTabletServer::permanent_uuid() const {
   return uuid_;
 }
 
+bool RemoteTabletServer::MaySupportMultiWrite() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return !multi_write_unsupported_;
+}
+
+void RemoteTabletServer::MarkMultiWriteUnsupported() {
+  std::lock_guard<simple_spinlock> l(lock_);
+  multi_write_unsupported_ = true;
+}
+
 shared_ptr<TabletServerServiceProxy> RemoteTabletServer::proxy() const {
   std::lock_guard<simple_spinlock> l(lock_);
   CHECK(proxy_);
@@ -106,6 +106,13 @@ class RemoteTabletServer {
   // Returns the remote server's uuid.
   const std::string& permanent_uuid() const;
 
+  // Whether the server may support the MultiWrite RPC, i.e. hasn't rejected
+  // it as an unsupported feature.
+  bool MaySupportMultiWrite() const;
+
+  // Records that the server doesn't support the MultiWrite RPC.
+  void MarkMultiWriteUnsupported();
+
  private:
   // Internal callback for DNS resolution.
   void DnsResolutionFinished(const HostPort& hp,
@@ -120,6 +127,8 @@ class RemoteTabletServer {
   std::vector<HostPort> rpc_hostports_;
   std::shared_ptr<tserver::TabletServerServiceProxy> proxy_;
 
+  bool multi_write_unsupported_;
+
   DISALLOW_COPY_AND_ASSIGN(RemoteTabletServer);
 };
 
@@ -39,6 +39,7 @@
 #include "kudu/mini-cluster/internal_mini_cluster.h"
 #include "kudu/util/decimal_util.h"
 #include "kudu/util/int128.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
@@ -1160,5 +1161,72 @@ TEST_F(PredicateTest, TestBinaryPredicates) {
   CheckStringPredicates(table);
 }
 
+TEST_F(PredicateTest, TestBloomFilterPredicates) {
+  shared_ptr<KuduTable> table = CreateAndOpenTable(KuduColumnSchema::INT32);
+  shared_ptr<KuduSession> session = CreateSession();
+
+  for (int32_t i = 0; i < 100; i++) {
+    unique_ptr<KuduInsert> insert(table->NewInsert());
+    ASSERT_OK(insert->mutable_row()->SetInt64("key", i));
+    ASSERT_OK(insert->mutable_row()->SetInt32("value", i));
+    ASSERT_OK(session->Apply(insert.release()));
+  }
+  unique_ptr<KuduInsert> null_insert(table->NewInsert());
+  ASSERT_OK(null_insert->mutable_row()->SetInt64("key", 100));
+  ASSERT_OK(null_insert->mutable_row()->SetNull("value"));
+  ASSERT_OK(session->Apply(null_insert.release()));
+  ASSERT_OK(session->Flush());
+
+  // Returns a filter containing the values in [0, 'end'), in the layout
+  // given by 'cache_blocked'.
+  auto make_filter = [] (int32_t end, bool cache_blocked) {
+    KuduBloomFilter* bf;
+    CHECK_OK(KuduBloomFilter::Create(100, 0.01, cache_blocked, &bf));
+    for (int32_t i = 0; i < end; i++) {
+      bf->Insert(Slice(reinterpret_cast<const uint8_t*>(&i), sizeof(i)));
+    }
+    return bf;
+  };
+
+  for (bool cache_blocked : { false, true }) {
+    SCOPED_TRACE(cache_blocked);
+    // An empty filter matches no rows, and a filter of every value matches
+    // every non-NULL row.
+    vector<KuduBloomFilter*> filters = { make_filter(0, cache_blocked) };
+    ASSERT_EQ(0, CountRows(table, { table->NewInBloomFilterPredicate("value", &filters) }));
+    filters = { make_filter(100, cache_blocked) };
+    ASSERT_EQ(100, CountRows(table, { table->NewInBloomFilterPredicate("value", &filters) }));
+
+    // Bloom filters are merged with each other and with comparison predicates.
+    filters = { make_filter(100, cache_blocked), make_filter(100, cache_blocked) };
+    ASSERT_EQ(10, CountRows(table, {
+        table->NewInBloomFilterPredicate("value", &filters),
+        table->NewComparisonPredicate("value", KuduPredicate::LESS, KuduValue::FromInt(10)),
+    }));
+    filters = { make_filter(100, cache_blocked) };
+    vector<KuduBloomFilter*> empty_filters = { make_filter(0, cache_blocked) };
+    ASSERT_EQ(0, CountRows(table, {
+        table->NewInBloomFilterPredicate("value", &filters),
+        table->NewInBloomFilterPredicate("value", &empty_filters),
+    }));
+  }
+
+  // A predicate without any filters is an error.
+  vector<KuduBloomFilter*> filters;
+  KuduScanner scanner(table.get());
+  Status s = scanner.AddConjunctPredicate(table->NewInBloomFilterPredicate("value", &filters));
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+
+  // So are filters which can't be sized.
+  KuduBloomFilter* bf;
+  s = KuduBloomFilter::Create(0, 0.01, true, &bf);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  for (double fp_rate : { 0.0, 1.0, -0.5, 2.0, std::numeric_limits<double>::quiet_NaN() }) {
+    SCOPED_TRACE(fp_rate);
+    s = KuduBloomFilter::Create(100, fp_rate, true, &bf);
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  }
+}
+
 } // namespace client
 } // namespace kudu
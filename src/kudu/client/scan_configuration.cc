@@ -17,6 +17,7 @@
 
 #include "kudu/client/scan_configuration.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -28,6 +29,7 @@
 #include "kudu/common/column_predicate.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/partial_row.h"
+#include "kudu/common/scan_aggregator.h"
 #include "kudu/common/schema.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -46,8 +48,10 @@ ScanConfiguration::ScanConfiguration(KuduTable* table)
     : table_(table),
       projection_(table->schema().schema_),
       client_projection_(*table->schema().schema_),
+      aggregates_schema_(nullptr),
       has_batch_size_bytes_(false),
       batch_size_bytes_(0),
+      prefetch_depth_(0),
       selection_(KuduClient::CLOSEST_REPLICA),
       read_mode_(KuduScanner::READ_LATEST),
       is_fault_tolerant_(false),
@@ -155,6 +159,14 @@ Status ScanConfiguration::SetBatchSizeBytes(uint32_t batch_size) {
   return Status::OK();
 }
 
+Status ScanConfiguration::SetPrefetchDepth(int depth) {
+  if (depth < 0) {
+    return Status::InvalidArgument("prefetch depth must not be negative");
+  }
+  prefetch_depth_ = depth;
+  return Status::OK();
+}
+
 Status ScanConfiguration::SetSelection(KuduClient::ReplicaSelection selection) {
   selection_ = selection;
   return Status::OK();
@@ -202,6 +214,45 @@ Status ScanConfiguration::SetLimit(int64_t limit) {
   return Status::OK();
 }
 
+Status ScanConfiguration::AddAggregate(KuduScanner::AggregateFunction function,
+                                       const string& col_name) {
+  ScanAggregatePB pb;
+  switch (function) {
+    case KuduScanner::COUNT: pb.set_function(ScanAggregatePB::COUNT); break;
+    case KuduScanner::SUM: pb.set_function(ScanAggregatePB::SUM); break;
+    case KuduScanner::MIN: pb.set_function(ScanAggregatePB::MIN); break;
+    case KuduScanner::MAX: pb.set_function(ScanAggregatePB::MAX); break;
+    default: return Status::InvalidArgument("Bad aggregate function");
+  }
+  vector<string> col_names = aggregated_col_names_;
+  if (!col_name.empty()) {
+    pb.set_column(col_name);
+    if (std::find(col_names.begin(), col_names.end(), col_name) == col_names.end()) {
+      col_names.push_back(col_name);
+    }
+  }
+  Schema* old_projection = projection_;
+  KuduSchema old_client_projection = client_projection_;
+  RETURN_NOT_OK(SetProjectedColumnNames(col_names));
+
+  // Validate the aggregates and derive the schema of the rows the tablet
+  // servers will return.
+  google::protobuf::RepeatedPtrField<ScanAggregatePB> aggregates = aggregates_;
+  *aggregates.Add() = std::move(pb);
+  unique_ptr<ScanAggregator> aggregator;
+  Status s = ScanAggregator::Create(*projection_, aggregates, &aggregator);
+  if (!s.ok()) {
+    projection_ = old_projection;
+    client_projection_ = old_client_projection;
+    return s;
+  }
+  aggregates_schema_ = pool_.Add(new Schema(aggregator->result_schema()));
+  client_projection_ = KuduSchema(*aggregates_schema_);
+  aggregates_.Swap(&aggregates);
+  aggregated_col_names_.swap(col_names);
+  return Status::OK();
+}
+
 void ScanConfiguration::OptimizeScanSpec() {
   spec_.OptimizeScan(*table_->schema().schema_,
                      &arena_,
@@ -22,9 +22,11 @@
 #include <vector>
 
 #include <glog/logging.h>
+#include <google/protobuf/repeated_field.h>
 
 #include "kudu/client/client.h"
 #include "kudu/client/schema.h"
+#include "kudu/common/common.pb.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/gutil/port.h"
 #include "kudu/util/auto_release_pool.h"
@@ -76,6 +78,8 @@ class ScanConfiguration {
 
   Status SetBatchSizeBytes(uint32_t batch_size);
 
+  Status SetPrefetchDepth(int depth) WARN_UNUSED_RESULT;
+
   Status SetSelection(KuduClient::ReplicaSelection selection) WARN_UNUSED_RESULT;
 
   Status SetReadMode(KuduScanner::ReadMode read_mode) WARN_UNUSED_RESULT;
@@ -100,6 +104,11 @@ class ScanConfiguration {
 
   Status SetLimit(int64_t limit);
 
+  // Adds an aggregate, and replaces the projection with the columns needed
+  // by the aggregates.
+  Status AddAggregate(KuduScanner::AggregateFunction function,
+                      const std::string& col_name) WARN_UNUSED_RESULT;
+
   void OptimizeScanSpec();
 
   const KuduTable& table() {
@@ -120,6 +129,22 @@ class ScanConfiguration {
     return &client_projection_;
   }
 
+  // Returns the schema of the rows returned by the tablet servers: the
+  // projection, or the schema of the partial aggregates if there are any.
+  //
+  // The ScanConfiguration retains ownership of the schema.
+  const Schema* result_schema() const {
+    return has_aggregates() ? aggregates_schema_ : projection_;
+  }
+
+  bool has_aggregates() const {
+    return !aggregates_.empty();
+  }
+
+  const google::protobuf::RepeatedPtrField<ScanAggregatePB>& aggregates() const {
+    return aggregates_;
+  }
+
   const ScanSpec& spec() const {
     return spec_;
   }
@@ -133,6 +158,10 @@ class ScanConfiguration {
     return batch_size_bytes_;
   }
 
+  int prefetch_depth() const {
+    return prefetch_depth_;
+  }
+
   KuduClient::ReplicaSelection selection() const {
     return selection_;
   }
@@ -190,11 +219,20 @@ class ScanConfiguration {
   // Owned client projection.
   KuduSchema client_projection_;
 
+  // The aggregates evaluated by the tablet servers, if any, the columns they
+  // aggregate, and the non-owned schema of the rows of partial aggregates.
+  google::protobuf::RepeatedPtrField<ScanAggregatePB> aggregates_;
+  std::vector<std::string> aggregated_col_names_;
+  Schema* aggregates_schema_;
+
   ScanSpec spec_;
 
   bool has_batch_size_bytes_;
   uint32_t batch_size_bytes_;
 
+  // The number of batches to fetch ahead of the caller, or 0 not to.
+  int prefetch_depth_;
+
   KuduClient::ReplicaSelection selection_;
 
   KuduScanner::ReadMode read_mode_;
@@ -25,6 +25,7 @@
 #include "kudu/client/value.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/status.h"
 
@@ -117,6 +118,57 @@ class InListPredicateData : public KuduPredicate::Data {
   std::vector<KuduValue*> vals_;
 };
 
+// A predicate for the values of a column which may be contained in each of
+// a set of bloom filters.
+class InBloomFilterPredicateData : public KuduPredicate::Data {
+ public:
+  InBloomFilterPredicateData(ColumnSchema col, std::vector<KuduBloomFilter*>* bloom_filters);
+
+  virtual ~InBloomFilterPredicateData();
+
+  Status AddToScanSpec(ScanSpec* spec, Arena* arena) override;
+
+  InBloomFilterPredicateData* Clone() const override {
+    std::vector<KuduBloomFilter*> bloom_filters;
+    bloom_filters.reserve(bloom_filters_.size());
+    for (KuduBloomFilter* bf : bloom_filters_) {
+      bloom_filters.push_back(bf->Clone());
+    }
+
+    return new InBloomFilterPredicateData(col_, &bloom_filters);
+  }
+
+ private:
+  friend class KuduScanner;
+
+  ColumnSchema col_;
+  std::vector<KuduBloomFilter*> bloom_filters_;
+};
+
+class KuduBloomFilter::Data {
+ public:
+  Data(size_t expected_count, double fp_rate, BloomFilterLayout layout)
+      : expected_count_(expected_count),
+        fp_rate_(fp_rate),
+        builder_(BloomFilterSizing::ByCountAndFPRate(expected_count, fp_rate), layout) {
+  }
+
+  Data* Clone() const {
+    Data* clone = new Data(expected_count_, fp_rate_, builder_.layout());
+    clone->builder_.CopyFrom(builder_);
+    return clone;
+  }
+
+  // The sizing parameters, kept for Clone().
+  const size_t expected_count_;
+  const double fp_rate_;
+
+  BloomFilterBuilder builder_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Data);
+};
+
 // A predicate for selecting non-null values.
 class IsNotNullPredicateData : public KuduPredicate::Data {
  public:
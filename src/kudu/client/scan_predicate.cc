@@ -17,6 +17,7 @@
 
 #include "kudu/client/scan_predicate.h"
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -32,10 +33,13 @@
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/bloom_filter.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 using boost::optional;
 using std::move;
+using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
@@ -148,5 +152,70 @@ Status InListPredicateData::AddToScanSpec(ScanSpec* spec, Arena* /*arena*/) {
   return Status::OK();
 }
 
+InBloomFilterPredicateData::InBloomFilterPredicateData(ColumnSchema col,
+                                                       vector<KuduBloomFilter*>* bloom_filters)
+    : col_(move(col)) {
+  bloom_filters_.swap(*bloom_filters);
+}
+
+InBloomFilterPredicateData::~InBloomFilterPredicateData() {
+  STLDeleteElements(&bloom_filters_);
+}
+
+Status InBloomFilterPredicateData::AddToScanSpec(ScanSpec* spec, Arena* /*arena*/) {
+  if (bloom_filters_.empty()) {
+    return Status::InvalidArgument(
+        Substitute("no bloom filters given for predicate on column $0", col_.name()));
+  }
+  // The filters reference the builders' data, which is owned by this
+  // predicate and so lives as long as the scan.
+  vector<BloomFilter> filters;
+  filters.reserve(bloom_filters_.size());
+  for (const KuduBloomFilter* bf : bloom_filters_) {
+    const BloomFilterBuilder& builder = bf->data_->builder_;
+    filters.emplace_back(builder.slice(), builder.n_hashes(), builder.layout());
+  }
+  spec->AddPredicate(ColumnPredicate::InBloomFilter(col_, &filters, nullptr, nullptr));
+  return Status::OK();
+}
+
+Status KuduBloomFilter::Create(size_t expected_count, double fp_rate, bool cache_blocked,
+                               KuduBloomFilter** bloom_filter) {
+  if (expected_count == 0) {
+    return Status::InvalidArgument("expected count of bloom filter values must be positive");
+  }
+  // Written so that NaN is rejected too.
+  if (!(fp_rate > 0 && fp_rate < 1)) {
+    return Status::InvalidArgument(
+        Substitute("bloom filter false positive rate $0 is not in (0, 1)", fp_rate));
+  }
+  unique_ptr<Data> data(new Data(expected_count, fp_rate,
+                                 cache_blocked ? BloomFilterLayout::kCacheBlocked
+                                               : BloomFilterLayout::kClassic));
+  // Tablet servers refuse filters with more hash functions than this.
+  if (data->builder_.n_hashes() > BloomFilter::kMaxClientHashes) {
+    return Status::InvalidArgument(
+        Substitute("bloom filter false positive rate $0 is too low", fp_rate));
+  }
+  *bloom_filter = new KuduBloomFilter(data.release());
+  return Status::OK();
+}
+
+KuduBloomFilter::KuduBloomFilter(Data* d)
+    : data_(d) {
+}
+
+KuduBloomFilter::~KuduBloomFilter() {
+  delete data_;
+}
+
+void KuduBloomFilter::Insert(const Slice& value) {
+  data_->builder_.AddKey(BloomKeyProbe(value));
+}
+
+KuduBloomFilter* KuduBloomFilter::Clone() const {
+  return new KuduBloomFilter(data_->Clone());
+}
+
 } // namespace client
 } // namespace kudu
@@ -24,6 +24,8 @@
 #endif
 
 #include "kudu/util/kudu_export.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 
 namespace kudu {
 namespace client {
@@ -55,6 +57,7 @@ class KUDU_EXPORT KuduPredicate {
  private:
   friend class ComparisonPredicateData;
   friend class ErrorPredicateData;
+  friend class InBloomFilterPredicateData;
   friend class InListPredicateData;
   friend class IsNotNullPredicateData;
   friend class IsNullPredicateData;
@@ -67,6 +70,61 @@ class KUDU_EXPORT KuduPredicate {
   DISALLOW_COPY_AND_ASSIGN(KuduPredicate);
 };
 
+/// @brief A bloom filter of column values, for use in an IN BLOOM FILTER
+///   predicate.
+///
+/// A typical use is a semi-join: the join keys of one side of the join are
+/// inserted into a filter, which is then pushed down into the scan of the
+/// other side with KuduTable::NewInBloomFilterPredicate(), so that the
+/// tablet servers only return the rows which may have a match.
+class KUDU_EXPORT KuduBloomFilter {
+ public:
+  /// Create an empty bloom filter.
+  ///
+  /// @param [in] expected_count
+  ///   The expected number of distinct values to be inserted. Must be
+  ///   positive.
+  /// @param [in] fp_rate
+  ///   The desired false positive rate, in the range (0, 1), once
+  ///   @c expected_count values have been inserted.
+  /// @param [in] cache_blocked
+  ///   Whether to keep the bits for each value within a single cache line
+  ///   of the filter. This makes probing much cheaper for large filters, at
+  ///   the cost of a slightly higher false positive rate for a given size.
+  /// @param [out] bloom_filter
+  ///   The newly created filter. The caller takes ownership of it, unless
+  ///   it is passed to KuduTable::NewInBloomFilterPredicate().
+  /// @return Operation status. The return value is
+  ///   @c Status::InvalidArgument if @c expected_count or @c fp_rate is
+  ///   out of range.
+  static Status Create(size_t expected_count, double fp_rate, bool cache_blocked,
+                       KuduBloomFilter** bloom_filter);
+
+  ~KuduBloomFilter();
+
+  /// Insert a value into the filter.
+  ///
+  /// @param [in] value
+  ///   The value, encoded as its bytes for STRING and BINARY columns, and as
+  ///   its little-endian in-memory representation for other column types,
+  ///   e.g. the 4 bytes of an @c int32_t for an INT32 column. The value is
+  ///   not retained.
+  void Insert(const Slice& value);
+
+  /// @return A new, identical, KuduBloomFilter object.
+  KuduBloomFilter* Clone() const;
+
+ private:
+  class KUDU_NO_EXPORT Data;
+
+  friend class InBloomFilterPredicateData;
+
+  explicit KuduBloomFilter(Data* d);
+
+  Data* data_;
+  DISALLOW_COPY_AND_ASSIGN(KuduBloomFilter);
+};
+
 } // namespace client
 } // namespace kudu
 #endif // KUDU_CLIENT_SCAN_PREDICATE_H
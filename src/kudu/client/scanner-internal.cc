@@ -25,11 +25,13 @@
 #include <utility>
 #include <vector>
 
+#include <boost/bind.hpp>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
 
 #include "kudu/client/client-internal.h"
 #include "kudu/client/meta_cache.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/partition.h"
@@ -61,6 +63,7 @@ using rpc::CredentialsPolicy;
 using rpc::RpcController;
 using strings::Substitute;
 using tserver::NewScanRequestPB;
+using tserver::ScanResponsePB;
 using tserver::TabletServerFeatures;
 
 namespace client {
@@ -74,10 +77,14 @@ KuduScanner::Data::Data(KuduTable* table)
     short_circuit_(false),
     table_(DCHECK_NOTNULL(table)->shared_from_this()),
     scan_attempts_(0),
-    num_rows_returned_(0) {
+    num_rows_returned_(0),
+    prefetch_cond_(&prefetch_lock_),
+    prefetched_bytes_(0),
+    prefetch_stopping_(false) {
 }
 
 KuduScanner::Data::~Data() {
+  StopPrefetching();
 }
 
 Status KuduScanner::Data::HandleError(const ScanRpcStatus& err,
@@ -296,13 +303,7 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
   }
 
   controller_.Reset();
-  controller_.set_deadline(rpc_deadline);
-  if (!configuration_.spec().predicates().empty()) {
-    controller_.RequireServerFeature(TabletServerFeatures::COLUMN_PREDICATES);
-  }
-  if (configuration().row_format_flags() & KuduScanner::PAD_UNIXTIME_MICROS_TO_16_BYTES) {
-    controller_.RequireServerFeature(TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES);
-  }
+  PrepareController(&controller_, rpc_deadline);
   ScanRpcStatus scan_status = AnalyzeResponse(
       proxy_->Scan(next_req_,
                    &last_response_,
@@ -310,11 +311,132 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
       rpc_deadline, overall_deadline);
   if (scan_status.result == ScanRpcStatus::OK) {
     UpdateResourceMetrics();
-    num_rows_returned_ += last_response_.data().num_rows();
+    num_rows_returned_ += NumRowsInLastResponse();
   }
   return scan_status;
 }
 
+void KuduScanner::Data::PrepareController(RpcController* controller,
+                                          const MonoTime& rpc_deadline) {
+  controller->set_deadline(rpc_deadline);
+  if (!configuration_.spec().predicates().empty()) {
+    controller->RequireServerFeature(TabletServerFeatures::COLUMN_PREDICATES);
+  }
+  for (const auto& col_pred : configuration_.spec().predicates()) {
+    if (col_pred.second.predicate_type() == PredicateType::InBloomFilter) {
+      controller->RequireServerFeature(TabletServerFeatures::BLOOM_FILTER_PREDICATE);
+      break;
+    }
+  }
+  if (configuration().row_format_flags() & KuduScanner::PAD_UNIXTIME_MICROS_TO_16_BYTES) {
+    controller->RequireServerFeature(TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES);
+  }
+  if (configuration().row_format_flags() & KuduScanner::COLUMNAR_LAYOUT) {
+    controller->RequireServerFeature(TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE);
+  }
+  if (configuration().has_aggregates()) {
+    controller->RequireServerFeature(TabletServerFeatures::SCAN_AGGREGATES);
+  }
+}
+
+void KuduScanner::Data::MaybePrefetch() {
+  MutexLock l(prefetch_lock_);
+  MaybePrefetchUnlocked();
+}
+
+bool KuduScanner::Data::LastReceivedHasMoreResultsUnlocked() const {
+  if (prefetched_.empty()) {
+    return last_response_.has_more_results();
+  }
+  const PrefetchedResponse& last = *prefetched_.back();
+  return last.controller.status().ok() &&
+      !last.response.has_error() &&
+      last.response.has_more_results();
+}
+
+void KuduScanner::Data::MaybePrefetchUnlocked() {
+  const int depth = configuration_.prefetch_depth();
+  if (depth == 0 || prefetch_stopping_ || prefetch_in_flight_) {
+    return;
+  }
+  // Without a batch size hint, assume the tablet servers' default of 1MB.
+  const size_t batch_size = configuration_.has_batch_size_bytes() ?
+      configuration_.batch_size_bytes() : 1024 * 1024;
+  if (!prefetched_.empty() &&
+      (prefetched_.size() >= static_cast<size_t>(depth) ||
+       prefetched_bytes_ >= depth * batch_size)) {
+    return;
+  }
+  if (!LastReceivedHasMoreResultsUnlocked()) {
+    return;
+  }
+
+  unique_ptr<PrefetchedResponse> p(new PrefetchedResponse);
+  p->rpc_deadline = MonoTime::Now() + configuration_.timeout();
+  PrepareController(&p->controller, p->rpc_deadline);
+  PrepareRequest(KuduScanner::Data::CONTINUE);
+  PrefetchedResponse* raw = p.get();
+  prefetch_in_flight_ = std::move(p);
+  proxy_->ScanAsync(next_req_, &raw->response, &raw->controller,
+                    boost::bind(&KuduScanner::Data::PrefetchDone, this));
+}
+
+void KuduScanner::Data::PrefetchDone() {
+  MutexLock l(prefetch_lock_);
+  unique_ptr<PrefetchedResponse> p = std::move(prefetch_in_flight_);
+  DCHECK(p);
+  p->size_bytes = p->response.ByteSize();
+  if (p->controller.status().ok()) {
+    Slice sidecar;
+    for (int i = 0; p->controller.GetInboundSidecar(i, &sidecar).ok(); i++) {
+      p->size_bytes += sidecar.size();
+    }
+  }
+  prefetched_bytes_ += p->size_bytes;
+  prefetched_.emplace_back(std::move(p));
+  MaybePrefetchUnlocked();
+  prefetch_cond_.Broadcast();
+}
+
+ScanRpcStatus KuduScanner::Data::TakePrefetchedResponse(const MonoTime& overall_deadline) {
+  MutexLock l(prefetch_lock_);
+  MaybePrefetchUnlocked();
+  DCHECK(!prefetched_.empty() || prefetch_in_flight_);
+  // The in-flight request has its own deadline, so this wait is bounded.
+  while (prefetched_.empty()) {
+    prefetch_cond_.Wait();
+  }
+  unique_ptr<PrefetchedResponse> p = std::move(prefetched_.front());
+  prefetched_.pop_front();
+  prefetched_bytes_ -= p->size_bytes;
+
+  controller_.Swap(&p->controller);
+  last_response_.Swap(&p->response);
+  // The response's deadline was set when it was prefetched, so time out as
+  // for an individual RPC, which may be retried.
+  ScanRpcStatus scan_status = AnalyzeResponse(controller_.status(),
+                                              overall_deadline,
+                                              p->rpc_deadline);
+  if (scan_status.result == ScanRpcStatus::OK) {
+    UpdateResourceMetrics();
+    num_rows_returned_ += NumRowsInLastResponse();
+    // Room was made in the buffer.
+    MaybePrefetchUnlocked();
+  }
+  return scan_status;
+}
+
+void KuduScanner::Data::StopPrefetching() {
+  MutexLock l(prefetch_lock_);
+  prefetch_stopping_ = true;
+  while (prefetch_in_flight_) {
+    prefetch_cond_.Wait();
+  }
+  prefetch_stopping_ = false;
+  prefetched_.clear();
+  prefetched_bytes_ = 0;
+}
+
 Status KuduScanner::Data::OpenTablet(const string& partition_key,
                                      const MonoTime& deadline,
                                      set<string>* blacklist) {
@@ -408,6 +530,7 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
   }
   RETURN_NOT_OK(SchemaToColumnPBs(*configuration_.projection(), scan->mutable_projected_columns(),
                                   SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES | SCHEMA_PB_WITHOUT_IDS));
+  *scan->mutable_aggregates() = configuration_.aggregates();
 
   for (int attempt = 1;; attempt++) {
     Synchronizer sync;
@@ -482,12 +605,12 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
   partition_pruner_.RemovePartitionKeyRange(remote_->partition().partition_key_end());
 
   next_req_.clear_new_scan_request();
-  data_in_open_ = last_response_.has_data() && last_response_.data().num_rows() > 0;
+  data_in_open_ = NumRowsInLastResponse() > 0;
   if (last_response_.has_more_results()) {
     next_req_.set_scanner_id(last_response_.scanner_id());
     VLOG(2) << "Opened tablet " << remote_->tablet_id()
             << ", scanner ID " << last_response_.scanner_id();
-  } else if (last_response_.has_data()) {
+  } else if (last_response_.has_data() || last_response_.has_columnar_data()) {
     VLOG(2) << "Opened tablet " << remote_->tablet_id() << ", no scanner ID assigned";
   } else {
     VLOG(2) << "Opened tablet " << remote_->tablet_id() << " (no rows), no scanner ID assigned";
@@ -528,6 +651,15 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
 
 Status KuduScanner::Data::KeepAlive() {
   if (!open_) return Status::IllegalState("Scanner was not open.");
+  {
+    // A scanner with a prefetch request in flight is busy, and one whose
+    // prefetched responses include its last is already closed.
+    MutexLock l(prefetch_lock_);
+    if (prefetch_in_flight_ ||
+        (!prefetched_.empty() && !LastReceivedHasMoreResultsUnlocked())) {
+      return Status::OK();
+    }
+  }
   // If there is no scanner to keep alive, we still return Status::OK().
   if (!last_response_.IsInitialized() || !last_response_.has_more_results() ||
       !next_req_.has_scanner_id()) {
@@ -591,8 +723,9 @@ Status KuduScanBatch::Data::Reset(RpcController* controller,
                                   const Schema* projection,
                                   const KuduSchema* client_projection,
                                   uint64_t row_format_flags,
-                                  unique_ptr<RowwiseRowBlockPB> resp_data) {
+                                  ScanResponsePB* response) {
   CHECK(controller->finished());
+  unique_ptr<RowwiseRowBlockPB> resp_data(response->release_data());
   controller_.Swap(controller);
   projection_ = projection;
   projected_row_size_ = CalculateProjectedRowSize(*projection_);
@@ -669,5 +802,127 @@ void KuduScanBatch::Data::Clear() {
   controller_.Reset();
 }
 
+////////////////////////////////////////////////////////////
+// KuduColumnarScanBatch
+////////////////////////////////////////////////////////////
+
+KuduColumnarScanBatch::Data::Data() : projection_(nullptr), client_projection_(nullptr) {}
+
+KuduColumnarScanBatch::Data::~Data() {}
+
+Status KuduColumnarScanBatch::Data::Reset(RpcController* controller,
+                                          const Schema* projection,
+                                          const KuduSchema* client_projection,
+                                          uint64_t row_format_flags,
+                                          ScanResponsePB* response) {
+  CHECK(controller->finished());
+  DCHECK(row_format_flags & KuduScanner::COLUMNAR_LAYOUT);
+  controller_.Swap(controller);
+  projection_ = projection;
+  client_projection_ = client_projection;
+  columns_.clear();
+  if (!response->has_columnar_data()) {
+    // No new data; just clear out the old stuff.
+    resp_data_.Clear();
+    return Status::OK();
+  }
+
+  // There's new data. Swap it in and process it.
+  resp_data_.Swap(response->mutable_columnar_data());
+  response->clear_columnar_data();
+
+  if (PREDICT_FALSE(resp_data_.columns_size() != projection_->num_columns())) {
+    return Status::Corruption(Substitute(
+        "Server sent invalid response: $0 columns but expected $1",
+        resp_data_.columns_size(), projection_->num_columns()));
+  }
+
+  const int64_t num_rows = resp_data_.num_rows();
+  columns_.resize(projection_->num_columns());
+  for (int i = 0; i < projection_->num_columns(); i++) {
+    const ColumnSchema& col = projection_->column(i);
+    const ColumnarRowBlockPB::Column& col_pb = resp_data_.columns(i);
+    Column* dst = &columns_[i];
+
+    if (PREDICT_FALSE(!col_pb.has_data_sidecar())) {
+      return Status::Corruption(Substitute(
+          "Server sent invalid response: no data for column $0", col.name()));
+    }
+    Status s = controller_.GetInboundSidecar(col_pb.data_sidecar(), &dst->data);
+    if (!s.ok()) {
+      return Status::Corruption("Server sent invalid response: "
+          "column data sidecar index corrupt", s.ToString());
+    }
+
+    if (col.type_info()->physical_type() == BINARY) {
+      if (PREDICT_FALSE(!col_pb.has_varlen_data_sidecar())) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: no varlen data for column $0", col.name()));
+      }
+      s = controller_.GetInboundSidecar(col_pb.varlen_data_sidecar(), &dst->varlen_data);
+      if (!s.ok()) {
+        return Status::Corruption("Server sent invalid response: "
+            "column varlen data sidecar index corrupt", s.ToString());
+      }
+      // Every offset must point within the varlen data. Checking the last
+      // offset suffices so long as they are monotonic, which callers may
+      // otherwise rely on.
+      if (PREDICT_FALSE(dst->data.size() != (num_rows + 1) * sizeof(uint32_t))) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: column $0 has $1 bytes of offsets for $2 rows",
+            col.name(), dst->data.size(), num_rows));
+      }
+      const uint32_t* offsets = reinterpret_cast<const uint32_t*>(dst->data.data());
+      for (int64_t r = 0; r < num_rows; r++) {
+        if (PREDICT_FALSE(offsets[r] > offsets[r + 1])) {
+          return Status::Corruption(Substitute(
+              "Server sent invalid response: column $0 has decreasing offsets", col.name()));
+        }
+      }
+      if (PREDICT_FALSE(offsets[num_rows] > dst->varlen_data.size())) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: column $0 has offsets past its $1 bytes of data",
+            col.name(), dst->varlen_data.size()));
+      }
+    } else if (PREDICT_FALSE(dst->data.size() != num_rows * col.type_info()->size())) {
+      return Status::Corruption(Substitute(
+          "Server sent invalid response: column $0 has $1 bytes of data for $2 rows",
+          col.name(), dst->data.size(), num_rows));
+    }
+
+    if (col.is_nullable()) {
+      if (PREDICT_FALSE(!col_pb.has_non_null_bitmap_sidecar())) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: no null bitmap for column $0", col.name()));
+      }
+      s = controller_.GetInboundSidecar(col_pb.non_null_bitmap_sidecar(),
+                                        &dst->non_null_bitmap);
+      if (!s.ok()) {
+        return Status::Corruption("Server sent invalid response: "
+            "column null bitmap sidecar index corrupt", s.ToString());
+      }
+      if (PREDICT_FALSE(dst->non_null_bitmap.size() != BitmapSize(num_rows))) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: column $0 has a $1-byte null bitmap for $2 rows",
+            col.name(), dst->non_null_bitmap.size(), num_rows));
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::Data::CheckColumnIndex(int idx) const {
+  if (PREDICT_FALSE(idx < 0 || idx >= columns_.size())) {
+    return Status::InvalidArgument(Substitute("invalid column index: $0", idx));
+  }
+  return Status::OK();
+}
+
+void KuduColumnarScanBatch::Data::Clear() {
+  resp_data_.Clear();
+  columns_.clear();
+  controller_.Reset();
+}
+
 } // namespace client
 } // namespace kudu
@@ -19,6 +19,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <ostream>
 #include <set>
@@ -28,6 +29,7 @@
 #include <glog/logging.h>
 
 #include "kudu/client/client.h"
+#include "kudu/client/columnar_scan_batch.h"
 #include "kudu/client/resource_metrics.h"
 #include "kudu/client/row_result.h"
 #include "kudu/client/scan_batch.h"
@@ -43,13 +45,14 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
 
-class MonoTime;
-
 namespace tserver {
 class TabletServerServiceProxy;
 }
@@ -59,6 +62,24 @@ namespace client {
 namespace internal {
 class RemoteTablet;
 class RemoteTabletServer;
+
+// The interface shared by the internal data of the different kinds of scan
+// batches, so that KuduScanner can fill any of them from a scan response.
+class ScanBatchDataInterface {
+ public:
+  virtual ~ScanBatchDataInterface() {}
+
+  // Takes ownership of the row data in 'response' and of the sidecars held by
+  // 'controller', and prepares the batch for access. If 'response' has no
+  // row data, the batch is left empty.
+  virtual Status Reset(rpc::RpcController* controller,
+                       const Schema* projection,
+                       const KuduSchema* client_projection,
+                       uint64_t row_format_flags,
+                       tserver::ScanResponsePB* response) = 0;
+
+  virtual void Clear() = 0;
+};
 } // namespace internal
 
 // The result of KuduScanner::Data::AnalyzeResponse.
@@ -190,6 +211,34 @@ class KuduScanner::Data {
   // non-fatal (i.e. retriable) scan error is encountered.
   void UpdateLastError(const Status& error);
 
+  // If prefetching is enabled, sends the next CONTINUE request for the
+  // current tablet in the background, unless a request is already in flight,
+  // the last response received has no more results or was an error, or the
+  // buffer of prefetched responses is full. Each successful response sends
+  // the next request in turn, until the buffer fills up.
+  void MaybePrefetch();
+
+  // Waits for the oldest prefetched response, which must exist or be in
+  // flight, and moves it into 'last_response_' and 'controller_'. Returns
+  // what SendScanRpc() would have for it.
+  //
+  // After an error, 'next_req_' is left as it was for the failed request, and
+  // no request is in flight, so the request may be retried with SendScanRpc().
+  ScanRpcStatus TakePrefetchedResponse(const MonoTime& overall_deadline);
+
+  // Waits for any in-flight prefetch request to complete and discards the
+  // prefetched responses.
+  void StopPrefetching();
+
+  // Returns the number of rows in 'last_response_', whichever row layout it
+  // was returned in.
+  int64_t NumRowsInLastResponse() const {
+    if (last_response_.has_columnar_data()) {
+      return last_response_.columnar_data().num_rows();
+    }
+    return last_response_.data().num_rows();
+  }
+
   const ScanConfiguration& configuration() const {
     return configuration_;
   }
@@ -286,10 +335,49 @@ class KuduScanner::Data {
 
   void UpdateResourceMetrics();
 
+  // Sets the deadline of 'controller' and the server features the scan
+  // requires.
+  void PrepareController(rpc::RpcController* controller, const MonoTime& rpc_deadline);
+
+  // A response to a prefetch request.
+  struct PrefetchedResponse {
+    rpc::RpcController controller;
+    tserver::ScanResponsePB response;
+    MonoTime rpc_deadline;
+
+    // The size of the response, including its sidecars, once received.
+    size_t size_bytes = 0;
+  };
+
+  // Callback for a prefetch request.
+  void PrefetchDone();
+
+  void MaybePrefetchUnlocked();
+
+  // Whether the latest response received, prefetched or not, was successful
+  // and has more results.
+  bool LastReceivedHasMoreResultsUnlocked() const;
+
+  // Protects the prefetch state below, and 'next_req_' while a prefetch
+  // request may be in flight.
+  Mutex prefetch_lock_;
+  ConditionVariable prefetch_cond_;
+
+  // The prefetched responses not yet consumed, oldest first, and their total
+  // size in bytes.
+  std::deque<std::unique_ptr<PrefetchedResponse>> prefetched_;
+  size_t prefetched_bytes_;
+
+  // The response to the in-flight prefetch request, if any.
+  std::unique_ptr<PrefetchedResponse> prefetch_in_flight_;
+
+  // Set while StopPrefetching() waits, so that no further request is sent.
+  bool prefetch_stopping_;
+
   DISALLOW_COPY_AND_ASSIGN(Data);
 };
 
-class KuduScanBatch::Data {
+class KuduScanBatch::Data : public internal::ScanBatchDataInterface {
  public:
   Data();
   ~Data();
@@ -298,7 +386,7 @@ class KuduScanBatch::Data {
                const Schema* projection,
                const KuduSchema* client_projection,
                uint64_t row_format_flags,
-               std::unique_ptr<RowwiseRowBlockPB> resp_data);
+               tserver::ScanResponsePB* response) override;
 
   int num_rows() const {
     return resp_data_.num_rows();
@@ -316,7 +404,7 @@ class KuduScanBatch::Data {
 
   void ExtractRows(std::vector<KuduScanBatch::RowPtr>* rows);
 
-  void Clear();
+  void Clear() override;
 
   // Returns the size of a row for the given projection 'proj'.
   static size_t CalculateProjectedRowSize(const Schema& proj);
@@ -346,6 +434,49 @@ class KuduScanBatch::Data {
   size_t projected_row_size_;
 };
 
+class KuduColumnarScanBatch::Data : public internal::ScanBatchDataInterface {
+ public:
+  Data();
+  ~Data();
+
+  Status Reset(rpc::RpcController* controller,
+               const Schema* projection,
+               const KuduSchema* client_projection,
+               uint64_t row_format_flags,
+               tserver::ScanResponsePB* response) override;
+
+  void Clear() override;
+
+  int num_rows() const {
+    return resp_data_.num_rows();
+  }
+
+  // Returns a bad Status if 'idx' isn't a valid column index.
+  Status CheckColumnIndex(int idx) const;
+
+  // The RPC controller for the RPC which returned this batch.
+  // Holding on to the controller ensures we hold on to the sidecars
+  // which contain the column data.
+  rpc::RpcController controller_;
+
+  // The PB which contains the sidecar indexes of the columns.
+  ColumnarRowBlockPB resp_data_;
+
+  // Slices into the sidecars of each projected column, whose lifetime is
+  // ensured by the members above. See KuduColumnarScanBatch for the format.
+  struct Column {
+    Slice data;
+    Slice varlen_data;
+    Slice non_null_bitmap;
+  };
+  std::vector<Column> columns_;
+
+  // The projection being scanned.
+  const Schema* projection_;
+  // The KuduSchema version of 'projection_'
+  const KuduSchema* client_projection_;
+};
+
 } // namespace client
 } // namespace kudu
 
@@ -17,6 +17,7 @@
 
 #include "kudu/client/session-internal.h"
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <utility>
@@ -57,6 +58,8 @@ KuduSession::Data::Data(shared_ptr<KuduClient> client,
       messenger_(std::move(messenger)),
       error_collector_(new ErrorCollector()),
       external_consistency_mode_(CLIENT_PROPAGATED),
+      bulk_load_(false),
+      adaptive_batching_(false),
       flush_interval_(MonoDelta::FromMilliseconds(1000)),
       flush_task_active_(false),
       flush_mode_(AUTO_FLUSH_SYNC),
@@ -66,6 +69,10 @@ KuduSession::Data::Data(shared_ptr<KuduClient> client,
       buffer_bytes_limit_(7 * 1024 * 1024),
       buffer_watermark_pct_(50),
       buffer_bytes_used_(0),
+      adaptive_flush_watermark_(0),
+      apply_rate_avg_(0),
+      flush_latency_avg_(0),
+      backpressure_factor_(1),
       buffer_pre_flush_enabled_(true) {
 }
 
@@ -80,6 +87,9 @@ void KuduSession::Data::FlushFinished(Batcher* batcher) {
     std::lock_guard<Mutex> l(mutex_);
     buffer_bytes_used_ -= bytes_flushed;
     --batchers_num_;
+    if (adaptive_batching_) {
+      UpdateAdaptiveFlushWatermarkUnlocked(batcher);
+    }
     // The logic of KuduSession::ApplyWriteOp() needs to know
     // if total number of batchers or buffer byte count decreases.
     // There can be a thread waiting on the corresponding condition
@@ -120,6 +130,35 @@ Status KuduSession::Data::SetExternalConsistencyMode(
   return Status::OK();
 }
 
+Status KuduSession::Data::SetBulkLoad(bool enable) {
+  std::lock_guard<Mutex> l(mutex_);
+  if (HasPendingOperationsUnlocked()) {
+    // NOTE: this is an artificial restriction, same as for the external
+    // consistency mode above.
+    return Status::IllegalState(
+        "Cannot change bulk load mode when writes are buffered");
+  }
+  bulk_load_ = enable;
+  return Status::OK();
+}
+
+Status KuduSession::Data::SetAdaptiveBatching(bool enable) {
+  std::lock_guard<Mutex> l(mutex_);
+  if (HasPendingOperationsUnlocked()) {
+    // NOTE: this is an artificial restriction, same as for the bulk load mode.
+    return Status::IllegalState(
+        "Cannot change adaptive batching when writes are buffered");
+  }
+  adaptive_batching_ = enable;
+  // Start over: until the first batch is flushed, the flush watermark is
+  // the one set by buffer_watermark_pct_.
+  adaptive_flush_watermark_ = 0;
+  apply_rate_avg_ = 0;
+  flush_latency_avg_ = 0;
+  backpressure_factor_ = 1;
+  return Status::OK();
+}
+
 Status KuduSession::Data::SetFlushMode(FlushMode mode) {
   {
     std::lock_guard<Mutex> l(mutex_);
@@ -393,6 +432,7 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
       FlushCurrentBatcher(max_size - required_size + 1, nullptr);
     }
   }
+  int64_t flush_watermark;
   {
     std::lock_guard<Mutex> l(mutex_);
     if (flush_mode == AUTO_FLUSH_BACKGROUND) {
@@ -422,12 +462,12 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
         condition_.Wait();
       }
       DCHECK(!batcher_);
-      // Thread-safety note: the external_consistecy_mode_ and timeout_ms_
-      // are not supposed to be accessed or modified from any other thread
-      // no thread-safety is advertised for the kudu::KuduSession interface.
+      // Thread-safety note: the external_consistecy_mode_, bulk_load_,
+      // adaptive_batching_ and timeout_ms_ are not supposed to be accessed or modified from any other
+      // thread: no thread-safety is advertised for the kudu::KuduSession interface.
       scoped_refptr<Batcher> batcher(
           new Batcher(client_.get(), error_collector_, session_,
-                      external_consistency_mode_));
+                      external_consistency_mode_, bulk_load_, adaptive_batching_));
       if (timeout_.Initialized()) {
         batcher->SetTimeout(timeout_);
       }
@@ -442,11 +482,10 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
     }
     // Finally, update the buffer space usage.
     buffer_bytes_used_ += required_size;
+    flush_watermark = FlushWatermarkUnlocked();
   }
 
   if (flush_mode == AUTO_FLUSH_BACKGROUND) {
-    const size_t flush_watermark =
-        buffer_bytes_limit_ * buffer_watermark_pct_ / 100;
     // In AUTO_FLUSH_BACKGROUND mode it's necessary to flush the newly added
     // operations if the flush watermark is reached. The current batcher is
     // the exclusive and the only container for the newly added operations.
@@ -458,6 +497,54 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
   return Status::OK();
 }
 
+int64_t KuduSession::Data::FlushWatermarkUnlocked() const {
+  mutex_.AssertAcquired();
+  const int64_t watermark = buffer_bytes_limit_ * buffer_watermark_pct_ / 100;
+  if (adaptive_batching_ && adaptive_flush_watermark_ > 0) {
+    return std::min(adaptive_flush_watermark_, watermark);
+  }
+  return watermark;
+}
+
+void KuduSession::Data::UpdateAdaptiveFlushWatermarkUnlocked(const Batcher* batcher) {
+  mutex_.AssertAcquired();
+  // The weight of the latest sample in the moving averages.
+  static const double kSampleWeight = 0.2;
+  // The adaptive watermark doesn't go below this, so that batches don't
+  // degrade into a stream of tiny RPCs.
+  static const int64_t kMinAdaptiveFlushWatermark = 32 * 1024;
+  static const int kMaxBackpressureFactor = 64;
+
+  const MonoTime first_op_time = batcher->first_op_time();
+  const MonoTime flush_start_time = batcher->flush_start_time();
+  if (PREDICT_FALSE(!first_op_time.Initialized() || !flush_start_time.Initialized())) {
+    return;
+  }
+  const double gather_secs = (flush_start_time - first_op_time).ToSeconds();
+  const double flush_secs = (MonoTime::Now() - flush_start_time).ToSeconds();
+  const int64_t bytes = batcher->buffer_bytes_used();
+  auto update_avg = [](double sample, double* avg) {
+    *avg = *avg == 0 ? sample : kSampleWeight * sample + (1 - kSampleWeight) * *avg;
+  };
+  if (gather_secs > 0 && bytes > 0) {
+    update_avg(bytes / gather_secs, &apply_rate_avg_);
+  }
+  update_avg(flush_secs, &flush_latency_avg_);
+
+  if (batcher->had_backpressure()) {
+    backpressure_factor_ = std::min(backpressure_factor_ * 2, kMaxBackpressureFactor);
+  } else if (backpressure_factor_ > 1) {
+    backpressure_factor_ /= 2;
+  }
+
+  // Computed as a double, and capped by the buffer size, to not overflow.
+  const double watermark =
+      apply_rate_avg_ * flush_latency_avg_ * backpressure_factor_;
+  adaptive_flush_watermark_ = std::max(
+      kMinAdaptiveFlushWatermark,
+      static_cast<int64_t>(std::min(watermark, static_cast<double>(buffer_bytes_limit_))));
+}
+
 void KuduSession::Data::TimeBasedFlushInit() {
   KuduSession::Data::TimeBasedFlushTask(
       Status::OK(), messenger_, session_, true);
@@ -81,6 +81,12 @@ class KuduSession::Data {
   // Set external consistency mode for the session.
   Status SetExternalConsistencyMode(KuduSession::ExternalConsistencyMode m);
 
+  // Set whether the session's writes are sent as bulk loads.
+  Status SetBulkLoad(bool enable);
+
+  // Set whether the session's write batches are sized and sent adaptively.
+  Status SetAdaptiveBatching(bool enable);
+
   // Set limit on buffer space consumed by buffered write operations.
   Status SetBufferBytesLimit(size_t size);
 
@@ -136,6 +142,14 @@ class KuduSession::Data {
   // Check and start the time-based flush task in background, if necessary.
   void TimeBasedFlushInit();
 
+  // Get the flush watermark (in bytes) for fresh operations in
+  // AUTO_FLUSH_BACKGROUND mode.
+  int64_t FlushWatermarkUnlocked() const;
+
+  // With adaptive batching, updates the flush watermark given the flushed
+  // 'batcher': see 'adaptive_flush_watermark_' below.
+  void UpdateAdaptiveFlushWatermarkUnlocked(const internal::Batcher* batcher);
+
   // The self-rescheduling task to flush write operations which have been
   // accumulating for too long (controlled by flush_interval_).
   // This does real work only in case of AUTO_FLUSH_BACKGROUND mode.
@@ -180,6 +194,13 @@ class KuduSession::Data {
 
   kudu::client::KuduSession::ExternalConsistencyMode external_consistency_mode_;
 
+  // Whether write requests are sent as bulk loads.
+  bool bulk_load_;
+
+  // Whether write batches are sized and sent adaptively.
+  // See KuduSession::SetAdaptiveBatching().
+  bool adaptive_batching_;
+
   // Timeout for the next batch.
   MonoDelta timeout_;
 
@@ -237,6 +258,27 @@ class KuduSession::Data {
   // The total number of bytes used by buffered write operations.
   int64_t buffer_bytes_used_;  // protected by mutex_
 
+  // With adaptive batching, the flush watermark (in bytes) used instead of
+  // the one set by buffer_watermark_pct_, which remains its upper bound.
+  //
+  // A batch is flushed once it holds about as much data as is applied while
+  // the previous batch is being flushed: by then, the previous batch has
+  // likely completed, so batches are kept small without leaving the session
+  // waiting for the tablet servers. While tablet servers push back, the
+  // watermark is doubled for each batch which saw the pushback, so that
+  // fewer, larger batches are sent; the factor is halved back for each batch which
+  // didn't see any.
+  int64_t adaptive_flush_watermark_;  // protected by mutex_
+
+  // Moving averages of the rate at which data is applied to the session
+  // (bytes per second) and of the time it takes to flush a batch (seconds).
+  double apply_rate_avg_;  // protected by mutex_
+  double flush_latency_avg_;  // protected by mutex_
+
+  // The factor the adaptive flush watermark is scaled by due to pushback
+  // from the tablet servers.
+  int backpressure_factor_;  // protected by mutex_
+
  private:
   FRIEND_TEST(ClientTest, TestAutoFlushBackgroundApplyBlocks);
   FRIEND_TEST(ClientTest, TestAutoFlushBackgroundAndErrorCollector);
@@ -38,7 +38,9 @@ class ColumnMaterializationContext {
       pred_(pred),
       block_(block),
       sel_(sel),
-      decoder_eval_status_(kNotSet) {
+      decoder_eval_status_(kNotSet),
+      materialize_selected_rows_only_(false),
+      values_may_be_updated_(false) {
       if (!pred_ || !sel || !block) {
         decoder_eval_status_ = kDecoderEvalNotSupported;
       }
@@ -73,6 +75,35 @@ class ColumnMaterializationContext {
     return decoder_eval_status_ != kDecoderEvalNotSupported;
   }
 
+  // Checked during materialization to determine whether the rows which are
+  // already deselected in sel() may be left unmaterialized in block(). If
+  // true, iterators may skip over the data of those rows, leaving their cells
+  // (including their null bits) undefined.
+  bool materialize_selected_rows_only() const {
+    return materialize_selected_rows_only_;
+  }
+
+  // Allows the rows which are deselected in sel() when materialization starts
+  // to be left unmaterialized. Requires sel() to be non-null.
+  void SetMaterializeSelectedRowsOnly() {
+    DCHECK(sel_ != nullptr);
+    materialize_selected_rows_only_ = true;
+  }
+
+  // Checked during materialization to determine whether the values read from
+  // the base data may be changed by updates before the predicate is evaluated.
+  // If false, iterators may use statistics of the base data, such as a
+  // CFile's zone map, to deselect rows which can't satisfy pred().
+  bool values_may_be_updated() const {
+    return values_may_be_updated_;
+  }
+
+  // Should be called before materializing a column if updates may be applied
+  // to the base data.
+  void SetValuesMayBeUpdated() {
+    values_may_be_updated_ = true;
+  }
+
   // Checked during materialization to determine whether null values should be
   // cleared in the results vector.
   bool EvaluatingIsNull() const {
@@ -138,6 +169,10 @@ class ColumnMaterializationContext {
   SelectionVector* const sel_;
 
   DecoderEvalStatus decoder_eval_status_;
+
+  bool materialize_selected_rows_only_;
+
+  bool values_may_be_updated_;
 };
 
 } // namespace kudu
@@ -0,0 +1,135 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/random.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_bool(predicate_eval_wordwise);
+DEFINE_int32(predicate_bench_num_rows, 64 * 1024,
+             "The number of rows of the column block the predicates are evaluated on");
+DEFINE_int32(predicate_bench_iterations, 200,
+             "The number of times each predicate is evaluated on the block");
+
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+// The number of distinct values in the benchmarked columns.
+static constexpr int kNumDistinctValues = 1000;
+
+// Compares the time it takes to evaluate predicates row by row and 64 rows
+// at a time (see --predicate_eval_wordwise), for a range of selectivities.
+class ColumnPredicateBench : public KuduTest,
+                             public testing::WithParamInterface<double> {
+ protected:
+  // Returns the number of rows per second at which 'pred' is evaluated on
+  // 'block', all of whose rows are initially selected.
+  double RowsPerSecond(const ColumnPredicate& pred, const ColumnBlock& block) {
+    SelectionVector sel(block.nrows());
+    Stopwatch sw;
+    sw.start();
+    for (int i = 0; i < FLAGS_predicate_bench_iterations; i++) {
+      sel.SetAllTrue();
+      pred.Evaluate(block, &sel);
+    }
+    sw.stop();
+    return static_cast<double>(block.nrows()) * FLAGS_predicate_bench_iterations /
+        sw.elapsed().wall_seconds();
+  }
+
+  void Compare(const ColumnPredicate& pred, const ColumnBlock& block) {
+    FLAGS_predicate_eval_wordwise = false;
+    double rowwise = RowsPerSecond(pred, block);
+    FLAGS_predicate_eval_wordwise = true;
+    double wordwise = RowsPerSecond(pred, block);
+    LOG(INFO) << Substitute("$0 on $1 (selectivity $2): row by row $3 Mrows/s, "
+                            "wordwise $4 Mrows/s, speedup $5x",
+                            pred.ToString(), block.type_info()->name(), GetParam(),
+                            StringPrintf("%.1f", rowwise / 1e6),
+                            StringPrintf("%.1f", wordwise / 1e6),
+                            StringPrintf("%.2f", wordwise / rowwise));
+  }
+
+  // Benchmarks a range predicate matching about the fraction GetParam() of
+  // the rows of a nullable column of the given type, as well as IN list and
+  // IS NOT NULL predicates on it.
+  template <DataType Type>
+  void RunBench() {
+    typedef typename DataTypeTraits<Type>::cpp_type T;
+    ColumnSchema column("c", Type, true);
+    Random rand(SeedRandom());
+    ScopedColumnBlock<Type> block(FLAGS_predicate_bench_num_rows);
+    for (int i = 0; i < block.nrows(); i++) {
+      block[i] = static_cast<T>(rand.Uniform(kNumDistinctValues));
+      block.SetCellIsNull(i, rand.OneIn(20));
+    }
+
+    const int num_matching = static_cast<int>(GetParam() * kNumDistinctValues);
+    const T lower = 0;
+    const T upper = static_cast<T>(num_matching);
+    Compare(ColumnPredicate::Range(column, &lower, &upper), block);
+
+    // IN lists up to 16 values are evaluated differently than longer ones,
+    // so benchmark both.
+    for (int list_size : { 8, 64 }) {
+      vector<T> values;
+      for (int i = 0; i < list_size; i++) {
+        // Spread the values over the range of the column.
+        values.push_back(static_cast<T>(i * kNumDistinctValues / list_size));
+      }
+      vector<const void*> value_ptrs;
+      for (const T& value : values) {
+        value_ptrs.push_back(&value);
+      }
+      Compare(ColumnPredicate::InList(column, &value_ptrs), block);
+    }
+
+    Compare(ColumnPredicate::IsNotNull(column), block);
+  }
+};
+
+INSTANTIATE_TEST_CASE_P(Selectivities, ColumnPredicateBench,
+                        testing::Values(0.01, 0.1, 0.5, 0.9));
+
+TEST_P(ColumnPredicateBench, RunBench) {
+  NO_FATALS(RunBench<INT16>());
+  NO_FATALS(RunBench<INT32>());
+  NO_FATALS(RunBench<INT64>());
+  NO_FATALS(RunBench<DOUBLE>());
+}
+
+} // namespace kudu
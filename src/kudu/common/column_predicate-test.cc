@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -26,15 +27,23 @@
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/int128.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/random.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(predicate_eval_wordwise);
+
 using std::vector;
 
 namespace kudu {
@@ -68,6 +77,62 @@ class TestColumnPredicate : public KuduTest {
     ASSERT_EQ(b_base.predicate_type(), type);
   }
 
+  // Checks that evaluating predicates on a block of the given type 64 rows at
+  // a time selects the same rows as evaluating them row by row.
+  template <DataType Type>
+  void TestWordwiseEvaluation() {
+    typedef typename DataTypeTraits<Type>::cpp_type T;
+    ColumnSchema column("c", Type, true);
+    Random rand(SeedRandom());
+
+    // The last group of 64 rows is only partially filled.
+    const int kNumRows = 16 * 64 + 13;
+    ScopedColumnBlock<Type> block(kNumRows);
+    vector<uint8_t> initial_sel(BitmapSize(kNumRows));
+    for (int i = 0; i < kNumRows; i++) {
+      block[i] = static_cast<T>(static_cast<int>(rand.Uniform(100)) - 50);
+      block.SetCellIsNull(i, rand.OneIn(10));
+      BitmapChange(initial_sel.data(), i, !rand.OneIn(4));
+    }
+    // A fully deselected group of rows.
+    BitmapChangeBits(initial_sel.data(), 128, 64, false);
+
+    vector<T> values;
+    for (int i = -60; i < 60; i += 3) {
+      values.push_back(static_cast<T>(i));
+    }
+    vector<const void*> short_list = { &values[3], &values[10], &values[11], &values[30] };
+    vector<const void*> long_list;
+    for (const T& value : values) {
+      long_list.push_back(&value);
+    }
+    vector<ColumnPredicate> predicates = {
+      ColumnPredicate::Range(column, &values[5], nullptr),
+      ColumnPredicate::Range(column, nullptr, &values[20]),
+      ColumnPredicate::Range(column, &values[5], &values[20]),
+      ColumnPredicate::Equality(column, &values[10]),
+      ColumnPredicate::InList(column, &short_list),
+      ColumnPredicate::InList(column, &long_list),
+      ColumnPredicate::IsNotNull(column),
+      ColumnPredicate::IsNull(column),
+    };
+
+    for (const ColumnPredicate& pred : predicates) {
+      SCOPED_TRACE(pred.ToString());
+      SelectionVector rowwise(kNumRows);
+      SelectionVector wordwise(kNumRows);
+      memcpy(rowwise.mutable_bitmap(), initial_sel.data(), initial_sel.size());
+      memcpy(wordwise.mutable_bitmap(), initial_sel.data(), initial_sel.size());
+      FLAGS_predicate_eval_wordwise = false;
+      pred.Evaluate(block, &rowwise);
+      FLAGS_predicate_eval_wordwise = true;
+      pred.Evaluate(block, &wordwise);
+      for (int i = 0; i < kNumRows; i++) {
+        ASSERT_EQ(rowwise.IsRowSelected(i), wordwise.IsRowSelected(i)) << "row " << i;
+      }
+    }
+  }
+
   template <typename T>
   void TestMergeCombinations(const ColumnSchema& column, vector<T> values) {
     // Range + Range
@@ -1154,6 +1219,164 @@ TEST_F(TestColumnPredicate, TestSelectivity) {
             0);
 }
 
+// Bloom filter keys of fixed-length cells are little-endian on every host, as
+// clients build the filters from the little-endian encoding of their values.
+TEST_F(TestColumnPredicate, TestBloomKeyForCell) {
+  ColumnPredicate::BloomKeyBuffer buf;
+  int32_t i32 = 0x01020304;
+  ASSERT_EQ(Slice("\x04\x03\x02\x01", 4), ColumnPredicate::BloomKeyForCell<INT32>(&i32, &buf));
+  int64_t i64 = 0x0102030405060708;
+  ASSERT_EQ(Slice("\x08\x07\x06\x05\x04\x03\x02\x01", 8),
+            ColumnPredicate::BloomKeyForCell<INT64>(&i64, &buf));
+  Slice binary("abc");
+  ASSERT_EQ(binary, ColumnPredicate::BloomKeyForCell<BINARY>(&binary, &buf));
+}
+
+// Test the InBloomFilter constructor, merges, and evaluation.
+TEST_F(TestColumnPredicate, TestInBloomFilter) {
+  ColumnSchema column("c", INT32, true);
+  int32_t zero = 0, five = 5, six = 6, eight = 8, ten = 10;
+  ColumnPredicate::BloomKeyBuffer buf;
+  auto key = [&] (const int32_t* v) {
+    return ColumnPredicate::BloomKeyForCell<INT32>(v, &buf);
+  };
+
+  // 'bfb' contains the multiples of 5 in [0, 100), while 'empty_bfb' contains
+  // nothing, so that probing it never yields a false positive.
+  BloomFilterBuilder bfb(BloomFilterSizing::ByCountAndFPRate(20, 0.01),
+                         BloomFilterLayout::kCacheBlocked);
+  for (int32_t i = 0; i < 100; i += 5) {
+    bfb.AddKey(BloomKeyProbe(key(&i)));
+  }
+  BloomFilterBuilder empty_bfb(BloomFilterSizing::ByCountAndFPRate(20, 0.01));
+  BloomFilter bf(bfb.slice(), bfb.n_hashes(), bfb.layout());
+  BloomFilter empty_bf(empty_bfb.slice(), empty_bfb.n_hashes());
+  auto bloom = [&] (const BloomFilter& f, const void* lower, const void* upper) {
+    vector<BloomFilter> filters = { f };
+    return ColumnPredicate::InBloomFilter(column, &filters, lower, upper);
+  };
+
+  // Simplification.
+  vector<BloomFilter> no_filters;
+  ASSERT_EQ(PredicateType::IsNotNull,
+            ColumnPredicate::InBloomFilter(column, &no_filters, nullptr, nullptr).predicate_type());
+  ASSERT_EQ(ColumnPredicate::Range(column, &five, &ten),
+            ColumnPredicate::InBloomFilter(column, &no_filters, &five, &ten));
+  ASSERT_EQ(PredicateType::InBloomFilter, bloom(bf, nullptr, nullptr).predicate_type());
+  ASSERT_EQ(ColumnPredicate::Equality(column, &five), bloom(bf, &five, &six));
+  ASSERT_EQ(PredicateType::None, bloom(empty_bf, &five, &six).predicate_type());
+  ASSERT_EQ(PredicateType::None, bloom(bf, &ten, &five).predicate_type());
+
+  // Merges.
+  TestMerge(bloom(bf, nullptr, nullptr),
+            ColumnPredicate::Range(column, &zero, &eight),
+            bloom(bf, &zero, &eight),
+            PredicateType::InBloomFilter);
+  TestMerge(bloom(bf, &zero, &eight),
+            ColumnPredicate::Range(column, &five, &ten),
+            bloom(bf, &five, &eight),
+            PredicateType::InBloomFilter);
+  TestMerge(bloom(bf, nullptr, nullptr),
+            ColumnPredicate::Equality(column, &five),
+            ColumnPredicate::Equality(column, &five),
+            PredicateType::Equality);
+  TestMerge(bloom(empty_bf, nullptr, nullptr),
+            ColumnPredicate::Equality(column, &five),
+            ColumnPredicate::None(column),
+            PredicateType::None);
+  vector<const void*> values = { &five, &ten };
+  TestMerge(bloom(bf, &zero, &eight),
+            ColumnPredicate::InList(column, &values),
+            ColumnPredicate::Equality(column, &five),
+            PredicateType::Equality);
+  values = { &five, &ten };
+  TestMerge(bloom(empty_bf, nullptr, nullptr),
+            ColumnPredicate::InList(column, &values),
+            ColumnPredicate::None(column),
+            PredicateType::None);
+  TestMerge(bloom(bf, nullptr, nullptr),
+            ColumnPredicate::IsNotNull(column),
+            bloom(bf, nullptr, nullptr),
+            PredicateType::InBloomFilter);
+  TestMerge(bloom(bf, nullptr, nullptr),
+            ColumnPredicate::IsNull(column),
+            ColumnPredicate::None(column),
+            PredicateType::None);
+  TestMerge(bloom(bf, nullptr, nullptr),
+            ColumnPredicate::None(column),
+            ColumnPredicate::None(column),
+            PredicateType::None);
+
+  // Merging two bloom filter predicates keeps both filters.
+  ColumnPredicate both = bloom(bf, &zero, nullptr);
+  both.Merge(bloom(empty_bf, nullptr, &ten));
+  ASSERT_EQ(PredicateType::InBloomFilter, both.predicate_type());
+  ASSERT_EQ(2, both.bloom_filters().size());
+  ASSERT_EQ(0, *static_cast<const int32_t*>(both.raw_lower()));
+  ASSERT_EQ(10, *static_cast<const int32_t*>(both.raw_upper()));
+  ASSERT_FALSE(both.EvaluateCell<INT32>(&five));
+
+  // The batched evaluation agrees with the evaluation of single cells, and
+  // selects every non-NULL cell within the bounds which is in the filter.
+  const int kNumRows = 300;
+  ScopedColumnBlock<INT32> block(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    block[i] = i % 100;
+    block.SetCellIsNull(i, i % 7 == 0);
+  }
+  int32_t forty = 40;
+  for (const auto& pred : { bloom(bf, nullptr, nullptr), bloom(bf, &ten, &forty) }) {
+    SCOPED_TRACE(pred.ToString());
+    SelectionVector sel(kNumRows);
+    sel.SetAllTrue();
+    BitmapClear(sel.mutable_bitmap(), 5);
+    pred.Evaluate(block, &sel);
+    for (int i = 0; i < kNumRows; i++) {
+      bool expected = i != 5 && !block.is_null(i) && pred.EvaluateCell<INT32>(&block[i]);
+      ASSERT_EQ(expected, sel.IsRowSelected(i)) << i;
+      if (i != 5 && !block.is_null(i) && block[i] % 5 == 0 &&
+          pred.raw_lower() == nullptr) {
+        ASSERT_TRUE(sel.IsRowSelected(i)) << i;
+      }
+    }
+  }
+}
+
+TEST_F(TestColumnPredicate, TestWordwiseEvaluation) {
+  NO_FATALS(TestWordwiseEvaluation<INT8>());
+  NO_FATALS(TestWordwiseEvaluation<INT16>());
+  NO_FATALS(TestWordwiseEvaluation<INT32>());
+  NO_FATALS(TestWordwiseEvaluation<INT64>());
+  NO_FATALS(TestWordwiseEvaluation<UNIXTIME_MICROS>());
+  NO_FATALS(TestWordwiseEvaluation<FLOAT>());
+  NO_FATALS(TestWordwiseEvaluation<DOUBLE>());
+}
+
+TEST_F(TestColumnPredicate, TestMayBeSatisfiedByRange) {
+  ColumnSchema column("a", INT32, true);
+  int32_t five = 5, ten = 10, fifteen = 15, twenty = 20;
+  vector<const void*> values = { &five, &twenty };
+
+  auto range = ColumnPredicate::Range(column, &ten, &twenty);
+  ASSERT_TRUE(range.MayBeSatisfiedByRange(&five, &ten));
+  ASSERT_TRUE(range.MayBeSatisfiedByRange(&fifteen, &fifteen));
+  ASSERT_FALSE(range.MayBeSatisfiedByRange(&twenty, nullptr));
+  ASSERT_FALSE(range.MayBeSatisfiedByRange(&five, &five));
+  ASSERT_TRUE(range.MayBeSatisfiedByRange(nullptr, nullptr));
+
+  auto eq = ColumnPredicate::Equality(column, &ten);
+  ASSERT_TRUE(eq.MayBeSatisfiedByRange(&five, &fifteen));
+  ASSERT_FALSE(eq.MayBeSatisfiedByRange(&fifteen, nullptr));
+
+  auto in_list = ColumnPredicate::InList(column, &values);
+  ASSERT_TRUE(in_list.MayBeSatisfiedByRange(&five, &five));
+  ASSERT_FALSE(in_list.MayBeSatisfiedByRange(&ten, &fifteen));
+  ASSERT_TRUE(in_list.MayBeSatisfiedByRange(&ten, nullptr));
+
+  ASSERT_TRUE(ColumnPredicate::IsNotNull(column).MayBeSatisfiedByRange(&five, &ten));
+  ASSERT_FALSE(ColumnPredicate::IsNull(column).MayBeSatisfiedByRange(&five, &ten));
+}
+
 TEST_F(TestColumnPredicate, TestRedaction) {
   ASSERT_NE("", gflags::SetCommandLineOption("redact", "log"));
   ColumnSchema column_i32("a", INT32, true);
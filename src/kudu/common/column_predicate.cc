@@ -18,18 +18,23 @@
 #include "kudu/common/column_predicate.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags.h>
 
 #include "kudu/common/columnblock.h"
 #include "kudu/common/key_util.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/gutil/endian.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/memory/arena.h"
 
@@ -37,6 +42,12 @@ using std::move;
 using std::string;
 using std::vector;
 
+DEFINE_bool(predicate_eval_wordwise, true,
+            "Whether to evaluate column predicates 64 rows at a time with branch-free "
+            "kernels where possible, rather than row by row");
+TAG_FLAG(predicate_eval_wordwise, hidden);
+TAG_FLAG(predicate_eval_wordwise, runtime);
+
 namespace kudu {
 
 ColumnPredicate::ColumnPredicate(PredicateType predicate_type,
@@ -59,6 +70,18 @@ ColumnPredicate::ColumnPredicate(PredicateType predicate_type,
   values_.swap(*values);
 }
 
+ColumnPredicate::ColumnPredicate(PredicateType predicate_type,
+                                 ColumnSchema column,
+                                 vector<BloomFilter>* bloom_filters,
+                                 const void* lower,
+                                 const void* upper)
+    : predicate_type_(predicate_type),
+      column_(move(column)),
+      lower_(lower),
+      upper_(upper) {
+  bloom_filters_.swap(*bloom_filters);
+}
+
 ColumnPredicate ColumnPredicate::Equality(ColumnSchema column, const void* value) {
   CHECK(value != nullptr);
   return ColumnPredicate(PredicateType::Equality, move(column), value, nullptr);
@@ -157,6 +180,16 @@ ColumnPredicate ColumnPredicate::IsNull(ColumnSchema column) {
          None(move(column));
 }
 
+ColumnPredicate ColumnPredicate::InBloomFilter(ColumnSchema column,
+                                               vector<BloomFilter>* bloom_filters,
+                                               const void* lower,
+                                               const void* upper) {
+  CHECK(bloom_filters != nullptr);
+  ColumnPredicate pred(PredicateType::InBloomFilter, move(column), bloom_filters, lower, upper);
+  pred.Simplify();
+  return pred;
+}
+
 ColumnPredicate ColumnPredicate::None(ColumnSchema column) {
   return ColumnPredicate(PredicateType::None, move(column), nullptr, nullptr);
 }
@@ -165,6 +198,7 @@ void ColumnPredicate::SetToNone() {
   predicate_type_ = PredicateType::None;
   lower_ = nullptr;
   upper_ = nullptr;
+  bloom_filters_.clear();
 }
 
 // TODO: For decimal columns, use column_.type_attributes().precision
@@ -229,6 +263,43 @@ void ColumnPredicate::Simplify() {
       }
       return;
     };
+    case PredicateType::InBloomFilter: {
+      if (bloom_filters_.empty()) {
+        // Without any filters, only the bounds are left.
+        if (lower_ == nullptr && upper_ == nullptr) {
+          predicate_type_ = PredicateType::IsNotNull;
+        } else {
+          predicate_type_ = PredicateType::Range;
+          Simplify();
+        }
+        return;
+      }
+      if (lower_ != nullptr && type_info->IsMinValue(lower_)) {
+        // VALUE >= MIN always holds.
+        lower_ = nullptr;
+      }
+      if (upper_ != nullptr && type_info->IsMinValue(upper_)) {
+        // VALUE < MIN never holds.
+        SetToNone();
+      } else if (lower_ != nullptr && upper_ != nullptr &&
+                 type_info->Compare(lower_, upper_) >= 0) {
+        // If the range bounds are empty then no results can be returned.
+        SetToNone();
+      } else if (lower_ != nullptr &&
+                 (upper_ == nullptr ? type_info->IsMaxValue(lower_)
+                                    : type_info->AreConsecutive(lower_, upper_))) {
+        // Only the lower bound is left in the range, so probing the filters
+        // with it settles the predicate.
+        if (EvaluateCell(type_info->physical_type(), lower_)) {
+          predicate_type_ = PredicateType::Equality;
+          upper_ = nullptr;
+          bloom_filters_.clear();
+        } else {
+          SetToNone();
+        }
+      }
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -257,10 +328,28 @@ void ColumnPredicate::Merge(const ColumnPredicate& other) {
       MergeIntoInList(other);
       return;
     };
+    case PredicateType::InBloomFilter: {
+      MergeIntoBloomFilter(other);
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
 
+void ColumnPredicate::IntersectBounds(const ColumnPredicate& other) {
+  // Set the lower bound to the larger of the two.
+  if (other.lower_ != nullptr &&
+      (lower_ == nullptr || column_.type_info()->Compare(lower_, other.lower_) < 0)) {
+    lower_ = other.lower_;
+  }
+
+  // Set the upper bound to the smaller of the two.
+  if (other.upper_ != nullptr &&
+      (upper_ == nullptr || column_.type_info()->Compare(upper_, other.upper_) > 0)) {
+    upper_ = other.upper_;
+  }
+}
+
 void ColumnPredicate::MergeIntoRange(const ColumnPredicate& other) {
   CHECK(predicate_type_ == PredicateType::Range);
 
@@ -271,18 +360,7 @@ void ColumnPredicate::MergeIntoRange(const ColumnPredicate& other) {
     };
 
     case PredicateType::Range: {
-      // Set the lower bound to the larger of the two.
-      if (other.lower_ != nullptr &&
-          (lower_ == nullptr || column_.type_info()->Compare(lower_, other.lower_) < 0)) {
-        lower_ = other.lower_;
-      }
-
-      // Set the upper bound to the smaller of the two.
-      if (other.upper_ != nullptr &&
-          (upper_ == nullptr || column_.type_info()->Compare(upper_, other.upper_) > 0)) {
-        upper_ = other.upper_;
-      }
-
+      IntersectBounds(other);
       Simplify();
       return;
     };
@@ -323,6 +401,14 @@ void ColumnPredicate::MergeIntoRange(const ColumnPredicate& other) {
       Simplify();
       return;
     };
+    case PredicateType::InBloomFilter: {
+      // The range narrows the bounds of the bloom filter predicate.
+      IntersectBounds(other);
+      bloom_filters_ = other.bloom_filters_;
+      predicate_type_ = PredicateType::InBloomFilter;
+      Simplify();
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -360,6 +446,13 @@ void ColumnPredicate::MergeIntoEquality(const ColumnPredicate& other) {
       }
       return;
     };
+    case PredicateType::InBloomFilter: {
+      // The equality value needs to pass the bounds and the filters.
+      if (!other.EvaluateCell(column_.type_info()->physical_type(), lower_)) {
+        SetToNone();
+      }
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -378,6 +471,7 @@ void ColumnPredicate::MergeIntoIsNotNull(const ColumnPredicate &other) {
       lower_ = other.lower_;
       upper_ = other.upper_;
       values_ = other.values_;
+      bloom_filters_ = other.bloom_filters_;
       return;
     }
   }
@@ -499,6 +593,72 @@ void ColumnPredicate::MergeIntoInList(const ColumnPredicate &other) {
       Simplify();
       return;
     };
+    case PredicateType::InBloomFilter: {
+      // Only the values which pass the bounds and the filters are retained.
+      DataType physical_type = column_.type_info()->physical_type();
+      values_.erase(std::remove_if(values_.begin(), values_.end(),
+                                   [&] (const void* v) {
+                                     return !other.EvaluateCell(physical_type, v);
+                                   }), values_.end());
+      Simplify();
+      return;
+    };
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
+void ColumnPredicate::MergeIntoBloomFilter(const ColumnPredicate& other) {
+  CHECK(predicate_type_ == PredicateType::InBloomFilter);
+
+  switch (other.predicate_type()) {
+    case PredicateType::None: {
+      SetToNone();
+      return;
+    };
+    case PredicateType::Range: {
+      IntersectBounds(other);
+      Simplify();
+      return;
+    };
+    case PredicateType::Equality: {
+      if (EvaluateCell(column_.type_info()->physical_type(), other.lower_)) {
+        predicate_type_ = PredicateType::Equality;
+        lower_ = other.lower_;
+        upper_ = nullptr;
+        bloom_filters_.clear();
+      } else {
+        SetToNone();
+      }
+      return;
+    };
+    case PredicateType::IsNotNull: return;
+    case PredicateType::IsNull: {
+      SetToNone();
+      return;
+    };
+    case PredicateType::InList: {
+      // The InList is more selective, so the predicate becomes an InList of
+      // the values which pass the bounds and the filters.
+      DataType physical_type = column_.type_info()->physical_type();
+      values_ = other.values_;
+      values_.erase(std::remove_if(values_.begin(), values_.end(),
+                                   [&] (const void* v) {
+                                     return !EvaluateCell(physical_type, v);
+                                   }), values_.end());
+      predicate_type_ = PredicateType::InList;
+      lower_ = nullptr;
+      upper_ = nullptr;
+      bloom_filters_.clear();
+      Simplify();
+      return;
+    };
+    case PredicateType::InBloomFilter: {
+      IntersectBounds(other);
+      bloom_filters_.insert(bloom_filters_.end(),
+                            other.bloom_filters_.begin(), other.bloom_filters_.end());
+      Simplify();
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -524,11 +684,193 @@ void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
     }
   }
 }
+
+// Loads the 'n_bytes' (between 1 and 8) bytes of a bitmap at 'p' into a word
+// in which bit i is bit i of the bitmap, whatever the host's byte order.
+inline uint64_t LoadBitmapWord(const uint8_t* p, size_t n_bytes) {
+  if (PREDICT_TRUE(n_bytes == 8)) {
+    return LittleEndian::Load64(p);
+  }
+  uint64_t word = 0;
+  for (size_t i = 0; i < n_bytes; i++) {
+    word |= static_cast<uint64_t>(p[i]) << (i * 8);
+  }
+  return word;
+}
+
+// The inverse of LoadBitmapWord().
+inline void StoreBitmapWord(uint8_t* p, size_t n_bytes, uint64_t word) {
+  if (PREDICT_TRUE(n_bytes == 8)) {
+    LittleEndian::Store64(p, word);
+    return;
+  }
+  for (size_t i = 0; i < n_bytes; i++) {
+    p[i] = static_cast<uint8_t>(word >> (i * 8));
+  }
+}
+
+// Calls 'f(word, start, n, non_null)' for each group of (up to) 64 rows of
+// 'block', where 'word' is the group's word of the selection vector, 'start'
+// the index of the group's first row, 'n' the number of rows in the group,
+// and 'non_null' the group's word of the null bitmap, or all ones if the
+// block isn't nullable. The word returned by 'f' replaces the
+// selection bits of the group; groups whose rows are all deselected are
+// skipped.
+template <typename F>
+void ForEachSelectionWord(const ColumnBlock& block, SelectionVector* sel, const F& f) {
+  uint8_t* sel_bitmap = sel->mutable_bitmap();
+  const uint8_t* null_bitmap = block.null_bitmap();
+  const size_t nrows = block.nrows();
+  for (size_t start = 0; start < nrows; start += 64) {
+    const size_t n = std::min<size_t>(64, nrows - start);
+    const size_t n_bytes = BitmapSize(n);
+    uint8_t* sel_p = sel_bitmap + start / 8;
+    uint64_t word = LoadBitmapWord(sel_p, n_bytes);
+    // The bits past the end of the block are left as they are.
+    const uint64_t tail = n == 64 ? 0 : ~static_cast<uint64_t>(0) << n;
+    if ((word & ~tail) == 0) continue;
+    uint64_t non_null = null_bitmap == nullptr ?
+        ~static_cast<uint64_t>(0) : LoadBitmapWord(null_bitmap + start / 8, n_bytes);
+    StoreBitmapWord(sel_p, n_bytes, (f(word, start, n, non_null) & ~tail) | (word & tail));
+  }
+}
+
+// Like ApplyPredicate(), but for a block of fixed-width values of type T.
+//
+// Rather than testing and clearing the selection bits one row at a time, the
+// predicate is evaluated on all of a group of 64 cells, selected or not, with
+// a loop free of branches that the compiler can vectorize for the SIMD
+// instructions of the target, and the resulting word of matches is combined
+// with the selection and null bitmaps with a few bitwise operations. This
+// pays off when at least a few rows of each group are selected, which
+// ForEachSelectionWord() helps with by skipping fully deselected groups.
+template <typename T, typename P>
+void ApplyPredicateWordwise(const ColumnBlock& block, SelectionVector* sel, P p) {
+  const T* data = reinterpret_cast<const T*>(block.data());
+  ForEachSelectionWord(block, sel, [&] (uint64_t word, size_t start, size_t n, uint64_t non_null) {
+    const T* vals = data + start;
+    uint64_t matches = 0;
+    if (PREDICT_TRUE(n == 64)) {
+      for (size_t i = 0; i < 64; i++) {
+        matches |= static_cast<uint64_t>(p(vals[i])) << i;
+      }
+    } else {
+      for (size_t i = 0; i < n; i++) {
+        matches |= static_cast<uint64_t>(p(vals[i])) << i;
+      }
+    }
+    return word & matches & non_null;
+  });
+}
+
+// Whether predicates on columns of the physical type can be evaluated by
+// WordwiseEvaluator.
+constexpr bool IsWordwiseType(DataType type) {
+  return type == INT8 || type == INT16 || type == INT32 || type == INT64 ||
+         type == UINT8 || type == UINT16 || type == UINT32 || type == UINT64 ||
+         type == FLOAT || type == DOUBLE;
+}
+
+// IN lists up to this size are evaluated by comparing each cell against all
+// of the values, which vectorizes; larger ones with a binary search.
+const size_t kMaxLinearInListSize = 16;
+
+// Evaluates Range, Equality and InList predicates on a block of the physical
+// type with ApplyPredicateWordwise(). Evaluate() returns false, leaving 'sel'
+// untouched, if the predicate or type isn't supported.
+template <DataType PhysicalType, bool = IsWordwiseType(PhysicalType)>
+struct WordwiseEvaluator {
+  static bool Evaluate(const ColumnPredicate& /* pred */,
+                       const ColumnBlock& /* block */,
+                       SelectionVector* /* sel */) {
+    return false;
+  }
+};
+
+template <DataType PhysicalType>
+struct WordwiseEvaluator<PhysicalType, true> {
+  typedef typename DataTypeTraits<PhysicalType>::cpp_type T;
+
+  // The comparisons mirror DataTypeTraits<PhysicalType>::Compare(), under
+  // which a NaN compares equal to any value. '&' rather than '&&' keeps the
+  // kernels free of branches.
+  static bool Less(T a, T b) { return a < b; }
+  static bool Equal(T a, T b) { return !(a < b) & !(b < a); }
+
+  static bool Evaluate(const ColumnPredicate& pred,
+                       const ColumnBlock& block,
+                       SelectionVector* sel) {
+    switch (pred.predicate_type()) {
+      case PredicateType::Range: {
+        if (pred.raw_lower() == nullptr) {
+          const T upper = UnalignedLoad<T>(pred.raw_upper());
+          ApplyPredicateWordwise<T>(block, sel, [upper] (T v) { return Less(v, upper); });
+        } else if (pred.raw_upper() == nullptr) {
+          const T lower = UnalignedLoad<T>(pred.raw_lower());
+          ApplyPredicateWordwise<T>(block, sel, [lower] (T v) { return !Less(v, lower); });
+        } else {
+          const T lower = UnalignedLoad<T>(pred.raw_lower());
+          const T upper = UnalignedLoad<T>(pred.raw_upper());
+          ApplyPredicateWordwise<T>(block, sel, [lower, upper] (T v) {
+            return !Less(v, lower) & Less(v, upper);
+          });
+        }
+        return true;
+      };
+      case PredicateType::Equality: {
+        const T value = UnalignedLoad<T>(pred.raw_lower());
+        ApplyPredicateWordwise<T>(block, sel, [value] (T v) { return Equal(v, value); });
+        return true;
+      };
+      case PredicateType::InList: {
+        vector<T> values;
+        values.reserve(pred.raw_values().size());
+        for (const void* value : pred.raw_values()) {
+          values.push_back(UnalignedLoad<T>(value));
+        }
+        if (values.size() <= kMaxLinearInListSize) {
+          ApplyPredicateWordwise<T>(block, sel, [&values] (T v) {
+            bool found = false;
+            for (T value : values) {
+              found |= Equal(v, value);
+            }
+            return found;
+          });
+        } else {
+          // A binary search in which the only branch is the loop, whose trip
+          // count is the same for every cell.
+          const T* first = values.data();
+          const size_t size = values.size();
+          ApplyPredicateWordwise<T>(block, sel, [first, size] (T v) {
+            const T* base = first;
+            size_t len = size;
+            while (len > 1) {
+              size_t half = len / 2;
+              base = Less(base[half], v) ? base + half : base;
+              len -= half;
+            }
+            // 'base' is now the lower bound of 'v', or the element before it.
+            size_t idx = std::min<size_t>(base - first + Less(*base, v), size - 1);
+            return Equal(first[idx], v);
+          });
+        }
+        return true;
+      };
+      default:
+        return false;
+    }
+  }
+};
+
 } // anonymous namespace
 
 template <DataType PhysicalType>
 void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
                                               SelectionVector* sel) const {
+  if (FLAGS_predicate_eval_wordwise &&
+      WordwiseEvaluator<PhysicalType>::Evaluate(*this, block, sel)) {
+    return;
+  }
   switch (predicate_type()) {
     case PredicateType::Range: {
       if (lower_ == nullptr) {
@@ -555,8 +897,13 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
     };
     case PredicateType::IsNotNull: {
       if (!block.is_nullable()) return;
-      // TODO: make this more efficient by using bitwise operations on the
-      // null and selection vectors.
+      if (FLAGS_predicate_eval_wordwise) {
+        ForEachSelectionWord(block, sel, [] (uint64_t word, size_t /* start */, size_t /* n */,
+                                             uint64_t non_null) {
+          return word & non_null;
+        });
+        return;
+      }
       for (size_t i = 0; i < block.nrows(); i++) {
         if (sel->IsRowSelected(i) && block.is_null(i)) {
           BitmapClear(sel->mutable_bitmap(), i);
@@ -569,8 +916,13 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
         BitmapChangeBits(sel->mutable_bitmap(), 0, block.nrows(), false);
         return;
       }
-      // TODO(wdberkeley): make this more efficient by using bitwise operations on the
-      // null and selection vectors.
+      if (FLAGS_predicate_eval_wordwise) {
+        ForEachSelectionWord(block, sel, [] (uint64_t word, size_t /* start */, size_t /* n */,
+                                             uint64_t non_null) {
+          return word & ~non_null;
+        });
+        return;
+      }
       for (size_t i = 0; i < block.nrows(); i++) {
         if (sel->IsRowSelected(i) && !block.is_null(i)) {
           BitmapClear(sel->mutable_bitmap(), i);
@@ -587,11 +939,68 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
       });
       return;
     };
+    case PredicateType::InBloomFilter: {
+      EvaluateBloomFilterForPhysicalType<PhysicalType>(block, sel);
+      return;
+    };
     case PredicateType::None: LOG(FATAL) << "NONE predicate evaluation";
   }
   LOG(FATAL) << "unknown predicate type";
 }
 
+template <DataType PhysicalType>
+void ColumnPredicate::EvaluateBloomFilterForPhysicalType(const ColumnBlock& block,
+                                                         SelectionVector* sel) const {
+  // Apply the bounds first, since they are much cheaper than hashing the
+  // cells. This also deselects the NULL cells.
+  if (lower_ != nullptr || upper_ != nullptr) {
+    ApplyPredicate(block, sel, [this] (const void* cell) {
+      return (lower_ == nullptr || DataTypeTraits<PhysicalType>::Compare(cell, lower_) >= 0) &&
+             (upper_ == nullptr || DataTypeTraits<PhysicalType>::Compare(cell, upper_) < 0);
+    });
+  } else if (block.is_nullable()) {
+    for (size_t i = 0; i < block.nrows(); i++) {
+      if (sel->IsRowSelected(i) && block.is_null(i)) {
+        BitmapClear(sel->mutable_bitmap(), i);
+      }
+    }
+  }
+
+  // Then probe the filters a batch of rows at a time. The keys of all the
+  // selected rows of the batch are hashed up front, and each filter is then
+  // probed with the whole batch: the probes of a filter are independent, so
+  // their cache misses overlap rather than being serialized behind the
+  // hashing, and each filter only sees the rows that passed the previous ones.
+  static const size_t kBatchSize = 64;
+  BloomKeyProbe probes[kBatchSize];
+  BloomKeyBuffer key_bufs[kBatchSize];
+  size_t rows[kBatchSize];
+  uint8_t* bitmap = sel->mutable_bitmap();
+  for (size_t start = 0; start < block.nrows(); start += kBatchSize) {
+    size_t end = std::min(start + kBatchSize, block.nrows());
+    size_t n = 0;
+    for (size_t i = start; i < end; i++) {
+      if (!sel->IsRowSelected(i)) continue;
+      probes[n] = BloomKeyProbe(BloomKeyForCell<PhysicalType>(block.cell_ptr(i), &key_bufs[n]));
+      rows[n] = i;
+      n++;
+    }
+    for (const BloomFilter& bf : bloom_filters_) {
+      size_t n_passed = 0;
+      for (size_t j = 0; j < n; j++) {
+        if (bf.MayContainKey(probes[j])) {
+          probes[n_passed] = probes[j];
+          rows[n_passed] = rows[j];
+          n_passed++;
+        } else {
+          BitmapClear(bitmap, rows[j]);
+        }
+      }
+      n = n_passed;
+    }
+  }
+}
+
 bool ColumnPredicate::EvaluateCell(DataType type, const void* cell) const {
   switch (type) {
     case BOOL: return EvaluateCell<BOOL>(cell);
@@ -611,6 +1020,44 @@ bool ColumnPredicate::EvaluateCell(DataType type, const void* cell) const {
   }
 }
 
+bool ColumnPredicate::MayBeSatisfiedByRange(const void* min, const void* max) const {
+  const TypeInfo* type_info = column_.type_info();
+  if (min != nullptr && max != nullptr && type_info->Compare(min, max) == 0) {
+    return EvaluateCell(type_info->physical_type(), min);
+  }
+  // Returns true if 'value' may be within the range.
+  auto may_contain = [&] (const void* value) {
+    return (min == nullptr || type_info->Compare(min, value) <= 0) &&
+           (max == nullptr || type_info->Compare(max, value) >= 0);
+  };
+  switch (predicate_type_) {
+    case PredicateType::None:
+    case PredicateType::IsNull:
+      return false;
+    case PredicateType::IsNotNull:
+      return true;
+    case PredicateType::Equality:
+      return may_contain(lower_);
+    case PredicateType::Range:
+    case PredicateType::InBloomFilter:
+      return (upper_ == nullptr || min == nullptr || type_info->Compare(min, upper_) < 0) &&
+             (lower_ == nullptr || max == nullptr || type_info->Compare(max, lower_) >= 0);
+    case PredicateType::InList: {
+      // The values are sorted, so only the lowest one which isn't below the
+      // range needs to be checked.
+      auto it = values_.begin();
+      if (min != nullptr) {
+        it = std::lower_bound(values_.begin(), values_.end(), min,
+                              [&] (const void* lhs, const void* rhs) {
+                                return type_info->Compare(lhs, rhs) < 0;
+                              });
+      }
+      return it != values_.end() && may_contain(*it);
+    }
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
 void ColumnPredicate::Evaluate(const ColumnBlock& block, SelectionVector* sel) const {
   DCHECK(sel);
   switch (block.type_info()->physical_type()) {
@@ -666,6 +1113,17 @@ string ColumnPredicate::ToString() const {
       ss.append(")");
       return ss;
     };
+    case PredicateType::InBloomFilter: {
+      string ss = strings::Substitute("$0 IN BLOOM FILTER($1)",
+                                      column_.name(), bloom_filters_.size());
+      if (lower_ != nullptr) {
+        ss.append(strings::Substitute(" AND $0 >= $1", column_.name(), column_.Stringify(lower_)));
+      }
+      if (upper_ != nullptr) {
+        ss.append(strings::Substitute(" AND $0 < $1", column_.name(), column_.Stringify(upper_)));
+      }
+      return ss;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -675,15 +1133,29 @@ bool ColumnPredicate::operator==(const ColumnPredicate& other) const {
   if (predicate_type_ != other.predicate_type_) {
     return false;
   }
+  auto bounds_equal = [&] {
+    return (lower_ == other.lower_ ||
+            (lower_ != nullptr && other.lower_ != nullptr &&
+             column_.type_info()->Compare(lower_, other.lower_) == 0)) &&
+           (upper_ == other.upper_ ||
+            (upper_ != nullptr && other.upper_ != nullptr &&
+             column_.type_info()->Compare(upper_, other.upper_) == 0));
+  };
   switch (predicate_type_) {
     case PredicateType::Equality: return column_.type_info()->Compare(lower_, other.lower_) == 0;
-    case PredicateType::Range: {
-      return (lower_ == other.lower_ ||
-              (lower_ != nullptr && other.lower_ != nullptr &&
-               column_.type_info()->Compare(lower_, other.lower_) == 0)) &&
-             (upper_ == other.upper_ ||
-              (upper_ != nullptr && other.upper_ != nullptr &&
-               column_.type_info()->Compare(upper_, other.upper_) == 0));
+    case PredicateType::Range: return bounds_equal();
+    case PredicateType::InBloomFilter: {
+      if (!bounds_equal() || bloom_filters_.size() != other.bloom_filters_.size()) return false;
+      for (int i = 0; i < bloom_filters_.size(); i++) {
+        const BloomFilter& bf = bloom_filters_[i];
+        const BloomFilter& other_bf = other.bloom_filters_[i];
+        if (bf.n_hashes() != other_bf.n_hashes() ||
+            bf.layout() != other_bf.layout() ||
+            bf.data() != other_bf.data()) {
+          return false;
+        }
+      }
+      return true;
     };
     case PredicateType::InList: {
       if (values_.size() != other.values_.size()) return false;
@@ -720,8 +1192,9 @@ int SelectivityRank(const ColumnPredicate& predicate) {
     case PredicateType::IsNull: rank = 1; break;
     case PredicateType::Equality: rank = 2; break;
     case PredicateType::InList: rank = 3; break;
-    case PredicateType::Range: rank = 4; break;
-    case PredicateType::IsNotNull: rank = 5; break;
+    case PredicateType::InBloomFilter: rank = 4; break;
+    case PredicateType::Range: rank = 5; break;
+    case PredicateType::IsNotNull: rank = 6; break;
     default: LOG(FATAL) << "unknown predicate type";
   }
   return rank * (kLargestTypeSize + 1) + predicate.column().type_info()->size();
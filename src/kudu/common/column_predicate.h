@@ -18,6 +18,8 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -28,6 +30,9 @@
 #include "kudu/common/common.pb.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/bloom_filter.h"
+#include "kudu/util/slice.h"
 
 namespace kudu {
 
@@ -56,6 +61,12 @@ enum class PredicateType {
   // A predicate which evaluates to true if the column value is present in
   // a value list.
   InList,
+
+  // A predicate which evaluates to true if the column value may be present
+  // in each of a set of bloom filters, and falls within an optional range.
+  // Typically used to push the keys of the build side of a join down into
+  // the scan of the probe side.
+  InBloomFilter,
 };
 
 // A predicate which can be evaluated over a block of column values.
@@ -130,9 +141,52 @@ class ColumnPredicate {
   // The InList will be simplified into an Equality, Range or None if possible.
   static ColumnPredicate InList(ColumnSchema column, std::vector<const void*>* values);
 
+  // Creates a new IN <BLOOM FILTER> predicate for the column, which matches
+  // the values which may be contained in every one of the bloom filters and
+  // fall within the inclusive lower bound and the exclusive upper bound.
+  // Either or both of the bounds may be nullptr.
+  //
+  // The filters are keyed by BloomKeyForCell(). Neither the filters' data nor
+  // the bounds are copied, and they must outlive the returned predicate.
+  //
+  // The predicate will be simplified into a Range, IsNotNull, Equality or
+  // None predicate if possible.
+  static ColumnPredicate InBloomFilter(ColumnSchema column,
+                                       std::vector<BloomFilter>* bloom_filters,
+                                       const void* lower,
+                                       const void* upper);
+
   // Creates a new predicate which matches no values.
   static ColumnPredicate None(ColumnSchema column);
 
+  // Scratch space for BloomKeyForCell(), large enough for any fixed-length
+  // cell.
+  typedef uint8_t BloomKeyBuffer[16];
+
+  // Returns the key under which a cell of the given physical type is
+  // inserted into, or looked up in, the filters of an InBloomFilter
+  // predicate: the bytes of the value for variable-length types, and the
+  // little-endian encoding of the value for fixed-length types, so that
+  // clients and servers agree on the keys whatever their byte order. On
+  // big-endian hosts, the key is encoded into 'buf', which must outlive it.
+  template <DataType PhysicalType>
+  static Slice BloomKeyForCell(const void* cell, BloomKeyBuffer* buf) {
+    if (PhysicalType == BINARY) {
+      return *static_cast<const Slice*>(cell);
+    }
+    const size_t size = sizeof(typename DataTypeTraits<PhysicalType>::cpp_type);
+    DCHECK_LE(size, sizeof(*buf));
+#if defined(IS_LITTLE_ENDIAN)
+    return Slice(static_cast<const uint8_t*>(cell), size);
+#else
+    const uint8_t* src = static_cast<const uint8_t*>(cell);
+    for (size_t i = 0; i < size; i++) {
+      (*buf)[i] = src[size - 1 - i];
+    }
+    return Slice(*buf, size);
+#endif
+  }
+
   // Returns the type of this predicate.
   PredicateType predicate_type() const {
     return predicate_type_;
@@ -164,6 +218,14 @@ class ColumnPredicate {
   // same vector as block->selection_vector().
   void Evaluate(const ColumnBlock& block, SelectionVector* sel) const;
 
+  // Returns false if no non-NULL cell with a value in the range [min, max]
+  // could satisfy the predicate, e.g. if the range doesn't overlap a range
+  // predicate's bounds. Either bound may be null if it's unknown.
+  //
+  // NULL cells are not taken into account, so IsNull predicates always return
+  // false and IsNotNull predicates always return true.
+  bool MayBeSatisfiedByRange(const void* min, const void* max) const;
+
   // Evaluate the predicate on a single cell.
   template <DataType PhysicalType>
   bool EvaluateCell(const void* cell) const {
@@ -196,6 +258,14 @@ class ColumnPredicate {
                                     return DataTypeTraits<PhysicalType>::Compare(lhs, rhs) < 0;
                                   });
       };
+      case PredicateType::InBloomFilter: {
+        BloomKeyBuffer buf;
+        return (lower_ == nullptr ||
+                DataTypeTraits<PhysicalType>::Compare(cell, this->lower_) >= 0) &&
+               (upper_ == nullptr ||
+                DataTypeTraits<PhysicalType>::Compare(cell, this->upper_) < 0) &&
+               CheckValueInBloomFilters(BloomKeyProbe(BloomKeyForCell<PhysicalType>(cell, &buf)));
+      };
     }
     LOG(FATAL) << "unknown predicate type";
   }
@@ -212,13 +282,13 @@ class ColumnPredicate {
   // Predicates over different columns are not equal.
   bool operator==(const ColumnPredicate& other) const;
 
-  // Returns the raw lower bound value if this is a range predicate, or the
-  // equality value if this is an equality predicate.
+  // Returns the raw lower bound value if this is a range or bloom filter
+  // predicate, or the equality value if this is an equality predicate.
   const void* raw_lower() const {
     return lower_;
   }
 
-  // Returns the raw upper bound if this is a range predicate.
+  // Returns the raw upper bound if this is a range or bloom filter predicate.
   const void* raw_upper() const {
     return upper_;
   }
@@ -234,6 +304,11 @@ class ColumnPredicate {
     return values_;
   }
 
+  // Returns the bloom filters if this is a bloom filter predicate.
+  const std::vector<BloomFilter>& bloom_filters() const {
+    return bloom_filters_;
+  }
+
  private:
 
   friend class TestColumnPredicate;
@@ -249,6 +324,13 @@ class ColumnPredicate {
                   ColumnSchema column,
                   std::vector<const void*>* values);
 
+  // Creates a new InBloomFilter column predicate.
+  ColumnPredicate(PredicateType predicate_type,
+                  ColumnSchema column,
+                  std::vector<BloomFilter>* bloom_filters,
+                  const void* lower,
+                  const void* upper);
+
   // Transition to a None predicate type.
   void SetToNone();
 
@@ -267,12 +349,25 @@ class ColumnPredicate {
   // Merge another predicate into this IS NULL predicate.
   void MergeIntoIsNull(const ColumnPredicate& other);
 
+  // Merge another predicate into this InBloomFilter predicate.
+  void MergeIntoBloomFilter(const ColumnPredicate& other);
+
+  // Narrows the bounds of this Range or InBloomFilter predicate to those of
+  // another Range or InBloomFilter predicate.
+  void IntersectBounds(const ColumnPredicate& other);
+
   // Templated evaluation to inline the dispatch of comparator. Templating this
   // allows dispatch to occur only once per batch.
   template <DataType PhysicalType>
   void EvaluateForPhysicalType(const ColumnBlock& block,
                                SelectionVector* sel) const;
 
+  // Evaluates this InBloomFilter predicate, probing the filters a batch of
+  // rows at a time.
+  template <DataType PhysicalType>
+  void EvaluateBloomFilterForPhysicalType(const ColumnBlock& block,
+                                          SelectionVector* sel) const;
+
   // Merge another predicate into this InList predicate.
   void MergeIntoInList(const ColumnPredicate& other);
 
@@ -284,21 +379,36 @@ class ColumnPredicate {
   // whether a given value is in the list.
   bool CheckValueInList(const void* value) const;
 
+  // For an InBloomFilter type predicate, this helper function checks
+  // whether a given key may be in all of the filters. The bounds are not
+  // checked.
+  bool CheckValueInBloomFilters(const BloomKeyProbe& probe) const {
+    for (const BloomFilter& bf : bloom_filters_) {
+      if (!bf.MayContainKey(probe)) return false;
+    }
+    return true;
+  }
+
   // The type of this predicate.
   PredicateType predicate_type_;
 
   // The data type of the column. TypeInfo instances have a static lifetime.
   ColumnSchema column_;
 
-  // The inclusive lower bound value if this is a Range predicate, or the
-  // equality value if this is an Equality predicate.
+  // The inclusive lower bound value if this is a Range or InBloomFilter
+  // predicate, or the equality value if this is an Equality predicate.
   const void* lower_;
 
-  // The exclusive upper bound value if this is a Range predicate.
+  // The exclusive upper bound value if this is a Range or InBloomFilter
+  // predicate.
   const void* upper_;
 
   // The list of values to check column against if this is an InList predicate.
   std::vector<const void*> values_;
+
+  // The bloom filters to check column against if this is an InBloomFilter
+  // predicate.
+  std::vector<BloomFilter> bloom_filters_;
 };
 
 // Compares predicates according to selectivity. Predicates that match fewer
@@ -42,10 +42,12 @@
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/mathlimits.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
 
 DEFINE_int32(num_lists, 3, "Number of lists to merge");
 DEFINE_int32(num_rows, 1000, "Number of entries per list");
@@ -55,6 +57,7 @@ using std::make_shared;
 using std::shared_ptr;
 using std::string;
 using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 
@@ -247,6 +250,59 @@ TEST(TestMergeIterator, TestMergePredicate2) {
   TestMerge(predicate);
 }
 
+// Merges 'num_inputs' lists of FLAGS_num_rows rows each, and verifies that the
+// result is sorted. 'overlap' controls how much the key ranges of consecutive
+// lists overlap: 0 means that the lists are disjoint, 1 that they all span
+// the same range of keys.
+void RunMergeBenchmark(int num_inputs, double overlap) {
+  // Keys within a list are spaced so that 'num_inputs' fully overlapping
+  // lists interleave without duplicates.
+  const uint32_t span = FLAGS_num_rows * num_inputs;
+  vector<shared_ptr<RowwiseIterator>> to_merge;
+  for (int i = 0; i < num_inputs; i++) {
+    vector<uint32_t> ints;
+    ints.reserve(FLAGS_num_rows);
+    uint32_t start = i + static_cast<uint32_t>(i * span * (1 - overlap));
+    for (int j = 0; j < FLAGS_num_rows; j++) {
+      ints.push_back(start + j * num_inputs);
+    }
+    shared_ptr<VectorIterator> it(new VectorIterator(ints));
+    it->set_block_size(100);
+    to_merge.emplace_back(new MaterializingIterator(it));
+  }
+
+  LOG_TIMING(INFO, Substitute("merging $0 lists with $1 overlap", num_inputs, overlap)) {
+    MergeIterator merger(kIntSchema, to_merge);
+    ASSERT_OK(merger.Init(nullptr));
+
+    RowBlock dst(kIntSchema, 100, nullptr);
+    size_t total_rows = 0;
+    uint32_t prev = 0;
+    while (merger.HasNext()) {
+      ASSERT_OK(merger.NextBlock(&dst));
+      for (int i = 0; i < dst.nrows(); i++) {
+        uint32_t this_row = *kIntSchema.ExtractColumnFromRow<UINT32>(dst.row(i), 0);
+        ASSERT_GE(this_row, prev) << "Yielded out of order at idx " << total_rows;
+        prev = this_row;
+        total_rows++;
+      }
+    }
+    ASSERT_EQ(FLAGS_num_rows * num_inputs, total_rows);
+  }
+}
+
+TEST(TestMergeIterator, TestMergeBenchmark) {
+  vector<int> num_inputs = { 1, 10, 100 };
+  if (AllowSlowTests()) {
+    num_inputs.push_back(1000);
+  }
+  for (int n : num_inputs) {
+    for (double overlap : { 0.0, 0.1, 0.5, 1.0 }) {
+      NO_FATALS(RunMergeBenchmark(n, overlap));
+    }
+  }
+}
+
 // Test that the MaterializingIterator properly evaluates predicates when they apply
 // to single columns.
 TEST(TestMaterializingIterator, TestMaterializingPredicatePushdown) {
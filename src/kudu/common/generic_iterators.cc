@@ -36,6 +36,8 @@
 #include "kudu/common/iterator_stats.h"
 #include "kudu/common/row.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
@@ -60,9 +62,22 @@ DEFINE_bool(materializing_iterator_decoder_eval, true,
             "Should MaterializingIterator do decoder-level evaluation");
 TAG_FLAG(materializing_iterator_decoder_eval, hidden);
 TAG_FLAG(materializing_iterator_decoder_eval, runtime);
+DEFINE_bool(materializing_iterator_late_materialization, true,
+            "Should MaterializingIterator skip materializing the cells of rows "
+            "which have already been filtered out by a predicate");
+TAG_FLAG(materializing_iterator_late_materialization, hidden);
+TAG_FLAG(materializing_iterator_late_materialization, runtime);
 
 namespace kudu {
 namespace {
+
+// Returns a rough relative cost of materializing a cell of 'col', used to
+// order predicates of equal selectivity: variable-length cells are copied
+// into the arena and compared byte-wise, so they're evaluated last.
+int MaterializationCost(const ColumnSchema& col) {
+  return col.type_info()->physical_type() == BINARY ? 1 : 0;
+}
+
 void AddIterStats(const RowwiseIterator& iter,
                   std::vector<IteratorStats>* stats) {
   vector<IteratorStats> iter_stats;
@@ -86,8 +101,9 @@ static const int kMergeRowBuffer = 1000;
 // such that all returned rows are valid.
 class MergeIterState {
  public:
-  explicit MergeIterState(shared_ptr<RowwiseIterator> iter) :
+  MergeIterState(shared_ptr<RowwiseIterator> iter, size_t idx) :
       iter_(std::move(iter)),
+      idx_(idx),
       arena_(1024),
       read_block_(iter_->schema(), kMergeRowBuffer, &arena_),
       next_row_idx_(0),
@@ -95,28 +111,39 @@ class MergeIterState {
       num_valid_(0)
   {}
 
-  const RowBlockRow& next_row() {
+  const RowBlockRow& next_row() const {
     DCHECK_LT(num_advanced_, num_valid_);
     return next_row_;
   }
 
-  Status Advance() {
+  // The last selected row in the currently buffered block. All rows yielded
+  // from this block are less than or equal to it.
+  const RowBlockRow& last_row() const {
+    DCHECK_LT(num_advanced_, num_valid_);
+    return last_row_;
+  }
+
+  // Advances past the current row. If that exhausts the current block, the
+  // next block is pulled from the wrapped iterator and '*pulled_new_block' is
+  // set to true.
+  Status Advance(bool* pulled_new_block) {
     num_advanced_++;
     if (IsBlockExhausted()) {
+      *pulled_new_block = true;
       arena_.Reset();
       return PullNextBlock();
-    } else {
-      // Seek to the next selected row.
-      SelectionVector *selection = read_block_.selection_vector();
-      for (++next_row_idx_; next_row_idx_ < read_block_.nrows(); next_row_idx_++) {
-        if (selection->IsRowSelected(next_row_idx_)) {
-          next_row_.Reset(&read_block_, next_row_idx_);
-          break;
-        }
+    }
+    *pulled_new_block = false;
+    // Seek to the next selected row.
+    SelectionVector *selection = read_block_.selection_vector();
+    for (++next_row_idx_; next_row_idx_ < read_block_.nrows(); next_row_idx_++) {
+      if (selection->IsRowSelected(next_row_idx_)) {
+        next_row_.Reset(&read_block_, next_row_idx_);
+        break;
       }
-      DCHECK_NE(next_row_idx_, read_block_.nrows()+1) << "No selected rows found!";
-      return Status::OK();
     }
+    DCHECK_NE(next_row_idx_, read_block_.nrows()+1) << "No selected rows found!";
+    return Status::OK();
   }
 
   bool IsBlockExhausted() const {
@@ -140,15 +167,25 @@ class MergeIterState {
       DCHECK_LE(selection->CountSelected(), read_block_.nrows());
       num_valid_ = selection->CountSelected();
       VLOG(2) << selection->CountSelected() << "/" << read_block_.nrows() << " rows selected";
-      // Seek next_row_ to the first selected row.
+      if (num_valid_ == 0) {
+        // The block had no selected rows, so we need to continue to the
+        // next block.
+        continue;
+      }
+      // Seek next_row_ to the first selected row, and last_row_ to the last.
       for (next_row_idx_ = 0; next_row_idx_ < read_block_.nrows(); next_row_idx_++) {
         if (selection->IsRowSelected(next_row_idx_)) {
           next_row_.Reset(&read_block_, next_row_idx_);
-          return Status::OK();
+          break;
         }
       }
-      // The block may have had no selected rows, in which case we need to continue
-      // to the next block.
+      for (size_t i = read_block_.nrows(); i > next_row_idx_; i--) {
+        if (selection->IsRowSelected(i - 1)) {
+          last_row_.Reset(&read_block_, i - 1);
+          break;
+        }
+      }
+      return Status::OK();
     }
 
     // The underlying iterator is fully exhausted.
@@ -165,17 +202,29 @@ class MergeIterState {
     return iter_;
   }
 
+  // The position of this sub-iterator in the MergeIterator's input. Used to
+  // break ties between equal rows deterministically.
+  size_t idx() const {
+    return idx_;
+  }
+
+ private:
   shared_ptr<RowwiseIterator> iter_;
+  const size_t idx_;
   Arena arena_;
   RowBlock read_block_;
   // The row currently pointed to by the iterator.
   RowBlockRow next_row_;
+  // The last selected row in read_block_.
+  RowBlockRow last_row_;
   // Row index of next_row_ in read_block_.
   size_t next_row_idx_;
   // Number of rows we've advanced past in the current RowBlock.
   size_t num_advanced_;
   // Number of valid (selected) rows in the current RowBlock.
   size_t num_valid_;
+
+  DISALLOW_COPY_AND_ASSIGN(MergeIterState);
 };
 
 
@@ -185,6 +234,7 @@ MergeIterator::MergeIterator(
     : schema_(schema),
       initted_(false),
       orig_iters_(std::move(iters)),
+      hot_window_end_(nullptr),
       finished_iter_stats_by_col_(schema_.num_columns()),
       num_orig_iters_(orig_iters_.size()) {
   CHECK_GT(orig_iters_.size(), 0);
@@ -212,6 +262,17 @@ Status MergeIterator::Init(ScanSpec *spec) {
       }),
       iters_.end());
 
+  // Everything starts out cold; the first refill moves the sub-iterators that
+  // overlap the initial merge window into the hot heap.
+  auto cmp = [this](const MergeIterState* a, const MergeIterState* b) {
+    return NextRowGreater(a, b);
+  };
+  for (const auto& state : iters_) {
+    cold_.push_back(state.get());
+  }
+  std::make_heap(cold_.begin(), cold_.end(), cmp);
+  RefillHotHeap();
+
   initted_ = true;
   return Status::OK();
 }
@@ -226,7 +287,8 @@ Status MergeIterator::InitSubIterators(ScanSpec *spec) {
   for (shared_ptr<RowwiseIterator> &iter : orig_iters_) {
     ScanSpec *spec_copy = spec != nullptr ? scan_spec_copies_.Construct(*spec) : nullptr;
     RETURN_NOT_OK(PredicateEvaluatingIterator::InitAndMaybeWrap(&iter, spec_copy));
-    iters_.push_back(unique_ptr<MergeIterState>(new MergeIterState(std::move(iter))));
+    iters_.push_back(unique_ptr<MergeIterState>(
+        new MergeIterState(std::move(iter), iters_.size())));
   }
   orig_iters_.clear();
 
@@ -238,6 +300,56 @@ Status MergeIterator::InitSubIterators(ScanSpec *spec) {
   return Status::OK();
 }
 
+bool MergeIterator::NextRowGreater(const MergeIterState* a, const MergeIterState* b) const {
+  int cmp = schema_.Compare(a->next_row(), b->next_row());
+  if (PREDICT_TRUE(cmp != 0)) {
+    return cmp > 0;
+  }
+  return a->idx() > b->idx();
+}
+
+void MergeIterator::RefillHotHeap() {
+  auto cmp = [this](const MergeIterState* a, const MergeIterState* b) {
+    return NextRowGreater(a, b);
+  };
+  while (!cold_.empty()) {
+    MergeIterState* candidate = cold_.front();
+    if (hot_window_end_ != nullptr &&
+        schema_.Compare(candidate->next_row(), hot_window_end_->last_row()) > 0) {
+      // The smallest cold row lies beyond the merge window, and so do all
+      // the other cold rows.
+      break;
+    }
+    std::pop_heap(cold_.begin(), cold_.end(), cmp);
+    cold_.pop_back();
+    hot_.push_back(candidate);
+    std::push_heap(hot_.begin(), hot_.end(), cmp);
+    if (hot_window_end_ == nullptr ||
+        schema_.Compare(candidate->last_row(), hot_window_end_->last_row()) < 0) {
+      hot_window_end_ = candidate;
+    }
+  }
+}
+
+void MergeIterator::RecomputeHotWindowEnd() {
+  hot_window_end_ = nullptr;
+  for (MergeIterState* state : hot_) {
+    if (hot_window_end_ == nullptr ||
+        schema_.Compare(state->last_row(), hot_window_end_->last_row()) < 0) {
+      hot_window_end_ = state;
+    }
+  }
+}
+
+void MergeIterator::DestroySubIterator(MergeIterState* state) {
+  std::lock_guard<rw_spinlock> l(iters_lock_);
+  AddIterStats(*state->iter(), &finished_iter_stats_by_col_);
+  iters_.erase(std::find_if(iters_.begin(), iters_.end(),
+                            [state](const unique_ptr<MergeIterState>& s) {
+                              return s.get() == state;
+                            }));
+}
+
 Status MergeIterator::NextBlock(RowBlock* dst) {
   CHECK(initted_);
   DCHECK_SCHEMA_EQ(dst->schema(), schema());
@@ -267,40 +379,50 @@ void MergeIterator::PrepareBatch(RowBlock* dst) {
 // and such around the comparisons. A simple experiment indicated there's some
 // 2x to be gained.
 Status MergeIterator::MaterializeBlock(RowBlock *dst) {
+  auto cmp = [this](const MergeIterState* a, const MergeIterState* b) {
+    return NextRowGreater(a, b);
+  };
+
   // Initialize the selection vector.
   // MergeIterState only returns selected rows.
   dst->selection_vector()->SetAllTrue();
   for (size_t dst_row_idx = 0; dst_row_idx < dst->nrows(); dst_row_idx++) {
-    RowBlockRow dst_row = dst->row(dst_row_idx);
-
-    // Find the sub-iterator which is currently smallest
-    MergeIterState *smallest = nullptr;
-    ssize_t smallest_idx = -1;
-
-    // Typically the number of iters_ is not that large, so using a priority
-    // queue is not worth it
-    for (size_t i = 0; i < iters_.size(); i++) {
-      unique_ptr<MergeIterState> &state = iters_[i];
-
-      if (smallest == nullptr ||
-          schema_.Compare(state->next_row(), smallest->next_row()) < 0) {
-        smallest = state.get();
-        smallest_idx = i;
-      }
+    // If no iterators had any row left, then we're done iterating.
+    if (PREDICT_FALSE(hot_.empty())) {
+      DCHECK(cold_.empty());
+      break;
     }
 
-    // If no iterators had any row left, then we're done iterating.
-    if (PREDICT_FALSE(smallest == nullptr)) break;
+    // The smallest row across all sub-iterators is at the top of the hot heap.
+    // When only a single sub-iterator is hot, this doesn't compare anything.
+    std::pop_heap(hot_.begin(), hot_.end(), cmp);
+    MergeIterState* smallest = hot_.back();
+    hot_.pop_back();
 
-    // Otherwise, copy the row from the smallest one, and advance it
+    // Copy the row from the smallest one, and advance it.
+    RowBlockRow dst_row = dst->row(dst_row_idx);
     RETURN_NOT_OK(CopyRow(smallest->next_row(), &dst_row, dst->arena()));
-    RETURN_NOT_OK(smallest->Advance());
+    bool pulled_new_block;
+    RETURN_NOT_OK(smallest->Advance(&pulled_new_block));
+
+    if (PREDICT_TRUE(!pulled_new_block)) {
+      // Still within the same block, and therefore within the merge window.
+      hot_.push_back(smallest);
+      std::push_heap(hot_.begin(), hot_.end(), cmp);
+      continue;
+    }
 
+    // The sub-iterator moved on to a new block (or ran dry), so the merge
+    // window may have shifted. Its new block can only rejoin the hot heap
+    // through the cold heap, once it overlaps the window.
     if (smallest->IsFullyExhausted()) {
-      std::lock_guard<rw_spinlock> l(iters_lock_);
-      AddIterStats(*smallest->iter(), &finished_iter_stats_by_col_);
-      iters_.erase(iters_.begin() + smallest_idx);
+      DestroySubIterator(smallest);
+    } else {
+      cold_.push_back(smallest);
+      std::push_heap(cold_.begin(), cold_.end(), cmp);
     }
+    RecomputeHotWindowEnd();
+    RefillHotHeap();
   }
 
   return Status::OK();
@@ -449,7 +571,8 @@ void UnionIterator::GetIteratorStats(std::vector<IteratorStats>* stats) const {
 MaterializingIterator::MaterializingIterator(shared_ptr<ColumnwiseIterator> iter)
     : iter_(move(iter)),
       disallow_pushdown_for_tests_(!FLAGS_materializing_iterator_do_pushdown),
-      disallow_decoder_eval_(!FLAGS_materializing_iterator_decoder_eval) {
+      disallow_decoder_eval_(!FLAGS_materializing_iterator_decoder_eval),
+      late_materialization_(FLAGS_materializing_iterator_late_materialization) {
 }
 
 Status MaterializingIterator::Init(ScanSpec *spec) {
@@ -490,11 +613,16 @@ Status MaterializingIterator::Init(ScanSpec *spec) {
   }
 
   // Sort the predicates by selectivity so that the most selective are evaluated
-  // earlier, with ties broken by the column index.
+  // earlier, with ties broken by the cost of materializing the column, and
+  // then by the column index.
   sort(col_idx_predicates_.begin(), col_idx_predicates_.end(),
        [] (const pair<int32_t, ColumnPredicate>& left,
            const pair<int32_t, ColumnPredicate>& right) {
           int comp = SelectivityComparator(left.second, right.second);
+          if (comp == 0) {
+            comp = MaterializationCost(left.second.column()) -
+                   MaterializationCost(right.second.column());
+          }
           return comp ? comp < 0 : left.first < right.first;
        });
 
@@ -543,6 +671,9 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
     if (disallow_decoder_eval_) {
       ctx.SetDecoderEvalNotSupported();
     }
+    if (late_materialization_) {
+      ctx.SetMaterializeSelectedRowsOnly();
+    }
     RETURN_NOT_OK(iter_->MaterializeColumn(&ctx));
     if (ctx.DecoderEvalNotSupported()) {
       get<1>(col_pred).Evaluate(dst_col, dst->selection_vector());
@@ -563,6 +694,9 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
                                      nullptr,
                                      &dst_col,
                                      dst->selection_vector());
+    if (late_materialization_) {
+      ctx.SetMaterializeSelectedRowsOnly();
+    }
     RETURN_NOT_OK(iter_->MaterializeColumn(&ctx));
   }
 
@@ -47,6 +47,19 @@ class RowBlock;
 
 // An iterator which merges the results of other iterators, comparing
 // based on keys.
+//
+// Sub-iterators are tracked in two min-heaps ordered by their next row:
+//
+// - The "hot" heap holds the sub-iterators whose currently buffered block
+//   overlaps the merge window. The window starts at the smallest next row
+//   across all sub-iterators and ends at the smallest last row of any block
+//   buffered by a hot sub-iterator.
+// - The "cold" heap holds the sub-iterators whose next row lies beyond the
+//   end of the merge window, and which therefore can't yield the next row.
+//
+// Only hot sub-iterators take part in per-row comparisons, so when inputs are
+// mostly disjoint (e.g. rowsets whose key ranges barely overlap) the merge
+// degenerates into copying rows out of a single sub-iterator at a time.
 class MergeIterator : public RowwiseIterator {
  public:
   // TODO: clarify whether schema is just the projection, or must include the merge
@@ -74,6 +87,20 @@ class MergeIterator : public RowwiseIterator {
   Status MaterializeBlock(RowBlock* dst);
   Status InitSubIterators(ScanSpec *spec);
 
+  // Moves sub-iterators from the cold heap into the hot heap for as long as
+  // their next row falls within the merge window.
+  void RefillHotHeap();
+
+  // Recomputes 'hot_window_end_' from the sub-iterators in the hot heap.
+  void RecomputeHotWindowEnd();
+
+  // Removes a fully exhausted sub-iterator from 'iters_', accumulating its
+  // statistics into 'finished_iter_stats_by_col_'.
+  void DestroySubIterator(MergeIterState* state);
+
+  // Heap comparator: returns true if 'a' should be yielded after 'b'.
+  bool NextRowGreater(const MergeIterState* a, const MergeIterState* b) const;
+
   const Schema schema_;
 
   bool initted_;
@@ -87,6 +114,16 @@ class MergeIterator : public RowwiseIterator {
   mutable rw_spinlock iters_lock_;
   std::vector<std::unique_ptr<MergeIterState>> iters_;
 
+  // Min-heaps (by next row) of the sub-iterators in 'iters_', maintained
+  // with std::push_heap() and std::pop_heap(). Every live sub-iterator is in
+  // exactly one of them. See the class comment for details.
+  std::vector<MergeIterState*> hot_;
+  std::vector<MergeIterState*> cold_;
+
+  // The hot sub-iterator whose buffered block has the smallest last row, i.e.
+  // the one defining the end of the merge window. Null iff 'hot_' is empty.
+  MergeIterState* hot_window_end_;
+
   // Statistics (keyed by projection column index) accumulated so far by any
   // fully-consumed sub-iterators.
   std::vector<IteratorStats> finished_iter_stats_by_col_;
@@ -213,6 +250,10 @@ class MaterializingIterator : public RowwiseIterator {
   // Set only by test code to disallow pushdown.
   bool disallow_pushdown_for_tests_;
   bool disallow_decoder_eval_;
+
+  // Whether the cells of rows which were filtered out by the deletion
+  // bitmap or an earlier predicate may be left unmaterialized.
+  bool late_materialization_;
 };
 
 // An iterator which wraps another iterator and evaluates any predicates that the
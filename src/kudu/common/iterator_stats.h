@@ -37,6 +37,11 @@ struct IteratorStats {
   // The number of CFile data blocks read from disk (or cache) by the iterator.
   int64_t blocks_read;
 
+  // The number of CFile data blocks which the iterator didn't need to read
+  // because their zone map entries showed that none of their cells could
+  // satisfy the scan's predicates.
+  int64_t blocks_skipped;
+
   // Add statistics contained 'other' to this object (for each field
   // in this object, increment it by the value of the equivalent field
   // in 'other').
@@ -160,6 +160,22 @@ class SelectionVectorView {
     DCHECK_LE(nrows, sel_vec_->nrows() - row_offset_);
     BitmapChangeBits(sel_vec_->mutable_bitmap(), row_offset_, nrows, false);
   }
+  // Clears the 'nrows' bits starting at 'row_idx'.
+  void ClearBits(size_t row_idx, size_t nrows) {
+    DCHECK_LE(row_idx + nrows, sel_vec_->nrows() - row_offset_);
+    BitmapChangeBits(sel_vec_->mutable_bitmap(), row_offset_ + row_idx, nrows, false);
+  }
+  // Finds the first of the 'nrows' bits starting at 'row_idx' which is equal
+  // to 'value', and sets '*idx' to its index. Returns false if there is none.
+  bool FindFirst(size_t row_idx, size_t nrows, bool value, size_t* idx) const {
+    DCHECK_LE(row_idx + nrows, sel_vec_->nrows() - row_offset_);
+    if (!BitmapFindFirst(sel_vec_->bitmap(), row_offset_ + row_idx,
+                         row_offset_ + row_idx + nrows, value, idx)) {
+      return false;
+    }
+    *idx -= row_offset_;
+    return true;
+  }
  private:
   SelectionVector* sel_vec_;
   size_t row_offset_;
@@ -0,0 +1,222 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/scan_aggregator.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/repeated_field.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using google::protobuf::RepeatedPtrField;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+class ScanAggregatorTest : public KuduTest {
+ public:
+  ScanAggregatorTest()
+      : schema_({ ColumnSchema("key", INT32),
+                  ColumnSchema("val", INT64, true),
+                  ColumnSchema("str", STRING, true),
+                  ColumnSchema("dbl", DOUBLE) },
+                1),
+        arena_(1024) {
+  }
+
+ protected:
+  void AddAggregate(ScanAggregatePB::Function function, const string& column) {
+    ScanAggregatePB* pb = aggregates_.Add();
+    pb->set_function(function);
+    if (!column.empty()) {
+      pb->set_column(column);
+    }
+  }
+
+  // Fills 'block' with 'nrows' rows starting at key 'first_key', with a NULL
+  // 'val' and 'str' in every third row, and selects every other row.
+  void FillBlock(int first_key, int nrows, RowBlock* block) {
+    block->Resize(nrows);
+    for (int i = 0; i < nrows; i++) {
+      int32_t key = first_key + i;
+      int64_t val = -key;
+      double dbl = key * 0.5;
+      string str = Substitute("s$0", key);
+      Slice str_slice;
+      CHECK(arena_.RelocateSlice(str, &str_slice));
+      RowBlockRow row = block->row(i);
+      *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(0)) = key;
+      *reinterpret_cast<int64_t*>(row.mutable_cell_ptr(1)) = val;
+      *reinterpret_cast<Slice*>(row.mutable_cell_ptr(2)) = str_slice;
+      *reinterpret_cast<double*>(row.mutable_cell_ptr(3)) = dbl;
+      bool is_null = key % 3 == 0;
+      block->column_block(1).SetCellIsNull(i, is_null);
+      block->column_block(2).SetCellIsNull(i, is_null);
+      if (key % 2 == 0) {
+        block->selection_vector()->SetRowSelected(i);
+      } else {
+        block->selection_vector()->SetRowUnselected(i);
+      }
+    }
+  }
+
+  const Schema schema_;
+  Arena arena_;
+  RepeatedPtrField<ScanAggregatePB> aggregates_;
+};
+
+TEST_F(ScanAggregatorTest, TestAggregateBlocks) {
+  AddAggregate(ScanAggregatePB::COUNT, "");
+  AddAggregate(ScanAggregatePB::COUNT, "val");
+  AddAggregate(ScanAggregatePB::SUM, "val");
+  AddAggregate(ScanAggregatePB::SUM, "dbl");
+  AddAggregate(ScanAggregatePB::MIN, "str");
+  AddAggregate(ScanAggregatePB::MAX, "key");
+  unique_ptr<ScanAggregator> agg;
+  ASSERT_OK(ScanAggregator::Create(schema_, aggregates_, &agg));
+  ASSERT_EQ("count(*)", agg->result_schema().column(0).name());
+  ASSERT_EQ("max(key)", agg->result_schema().column(5).name());
+  ASSERT_FALSE(agg->result_schema().column(0).is_nullable());
+
+  // Evaluate the aggregates over keys [0, 200), in two blocks.
+  RowBlock block(schema_, 100, &arena_);
+  int64_t count = 0, count_val = 0, sum_val = 0;
+  double sum_dbl = 0;
+  for (int first_key = 0; first_key < 200; first_key += 100) {
+    NO_FATALS(FillBlock(first_key, 100, &block));
+    agg->AddBlock(block);
+    for (int key = first_key; key < first_key + 100; key++) {
+      if (key % 2 != 0) continue;
+      count++;
+      sum_dbl += key * 0.5;
+      if (key % 3 != 0) {
+        count_val++;
+        sum_val -= key;
+      }
+    }
+  }
+
+  RowBlock result(agg->result_schema(), 1, &arena_);
+  agg->Finish(&result);
+  ASSERT_EQ(1, result.selection_vector()->CountSelected());
+  RowBlockRow row = result.row(0);
+  ASSERT_EQ(count, *reinterpret_cast<const int64_t*>(row.cell_ptr(0)));
+  ASSERT_EQ(count_val, *reinterpret_cast<const int64_t*>(row.cell_ptr(1)));
+  ASSERT_EQ(sum_val, *reinterpret_cast<const int64_t*>(row.cell_ptr(2)));
+  ASSERT_DOUBLE_EQ(sum_dbl, *reinterpret_cast<const double*>(row.cell_ptr(3)));
+  // "s10" sorts lowest among the selected, non-NULL strings.
+  ASSERT_EQ("s10", reinterpret_cast<const Slice*>(row.cell_ptr(4))->ToString());
+  ASSERT_EQ(198, *reinterpret_cast<const int32_t*>(row.cell_ptr(5)));
+}
+
+TEST_F(ScanAggregatorTest, TestNoRows) {
+  AddAggregate(ScanAggregatePB::COUNT, "");
+  AddAggregate(ScanAggregatePB::SUM, "val");
+  AddAggregate(ScanAggregatePB::MIN, "key");
+  unique_ptr<ScanAggregator> agg;
+  ASSERT_OK(ScanAggregator::Create(schema_, aggregates_, &agg));
+
+  RowBlock result(agg->result_schema(), 1, &arena_);
+  agg->Finish(&result);
+  RowBlockRow row = result.row(0);
+  ASSERT_EQ(0, *reinterpret_cast<const int64_t*>(row.cell_ptr(0)));
+  ASSERT_TRUE(row.is_null(1));
+  ASSERT_TRUE(row.is_null(2));
+}
+
+TEST_F(ScanAggregatorTest, TestKeyBounds) {
+  AddAggregate(ScanAggregatePB::COUNT, "");
+  AddAggregate(ScanAggregatePB::COUNT, "dbl");
+  AddAggregate(ScanAggregatePB::MIN, "key");
+  AddAggregate(ScanAggregatePB::MAX, "key");
+  unique_ptr<ScanAggregator> agg;
+  ASSERT_OK(ScanAggregator::Create(schema_, aggregates_, &agg));
+  ASSERT_TRUE(agg->CanUseKeyBounds(schema_));
+
+  int32_t lo = 5, hi = 50;
+  agg->AddKeyBounds(20, &lo, &hi);
+  lo = 60, hi = 70;
+  agg->AddKeyBounds(5, &lo, &hi);
+  agg->AddKeyBounds(0, nullptr, nullptr);
+
+  RowBlock result(agg->result_schema(), 1, &arena_);
+  agg->Finish(&result);
+  RowBlockRow row = result.row(0);
+  ASSERT_EQ(25, *reinterpret_cast<const int64_t*>(row.cell_ptr(0)));
+  ASSERT_EQ(25, *reinterpret_cast<const int64_t*>(row.cell_ptr(1)));
+  ASSERT_EQ(5, *reinterpret_cast<const int32_t*>(row.cell_ptr(2)));
+  ASSERT_EQ(70, *reinterpret_cast<const int32_t*>(row.cell_ptr(3)));
+
+  // Aggregates over nullable or non-key columns need the data itself.
+  for (const auto& col : { "val", "str" }) {
+    aggregates_.Clear();
+    AddAggregate(ScanAggregatePB::COUNT, col);
+    ASSERT_OK(ScanAggregator::Create(schema_, aggregates_, &agg));
+    ASSERT_FALSE(agg->CanUseKeyBounds(schema_));
+  }
+  aggregates_.Clear();
+  AddAggregate(ScanAggregatePB::MAX, "dbl");
+  ASSERT_OK(ScanAggregator::Create(schema_, aggregates_, &agg));
+  ASSERT_FALSE(agg->CanUseKeyBounds(schema_));
+}
+
+TEST_F(ScanAggregatorTest, TestInvalidAggregates) {
+  unique_ptr<ScanAggregator> agg;
+  aggregates_.Add();
+  Status s = ScanAggregator::Create(schema_, aggregates_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+
+  aggregates_.Clear();
+  AddAggregate(ScanAggregatePB::SUM, "");
+  s = ScanAggregator::Create(schema_, aggregates_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+
+  aggregates_.Clear();
+  AddAggregate(ScanAggregatePB::SUM, "str");
+  s = ScanAggregator::Create(schema_, aggregates_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+
+  aggregates_.Clear();
+  AddAggregate(ScanAggregatePB::MIN, "missing");
+  s = ScanAggregator::Create(schema_, aggregates_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+
+  // Duplicate aggregates would yield duplicate result column names.
+  aggregates_.Clear();
+  AddAggregate(ScanAggregatePB::MIN, "key");
+  AddAggregate(ScanAggregatePB::MIN, "key");
+  s = ScanAggregator::Create(schema_, aggregates_, &agg);
+  ASSERT_FALSE(s.ok());
+}
+
+} // namespace kudu
@@ -0,0 +1,305 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/scan_aggregator.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+
+using google::protobuf::RepeatedPtrField;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// Calls 'f' with a pointer to each cell of 'cb' which is selected in 'sel'
+// and not NULL.
+template<class F>
+void ForEachSelectedCell(const ColumnBlock& cb, const SelectionVector& sel, const F& f) {
+  const bool nullable = cb.is_nullable();
+  for (size_t i = 0; i < cb.nrows(); i++) {
+    if (!sel.IsRowSelected(i) || (nullable && cb.is_null(i))) continue;
+    f(cb.cell_ptr(i));
+  }
+}
+
+// Adds the selected, non-NULL cells of 'cb' to 'sum', and their number to
+// 'count'. Integers are summed as uint64_t so that overflow wraps around
+// rather than being undefined.
+template<DataType Type, class SumType>
+void SumCells(const ColumnBlock& cb, const SelectionVector& sel,
+              int64_t* count, SumType* sum) {
+  typedef typename DataTypeTraits<Type>::cpp_type cpp_type;
+  SumType local_sum = 0;
+  int64_t local_count = 0;
+  ForEachSelectedCell(cb, sel, [&](const uint8_t* cell) {
+    local_sum += *reinterpret_cast<const cpp_type*>(cell);
+    local_count++;
+  });
+  *sum += local_sum;
+  *count += local_count;
+}
+
+const char* FunctionName(ScanAggregatePB::Function function) {
+  switch (function) {
+    case ScanAggregatePB::COUNT: return "count";
+    case ScanAggregatePB::SUM: return "sum";
+    case ScanAggregatePB::MIN: return "min";
+    case ScanAggregatePB::MAX: return "max";
+    default: return "unknown";
+  }
+}
+
+bool IsSummable(DataType type) {
+  switch (type) {
+    case INT8:
+    case INT16:
+    case INT32:
+    case INT64:
+    case FLOAT:
+    case DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // anonymous namespace
+
+struct ScanAggregator::Accumulator {
+  Accumulator(ScanAggregatePB::Function function, string column, const TypeInfo* type_info)
+      : function(function),
+        column(std::move(column)),
+        type_info(type_info) {
+  }
+
+  // Replaces the MIN or MAX partial with 'cell' if it's lower, or higher,
+  // respectively.
+  void UpdateMinMax(const void* cell) {
+    if (has_value) {
+      int cmp = type_info->Compare(cell, value);
+      if (function == ScanAggregatePB::MIN ? cmp >= 0 : cmp <= 0) return;
+    }
+    has_value = true;
+    if (type_info->physical_type() == BINARY) {
+      // Copy the data so that it outlives the block it came from.
+      const Slice* s = reinterpret_cast<const Slice*>(cell);
+      value_data.assign_copy(s->data(), s->size());
+      Slice copy(value_data);
+      memcpy(value, &copy, sizeof(copy));
+    } else {
+      memcpy(value, cell, type_info->size());
+    }
+  }
+
+  const ScanAggregatePB::Function function;
+
+  // The aggregated column, or empty for COUNT(*).
+  const string column;
+
+  // The type of the aggregated column, or null for COUNT(*).
+  const TypeInfo* const type_info;
+
+  // The number of rows, or non-NULL cells, folded so far.
+  int64_t count = 0;
+
+  // The SUM partial, for integer and floating point columns respectively.
+  uint64_t int_sum = 0;
+  double double_sum = 0;
+
+  // The MIN or MAX partial, valid once 'has_value' is set. For BINARY
+  // columns, 'value' holds a Slice pointing into 'value_data'.
+  bool has_value = false;
+  alignas(16) uint8_t value[16];
+  faststring value_data;
+};
+
+ScanAggregator::ScanAggregator() {}
+
+ScanAggregator::~ScanAggregator() {}
+
+Status ScanAggregator::Create(const Schema& projection,
+                              const RepeatedPtrField<ScanAggregatePB>& aggregates,
+                              unique_ptr<ScanAggregator>* aggregator) {
+  unique_ptr<ScanAggregator> agg(new ScanAggregator());
+  vector<ColumnSchema> result_cols;
+  for (const ScanAggregatePB& pb : aggregates) {
+    const char* name = FunctionName(pb.function());
+    if (pb.function() == ScanAggregatePB::UNKNOWN_FUNCTION) {
+      return Status::InvalidArgument("unknown aggregate function");
+    }
+    if (!pb.has_column()) {
+      if (pb.function() != ScanAggregatePB::COUNT) {
+        return Status::InvalidArgument(Substitute("$0 requires a column", name));
+      }
+      agg->accumulators_.emplace_back(new Accumulator(pb.function(), "", nullptr));
+      result_cols.emplace_back("count(*)", INT64);
+      continue;
+    }
+
+    int idx = projection.find_column(pb.column());
+    if (idx == Schema::kColumnNotFound) {
+      return Status::InvalidArgument(Substitute(
+          "aggregated column $0 is not in the projection", pb.column()));
+    }
+    const ColumnSchema& col = projection.column(idx);
+    string result_name = Substitute("$0($1)", name, col.name());
+    switch (pb.function()) {
+      case ScanAggregatePB::COUNT:
+        result_cols.emplace_back(std::move(result_name), INT64);
+        break;
+      case ScanAggregatePB::SUM:
+        if (!IsSummable(col.type_info()->type())) {
+          return Status::InvalidArgument(Substitute(
+              "can't sum column $0 of type $1", col.name(), col.type_info()->name()));
+        }
+        result_cols.emplace_back(std::move(result_name),
+                                 col.type_info()->type() == FLOAT ||
+                                 col.type_info()->type() == DOUBLE ? DOUBLE : INT64,
+                                 /*is_nullable=*/true);
+        break;
+      default:
+        result_cols.emplace_back(std::move(result_name), col.type_info()->type(),
+                                 /*is_nullable=*/true, nullptr, nullptr,
+                                 ColumnStorageAttributes(), col.type_attributes());
+        break;
+    }
+    agg->accumulators_.emplace_back(
+        new Accumulator(pb.function(), col.name(), col.type_info()));
+  }
+  RETURN_NOT_OK_PREPEND(agg->result_schema_.Reset(result_cols, 0),
+                        "invalid aggregates");
+  *aggregator = std::move(agg);
+  return Status::OK();
+}
+
+void ScanAggregator::AddBlock(const RowBlock& block) {
+  const SelectionVector& sel = *block.selection_vector();
+  for (const auto& acc : accumulators_) {
+    if (acc->column.empty()) {
+      acc->count += sel.CountSelected();
+      continue;
+    }
+    int idx = block.schema().find_column(acc->column);
+    DCHECK_NE(idx, Schema::kColumnNotFound);
+    const ColumnBlock cb = block.column_block(idx);
+    switch (acc->function) {
+      case ScanAggregatePB::COUNT:
+        ForEachSelectedCell(cb, sel, [&](const uint8_t* /* cell */) { acc->count++; });
+        break;
+      case ScanAggregatePB::SUM:
+        switch (acc->type_info->type()) {
+          case INT8: SumCells<INT8>(cb, sel, &acc->count, &acc->int_sum); break;
+          case INT16: SumCells<INT16>(cb, sel, &acc->count, &acc->int_sum); break;
+          case INT32: SumCells<INT32>(cb, sel, &acc->count, &acc->int_sum); break;
+          case INT64: SumCells<INT64>(cb, sel, &acc->count, &acc->int_sum); break;
+          case FLOAT: SumCells<FLOAT>(cb, sel, &acc->count, &acc->double_sum); break;
+          case DOUBLE: SumCells<DOUBLE>(cb, sel, &acc->count, &acc->double_sum); break;
+          default: LOG(FATAL) << "unexpected type: " << acc->type_info->name();
+        }
+        break;
+      default:
+        ForEachSelectedCell(cb, sel, [&](const uint8_t* cell) { acc->UpdateMinMax(cell); });
+        break;
+    }
+  }
+}
+
+bool ScanAggregator::CanUseKeyBounds(const Schema& tablet_schema) const {
+  for (const auto& acc : accumulators_) {
+    if (acc->column.empty()) continue;
+    int idx = tablet_schema.find_column(acc->column);
+    if (idx == Schema::kColumnNotFound) return false;
+    switch (acc->function) {
+      case ScanAggregatePB::COUNT:
+        if (tablet_schema.column(idx).is_nullable()) return false;
+        break;
+      case ScanAggregatePB::MIN:
+      case ScanAggregatePB::MAX:
+        if (idx != 0) return false;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+void ScanAggregator::AddKeyBounds(uint64_t num_rows,
+                                  const void* min_key_cell,
+                                  const void* max_key_cell) {
+  for (const auto& acc : accumulators_) {
+    switch (acc->function) {
+      case ScanAggregatePB::COUNT:
+        acc->count += num_rows;
+        break;
+      case ScanAggregatePB::MIN:
+        if (num_rows > 0) acc->UpdateMinMax(min_key_cell);
+        break;
+      case ScanAggregatePB::MAX:
+        if (num_rows > 0) acc->UpdateMinMax(max_key_cell);
+        break;
+      default:
+        LOG(FATAL) << "can't compute " << FunctionName(acc->function)
+                   << " from key bounds";
+    }
+  }
+}
+
+void ScanAggregator::Finish(RowBlock* block) const {
+  DCHECK_GE(block->row_capacity(), 1);
+  block->Resize(1);
+  for (int i = 0; i < accumulators_.size(); i++) {
+    const Accumulator& acc = *accumulators_[i];
+    ColumnBlock cb = block->column_block(i);
+    if (acc.function == ScanAggregatePB::COUNT) {
+      cb.SetCellValue(0, &acc.count);
+      continue;
+    }
+    bool is_null = acc.function == ScanAggregatePB::SUM ? acc.count == 0 : !acc.has_value;
+    cb.SetCellIsNull(0, is_null);
+    if (is_null) continue;
+    if (acc.function == ScanAggregatePB::SUM) {
+      if (cb.type_info()->type() == DOUBLE) {
+        cb.SetCellValue(0, &acc.double_sum);
+      } else {
+        int64_t sum = static_cast<int64_t>(acc.int_sum);
+        cb.SetCellValue(0, &sum);
+      }
+    } else {
+      cb.SetCellValue(0, acc.value);
+    }
+  }
+  block->selection_vector()->SetAllTrue();
+}
+
+} // namespace kudu
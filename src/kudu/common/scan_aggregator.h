@@ -0,0 +1,102 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/repeated_field.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class RowBlock;
+
+// Evaluates the aggregates of a scan (see ScanAggregatePB) over the row
+// blocks produced by the scan's iterator, accumulating a single row of
+// partial aggregates.
+//
+// The partial aggregates of several scans (e.g. one per tablet) are combined
+// by summing the COUNT and SUM partials and by taking the MIN of the MIN
+// partials and the MAX of the MAX partials.
+//
+// The columns of the result row are, in order:
+//   COUNT: INT64, not nullable.
+//   SUM: INT64 for integer columns, DOUBLE for floating point columns.
+//   MIN, MAX: the type of the aggregated column.
+// All but COUNT are nullable, and are NULL if no non-NULL cell was seen.
+// SUM of integers wraps around on overflow.
+//
+// This class is not thread-safe.
+class ScanAggregator {
+ public:
+  // Validates 'aggregates' against the columns of 'projection' and creates
+  // an aggregator for them. Returns InvalidArgument if an aggregate names a
+  // column that isn't in 'projection', or isn't supported on the column's
+  // type.
+  static Status Create(
+      const Schema& projection,
+      const google::protobuf::RepeatedPtrField<ScanAggregatePB>& aggregates,
+      std::unique_ptr<ScanAggregator>* aggregator);
+
+  ~ScanAggregator();
+
+  // Folds the selected rows of 'block' into the partial aggregates.
+  //
+  // The aggregated columns are looked up by name in the schema of 'block'.
+  void AddBlock(const RowBlock& block);
+
+  // Returns true if the aggregates can be computed from the number of rows
+  // and the bounds of the primary key alone, i.e. if they are only COUNTs of
+  // rows or of non-nullable columns, or MIN or MAX of the first primary key
+  // column of 'tablet_schema'.
+  bool CanUseKeyBounds(const Schema& tablet_schema) const;
+
+  // Folds 'num_rows' rows into the partial aggregates, given only the lowest
+  // and highest value of the first primary key column among them. Requires
+  // CanUseKeyBounds() to be true; the cells may be null only if 'num_rows'
+  // is 0.
+  void AddKeyBounds(uint64_t num_rows, const void* min_key_cell, const void* max_key_cell);
+
+  // Writes the partial aggregates to the first row of 'block', which must
+  // have result_schema() and room for at least one row. Only that row is
+  // left selected.
+  //
+  // Variable-length cells point into this object, so 'block' must not
+  // outlive it, and must be consumed before the next call to AddBlock().
+  void Finish(RowBlock* block) const;
+
+  // The schema of the row of partial aggregates.
+  const Schema& result_schema() const { return result_schema_; }
+
+ private:
+  struct Accumulator;
+
+  ScanAggregator();
+
+  std::vector<std::unique_ptr<Accumulator>> accumulators_;
+  Schema result_schema_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanAggregator);
+};
+
+} // namespace kudu
@@ -189,9 +189,10 @@ void ScanSpec::PushPredicatesIntoPrimaryKeyBounds(const Schema& schema,
       } else if (type == PredicateType::Range) {
         RemovePredicate(column);
         break;
-      } else if (type == PredicateType::InList) {
-        // InList predicates should not be removed as the full constraints imposed by an InList
-        // cannot be translated into only a single set of lower and upper bound primary keys
+      } else if (type == PredicateType::InList || type == PredicateType::InBloomFilter) {
+        // InList and InBloomFilter predicates should not be removed as the full constraints
+        // they impose cannot be translated into only a single set of lower and upper bound
+        // primary keys
         break;
       } else {
         LOG(FATAL) << "Can not remove unknown predicate type";
@@ -17,6 +17,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -32,6 +33,7 @@
 #include "kudu/common/wire_protocol.h"
 #include "kudu/common/wire_protocol.pb.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/hexdump.h"
 #include "kudu/util/memory/arena.h"
@@ -332,6 +334,62 @@ TEST_F(WireProtocolTest, TestColumnarRowBlockToPBWithPadding) {
   }
 }
 
+// Serialize blocks column by column, with some rows unselected and some cells
+// NULL, and ensure that the resulting buffers hold the selected cells.
+TEST_F(WireProtocolTest, TestRowBlockToColumnarBuffers) {
+  const int kNumRows = 10;
+  Arena arena(1024);
+  RowBlock block(schema_, kNumRows, &arena);
+  FillRowBlockWithTestRows(&block);
+  // Unselect the odd rows, and null out col3 of every fourth row.
+  for (int i = 0; i < kNumRows; i++) {
+    if (i % 2 == 1) {
+      block.selection_vector()->SetRowUnselected(i);
+    }
+    if (i % 4 == 0) {
+      block.row(i).cell(2).set_null(true);
+    }
+  }
+
+  // Serialize the block twice, to exercise appending to existing buffers.
+  Schema proj_schema({ ColumnSchema("col3", UINT32, true /* nullable */),
+                       ColumnSchema("col1", STRING) }, 0);
+  ColumnarSerializedBatch batch;
+  SerializeRowBlockColumnar(block, &proj_schema, &batch);
+  SerializeRowBlockColumnar(block, &proj_schema, &batch);
+  const int kNumSelected = kNumRows / 2;
+  ASSERT_EQ(kNumSelected * 2, batch.num_rows);
+  ASSERT_EQ(2, batch.columns.size());
+
+  // col3: fixed-length and nullable.
+  const auto& col3 = batch.columns[0];
+  ASSERT_EQ(kNumSelected * 2 * sizeof(uint32_t), col3.data->size());
+  ASSERT_FALSE(col3.varlen_data);
+  ASSERT_TRUE(col3.non_null_bitmap);
+  ASSERT_EQ(BitmapSize(kNumSelected * 2), col3.non_null_bitmap->size());
+  const uint32_t* col3_cells = reinterpret_cast<const uint32_t*>(col3.data->data());
+  for (int i = 0; i < kNumSelected * 2; i++) {
+    int src_row = (i % kNumSelected) * 2;
+    bool is_null = src_row % 4 == 0;
+    SCOPED_TRACE(i);
+    EXPECT_EQ(!is_null, BitmapTest(col3.non_null_bitmap->data(), i));
+    EXPECT_EQ(is_null ? 0 : src_row, col3_cells[i]);
+  }
+
+  // col1: variable-length and non-nullable.
+  const auto& col1 = batch.columns[1];
+  ASSERT_TRUE(col1.varlen_data);
+  ASSERT_FALSE(col1.non_null_bitmap);
+  ASSERT_EQ((kNumSelected * 2 + 1) * sizeof(uint32_t), col1.data->size());
+  const uint32_t* offsets = reinterpret_cast<const uint32_t*>(col1.data->data());
+  ASSERT_EQ(0, offsets[0]);
+  for (int i = 0; i < kNumSelected * 2; i++) {
+    Slice val(col1.varlen_data->data() + offsets[i], offsets[i + 1] - offsets[i]);
+    EXPECT_EQ("hello world col1", val.ToString());
+  }
+  ASSERT_EQ(col1.varlen_data->size(), offsets[kNumSelected * 2]);
+}
+
 #ifdef NDEBUG
 TEST_F(WireProtocolTest, TestColumnarRowBlockToPBBenchmark) {
   Arena arena(1024);
@@ -499,4 +557,58 @@ TEST_F(WireProtocolTest, TestColumnPredicateInList) {
     ASSERT_TRUE(ColumnPredicateFromPB(schema, &arena, pb, &predicate).IsInvalidArgument());
   }
 }
+
+TEST_F(WireProtocolTest, TestColumnPredicateInBloomFilter) {
+  ColumnSchema col1("col1", INT32);
+  vector<ColumnSchema> cols = { col1 };
+  Schema schema(cols, 1);
+  Arena arena(1024);
+  boost::optional<ColumnPredicate> predicate;
+
+  { // col1 IN BLOOM FILTER(5) AND col1 >= 0
+    int zero = 0;
+    int five = 5;
+    BloomFilterBuilder bfb(BloomFilterSizing::ByCountAndFPRate(10, 0.01),
+                           BloomFilterLayout::kCacheBlocked);
+    ColumnPredicate::BloomKeyBuffer buf;
+    bfb.AddKey(BloomKeyProbe(ColumnPredicate::BloomKeyForCell<INT32>(&five, &buf)));
+    vector<BloomFilter> filters = { BloomFilter(bfb.slice(), bfb.n_hashes(), bfb.layout()) };
+
+    ColumnPredicate cp = ColumnPredicate::InBloomFilter(col1, &filters, &zero, nullptr);
+    ColumnPredicatePB pb;
+    ASSERT_NO_FATAL_FAILURE(ColumnPredicateToPB(cp, &pb));
+
+    ASSERT_OK(ColumnPredicateFromPB(schema, &arena, pb, &predicate));
+    ASSERT_EQ(cp, *predicate);
+    ASSERT_TRUE(predicate->EvaluateCell<INT32>(&five));
+  }
+
+  { // No filters
+    ColumnPredicatePB pb;
+    pb.set_column("col1");
+    pb.mutable_in_bloom_filter();
+    ASSERT_TRUE(ColumnPredicateFromPB(schema, &arena, pb, &predicate).IsInvalidArgument());
+  }
+
+  { // A cache-blocked filter which isn't made of whole blocks
+    ColumnPredicatePB pb;
+    pb.set_column("col1");
+    auto* bf_pb = pb.mutable_in_bloom_filter()->add_bloom_filters();
+    bf_pb->set_bloom_data(string(100, '\0'));
+    bf_pb->set_n_hashes(3);
+    bf_pb->set_cache_blocked(true);
+    ASSERT_TRUE(ColumnPredicateFromPB(schema, &arena, pb, &predicate).IsInvalidArgument());
+  }
+
+  { // Too many hash functions, which would make every probe needlessly slow
+    ColumnPredicatePB pb;
+    pb.set_column("col1");
+    auto* bf_pb = pb.mutable_in_bloom_filter()->add_bloom_filters();
+    bf_pb->set_bloom_data(string(BloomFilter::kBlockBytes, '\0'));
+    bf_pb->set_n_hashes(BloomFilter::kMaxClientHashes);
+    ASSERT_OK(ColumnPredicateFromPB(schema, &arena, pb, &predicate));
+    bf_pb->set_n_hashes(std::numeric_limits<uint32_t>::max());
+    ASSERT_TRUE(ColumnPredicateFromPB(schema, &arena, pb, &predicate).IsInvalidArgument());
+  }
+}
 } // namespace kudu
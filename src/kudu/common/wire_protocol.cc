@@ -40,6 +40,7 @@
 #include "kudu/gutil/strings/fastmem.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/bloom_filter.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/memory/arena.h"
@@ -53,6 +54,7 @@ using google::protobuf::RepeatedPtrField;
 using kudu::pb_util::SecureDebugString;
 using kudu::pb_util::SecureShortDebugString;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
@@ -480,6 +482,26 @@ void ColumnPredicateToPB(const ColumnPredicate& predicate,
       }
       return;
     };
+    case PredicateType::InBloomFilter: {
+      auto* bloom_pred = pb->mutable_in_bloom_filter();
+      for (const BloomFilter& bf : predicate.bloom_filters()) {
+        auto* bf_pb = bloom_pred->add_bloom_filters();
+        bf_pb->set_bloom_data(bf.data().data(), bf.data().size());
+        bf_pb->set_n_hashes(bf.n_hashes());
+        bf_pb->set_cache_blocked(bf.layout() == BloomFilterLayout::kCacheBlocked);
+      }
+      if (predicate.raw_lower() != nullptr) {
+        CopyPredicateBoundToPB(predicate.column(),
+                               predicate.raw_lower(),
+                               bloom_pred->mutable_lower());
+      }
+      if (predicate.raw_upper() != nullptr) {
+        CopyPredicateBoundToPB(predicate.column(),
+                               predicate.raw_upper(),
+                               bloom_pred->mutable_upper());
+      }
+      return;
+    };
     case PredicateType::None: LOG(FATAL) << "None predicate may not be converted to protobuf";
   }
   LOG(FATAL) << "unknown predicate type";
@@ -549,6 +571,49 @@ Status ColumnPredicateFromPB(const Schema& schema,
         *predicate = ColumnPredicate::IsNull(col);
         break;
       }
+    case ColumnPredicatePB::kInBloomFilter: {
+      const auto& bloom_pred = pb.in_bloom_filter();
+      if (bloom_pred.bloom_filters_size() == 0) {
+        return Status::InvalidArgument("Invalid bloom filter predicate on column: no filters",
+                                       col.name());
+      }
+      vector<BloomFilter> bloom_filters;
+      for (const auto& bf_pb : bloom_pred.bloom_filters()) {
+        const string& data = bf_pb.bloom_data();
+        if (data.empty() || bf_pb.n_hashes() == 0) {
+          return Status::InvalidArgument("Invalid bloom filter predicate on column: "
+                                         "empty filter", col.name());
+        }
+        if (bf_pb.n_hashes() > BloomFilter::kMaxClientHashes) {
+          return Status::InvalidArgument(Substitute(
+              "Invalid bloom filter predicate on column $0: $1 hash functions (at most $2)",
+              col.name(), bf_pb.n_hashes(), BloomFilter::kMaxClientHashes));
+        }
+        BloomFilterLayout layout = BloomFilterLayout::kClassic;
+        if (bf_pb.cache_blocked()) {
+          if (data.size() % BloomFilter::kBlockBytes != 0) {
+            return Status::InvalidArgument(Substitute(
+                "Invalid bloom filter predicate on column $0: cache-blocked filter of $1 bytes",
+                col.name(), data.size()));
+          }
+          layout = BloomFilterLayout::kCacheBlocked;
+        }
+        // Copy the filter into the arena, so that it outlives the request.
+        uint8_t* data_copy = static_cast<uint8_t*>(arena->AllocateBytes(data.size()));
+        memcpy(data_copy, data.data(), data.size());
+        bloom_filters.emplace_back(Slice(data_copy, data.size()), bf_pb.n_hashes(), layout);
+      }
+      const void* lower = nullptr;
+      const void* upper = nullptr;
+      if (bloom_pred.has_lower()) {
+        RETURN_NOT_OK(CopyPredicateBoundFromPB(col, bloom_pred.lower(), arena, &lower));
+      }
+      if (bloom_pred.has_upper()) {
+        RETURN_NOT_OK(CopyPredicateBoundFromPB(col, bloom_pred.upper(), arena, &upper));
+      }
+      *predicate = ColumnPredicate::InBloomFilter(col, &bloom_filters, lower, upper);
+      break;
+    };
     default: return Status::InvalidArgument("Unknown predicate type for column", col.name());
   }
   return Status::OK();
@@ -873,4 +938,118 @@ void SerializeRowBlock(const RowBlock& block,
   rowblock_pb->set_num_rows(rowblock_pb->num_rows() + num_rows);
 }
 
+// Appends the selected cells of column 'col_idx' of 'block' to 'dst'.
+//
+// 'dst_row_idx' is the index of the first appended row within 'dst', which is
+// needed to position the bits of the non-null bitmap.
+//
+// IS_NULLABLE and IS_VARLEN are template parameters for the same reason as in
+// CopyColumn().
+template<bool IS_NULLABLE, bool IS_VARLEN>
+static void CopyColumnColumnar(const RowBlock& block, int col_idx, int64_t dst_row_idx,
+                               ColumnarSerializedBatch::Column* dst) {
+  ColumnBlock column_block = block.column_block(col_idx);
+  const size_t cell_size = column_block.stride();
+  const size_t num_rows = block.selection_vector()->CountSelected();
+
+  uint8_t* dst_cell;
+  if (IS_VARLEN) {
+    // Offsets are appended one at a time below, since their values depend on
+    // the amount of varlen data appended so far.
+    dst_cell = nullptr;
+    dst->data->reserve(dst->data->size() + num_rows * sizeof(uint32_t));
+  } else {
+    size_t old_size = dst->data->size();
+    dst->data->resize(old_size + num_rows * cell_size);
+    dst_cell = dst->data->data() + old_size;
+  }
+  if (IS_NULLABLE) {
+    // Zero the newly appended bitmap bytes; only the non-null bits get set
+    // below.
+    size_t old_size = dst->non_null_bitmap->size();
+    dst->non_null_bitmap->resize(BitmapSize(dst_row_idx + num_rows));
+    memset(dst->non_null_bitmap->data() + old_size, 0,
+           dst->non_null_bitmap->size() - old_size);
+  }
+
+  BitmapIterator selected_row_iter(block.selection_vector()->bitmap(), block.nrows());
+  int run_size;
+  bool selected;
+  int row_idx = 0;
+  while ((run_size = selected_row_iter.Next(&selected))) {
+    if (!selected) {
+      row_idx += run_size;
+      continue;
+    }
+    for (int i = 0; i < run_size; i++, row_idx++, dst_row_idx++) {
+      bool is_null = IS_NULLABLE && column_block.is_null(row_idx);
+      if (IS_NULLABLE && !is_null) {
+        BitmapSet(dst->non_null_bitmap->data(), dst_row_idx);
+      }
+      if (IS_VARLEN) {
+        if (!is_null) {
+          const Slice* slice = reinterpret_cast<const Slice*>(column_block.cell_ptr(row_idx));
+          dst->varlen_data->append(slice->data(), slice->size());
+        }
+        uint32_t end_offset = dst->varlen_data->size();
+        dst->data->append(&end_offset, sizeof(end_offset));
+      } else {
+        if (is_null) {
+          memset(dst_cell, 0, cell_size);
+        } else {
+          strings::memcpy_inlined(dst_cell, column_block.cell_ptr(row_idx), cell_size);
+        }
+        dst_cell += cell_size;
+      }
+    }
+  }
+}
+
+void SerializeRowBlockColumnar(const RowBlock& block,
+                               const Schema* projection_schema,
+                               ColumnarSerializedBatch* out) {
+  const Schema& tablet_schema = block.schema();
+  if (projection_schema == nullptr) {
+    projection_schema = &tablet_schema;
+  }
+
+  if (out->columns.empty()) {
+    out->columns.resize(projection_schema->num_columns());
+    for (int i = 0; i < projection_schema->num_columns(); i++) {
+      const ColumnSchema& col = projection_schema->column(i);
+      ColumnarSerializedBatch::Column* dst = &out->columns[i];
+      dst->data.reset(new faststring());
+      if (col.type_info()->physical_type() == BINARY) {
+        dst->varlen_data.reset(new faststring());
+        // The leading offset of the first row.
+        uint32_t zero = 0;
+        dst->data->append(&zero, sizeof(zero));
+      }
+      if (col.is_nullable()) {
+        dst->non_null_bitmap.reset(new faststring());
+      }
+    }
+  }
+  DCHECK_EQ(out->columns.size(), projection_schema->num_columns());
+
+  for (int p_schema_idx = 0; p_schema_idx < projection_schema->num_columns(); p_schema_idx++) {
+    const ColumnSchema& col = projection_schema->column(p_schema_idx);
+    int t_schema_idx = tablet_schema.find_column(col.name());
+    DCHECK_NE(t_schema_idx, -1);
+    ColumnarSerializedBatch::Column* dst = &out->columns[p_schema_idx];
+
+    bool is_varlen = col.type_info()->physical_type() == BINARY;
+    if (col.is_nullable() && is_varlen) {
+      CopyColumnColumnar<true, true>(block, t_schema_idx, out->num_rows, dst);
+    } else if (col.is_nullable() && !is_varlen) {
+      CopyColumnColumnar<true, false>(block, t_schema_idx, out->num_rows, dst);
+    } else if (!col.is_nullable() && is_varlen) {
+      CopyColumnColumnar<false, true>(block, t_schema_idx, out->num_rows, dst);
+    } else {
+      CopyColumnColumnar<false, false>(block, t_schema_idx, out->num_rows, dst);
+    }
+  }
+  out->num_rows += block.selection_vector()->CountSelected();
+}
+
 } // namespace kudu
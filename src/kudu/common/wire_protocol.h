@@ -20,6 +20,7 @@
 #define KUDU_COMMON_WIRE_PROTOCOL_H
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "kudu/util/status.h"
@@ -154,6 +155,39 @@ void SerializeRowBlock(const RowBlock& block, RowwiseRowBlockPB* rowblock_pb,
                        faststring* data_buf, faststring* indirect_data,
                        bool pad_unixtime_micros_to_16_bytes = false);
 
+// The result of serializing one or more RowBlocks with
+// SerializeRowBlockColumnar(). See ColumnarRowBlockPB for the format of each
+// of the buffers.
+struct ColumnarSerializedBatch {
+  struct Column {
+    // The fixed-length cells, or the offsets into 'varlen_data' for
+    // variable-length columns.
+    std::unique_ptr<faststring> data;
+
+    // Only set for variable-length columns.
+    std::unique_ptr<faststring> varlen_data;
+
+    // Only set for nullable columns.
+    std::unique_ptr<faststring> non_null_bitmap;
+  };
+
+  // The columns, in the order of the projection schema.
+  std::vector<Column> columns;
+
+  // The number of rows serialized so far.
+  int64_t num_rows = 0;
+};
+
+// Like SerializeRowBlock(), but appends the selected rows of 'block' to 'out'
+// column by column, so that each projected column is returned in its own set
+// of contiguous buffers.
+//
+// If 'projection_schema' is not NULL, then only the columns it specifies are
+// serialized. The columns of 'out' are created on the first call.
+void SerializeRowBlockColumnar(const RowBlock& block,
+                               const Schema* projection_schema,
+                               ColumnarSerializedBatch* out);
+
 // Rewrites the data pointed-to by row data slice 'row_data_slice' by replacing
 // relative indirect data pointers with absolute ones in 'indirect_data_slice'.
 // At the time of this writing, this rewriting is only done for STRING types.
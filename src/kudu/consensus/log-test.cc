@@ -22,8 +22,10 @@
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -45,13 +47,17 @@
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/bind.h"
+#include "kudu/gutil/bind_helpers.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/async_util.h"
 #include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/env.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/random.h"
 #include "kudu/util/status.h"
@@ -68,6 +74,11 @@ DECLARE_double(log_inject_io_error_on_preallocate_fraction);
 DECLARE_int64(fs_wal_dir_reserved_bytes);
 DECLARE_int64(disk_reserved_bytes_free_for_testing);
 DECLARE_string(log_compression_codec);
+DECLARE_int32(log_segment_readahead_kb);
+DECLARE_bool(log_pipelined_sync);
+DECLARE_bool(log_shared_sync);
+DECLARE_double(env_inject_eio);
+DECLARE_string(env_inject_eio_globs);
 
 namespace kudu {
 namespace log {
@@ -249,6 +260,144 @@ TEST_P(LogTestOptionalCompression, TestFsync) {
   ASSERT_OK(log_->Close());
 }
 
+static void RecordAppendedIndex(simple_spinlock* lock, vector<int64_t>* indexes,
+                                CountDownLatch* latch, int64_t index, const Status& s) {
+  CHECK_OK(s);
+  {
+    std::lock_guard<simple_spinlock> l(*lock);
+    indexes->push_back(index);
+  }
+  latch->CountDown();
+}
+
+// Tests that, when the fsync of a group is pipelined with the appends of the
+// next ones, callbacks still run in append order, including across segment
+// roll-overs.
+TEST_P(LogTestOptionalCompression, TestPipelinedSyncCallbackOrder) {
+  FLAGS_log_pipelined_sync = true;
+  options_.force_fsync_all = true;
+  options_.segment_size_mb = 1;
+  ASSERT_OK(BuildLog());
+
+  const int kNumEntries = AllowSlowTests() ? 2000 : 500;
+  const string kPayload(8 * 1024, 'x');
+  simple_spinlock lock;
+  vector<int64_t> indexes;
+  CountDownLatch latch(kNumEntries);
+  for (int i = 1; i <= kNumEntries; i++) {
+    consensus::ReplicateRefPtr replicate =
+        make_scoped_refptr_replicate(new ReplicateMsg());
+    replicate->get()->set_op_type(NO_OP);
+    replicate->get()->mutable_id()->CopyFrom(MakeOpId(1, i));
+    replicate->get()->set_timestamp(clock_->Now().ToUint64());
+    replicate->get()->mutable_noop_request()->set_payload_for_tests(kPayload);
+    ASSERT_OK(log_->AsyncAppendReplicates(
+        { replicate }, Bind(&RecordAppendedIndex, Unretained(&lock), Unretained(&indexes),
+                            Unretained(&latch), i)));
+  }
+  latch.Wait();
+  ASSERT_OK(log_->Close());
+
+  ASSERT_EQ(kNumEntries, indexes.size());
+  for (int i = 0; i < kNumEntries; i++) {
+    ASSERT_EQ(i + 1, indexes[i]);
+  }
+  SegmentSequence segments;
+  ASSERT_OK(log_->reader()->GetSegmentsSnapshot(&segments));
+  ASSERT_GT(segments.size(), 1);
+}
+
+// Tests that the logs of several tablets can share their syncs.
+TEST_F(LogTest, TestSharedSync) {
+  FLAGS_log_shared_sync = true;
+  options_.force_fsync_all = true;
+  ASSERT_OK(BuildLog());
+  vector<scoped_refptr<Log>> logs = { log_ };
+  for (int i = 1; i < 4; i++) {
+    scoped_refptr<Log> other_log;
+    ASSERT_OK(Log::Open(options_, fs_manager_.get(), Substitute("other-tablet-$0", i),
+                        SchemaBuilder(schema_).Build(), 0, nullptr, &other_log));
+    logs.push_back(std::move(other_log));
+  }
+
+  const int kNumEntries = 100;
+  const int64_t syncs_before = log_->NumSharedSyncsForTests();
+  vector<std::thread> threads;
+  for (const auto& log : logs) {
+    threads.emplace_back([&, log]() {
+      OpId op_id = MakeOpId(1, 1);
+      for (int i = 0; i < kNumEntries; i++) {
+        CHECK_OK(AppendNoOpsToLogSync(clock_, log.get(), &op_id, 1));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // Every append waited for a sync, but the logs share the same WAL root, so
+  // appends to different logs which were in flight together shared syncs.
+  const int64_t num_syncs = log_->NumSharedSyncsForTests() - syncs_before;
+  ASSERT_GT(num_syncs, 0);
+  ASSERT_LT(num_syncs, kNumEntries * logs.size());
+
+  for (const auto& log : logs) {
+    ASSERT_OK(log->Close());
+    shared_ptr<LogReader> reader;
+    ASSERT_OK(LogReader::Open(fs_manager_.get(),
+                              make_scoped_refptr(new LogIndex(
+                                  fs_manager_->GetTabletWalDir(log->tablet_id()))),
+                              log->tablet_id(), nullptr, &reader));
+    SegmentSequence segments;
+    ASSERT_OK(reader->GetSegmentsSnapshot(&segments));
+    ASSERT_EQ(1, segments.size());
+    LogEntries entries;
+    ASSERT_OK(segments[0]->ReadEntries(&entries));
+    ASSERT_EQ(kNumEntries, entries.size());
+  }
+}
+
+// Once a shared filesystem sync fails, the data it should have made durable
+// may never be, so every later sync must fail as well.
+TEST_F(LogTest, TestSharedSyncErrorIsSticky) {
+  FLAGS_log_shared_sync = true;
+  options_.force_fsync_all = true;
+  ASSERT_OK(BuildLog());
+
+  OpId op_id = MakeOpId(1, 1);
+  ASSERT_OK(AppendNoOpsToLogSync(clock_, log_.get(), &op_id, 1));
+
+  FLAGS_env_inject_eio_globs = fs_manager_->GetWalsRootDir();
+  FLAGS_env_inject_eio = 1.0;
+  Status s = AppendNoOpsToLogSync(clock_, log_.get(), &op_id, 1);
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), Env::kInjectedFailureStatusMsg);
+
+  // The filesystem has "recovered", but the failed writeback hasn't.
+  FLAGS_env_inject_eio = 0;
+  const int64_t num_syncs = log_->NumSharedSyncsForTests();
+  s = AppendNoOpsToLogSync(clock_, log_.get(), &op_id, 1);
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), Env::kInjectedFailureStatusMsg);
+  ASSERT_EQ(num_syncs, log_->NumSharedSyncsForTests());
+}
+
+TEST_F(LogTest, TestSyncfsReportsWritebackErrors) {
+#if defined(__linux__)
+  ASSERT_FALSE(Log::SyncfsReportsWritebackErrors("2.6.32-754.el6.x86_64"));
+  ASSERT_FALSE(Log::SyncfsReportsWritebackErrors("4.18.0-348.el8.x86_64"));
+  ASSERT_FALSE(Log::SyncfsReportsWritebackErrors("5.7.19"));
+  ASSERT_TRUE(Log::SyncfsReportsWritebackErrors("5.8.0-63-generic"));
+  ASSERT_TRUE(Log::SyncfsReportsWritebackErrors("6.1.0"));
+
+  // Make sure it's a numeric sort, not a lexicographic one.
+  ASSERT_TRUE(Log::SyncfsReportsWritebackErrors("5.10.0"));
+  ASSERT_TRUE(Log::SyncfsReportsWritebackErrors("10.0.0"));
+#else
+  ASSERT_FALSE(Log::SyncfsReportsWritebackErrors("19.6.0"));
+#endif
+}
+
 // Regression test for part of KUDU-735:
 // if a log is not preallocated, we should properly track its on-disk size as we append to
 // it.
@@ -1044,6 +1193,45 @@ TEST_P(LogTestOptionalCompression, TestReadReplicatesHighIndex) {
   ASSERT_GT(op_id.index(), std::numeric_limits<int32_t>::max());
 }
 
+// Tests that entries are read correctly when the segment read-ahead buffer is
+// smaller than some of the entry batches and batches straddle its boundaries.
+TEST_P(LogTestOptionalCompression, TestReadWithSmallReadAhead) {
+  FLAGS_log_segment_readahead_kb = 1;
+  const int kNumBatches = 80;
+  ASSERT_OK(BuildLog());
+
+  OpId op_id = MakeOpId(1, 1);
+  int num_ops = 0;
+  for (int i = 1; i <= kNumBatches; i++) {
+    ASSERT_OK(AppendNoOpsToLogSync(clock_, log_.get(), &op_id, i));
+    num_ops += i;
+  }
+
+  // Read the in-progress segment sequentially.
+  SegmentSequence segments;
+  ASSERT_OK(log_->reader()->GetSegmentsSnapshot(&segments));
+  ASSERT_EQ(1, segments.size());
+  LogEntries entries;
+  ASSERT_OK(segments[0]->ReadEntries(&entries));
+  ASSERT_EQ(num_ops, entries.size());
+  for (int i = 0; i < num_ops; i++) {
+    ASSERT_EQ(i + 1, entries[i]->replicate().id().index());
+  }
+
+  // Read it through the index, once from the start and once from the middle
+  // of a batch.
+  vector<ReplicateMsg*> replicates;
+  ElementDeleter deleter(&replicates);
+  ASSERT_OK(log_->reader()->ReadReplicatesInRange(1, num_ops, LogReader::kNoSizeLimit,
+                                                  &replicates));
+  ASSERT_EQ(num_ops, replicates.size());
+  STLDeleteElements(&replicates);
+  ASSERT_OK(log_->reader()->ReadReplicatesInRange(num_ops / 2, num_ops,
+                                                  LogReader::kNoSizeLimit, &replicates));
+  ASSERT_EQ(num_ops - num_ops / 2 + 1, replicates.size());
+  ASSERT_EQ(num_ops / 2, replicates[0]->id().index());
+}
+
 // Test various situations where we expect different segments depending on what the
 // min log index is.
 TEST_F(LogTest, TestGetGCableDataSize) {
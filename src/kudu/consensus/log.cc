@@ -22,6 +22,8 @@
 #include <memory>
 #include <mutex>
 #include <ostream>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 #include <boost/range/adaptor/reversed.hpp>
@@ -39,11 +41,13 @@
 #include "kudu/gutil/dynamic_annotations.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/util/async_util.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/condition_variable.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -158,6 +162,38 @@ DEFINE_validator(fs_wal_dir_reserved_bytes, [](const char* /*n*/, int64_t v) { r
 TAG_FLAG(fs_wal_dir_reserved_bytes, runtime);
 TAG_FLAG(fs_wal_dir_reserved_bytes, evolving);
 
+DEFINE_bool(log_pipelined_sync, true,
+            "Whether to sync a group of WAL entries on a separate thread, so that the "
+            "next group can be written while the previous group's fsync is in flight. "
+            "Only has an effect when --log_force_fsync_all is set.");
+TAG_FLAG(log_pipelined_sync, advanced);
+TAG_FLAG(log_pipelined_sync, runtime);
+
+DEFINE_bool(log_shared_sync, false,
+            "Whether the WALs of all tablets share their fsyncs. Rather than syncing its "
+            "own segment, each tablet waits for a sync of the whole WAL filesystem, and "
+            "each such sync serves every tablet which was waiting for it. Only has an "
+            "effect when --log_force_fsync_all is set. Best used when the WAL directory "
+            "is on a dedicated disk, since the filesystem syncs also write back any "
+            "other data on it. Requires Linux 5.8 or later, since older kernels don't "
+            "report writeback errors to filesystem syncs.");
+TAG_FLAG(log_shared_sync, experimental);
+
+static bool ValidateLogSharedSync(const char* flagname, bool value) {
+  if (!value) {
+    return true;
+  }
+  const std::string release = kudu::Env::Default()->GetKernelRelease();
+  if (!kudu::log::Log::SyncfsReportsWritebackErrors(release)) {
+    LOG(ERROR) << strings::Substitute(
+        "--$0 is not supported on kernel $1: filesystem syncs may silently drop "
+        "writeback errors there", flagname, release);
+    return false;
+  }
+  return true;
+}
+DEFINE_validator(log_shared_sync, &ValidateLogSharedSync);
+
 // Validate that log_min_segments_to_retain >= 1
 static bool ValidateLogsToRetain(const char* flagname, int value) {
   if (value >= 1) {
@@ -183,6 +219,110 @@ using std::vector;
 using std::unique_ptr;
 using strings::Substitute;
 
+// Coalesces the fsyncs of all the logs under one WAL root directory into
+// syncs of the whole filesystem (see --log_shared_sync).
+//
+// A sync requested while another one is in flight waits for the next one,
+// which is then shared by every log which requested it in the meantime. This
+// way, a server hosting many tablets issues one stream of syncs per WAL
+// filesystem rather than one per tablet.
+class WalSyncGroup {
+ public:
+  // Returns the group for 'wal_root', creating it if necessary. Groups live
+  // for the lifetime of the process.
+  static WalSyncGroup* Get(Env* env, const string& wal_root);
+
+  // Returns once everything written to the filesystem before the call is
+  // durable.
+  Status Sync();
+
+  // Returns the number of filesystem syncs issued so far.
+  int64_t num_syncs() {
+    MutexLock l(lock_);
+    return started_;
+  }
+
+ private:
+  WalSyncGroup(Env* env, string wal_root)
+      : env_(env),
+        wal_root_(std::move(wal_root)),
+        cond_(&lock_),
+        started_(0),
+        completed_(0),
+        in_progress_(false) {
+  }
+
+  Env* const env_;
+  const string wal_root_;
+
+  // Protects the fields below.
+  Mutex lock_;
+  ConditionVariable cond_;
+
+  // The number of syncs started and completed.
+  int64_t started_;
+  int64_t completed_;
+  bool in_progress_;
+
+  // The first error returned by a filesystem sync. Once writeback has failed,
+  // the data written before may never become durable, even if later syncs
+  // succeed, so every sync which follows fails with the same error.
+  Status error_;
+
+  DISALLOW_COPY_AND_ASSIGN(WalSyncGroup);
+};
+
+WalSyncGroup* WalSyncGroup::Get(Env* env, const string& wal_root) {
+  static simple_spinlock lock;
+  static auto* groups = new std::unordered_map<string, WalSyncGroup*>();
+  std::lock_guard<simple_spinlock> l(lock);
+  WalSyncGroup*& group = (*groups)[wal_root];
+  if (!group) {
+    group = new WalSyncGroup(env, wal_root);
+  }
+  return group;
+}
+
+Status WalSyncGroup::Sync() {
+  MutexLock l(lock_);
+  // A sync which is already in flight may have started before the caller's
+  // data was written, so only the next one is guaranteed to cover it.
+  const int64_t target = started_ + 1;
+  while (completed_ < target && error_.ok()) {
+    if (in_progress_) {
+      cond_.Wait();
+      continue;
+    }
+    in_progress_ = true;
+    started_++;
+    l.Unlock();
+    Status s = env_->SyncFilesystem(wal_root_);
+    l.Lock();
+    in_progress_ = false;
+    completed_ = started_;
+    if (PREDICT_FALSE(!s.ok()) && error_.ok()) {
+      error_ = s.CloneAndPrepend(Substitute("Failed to sync WAL filesystem at $0", wal_root_));
+    }
+    cond_.Broadcast();
+  }
+  return error_;
+}
+
+bool Log::SyncfsReportsWritebackErrors(const string& kernel_release) {
+#if defined(__linux__)
+  // syncfs() reports writeback errors since Linux 5.8 (commit 735e4ae5ba28).
+  autodigit_less lt;
+  return !lt(kernel_release, "5.8");
+#else
+  // Elsewhere, filesystems are synced with sync(), which reports no errors.
+  return false;
+#endif
+}
+
+int64_t Log::NumSharedSyncsForTests() const {
+  return sync_group_ ? sync_group_->num_syncs() : 0;
+}
+
 // Manages the thread which drains groups of batches from the log's queue and
 // appends them to the underlying log instance.
 //
@@ -205,6 +345,14 @@ using strings::Substitute;
 //    ensure that it doesn't miss a concurrent wake-up. This is done in GoIdle().
 //
 // See the implementation comments in Wake() and GoIdle() for details.
+//
+// When fsync is enabled, a written group is handed to a task on a second
+// single-threaded pool which syncs it and runs its callbacks, while the append
+// task goes on to write the next group. Groups which are written while a sync
+// is in flight are synced together by the next sync. Since the sync task
+// handles groups in the order they were written, and groups which need no
+// sync are also routed through it while it is running, callbacks still run in
+// log order.
 class Log::AppendThread {
  public:
   explicit AppendThread(Log* log);
@@ -242,6 +390,14 @@ class Log::AppendThread {
   // LogEntryBatch* pointers.
   void HandleGroup(vector<LogEntryBatch*> entry_batches);
 
+  // The task submitted to sync_pool_ which syncs pending groups and runs
+  // their callbacks until there are none left.
+  void DoSync();
+
+  // Runs the callbacks of a group of batches which were written and synced
+  // with 'sync_status', and deletes the batches.
+  void FinishGroup(vector<LogEntryBatch*> entry_batches, const Status& sync_status);
+
   string LogPrefix() const;
 
   Log* const log_;
@@ -259,6 +415,22 @@ class Log::AppendThread {
   // Pool with a single thread, which handles shutting down the thread
   // when idle.
   gscoped_ptr<ThreadPool> append_pool_;
+
+  // Pool with a single thread which runs DoSync().
+  gscoped_ptr<ThreadPool> sync_pool_;
+
+  // Protects the fields below.
+  simple_spinlock sync_lock_;
+
+  // Batches which were written but whose callbacks haven't run yet, in the
+  // order they were written.
+  vector<LogEntryBatch*> pending_batches_;
+
+  // Whether any of 'pending_batches_' require a sync.
+  bool pending_needs_sync_ = false;
+
+  // Whether a DoSync() task is queued or running.
+  bool sync_task_running_ = false;
 };
 
 
@@ -278,6 +450,10 @@ Status Log::AppendThread::Init() {
                 // handles waiting for work while idle.
                 .set_idle_timeout(MonoDelta::FromSeconds(0))
                 .Build(&append_pool_));
+  RETURN_NOT_OK(ThreadPoolBuilder("wal-sync")
+                .set_min_threads(0)
+                .set_max_threads(1)
+                .Build(&sync_pool_));
   return Status::OK();
 }
 
@@ -349,6 +525,14 @@ void Log::AppendThread::DoWork() {
   VLOG_WITH_PREFIX(2) << "WAL Appender going idle";
 }
 
+// Reports a failure to append a batch to the batch's callback once the
+// callbacks of the preceding batches have run.
+static void ReportAppendError(const StatusCallback& callback,
+                              const Status& append_status,
+                              const Status& /* sync_status */) {
+  callback.Run(append_status);
+}
+
 void Log::AppendThread::HandleGroup(vector<LogEntryBatch*> entry_batches) {
   if (log_->metrics_) {
     log_->metrics_->entry_batches_per_group->Increment(entry_batches.size());
@@ -368,8 +552,7 @@ void Log::AppendThread::HandleGroup(vector<LogEntryBatch*> entry_batches) {
       // them to be appended? What about transactions in future
       // batches?
       if (!entry_batch->callback().is_null()) {
-        entry_batch->callback().Run(s);
-        entry_batch->callback_.Reset();
+        entry_batch->callback_ = Bind(&ReportAppendError, entry_batch->callback(), s);
       }
     }
     if (is_all_commits && entry_batch->type_ != COMMIT) {
@@ -377,15 +560,60 @@ void Log::AppendThread::HandleGroup(vector<LogEntryBatch*> entry_batches) {
     }
   }
 
+  {
+    std::lock_guard<simple_spinlock> l(sync_lock_);
+    // Once a group is handed to the sync task, every later group must be too,
+    // until the sync task catches up, so that callbacks run in order.
+    if (sync_task_running_ ||
+        (!is_all_commits && FLAGS_log_pipelined_sync &&
+         log_->force_sync_all_ && !log_->sync_disabled_)) {
+      pending_batches_.insert(pending_batches_.end(), entry_batches.begin(), entry_batches.end());
+      pending_needs_sync_ |= !is_all_commits;
+      if (!sync_task_running_) {
+        sync_task_running_ = true;
+        CHECK_OK(sync_pool_->SubmitClosure(Bind(&Log::AppendThread::DoSync, Unretained(this))));
+      }
+      return;
+    }
+  }
+
   Status s;
   if (!is_all_commits) {
     s = log_->Sync();
   }
-  if (PREDICT_FALSE(!s.ok())) {
-    LOG_WITH_PREFIX(ERROR) << "Error syncing log: " << s.ToString();
+  FinishGroup(std::move(entry_batches), s);
+}
+
+void Log::AppendThread::DoSync() {
+  while (true) {
+    vector<LogEntryBatch*> entry_batches;
+    bool needs_sync;
+    {
+      std::lock_guard<simple_spinlock> l(sync_lock_);
+      if (pending_batches_.empty()) {
+        sync_task_running_ = false;
+        return;
+      }
+      entry_batches.swap(pending_batches_);
+      needs_sync = pending_needs_sync_;
+      pending_needs_sync_ = false;
+    }
+
+    Status s;
+    if (needs_sync) {
+      s = log_->Sync();
+    }
+    FinishGroup(std::move(entry_batches), s);
+  }
+}
+
+void Log::AppendThread::FinishGroup(vector<LogEntryBatch*> entry_batches,
+                                    const Status& sync_status) {
+  if (PREDICT_FALSE(!sync_status.ok())) {
+    LOG_WITH_PREFIX(ERROR) << "Error syncing log: " << sync_status.ToString();
     for (LogEntryBatch* entry_batch : entry_batches) {
       if (!entry_batch->callback().is_null()) {
-        entry_batch->callback().Run(s);
+        entry_batch->callback().Run(sync_status);
       }
       delete entry_batch;
     }
@@ -411,6 +639,11 @@ void Log::AppendThread::Shutdown() {
     append_pool_->Wait();
     append_pool_->Shutdown();
   }
+  // The last groups written may still be waiting to be synced.
+  if (sync_pool_) {
+    sync_pool_->Wait();
+    sync_pool_->Shutdown();
+  }
 }
 
 string Log::AppendThread::LogPrefix() const {
@@ -474,6 +707,7 @@ Log::Log(LogOptions options, FsManager* fs_manager, string log_path,
       append_thread_(new AppendThread(this)),
       force_sync_all_(options_.force_fsync_all),
       sync_disabled_(false),
+      sync_group_(nullptr),
       allocation_state_(kAllocationNotStarted),
       codec_(nullptr),
       metric_entity_(std::move(metric_entity)),
@@ -497,6 +731,10 @@ Status Log::Init() {
     }
   }
 
+  if (FLAGS_log_shared_sync) {
+    sync_group_ = WalSyncGroup::Get(fs_manager_->env(), fs_manager_->GetWalsRootDir());
+  }
+
   // Init the index
   log_index_.reset(new LogIndex(log_dir_));
 
@@ -568,7 +806,10 @@ Status Log::RollOver() {
 
   DCHECK_EQ(allocation_state(), kAllocationFinished);
 
-  RETURN_NOT_OK(Sync());
+  // Hold off the append thread's sync task while the segment it syncs is
+  // replaced.
+  MutexLock l(segment_sync_lock_);
+  RETURN_NOT_OK(SyncUnlocked());
   RETURN_NOT_OK(CloseCurrentSegment());
 
   RETURN_NOT_OK(SwitchToAllocatedSegment());
@@ -731,6 +972,12 @@ FsManager* Log::GetFsManager() {
 }
 
 Status Log::Sync() {
+  MutexLock l(segment_sync_lock_);
+  return SyncUnlocked();
+}
+
+Status Log::SyncUnlocked() {
+  segment_sync_lock_.AssertAcquired();
   TRACE_EVENT0("log", "Sync");
   SCOPED_LATENCY_METRIC(metrics_, sync_latency);
 
@@ -746,7 +993,11 @@ Status Log::Sync() {
 
   if (force_sync_all_ && !sync_disabled_) {
     LOG_SLOW_EXECUTION(WARNING, 50, Substitute("$0Fsync log took a long time", LogPrefix())) {
-      RETURN_NOT_OK(active_segment_->Sync());
+      if (sync_group_) {
+        RETURN_NOT_OK(sync_group_->Sync());
+      } else {
+        RETURN_NOT_OK(active_segment_->Sync());
+      }
 
       if (log_hooks_) {
         RETURN_NOT_OK_PREPEND(log_hooks_->PostSyncIfFsyncEnabled(),
@@ -43,6 +43,7 @@
 #include "kudu/util/blocking_queue.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/promise.h"
 #include "kudu/util/rw_mutex.h"
 #include "kudu/util/slice.h"
@@ -66,6 +67,7 @@ struct RetentionIndexes;
 class LogEntryBatch;
 class LogIndex;
 class LogReader;
+class WalSyncGroup;
 
 typedef BlockingQueue<LogEntryBatch*, LogEntryBatchLogicalSize> LogEntryBatchQueue;
 
@@ -144,6 +146,10 @@ class Log : public RefCountedThreadSafe<Log> {
   // Intended to be invoked after log replay successfully completes.
   static Status RemoveRecoveryDirIfExists(FsManager* fs_manager, const std::string& tablet_id);
 
+  // Returns whether filesystem syncs report writeback errors on a kernel with
+  // the given release, which --log_shared_sync relies on.
+  static bool SyncfsReportsWritebackErrors(const std::string& kernel_release);
+
   // Returns a reader that is able to read through the previous segments,
   // provided the log is initialized and not yet closed. After being closed,
   // this function will return NULL, but existing reader references will
@@ -158,6 +164,10 @@ class Log : public RefCountedThreadSafe<Log> {
     options_.async_preallocate_segments = false;
   }
 
+  // Returns the number of filesystem syncs issued for the logs under this
+  // log's WAL root, or 0 if syncs aren't shared (see --log_shared_sync).
+  int64_t NumSharedSyncsForTests() const;
+
   void DisableSync() {
     sync_disabled_ = true;
   }
@@ -317,8 +327,13 @@ class Log : public RefCountedThreadSafe<Log> {
   // being written to, by the same segment once properly closed.
   Status ReplaceSegmentInReaderUnlocked();
 
+  // Syncs the active segment. May be called from the append thread's sync
+  // task concurrently with appends.
   Status Sync();
 
+  // Same as Sync(), but requires that 'segment_sync_lock_' is held.
+  Status SyncUnlocked();
+
   // Helper method to get the segment sequence to GC based on the provided 'retention' struct.
   Status GetSegmentsToGCUnlocked(RetentionIndexes retention_indexes,
                                  SegmentSequence* segments_to_gc) const;
@@ -398,6 +413,15 @@ class Log : public RefCountedThreadSafe<Log> {
   // This is used to disable fsync during bootstrap.
   bool sync_disabled_;
 
+  // Serializes syncing the active segment against rolling over to a new one,
+  // since segments may be synced by the append thread's sync task while the
+  // append thread itself writes to them.
+  Mutex segment_sync_lock_;
+
+  // If set, syncs go through this group rather than syncing the active segment
+  // directly (see --log_shared_sync).
+  WalSyncGroup* sync_group_;
+
   // The status of the most recent log-allocation action.
   Promise<Status> allocation_status_;
 
@@ -22,6 +22,7 @@
 #include <mutex>
 #include <ostream>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 
 #include "kudu/consensus/consensus.pb.h"
@@ -39,6 +40,8 @@
 #include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 
+DECLARE_int32(log_segment_readahead_kb);
+
 METRIC_DEFINE_counter(tablet, log_reader_bytes_read, "Bytes Read From Log",
                       kudu::MetricUnit::kBytes,
                       "Data read from the WAL since tablet start");
@@ -236,6 +239,7 @@ scoped_refptr<ReadableLogSegment> LogReader::GetSegmentBySequenceNumber(int64_t
 }
 
 Status LogReader::ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
+                                           SegmentReadBuffer* read_buf,
                                            faststring* tmp_buf,
                                            unique_ptr<LogEntryBatchPB>* batch) const {
   const int64_t index = index_entry.op_id.index();
@@ -252,7 +256,7 @@ Status LogReader::ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
   int64_t offset = index_entry.offset_in_segment;
   ScopedLatencyMetric scoped(read_batch_latency_.get());
   EntryHeaderStatus unused_status_detail;
-  RETURN_NOT_OK_PREPEND(segment->ReadEntryHeaderAndBatch(&offset, tmp_buf, batch,
+  RETURN_NOT_OK_PREPEND(segment->ReadEntryHeaderAndBatch(&offset, read_buf, tmp_buf, batch,
                                                          &unused_status_detail),
                         Substitute("Failed to read LogEntry for index $0 from log segment "
                                    "$1 offset $2",
@@ -283,6 +287,9 @@ Status LogReader::ReadReplicatesInRange(int64_t starting_at,
   int64_t total_size = 0;
   bool limit_exceeded = false;
   faststring tmp_buf;
+  // Consecutive operations are usually stored next to each other, so read
+  // ahead of the batch being read.
+  SegmentReadBuffer read_buf(FLAGS_log_segment_readahead_kb * 1024);
   unique_ptr<LogEntryBatchPB> batch;
   for (int64_t index = starting_at; index <= up_to && !limit_exceeded; index++) {
     LogIndexEntry index_entry;
@@ -296,7 +303,7 @@ Status LogReader::ReadReplicatesInRange(int64_t starting_at,
     if (index == starting_at ||
         index_entry.segment_sequence_number != prev_index_entry.segment_sequence_number ||
         index_entry.offset_in_segment != prev_index_entry.offset_in_segment) {
-      RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entry, &tmp_buf, &batch));
+      RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entry, &read_buf, &tmp_buf, &batch));
 
       // Sanity-check the property that a batch should only have increasing indexes.
       int64_t prev_index = 0;
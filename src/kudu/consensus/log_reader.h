@@ -166,8 +166,10 @@ class LogReader : public enable_make_shared<LogReader> {
   void UpdateLastSegmentOffset(int64_t readable_to_offset);
 
   // Read the LogEntryBatchPB pointed to by the provided index entry.
-  // 'tmp_buf' is used as scratch space to avoid extra allocation.
+  // 'read_buf' is used to read ahead of the batch, and 'tmp_buf' is used as
+  // scratch space to avoid extra allocation.
   Status ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
+                                  SegmentReadBuffer* read_buf,
                                   faststring* tmp_buf,
                                   std::unique_ptr<LogEntryBatchPB>* batch) const;
 
@@ -62,6 +62,12 @@ DEFINE_bool(log_async_preallocate_segments, true,
             "Whether the WAL segments preallocation should happen asynchronously");
 TAG_FLAG(log_async_preallocate_segments, advanced);
 
+DEFINE_int32(log_segment_readahead_kb, 1024,
+             "Amount of data, in KiB, read ahead from a WAL segment when reading its "
+             "entries sequentially, e.g. during tablet bootstrap or when catching up "
+             "a lagging follower. Set to 0 to read each entry with separate reads.");
+TAG_FLAG(log_segment_readahead_kb, advanced);
+
 DEFINE_double(fault_crash_before_write_log_segment_header, 0.0,
               "Fraction of the time we will crash just before writing the log segment header");
 TAG_FLAG(fault_crash_before_write_log_segment_header, unsafe);
@@ -105,6 +111,44 @@ LogOptions::LogOptions()
   async_preallocate_segments(FLAGS_log_async_preallocate_segments) {
 }
 
+////////////////////////////////////////////////////////////
+// SegmentReadBuffer
+////////////////////////////////////////////////////////////
+
+// Alignment of the reads issued by SegmentReadBuffer.
+static const int64_t kReadAheadAlignment = 4096;
+
+SegmentReadBuffer::SegmentReadBuffer(size_t capacity)
+    : buf_offset_(0),
+      capacity_(capacity) {
+}
+
+Status SegmentReadBuffer::Read(const ReadableLogSegment* seg, int64_t offset,
+                               size_t length, uint8_t* dst) {
+  if (length > capacity_) {
+    return seg->readable_file()->Read(offset, Slice(dst, length));
+  }
+
+  const int64_t end = offset + length;
+  if (file_ != seg->readable_file() ||
+      offset < buf_offset_ ||
+      end > buf_offset_ + static_cast<int64_t>(buf_.size())) {
+    // Refill the buffer starting at the aligned offset below 'offset'. Data at
+    // or beyond readable_up_to() may still be rewritten, so it isn't read
+    // ahead, though the requested range itself is always read.
+    int64_t fill_offset = offset & ~(kReadAheadAlignment - 1);
+    int64_t fill_end = std::min<int64_t>(fill_offset + capacity_, seg->readable_up_to());
+    fill_end = std::max(fill_end, end);
+    file_.reset();
+    buf_.resize(fill_end - fill_offset);
+    RETURN_NOT_OK(seg->readable_file()->Read(fill_offset, Slice(buf_.data(), buf_.size())));
+    file_ = seg->readable_file();
+    buf_offset_ = fill_offset;
+  }
+  memcpy(dst, buf_.data() + (offset - buf_offset_), length);
+  return Status::OK();
+}
+
 ////////////////////////////////////////////////////////////
 // LogEntryReader
 ////////////////////////////////////////////////////////////
@@ -113,7 +157,8 @@ LogEntryReader::LogEntryReader(ReadableLogSegment* seg)
     : seg_(seg),
       num_batches_read_(0),
       num_entries_read_(0),
-      offset_(seg_->first_entry_offset()) {
+      offset_(seg_->first_entry_offset()),
+      read_buf_(FLAGS_log_segment_readahead_kb * 1024) {
 
   int64_t readable_to_offset = seg_->readable_to_offset_.Load();
 
@@ -152,7 +197,8 @@ Status LogEntryReader::ReadNextEntry(unique_ptr<LogEntryPB>* entry) {
     Status s;
     EntryHeaderStatus s_detail = EntryHeaderStatus::OTHER_ERROR;
     if (offset_ + seg_->entry_header_size() < read_up_to_) {
-      s = seg_->ReadEntryHeaderAndBatch(&offset_, &tmp_buf_, &current_batch, &s_detail);
+      s = seg_->ReadEntryHeaderAndBatch(&offset_, &read_buf_, &tmp_buf_, &current_batch,
+                                        &s_detail);
     } else {
       s = Status::Corruption(Substitute("Truncated log entry at offset $0", offset_));
     }
@@ -615,13 +661,15 @@ Status ReadableLogSegment::ScanForValidEntryHeaders(int64_t offset, bool* has_va
   return Status::OK();
 }
 
-Status ReadableLogSegment::ReadEntryHeaderAndBatch(int64_t* offset, faststring* tmp_buf,
+Status ReadableLogSegment::ReadEntryHeaderAndBatch(int64_t* offset,
+                                                   SegmentReadBuffer* read_buf,
+                                                   faststring* tmp_buf,
                                                    unique_ptr<LogEntryBatchPB>* batch,
                                                    EntryHeaderStatus* status_detail) {
   int64_t cur_offset = *offset;
   EntryHeader header;
-  RETURN_NOT_OK(ReadEntryHeader(&cur_offset, &header, status_detail));
-  Status s = ReadEntryBatch(&cur_offset, header, tmp_buf, batch);
+  RETURN_NOT_OK(ReadEntryHeader(&cur_offset, read_buf, &header, status_detail));
+  Status s = ReadEntryBatch(&cur_offset, read_buf, header, tmp_buf, batch);
   if (PREDICT_FALSE(!s.ok())) {
     // If we failed to actually decode the batch, make sure to set status_detail to
     // non-OK.
@@ -632,12 +680,14 @@ Status ReadableLogSegment::ReadEntryHeaderAndBatch(int64_t* offset, faststring*
   return Status::OK();
 }
 
-Status ReadableLogSegment::ReadEntryHeader(int64_t *offset, EntryHeader* header,
+Status ReadableLogSegment::ReadEntryHeader(int64_t *offset,
+                                           SegmentReadBuffer* read_buf,
+                                           EntryHeader* header,
                                            EntryHeaderStatus* status_detail) {
   const size_t header_size = entry_header_size();
   uint8_t scratch[header_size];
   Slice slice(scratch, header_size);
-  RETURN_NOT_OK_PREPEND(readable_file()->Read(*offset, slice),
+  RETURN_NOT_OK_PREPEND(read_buf->Read(this, *offset, header_size, scratch),
                         "Could not read log entry header");
 
   *status_detail = DecodeEntryHeader(slice, header);
@@ -687,6 +737,7 @@ EntryHeaderStatus ReadableLogSegment::DecodeEntryHeader(
 
 
 Status ReadableLogSegment::ReadEntryBatch(int64_t* offset,
+                                          SegmentReadBuffer* read_buf,
                                           const EntryHeader& header,
                                           faststring* tmp_buf,
                                           unique_ptr<LogEntryBatchPB>* entry_batch) {
@@ -715,7 +766,7 @@ Status ReadableLogSegment::ReadEntryBatch(int64_t* offset,
   }
   tmp_buf->resize(buf_len);
   Slice entry_batch_slice(tmp_buf->data(), header.msg_length_compressed);
-  Status s =  readable_file()->Read(*offset, entry_batch_slice);
+  Status s = read_buf->Read(this, *offset, entry_batch_slice.size(), tmp_buf->data());
 
   if (!s.ok()) return Status::IOError(Substitute("Could not read entry. Cause: $0",
                                                  s.ToString()));
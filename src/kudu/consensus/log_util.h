@@ -95,6 +95,36 @@ enum class EntryHeaderStatus {
   OTHER_ERROR
 };
 
+// Buffers reads from a log segment so that entries which are read in file
+// order are fetched with a few large, aligned reads instead of two small
+// reads (header and batch) per entry.
+//
+// Only data below the segment's readable_up_to() offset at the time of a read
+// is buffered, so reading a segment which is still being written is safe.
+class SegmentReadBuffer {
+ public:
+  // Creates a buffer which reads ahead up to 'capacity' bytes. Reads larger
+  // than 'capacity' bypass the buffer.
+  explicit SegmentReadBuffer(size_t capacity);
+
+  // Copies 'length' bytes at 'offset' in 'seg' into 'dst', reading them ahead
+  // from the file along with the data which follows them if they aren't
+  // buffered already.
+  Status Read(const ReadableLogSegment* seg, int64_t offset, size_t length, uint8_t* dst);
+
+ private:
+  // The file whose data is buffered, or null if nothing is buffered.
+  std::shared_ptr<RandomAccessFile> file_;
+
+  // The file offset of the first byte in 'buf_'.
+  int64_t buf_offset_;
+
+  const size_t capacity_;
+  faststring buf_;
+
+  DISALLOW_COPY_AND_ASSIGN(SegmentReadBuffer);
+};
+
 // LogEntryReader provides iterator-style access to read the entries
 // from an open log segment.
 class LogEntryReader {
@@ -161,6 +191,9 @@ class LogEntryReader {
   // Temporary buffer used for deserialization.
   faststring tmp_buf_;
 
+  // Reads ahead of 'offset_'.
+  SegmentReadBuffer read_buf_;
+
   DISALLOW_COPY_AND_ASSIGN(LogEntryReader);
 };
 
@@ -331,13 +364,16 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
   // file.
   Status ScanForValidEntryHeaders(int64_t offset, bool* has_valid_entries);
 
-  // Read an entry header and its associated batch at the given offset.
+  // Read an entry header and its associated batch at the given offset,
+  // through 'read_buf'.
   // If successful, updates '*offset' to point to the next batch
   // in the file.
   //
   // If unsuccessful, '*offset' is not updated, and *status_detail will be updated
   // to indicate the cause of the error.
-  Status ReadEntryHeaderAndBatch(int64_t* offset, faststring* tmp_buf,
+  Status ReadEntryHeaderAndBatch(int64_t* offset,
+                                 SegmentReadBuffer* read_buf,
+                                 faststring* tmp_buf,
                                  std::unique_ptr<LogEntryBatchPB>* batch,
                                  EntryHeaderStatus* status_detail);
 
@@ -345,7 +381,7 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
   //
   // Also increments the passed offset* by the length of the entry on successful
   // read.
-  Status ReadEntryHeader(int64_t *offset, EntryHeader* header,
+  Status ReadEntryHeader(int64_t *offset, SegmentReadBuffer* read_buf, EntryHeader* header,
                          EntryHeaderStatus* status_detail);
 
   // Decode a log entry header from the given slice. The header length is
@@ -359,6 +395,7 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
   // Reads a log entry batch from the provided readable segment, which gets decoded
   // into 'entry_batch' and increments 'offset' by the batch's length.
   Status ReadEntryBatch(int64_t* offset,
+                        SegmentReadBuffer* read_buf,
                         const EntryHeader& header,
                         faststring* tmp_buf,
                         std::unique_ptr<LogEntryBatchPB>* entry_batch);
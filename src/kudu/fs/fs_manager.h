@@ -234,6 +234,12 @@ class FsManager {
     return JoinPathSegments(GetConsensusMetadataDir(), tablet_id);
   }
 
+  // Return the path where the keys of hot block cache entries are saved.
+  std::string GetBlockCacheKeysPath() const {
+    DCHECK(initted_);
+    return JoinPathSegments(canonicalized_metadata_fs_root_.path, kBlockCacheKeysFileName);
+  }
+
   Env* env() { return env_; }
 
   bool read_only() const {
@@ -326,6 +332,7 @@ class FsManager {
   static const char *kInstanceMetadataMagicNumber;
   static const char *kTabletSuperBlockMagicNumber;
   static const char *kConsensusMetadataDirName;
+  static const char *kBlockCacheKeysFileName;
 
   // The environment to be used for all filesystem operations.
   Env* env_;
@@ -68,6 +68,17 @@ class RetriableRpc : public Rpc {
   // Try() to actually send the request.
   void SendRpc() override;
 
+  // Makes this RPC a retry of a request which was already sent 'num_attempts'
+  // times under the sequence number 'seq_no', e.g. as part of another RPC.
+  // This RPC then takes over completing 'seq_no' in the request tracker.
+  //
+  // Must be called before SendRpc().
+  void AdoptSequenceNumber(internal::SequenceNumber seq_no, int32_t num_attempts) {
+    DCHECK_EQ(sequence_number_, RequestTracker::kNoSeqNo);
+    sequence_number_ = seq_no;
+    num_attempts_ = num_attempts;
+  }
+
   // The callback to call upon retrieving (of failing to retrieve) a new authn
   // token. This is the callback that subclasses should call in their custom
   // implementation of the GetNewAuthnTokenAndRetry() method.
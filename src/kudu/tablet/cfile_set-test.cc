@@ -54,6 +54,7 @@
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_bool(materializing_iterator_late_materialization);
 DECLARE_int32(cfile_default_block_size);
 
 using std::shared_ptr;
@@ -349,6 +350,97 @@ TEST_F(TestCFileSet, TestRangePredicates2) {
   DoTestRangeScan(fileset, kNumRows * 10, kNoBound);
 }
 
+// Test that scanning with a predicate that selects scattered rows yields the
+// same rows, with the same values, whether or not the cells of rows rejected
+// by the predicate are materialized.
+TEST_F(TestCFileSet, TestLateMaterialization) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), nullptr, &fileset));
+
+  // Select isolated rows, short runs of rows, and rows spread across batches
+  // and blocks.
+  vector<int32_t> expected_rows = { 3, 50, 51, 52, 99, 100, 250, 1003 };
+  for (int32_t i = 5000; i < 6000; i += 7) {
+    expected_rows.push_back(i);
+  }
+  vector<int32_t> c1_values;
+  for (int32_t row : expected_rows) {
+    c1_values.push_back(row * 10);
+  }
+
+  for (bool late_materialization : { false, true }) {
+    FLAGS_materializing_iterator_late_materialization = late_materialization;
+    shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_, nullptr));
+    gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+
+    vector<const void*> values;
+    for (const auto& v : c1_values) {
+      values.push_back(&v);
+    }
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::InList(schema_.column(1), &values));
+    ASSERT_OK(iter->Init(&spec));
+
+    vector<int32_t> rows;
+    Arena arena(1024);
+    RowBlock block(schema_, 100, &arena);
+    while (iter->HasNext()) {
+      ASSERT_OK_FAST(iter->NextBlock(&block));
+      for (size_t i = 0; i < block.nrows(); i++) {
+        if (!block.selection_vector()->IsRowSelected(i)) continue;
+        RowBlockRow row = block.row(i);
+        int32_t row_idx = *schema_.ExtractColumnFromRow<INT32>(row, 1) / 10;
+        ASSERT_EQ(row_idx * 2, *schema_.ExtractColumnFromRow<INT32>(row, 0));
+        ASSERT_EQ(row_idx * 100, *schema_.ExtractColumnFromRow<INT32>(row, 2));
+        rows.push_back(row_idx);
+      }
+    }
+    ASSERT_EQ(expected_rows, rows);
+  }
+}
+
+// Test that a predicate on a non-key column skips the data blocks whose zone
+// map entries rule it out.
+TEST_F(TestCFileSet, TestZoneMapSkipsBlocks) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), nullptr, &fileset));
+  shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_, nullptr));
+  gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+
+  // Only rows [5000, 5010) have a 'c2' value in the range.
+  int32_t lower = 500000;
+  int32_t upper = 501000;
+  ScanSpec spec;
+  spec.AddPredicate(ColumnPredicate::Range(schema_.column(2), &lower, &upper));
+  ASSERT_OK(iter->Init(&spec));
+
+  vector<string> results;
+  ASSERT_OK(IterateToStringList(iter.get(), &results));
+  ASSERT_EQ(10, results.size());
+  EXPECT_EQ("(int32 c0=10000, int32 c1=50000, int32 c2=500000)", results[0]);
+  EXPECT_EQ("(int32 c0=10018, int32 c1=50090, int32 c2=500900)", results[9]);
+
+  vector<IteratorStats> stats;
+  iter->GetIteratorStats(&stats);
+  ASSERT_EQ(3, stats.size());
+  for (int i = 0; i < 3; i++) {
+    LOG(INFO) << "Col " << i << " stats: " << stats[i].ToString();
+  }
+
+  // Nearly all of the predicate column's blocks were skipped, and so were
+  // the rows of the other columns.
+  ASSERT_GT(stats[2].blocks_skipped, 10);
+  ASSERT_LE(stats[2].blocks_read, 2);
+  ASSERT_LE(stats[0].blocks_read, 2);
+  ASSERT_LE(stats[1].blocks_read, 2);
+}
+
 
 } // namespace tablet
 } // namespace kudu
@@ -526,9 +526,22 @@ Status CFileSet::Iterator::MaterializeColumn(ColumnMaterializationContext *ctx)
   CHECK_EQ(prepared_count_, ctx->block()->nrows());
   DCHECK_LT(ctx->col_idx(), col_iters_.size());
 
-  RETURN_NOT_OK(PrepareColumn(ctx));
   ColumnIterator* iter = col_iters_[ctx->col_idx()].get();
+  if (ctx->materialize_selected_rows_only() && ctx->pred() != nullptr &&
+      !ctx->values_may_be_updated()) {
+    // Deselect the rows of blocks which can't satisfy the predicate before
+    // anything is read, so that those blocks may be skipped entirely.
+    RETURN_NOT_OK(iter->DeselectUnmatchedRows(cur_idx_, prepared_count_,
+                                              *ctx->pred(), ctx->sel()));
+  }
+
+  if (ctx->materialize_selected_rows_only() && !ctx->sel()->AnySelected()) {
+    // Every row was filtered out, so there's no need to read the column's
+    // blocks at all. If it's needed again, PrepareColumn() will seek it.
+    return Status::OK();
+  }
 
+  RETURN_NOT_OK(PrepareColumn(ctx));
   RETURN_NOT_OK(iter->Scan(ctx));
 
   return Status::OK();
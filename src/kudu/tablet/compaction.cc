@@ -90,18 +90,26 @@ class MemRowSetCompactionInput : public CompactionInput {
  public:
   MemRowSetCompactionInput(const MemRowSet& memrowset,
                            const MvccSnapshot& snap,
-                           const Schema* projection)
+                           const Schema* projection,
+                           const EncodedKey* lower_bound,
+                           const EncodedKey* exclusive_upper_bound)
     : arena_(32*1024),
       has_more_blocks_(false) {
     RowIteratorOptions opts;
     opts.projection = projection;
     opts.snap_to_include = snap;
     iter_.reset(memrowset.NewIterator(opts));
+    if (lower_bound) {
+      spec_.SetLowerBoundKey(lower_bound);
+    }
+    if (exclusive_upper_bound) {
+      spec_.SetExclusiveUpperBoundKey(exclusive_upper_bound);
+    }
   }
 
   Status Init() override {
-    RETURN_NOT_OK(iter_->Init(nullptr));
-    has_more_blocks_ = iter_->HasNext();
+    RETURN_NOT_OK(iter_->Init(&spec_));
+    has_more_blocks_ = iter_->HasNext() && !iter_->IsPastUpperBound();
     return Status::OK();
   }
 
@@ -123,6 +131,9 @@ class MemRowSetCompactionInput : public CompactionInput {
     RowChangeListEncoder undo_encoder(&buffer_);
     int next_row_index = 0;
     for (int i = 0; i < num_in_block; ++i) {
+      if (iter_->IsPastUpperBound()) {
+        break;
+      }
       // TODO(todd): A copy is performed to make all CompactionInputRow have the same schema
       CompactionInputRow& input_row = block->at(next_row_index);
       input_row.row.Reset(row_block_.get(), next_row_index);
@@ -163,7 +174,7 @@ class MemRowSetCompactionInput : public CompactionInput {
       block->resize(next_row_index);
     }
 
-    has_more_blocks_ = iter_->HasNext();
+    has_more_blocks_ = iter_->HasNext() && !iter_->IsPastUpperBound();
     return Status::OK();
   }
 
@@ -183,6 +194,9 @@ class MemRowSetCompactionInput : public CompactionInput {
 
   gscoped_ptr<MemRowSet::Iterator> iter_;
 
+  // Holds the key range of the input, if any.
+  ScanSpec spec_;
+
   // Arena used to store the projected undo/redo mutations of the current block.
   Arena arena_;
 
@@ -886,9 +900,12 @@ Status CompactionInput::Create(const DiskRowSet &rowset,
 
 CompactionInput *CompactionInput::Create(const MemRowSet &memrowset,
                                          const Schema* projection,
-                                         const MvccSnapshot &snap) {
+                                         const MvccSnapshot &snap,
+                                         const EncodedKey* lower_bound,
+                                         const EncodedKey* exclusive_upper_bound) {
   CHECK(projection->has_column_ids());
-  return new MemRowSetCompactionInput(memrowset, snap, projection);
+  return new MemRowSetCompactionInput(memrowset, snap, projection,
+                                      lower_bound, exclusive_upper_bound);
 }
 
 CompactionInput *CompactionInput::Merge(const vector<shared_ptr<CompactionInput> > &inputs,
@@ -35,6 +35,7 @@
 namespace kudu {
 
 class Arena;
+class EncodedKey;
 class Schema;
 
 namespace fs {
@@ -113,9 +114,14 @@ class CompactionInput {
 
   // Create an input which reads from the given memrowset, yielding base rows and updates
   // prior to the given snapshot.
+  //
+  // If 'lower_bound' or 'exclusive_upper_bound' are set, only the rows within
+  // those bounds are yielded. They must outlive the input.
   static CompactionInput *Create(const MemRowSet &memrowset,
                                  const Schema* projection,
-                                 const MvccSnapshot &snap);
+                                 const MvccSnapshot &snap,
+                                 const EncodedKey* lower_bound = nullptr,
+                                 const EncodedKey* exclusive_upper_bound = nullptr);
 
   // Create an input which merges several other compaction inputs. The inputs are merged
   // in key-order according to the given schema. All inputs must have matching schemas.
@@ -742,6 +742,18 @@ class LeafNode : public NodeBase<Traits> {
     return FindInSliceArray(keys_, num_entries_, key, exact);
   }
 
+  // Return true if 'key' belongs in this leaf, given that it does not sort
+  // before some key already known to belong here.
+  //
+  // Keys are never removed from the tree, and a split leaves the separator
+  // as the first key of the new right sibling, so the first key of the next
+  // leaf is always this leaf's exclusive upper bound and never changes.
+  // The caller must hold the lock so that 'next_' can't change underneath it.
+  bool CoversKeyNotBefore(const Slice &key) {
+    DCHECK(this->IsLocked());
+    return next_ == NULL || key.compare(next_->GetKey(0)) < 0;
+  }
+
   // Get the slice corresponding to the nth key.
   //
   // If the caller does not hold the lock, then this Slice
@@ -866,7 +878,41 @@ class PreparedMutation {
 
   bool Insert(const Slice &val) {
     CHECK(prepared());
-    return tree_->Insert(this, val);
+    return tree_->Insert(this, val, false);
+  }
+
+  // Re-prepare this mutation for 'key', which must not sort before the key
+  // it was last prepared for. This is meant for inserting a batch of keys
+  // in ascending order.
+  //
+  // If the leaf locked for the previous key is still held (see
+  // InsertAndHold()) and 'key' falls within it, the leaf is searched
+  // directly without descending from the root. Otherwise, this is
+  // equivalent to Reset() followed by Prepare() against the same tree.
+  void PrepareNext(const Slice &key) {
+    debug::ScopedTSANIgnoreReadsAndWrites ignore_tsan;
+    CHECK(prepared());
+    DCHECK_GE(key.compare(key_), 0);
+    key_ = key;
+    if (needs_unlock_ && leaf_->CoversKeyNotBefore(key)) {
+      leaf_->PrepareMutation(this);
+      return;
+    }
+    CBTree<Traits> *tree = tree_;
+    UnPrepare();
+    Prepare(tree);
+  }
+
+  // Like Insert(), but keeps the leaf locked after a successful or duplicate
+  // insert so that a following PrepareNext() can reuse it. If the leaf had to
+  // be split, it is unlocked as usual and the next key is prepared from the
+  // root.
+  //
+  // The leaf stays locked until the next PrepareNext() moves off of it or
+  // this object is destroyed, so callers should keep that window short.
+  bool InsertAndHold(const Slice &val) {
+    CHECK(prepared());
+    return tree_->Insert(this, val, true);
   }
 
   // Return a slice referencing the existing data in the row.
@@ -1295,9 +1341,11 @@ class CBTree {
   // Precondition:
   //   'node' is locked
   // Postcondition:
-  //   'node' is unlocked
+  //   'node' is unlocked, unless 'hold_lock' is true and no split
+  //   was needed, in which case 'mutation' still owns the lock
   bool Insert(PreparedMutation<Traits> *mutation,
-              const Slice &val) {
+              const Slice &val,
+              bool hold_lock) {
     debug::ScopedTSANIgnoreReadsAndWrites ignore_tsan;
     CHECK(!frozen_);
     CHECK_NOTNULL(mutation);
@@ -1306,18 +1354,22 @@ class CBTree {
     LeafNode<Traits> *node = mutation->leaf();
     DCHECK(node->IsLocked());
 
-    // After this function, the prepared mutation cannot be used
-    // again.
-    mutation->mark_done();
-
     switch (node->Insert(mutation, val)) {
       case INSERT_SUCCESS:
-        node->Unlock();
+        if (!hold_lock) {
+          // After this, the prepared mutation cannot be used again.
+          mutation->mark_done();
+          node->Unlock();
+        }
         return true;
       case INSERT_DUPLICATE:
-        node->Unlock();
+        if (!hold_lock) {
+          mutation->mark_done();
+          node->Unlock();
+        }
         return false;
       case INSERT_FULL:
+        mutation->mark_done();
         return SplitLeafAndInsertUp(mutation, val);
         // SplitLeafAndInsertUp takes care of unlocking
       default:
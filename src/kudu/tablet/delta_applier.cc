@@ -105,9 +105,11 @@ Status DeltaApplier::InitializeSelectionVector(SelectionVector *sel_vec) {
 
 Status DeltaApplier::MaterializeColumn(ColumnMaterializationContext *ctx) {
   DCHECK(!first_prepare_) << "PrepareBatch() must be called at least once";
-  // Data with updates cannot be evaluated at the decoder-level.
-  if (delta_iter_->MayHaveDeltas()) {
+  // Data with updates cannot be evaluated at the decoder-level. Columns
+  // without any updates in this batch skip the delta iterator entirely.
+  if (delta_iter_->MayHaveDeltas(ctx->col_idx())) {
     ctx->SetDecoderEvalNotSupported();
+    ctx->SetValuesMayBeUpdated();
     RETURN_NOT_OK(base_iter_->MaterializeColumn(ctx));
     RETURN_NOT_OK(delta_iter_->ApplyUpdates(ctx->col_idx(), ctx->block()));
   } else {
@@ -117,9 +117,9 @@ bool DeltaIteratorMerger::HasNext() {
   return false;
 }
 
-bool DeltaIteratorMerger::MayHaveDeltas() {
+bool DeltaIteratorMerger::MayHaveDeltas(size_t col_to_apply) {
   for (const unique_ptr<DeltaIterator>& iter : iters_) {
-    if (iter->MayHaveDeltas()) {
+    if (iter->MayHaveDeltas(col_to_apply)) {
       return true;
     }
   }
@@ -67,7 +67,7 @@ class DeltaIteratorMerger : public DeltaIterator {
                                                  std::vector<DeltaKeyAndUpdate>* out,
                                                  Arena* arena) OVERRIDE;
   virtual bool HasNext() OVERRIDE;
-  bool MayHaveDeltas() override;
+  bool MayHaveDeltas(size_t col_to_apply) override;
   virtual std::string ToString() const OVERRIDE;
 
  private:
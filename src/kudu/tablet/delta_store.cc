@@ -19,10 +19,14 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 #include <glog/logging.h>
 
+#include "kudu/common/columnblock.h"
+#include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
@@ -51,6 +55,83 @@ string DeltaKeyAndUpdate::Stringify(DeltaType type, const Schema& schema, bool p
                                                  key.timestamp().ToString()))));
 }
 
+ColumnarDeltaBatch::ColumnarDeltaBatch()
+    : projection_(nullptr),
+      first_row_(0) {
+  static_assert(sizeof(Slice) <= sizeof(CellUpdate::value),
+                "CellUpdate must be able to hold a Slice");
+}
+
+void ColumnarDeltaBatch::Reset(const Schema* projection, rowid_t first_row) {
+  projection_ = projection;
+  first_row_ = first_row;
+  // Keep the per-column vectors, and their capacity, across batches.
+  updates_by_col_.resize(projection->num_columns());
+  for (auto& updates : updates_by_col_) {
+    updates.clear();
+  }
+  liveness_changes_.clear();
+}
+
+Status ColumnarDeltaBatch::AddChanges(rowid_t row_idx, RowChangeListDecoder* decoder) {
+  DCHECK(decoder->is_update() || decoder->is_reinsert());
+  DCHECK_GE(row_idx, first_row_);
+  const uint32_t idx_in_block = row_idx - first_row_;
+  while (decoder->HasNext()) {
+    RowChangeListDecoder::DecodedUpdate dec;
+    RETURN_NOT_OK(decoder->DecodeNext(&dec));
+    int col_idx;
+    const void* col_val;
+    RETURN_NOT_OK(dec.Validate(*projection_, &col_idx, &col_val));
+    if (col_idx == -1) {
+      // This column isn't being projected.
+      continue;
+    }
+
+    // If we already have an earlier update to the same cell, we can just
+    // overwrite that one.
+    vector<CellUpdate>& updates = updates_by_col_[col_idx];
+    if (updates.empty() || updates.back().idx_in_block != idx_in_block) {
+      updates.emplace_back();
+    }
+    CellUpdate& cu = updates.back();
+    cu.idx_in_block = idx_in_block;
+    cu.is_null = col_val == nullptr;
+    if (!cu.is_null) {
+      memcpy(cu.value, col_val, projection_->column(col_idx).type_info()->size());
+    }
+  }
+  return Status::OK();
+}
+
+void ColumnarDeltaBatch::AddLivenessChange(rowid_t row_idx, bool is_live) {
+  DCHECK_GE(row_idx, first_row_);
+  liveness_changes_.emplace_back(row_idx - first_row_, is_live);
+}
+
+Status ColumnarDeltaBatch::ApplyUpdates(size_t col_idx, ColumnBlock* dst) const {
+  DCHECK_LT(col_idx, updates_by_col_.size());
+  const ColumnSchema* col_schema = &projection_->column(col_idx);
+  for (const CellUpdate& cu : updates_by_col_[col_idx]) {
+    DCHECK_LT(cu.idx_in_block, dst->nrows());
+    SimpleConstCell src(col_schema, cu.is_null ? nullptr : cu.value);
+    ColumnBlock::Cell dst_cell = dst->cell(cu.idx_in_block);
+    RETURN_NOT_OK(CopyCell(src, &dst_cell, dst->arena()));
+  }
+  return Status::OK();
+}
+
+void ColumnarDeltaBatch::ApplyLivenessChanges(SelectionVector* sel_vec) const {
+  for (const auto& change : liveness_changes_) {
+    DCHECK_LT(change.first, sel_vec->nrows());
+    if (change.second) {
+      sel_vec->SetRowSelected(change.first);
+    } else {
+      sel_vec->SetRowUnselected(change.first);
+    }
+  }
+}
+
 Status DebugDumpDeltaIterator(DeltaType type,
                               DeltaIterator* iter,
                               const Schema& schema,
@@ -21,9 +21,11 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "kudu/common/rowid.h"
+#include "kudu/gutil/macros.h"
 #include "kudu/tablet/delta_key.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -32,6 +34,7 @@ namespace kudu {
 
 class Arena;
 class ColumnBlock;
+class RowChangeListDecoder;
 class ScanSpec;
 class Schema;
 class SelectionVector;
@@ -82,6 +85,10 @@ class DeltaStore {
   // Get the store's estimated size in bytes.
   virtual uint64_t EstimateSize() const = 0;
 
+  // Returns false if the store is known to hold no updates to the given
+  // column. Stores whose statistics aren't loaded return true.
+  virtual bool MayHaveUpdatesForColumn(ColumnId col_id) = 0;
+
   virtual std::string ToString() const = 0;
 
   // TODO remove this once we don't need to have delta_stats for both DMS and DFR. Currently
@@ -126,6 +133,60 @@ struct DeltaKeyAndUpdate {
   std::string Stringify(DeltaType type, const Schema& schema, bool pad_key = false) const;
 };
 
+// The deltas for a prepared batch of rows, decoded once into per-column form
+// so that applying them to each projected column doesn't decode any
+// RowChangeLists again. Delta iterators prepared with PREPARE_FOR_APPLY build
+// one of these in PrepareBatch().
+//
+// Changes must be added in row order, and within a row in the order in which
+// they should be applied: a later update to a cell overrides an earlier one.
+class ColumnarDeltaBatch {
+ public:
+  ColumnarDeltaBatch();
+
+  // Clear the batch, readying it for rows of 'projection' starting at 'first_row'.
+  void Reset(const Schema* projection, rowid_t first_row);
+
+  // Decode the changed cells of the UPDATE or REINSERT in 'decoder', which
+  // applies to row 'row_idx'. Columns which aren't in the projection are
+  // skipped. Values aren't copied, so the memory being decoded must remain
+  // valid until the batch is next reset.
+  Status AddChanges(rowid_t row_idx, RowChangeListDecoder* decoder);
+
+  // Record that row 'row_idx' was deleted ('is_live' false) or reinserted.
+  void AddLivenessChange(rowid_t row_idx, bool is_live);
+
+  // Whether the batch updates any cells in the given projected column.
+  bool HasUpdates(size_t col_idx) const {
+    return col_idx < updates_by_col_.size() && !updates_by_col_[col_idx].empty();
+  }
+
+  // Apply the updates for the given projected column to 'dst', whose first
+  // row is the batch's first row.
+  Status ApplyUpdates(size_t col_idx, ColumnBlock* dst) const;
+
+  // Apply the deletes and reinserts to 'sel_vec'.
+  void ApplyLivenessChanges(SelectionVector* sel_vec) const;
+
+ private:
+  struct CellUpdate {
+    uint32_t idx_in_block;
+    // If true, the cell is set to NULL and 'value' is unused.
+    bool is_null;
+    // For BINARY columns, a Slice pointing at the new value. Otherwise the
+    // new value itself.
+    uint8_t value[16];
+  };
+
+  const Schema* projection_;
+  rowid_t first_row_;
+  std::vector<std::vector<CellUpdate>> updates_by_col_;
+  // Pairs of (index in block, new liveness), in the order they were added.
+  std::vector<std::pair<uint32_t, bool>> liveness_changes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnarDeltaBatch);
+};
+
 class DeltaIterator {
  public:
   // Initialize the iterator. This must be called once before any other
@@ -188,11 +249,11 @@ class DeltaIterator {
   // Returns true if there are any more rows left in this iterator.
   virtual bool HasNext() = 0;
 
-  // Returns true if there might exist deltas to be applied. It is safe to
-  // conservatively return true, but this would force a skip over decoder-level
-  // evaluation.
+  // Returns true if there might exist updates to be applied to the given
+  // column. It is safe to conservatively return true, but this would force a
+  // skip over decoder-level evaluation.
   // Must have called PrepareBatch() with flag = PREPARE_FOR_APPLY.
-  virtual bool MayHaveDeltas() = 0;
+  virtual bool MayHaveDeltas(size_t col_to_apply) = 0;
 
   // Return a string representation suitable for debug printouts.
   virtual std::string ToString() const = 0;
@@ -819,6 +819,19 @@ void DeltaTracker::GetColumnIdsWithUpdates(std::vector<ColumnId>* col_ids) const
   col_ids->assign(column_ids_with_updates.begin(), column_ids_with_updates.end());
 }
 
+bool DeltaTracker::MayHaveRedoUpdatesForColumn(ColumnId col_id) const {
+  shared_lock<rw_spinlock> lock(component_lock_);
+  if (dms_->MayHaveUpdatesForColumn(col_id)) {
+    return true;
+  }
+  for (const shared_ptr<DeltaStore>& ds : redo_delta_stores_) {
+    if (ds->MayHaveUpdatesForColumn(col_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Status DeltaTracker::InitAllDeltaStoresForTests(WhichStores stores) {
   shared_lock<rw_spinlock> lock(component_lock_);
   if (stores == UNDOS_AND_REDOS || stores == UNDOS_ONLY) {
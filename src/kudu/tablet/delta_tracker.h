@@ -245,6 +245,14 @@ class DeltaTracker {
   // Retrieves the list of column indexes that currently have updates.
   void GetColumnIdsWithUpdates(std::vector<ColumnId>* col_ids) const;
 
+  // Returns false if no REDO delta store, including the DMS, may hold updates
+  // to the given column. Stores which haven't been initialized count as
+  // possibly holding updates.
+  //
+  // UNDO delta stores aren't considered: the column statistics kept for the
+  // base data already account for the UNDOs written alongside it.
+  bool MayHaveRedoUpdatesForColumn(ColumnId col_id) const;
+
   Mutex* compact_flush_lock() {
     return &compact_flush_lock_;
   }
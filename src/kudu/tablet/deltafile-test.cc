@@ -187,6 +187,10 @@ class TestDeltaFile : public KuduTest {
       arena_.Reset();
 
       ASSERT_OK_FAST(it->PrepareBatch(block.nrows(), DeltaIterator::PREPARE_FOR_APPLY));
+      // Batches outside of the updated range shouldn't report any deltas.
+      bool batch_has_updates = start_row + block.nrows() > FLAGS_first_row_to_update &&
+          start_row <= FLAGS_last_row_to_update;
+      ASSERT_EQ(batch_has_updates, it->MayHaveDeltas(0)) << "batch at row " << start_row;
       ColumnBlock dst_col = block.column_block(0);
       ASSERT_OK_FAST(it->ApplyUpdates(0, &dst_col));
 
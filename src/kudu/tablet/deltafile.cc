@@ -406,6 +406,7 @@ DeltaFileIterator::DeltaFileIterator(shared_ptr<DeltaFileReader> dfr,
       prepared_idx_(0xdeadbeef),
       prepared_count_(0),
       prepared_(false),
+      prepared_for_apply_(false),
       exhausted_(false),
       initted_(false),
       delta_type_(delta_type),
@@ -464,6 +465,7 @@ Status DeltaFileIterator::SeekToOrdinal(rowid_t idx) {
   prepared_idx_ = idx;
   prepared_count_ = 0;
   prepared_ = false;
+  prepared_for_apply_ = false;
   delta_blocks_.clear();
   exhausted_ = false;
   return Status::OK();
@@ -584,6 +586,11 @@ Status DeltaFileIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
   prepared_idx_ = start_row;
   prepared_count_ = nrows;
   prepared_ = true;
+  prepared_for_apply_ = flag == PREPARE_FOR_APPLY;
+  if (prepared_for_apply_) {
+    // Decode the batch's deltas once, rather than once per projected column.
+    RETURN_NOT_OK(DecodeMutations());
+  }
   return Status::OK();
 }
 
@@ -681,140 +688,80 @@ inline bool IsUndoRelevant(const MvccSnapshot& snap,
   return true;
 }
 
+// Visitor which decodes each relevant mutation into the iterator's
+// ColumnarDeltaBatch, from which updates and deletes are then applied
+// without decoding the mutations again. See DecodeMutations().
 template<DeltaType Type>
-struct ApplyingVisitor {
+struct DecodingVisitor {
 
   Status Visit(const DeltaKey &key, const Slice &deltas, bool* continue_visit);
 
-  inline Status ApplyMutation(const DeltaKey &key, const Slice &deltas) {
-    int64_t rel_idx = key.row_idx() - dfi->prepared_idx_;
-    DCHECK_GE(rel_idx, 0);
-
-    // TODO(todd): this code looks eerily similar to DMSIterator::ApplyUpdates!
-    // I bet it can be combined.
-
-    const Schema* schema = dfi->opts_.projection;
+  inline Status Decode(const DeltaKey &key, const Slice &deltas) {
     RowChangeListDecoder decoder((RowChangeList(deltas)));
     RETURN_NOT_OK(decoder.Init());
-    if (decoder.is_update() || decoder.is_reinsert()) {
-      return decoder.ApplyToOneColumn(rel_idx, dst, *schema, col_to_apply, dst->arena());
+    if (decoder.is_delete()) {
+      DVLOG(3) << "Row deleted";
+      dfi->decoded_deltas_.AddLivenessChange(key.row_idx(), false);
+      return Status::OK();
     }
-
-    DCHECK(decoder.is_delete());
-    // If it's a DELETE, then it will be processed by LivenessVisitor.
-    return Status::OK();
+    if (decoder.is_reinsert()) {
+      DVLOG(3) << "Re-selected the row (reinsert)";
+      dfi->decoded_deltas_.AddLivenessChange(key.row_idx(), true);
+    }
+    DCHECK(decoder.is_update() || decoder.is_reinsert());
+    return dfi->decoded_deltas_.AddChanges(key.row_idx(), &decoder);
   }
 
   DeltaFileIterator *dfi;
-  size_t col_to_apply;
-  ColumnBlock *dst;
 };
 
 template<>
-inline Status ApplyingVisitor<REDO>::Visit(const DeltaKey& key,
+inline Status DecodingVisitor<REDO>::Visit(const DeltaKey& key,
                                            const Slice& deltas,
                                            bool* continue_visit) {
   if (IsRedoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    DVLOG(3) << "Applied redo delta";
-    return ApplyMutation(key, deltas);
+    DVLOG(3) << "Decoded redo delta";
+    return Decode(key, deltas);
   }
-  DVLOG(3) << "Redo delta uncommitted, skipped applying.";
+  DVLOG(3) << "Redo delta uncommitted, skipped decoding.";
   return Status::OK();
 }
 
 template<>
-inline Status ApplyingVisitor<UNDO>::Visit(const DeltaKey& key,
+inline Status DecodingVisitor<UNDO>::Visit(const DeltaKey& key,
                                            const Slice& deltas,
                                            bool* continue_visit) {
   if (IsUndoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    DVLOG(3) << "Applied undo delta";
-    return ApplyMutation(key, deltas);
+    DVLOG(3) << "Decoded undo delta";
+    return Decode(key, deltas);
   }
-  DVLOG(3) << "Undo delta committed, skipped applying.";
+  DVLOG(3) << "Undo delta committed, skipped decoding.";
   return Status::OK();
 }
 
-Status DeltaFileIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
-  DCHECK_LE(prepared_count_, dst->nrows());
-
+Status DeltaFileIterator::DecodeMutations() {
+  decoded_deltas_.Reset(opts_.projection, prepared_idx_);
   if (delta_type_ == REDO) {
-    DVLOG(3) << "Applying REDO mutations to " << col_to_apply;
-    ApplyingVisitor<REDO> visitor = {this, col_to_apply, dst};
+    DVLOG(3) << "Decoding REDO mutations";
+    DecodingVisitor<REDO> visitor = { this };
     return VisitMutations(&visitor);
   }
-  DVLOG(3) << "Applying UNDO mutations to " << col_to_apply;
-  ApplyingVisitor<UNDO> visitor = {this, col_to_apply, dst};
+  DVLOG(3) << "Decoding UNDO mutations";
+  DecodingVisitor<UNDO> visitor = { this };
   return VisitMutations(&visitor);
 }
 
-// Visitor which establishes the liveness of a row by applying deletes and reinserts.
-template<DeltaType Type>
-struct LivenessVisitor {
-
-  Status Visit(const DeltaKey &key, const Slice &deltas, bool* continue_visit);
-
-  inline Status ApplyDelete(const DeltaKey &key, const Slice &deltas) {
-    int64_t rel_idx = key.row_idx() - dfi->prepared_idx_;
-    DCHECK_GE(rel_idx, 0);
-
-    RowChangeListDecoder decoder((RowChangeList(deltas)));
-    RETURN_NOT_OK(decoder.Init());
-    if (decoder.is_update()) {
-      DVLOG(3) << "Didn't delete row (update)";
-      // If this is an update the row must be selected.
-      DCHECK(sel_vec->IsRowSelected(rel_idx));
-      return Status::OK();
-    }
-
-    if (decoder.is_delete()) {
-      DVLOG(3) << "Row deleted";
-      sel_vec->SetRowUnselected(rel_idx);
-      return Status::OK();
-    }
-
-    DCHECK(decoder.is_reinsert());
-    DVLOG(3) << "Re-selected the row (reinsert)";
-    // If this is a reinsert the row must be unselected.
-    DCHECK(!sel_vec->IsRowSelected(rel_idx));
-    sel_vec->SetRowSelected(rel_idx);
-    return Status::OK();
-  }
-
-  DeltaFileIterator *dfi;
-  SelectionVector *sel_vec;
-};
-
-template<>
-inline Status LivenessVisitor<REDO>::Visit(const DeltaKey& key,
-                                           const Slice& deltas,
-                                           bool* continue_visit) {
-  if (IsRedoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    return ApplyDelete(key, deltas);
-  }
-  return Status::OK();
-}
-
-template<>
-inline Status LivenessVisitor<UNDO>::Visit(const DeltaKey& key,
-                                           const Slice& deltas, bool*
-                                           continue_visit) {
-  if (IsUndoRelevant(dfi->opts_.snap_to_include, key.timestamp(), continue_visit)) {
-    return ApplyDelete(key, deltas);
-  }
-  return Status::OK();
+Status DeltaFileIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
+  DCHECK(prepared_for_apply_) << "must Prepare for apply";
+  DCHECK_LE(prepared_count_, dst->nrows());
+  return decoded_deltas_.ApplyUpdates(col_to_apply, dst);
 }
 
-
 Status DeltaFileIterator::ApplyDeletes(SelectionVector *sel_vec) {
+  DCHECK(prepared_for_apply_) << "must Prepare for apply";
   DCHECK_LE(prepared_count_, sel_vec->nrows());
-  if (delta_type_ == REDO) {
-    DVLOG(3) << "Applying REDO deletes";
-    LivenessVisitor<REDO> visitor = { this, sel_vec };
-    return VisitMutations(&visitor);
-  }
-  DVLOG(3) << "Applying UNDO deletes";
-  LivenessVisitor<UNDO> visitor = { this, sel_vec };
-  return VisitMutations(&visitor);
+  decoded_deltas_.ApplyLivenessChanges(sel_vec);
+  return Status::OK();
 }
 
 // Visitor which, for each mutation, adds it into a ColumnBlock of
@@ -875,20 +822,9 @@ bool DeltaFileIterator::HasNext() {
   return !exhausted_ || !delta_blocks_.empty();
 }
 
-bool DeltaFileIterator::MayHaveDeltas() {
-  // TODO: change the API to take in the col_to_apply and check for deltas on
-  // that column only.
-  DCHECK(prepared_) << "must Prepare";
-  for (auto& block : delta_blocks_) {
-    BinaryPlainBlockDecoder& bpd = *block->decoder_;
-    if (PREDICT_FALSE(prepared_idx_ > block->last_updated_idx_)) {
-      continue;
-    }
-    if (block->prepared_block_start_idx_ < bpd.Count()) {
-      return true;
-    }
-  }
-  return false;
+bool DeltaFileIterator::MayHaveDeltas(size_t col_to_apply) {
+  DCHECK(prepared_for_apply_) << "must Prepare for apply";
+  return decoded_deltas_.HasUpdates(col_to_apply);
 }
 
 string DeltaFileIterator::ToString() const {
@@ -77,11 +77,9 @@ namespace tablet {
 
 class Mutation;
 template<DeltaType Type>
-struct ApplyingVisitor;
-template<DeltaType Type>
 struct CollectingVisitor;
 template<DeltaType Type>
-struct LivenessVisitor;
+struct DecodingVisitor;
 
 class DeltaFileWriter {
  public:
@@ -176,6 +174,10 @@ class DeltaFileReader : public DeltaStore,
 
   virtual uint64_t EstimateSize() const OVERRIDE;
 
+  virtual bool MayHaveUpdatesForColumn(ColumnId col_id) OVERRIDE {
+    return !Initted() || delta_stats_->update_count_for_col_id(col_id) > 0;
+  }
+
   const BlockId& block_id() const { return reader_->block_id(); }
 
   virtual const DeltaStats& delta_stats() const OVERRIDE {
@@ -242,16 +244,14 @@ class DeltaFileIterator : public DeltaIterator {
                                          Arena* arena) OVERRIDE;
   std::string ToString() const OVERRIDE;
   virtual bool HasNext() OVERRIDE;
-  bool MayHaveDeltas() override;
+  bool MayHaveDeltas(size_t col_to_apply) override;
 
  private:
   friend class DeltaFileReader;
-  friend struct ApplyingVisitor<REDO>;
-  friend struct ApplyingVisitor<UNDO>;
   friend struct CollectingVisitor<REDO>;
   friend struct CollectingVisitor<UNDO>;
-  friend struct LivenessVisitor<REDO>;
-  friend struct LivenessVisitor<UNDO>;
+  friend struct DecodingVisitor<REDO>;
+  friend struct DecodingVisitor<UNDO>;
   friend struct FilterAndAppendVisitor;
 
   DISALLOW_COPY_AND_ASSIGN(DeltaFileIterator);
@@ -310,6 +310,10 @@ class DeltaFileIterator : public DeltaIterator {
   // onto the end of the delta_blocks_ queue.
   Status ReadCurrentBlockOntoQueue();
 
+  // Decode the mutations in the currently prepared row range which are
+  // relevant to the snapshot into 'decoded_deltas_'.
+  Status DecodeMutations();
+
   // Visit all mutations in the currently prepared row range with the specified
   // visitor class.
   template<class Visitor>
@@ -329,6 +333,9 @@ class DeltaFileIterator : public DeltaIterator {
   rowid_t prepared_idx_;
   uint32_t prepared_count_;
   bool prepared_;
+  // Whether the batch was prepared with PREPARE_FOR_APPLY, in which case
+  // 'decoded_deltas_' holds its deltas.
+  bool prepared_for_apply_;
   bool exhausted_;
   bool initted_;
 
@@ -336,6 +343,10 @@ class DeltaFileIterator : public DeltaIterator {
   // which correspond to prepared_block_.
   std::deque<std::unique_ptr<PreparedDeltaBlock>> delta_blocks_;
 
+  // The relevant deltas for the prepared batch, when prepared for apply. The
+  // decoded values point into the blocks in 'delta_blocks_'.
+  ColumnarDeltaBatch decoded_deltas_;
+
   // Temporary buffer used in seeking.
   faststring tmp_buf_;
 
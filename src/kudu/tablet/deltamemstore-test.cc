@@ -466,6 +466,9 @@ TEST_F(TestDeltaMemStore, TestIteratorDoesUpdates) {
   int block_start_row = 50;
   ASSERT_OK(iter->SeekToOrdinal(block_start_row));
   ASSERT_OK(iter->PrepareBatch(block.nrows(), DeltaIterator::PREPARE_FOR_APPLY));
+  // Only the updated column has deltas to apply.
+  ASSERT_TRUE(iter->MayHaveDeltas(kIntColumn));
+  ASSERT_FALSE(iter->MayHaveDeltas(kStringColumn));
   ASSERT_OK(iter->ApplyUpdates(kIntColumn, &block));
 
   for (int i = 0; i < 100; i++) {
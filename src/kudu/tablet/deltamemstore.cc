@@ -83,6 +83,7 @@ DeltaMemStore::DeltaMemStore(int64_t id,
     tree_(arena_),
     anchorer_(log_anchor_registry,
               Substitute("Rowset-$0/DeltaMemStore-$1", rs_id_, id_)),
+    has_updates_(false),
     disambiguator_sequence_number_(0) {
 }
 
@@ -115,6 +116,10 @@ Status DeltaMemStore::Update(Timestamp timestamp,
       << "Appended a sequence number but still hit a duplicate "
       << "for rowid " << row_idx << " at timestamp " << timestamp;
   }
+  if (!update.is_delete()) {
+    // Publish before the mutation becomes visible to readers.
+    has_updates_.Store(true, kMemOrderRelease);
+  }
   if (PREDICT_FALSE(!mutation.Insert(update.slice()))) {
     return Status::IOError("Unable to insert into tree");
   }
@@ -245,13 +250,7 @@ Status DMSIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
   rowid_t start_row = prepared_idx_ + prepared_count_;
   rowid_t stop_row = start_row + nrows - 1;
 
-  if (updates_by_col_.empty()) {
-    updates_by_col_.resize(opts_.projection->num_columns());
-  }
-  for (UpdatesForColumn& ufc : updates_by_col_) {
-    ufc.clear();
-  }
-  deleted_.clear();
+  decoded_deltas_.Reset(opts_.projection, start_row);
   prepared_deltas_.clear();
 
   while (iter_->IsValid()) {
@@ -274,39 +273,10 @@ Status DMSIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
       decoder.InitNoSafetyChecks();
       DCHECK(!decoder.is_reinsert()) << "Reinserts are not supported in the DeltaMemStore.";
       if (decoder.is_delete()) {
-        deleted_.push_back(key.row_idx());
+        decoded_deltas_.AddLivenessChange(key.row_idx(), false);
       } else {
         DCHECK(decoder.is_update());
-        while (decoder.HasNext()) {
-          RowChangeListDecoder::DecodedUpdate dec;
-          RETURN_NOT_OK(decoder.DecodeNext(&dec));
-          int col_idx;
-          const void* col_val;
-          RETURN_NOT_OK(dec.Validate(*opts_.projection, &col_idx, &col_val));
-          if (col_idx == -1) {
-            // This column isn't being projected.
-            continue;
-          }
-          int col_size = opts_.projection->column(col_idx).type_info()->size();
-
-          // If we already have an earlier update for the same column, we can
-          // just overwrite that one.
-          if (updates_by_col_[col_idx].empty() ||
-              updates_by_col_[col_idx].back().row_id != key.row_idx()) {
-            updates_by_col_[col_idx].emplace_back();
-          }
-
-          ColumnUpdate& cu = updates_by_col_[col_idx].back();
-          cu.row_id = key.row_idx();
-          if (col_val == nullptr) {
-            cu.new_val_ptr = nullptr;
-          } else {
-            memcpy(cu.new_val_buf, col_val, col_size);
-            // NOTE: we're constructing a pointer here to an element inside the deque.
-            // This is safe because deques never invalidate pointers to their elements.
-            cu.new_val_ptr = cu.new_val_buf;
-          }
-        }
+        RETURN_NOT_OK(decoded_deltas_.AddChanges(key.row_idx(), &decoder));
       }
     } else {
       DCHECK_EQ(flag, PREPARE_FOR_COLLECT);
@@ -327,29 +297,14 @@ Status DMSIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
 Status DMSIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
   DCHECK_EQ(prepared_for_, PREPARED_FOR_APPLY);
   DCHECK_EQ(prepared_count_, dst->nrows());
-
-  const ColumnSchema* col_schema = &opts_.projection->column(col_to_apply);
-  for (const ColumnUpdate& cu : updates_by_col_[col_to_apply]) {
-    int32_t idx_in_block = cu.row_id - prepared_idx_;
-    DCHECK_GE(idx_in_block, 0);
-    SimpleConstCell src(col_schema, cu.new_val_ptr);
-    ColumnBlock::Cell dst_cell = dst->cell(idx_in_block);
-    RETURN_NOT_OK(CopyCell(src, &dst_cell, dst->arena()));
-  }
-
-  return Status::OK();
+  return decoded_deltas_.ApplyUpdates(col_to_apply, dst);
 }
 
 
 Status DMSIterator::ApplyDeletes(SelectionVector *sel_vec) {
   DCHECK_EQ(prepared_for_, PREPARED_FOR_APPLY);
   DCHECK_EQ(prepared_count_, sel_vec->nrows());
-
-  for (auto& row_id : deleted_) {
-    uint32_t idx_in_block = row_id - prepared_idx_;
-    sel_vec->SetRowUnselected(idx_in_block);
-  }
-
+  decoded_deltas_.ApplyLivenessChanges(sel_vec);
   return Status::OK();
 }
 
@@ -381,16 +336,9 @@ bool DMSIterator::HasNext() {
   return false;
 }
 
-bool DMSIterator::MayHaveDeltas() {
-  if (!deleted_.empty()) {
-    return true;
-  }
-  for (auto& col: updates_by_col_) {
-    if (!col.empty()) {
-      return true;
-    }
-  }
-  return false;
+bool DMSIterator::MayHaveDeltas(size_t col_to_apply) {
+  DCHECK_EQ(prepared_for_, PREPARED_FOR_APPLY);
+  return decoded_deltas_.HasUpdates(col_to_apply);
 }
 
 string DMSIterator::ToString() const {
@@ -133,6 +133,12 @@ class DeltaMemStore : public DeltaStore,
     return arena_->memory_footprint();
   }
 
+  // The DMS doesn't track which columns are updated, so this only tells
+  // whether it holds anything other than deletes.
+  virtual bool MayHaveUpdatesForColumn(ColumnId /*col_id*/) OVERRIDE {
+    return has_updates_.Load(kMemOrderAcquire);
+  }
+
   const int64_t id() const { return id_; }
 
   typedef btree::CBTree<DMSTreeTraits> DMSTree;
@@ -178,6 +184,9 @@ class DeltaMemStore : public DeltaStore,
 
   const DeltaStats delta_stats_;
 
+  // Whether any mutation other than a DELETE has been added.
+  AtomicBool has_updates_;
+
   // It's possible for multiple mutations to apply to the same row
   // in the same timestamp (e.g. if a batch contains multiple updates for that
   // row). In that case, we need to append a sequence number to the delta key
@@ -220,7 +229,7 @@ class DMSIterator : public DeltaIterator {
 
   virtual bool HasNext() OVERRIDE;
 
-  bool MayHaveDeltas() override;
+  bool MayHaveDeltas(size_t col_to_apply) override;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(DMSIterator);
@@ -262,14 +271,7 @@ class DMSIterator : public DeltaIterator {
 
   // State when prepared_for_ == PREPARED_FOR_APPLY
   // ------------------------------------------------------------
-  struct ColumnUpdate {
-    rowid_t row_id;
-    void* new_val_ptr;
-    uint8_t new_val_buf[16];
-  };
-  typedef std::deque<ColumnUpdate> UpdatesForColumn;
-  std::vector<UpdatesForColumn> updates_by_col_;
-  std::deque<rowid_t> deleted_;
+  ColumnarDeltaBatch decoded_deltas_;
 
   // State when prepared_for_ == PREPARED_FOR_COLLECT
   // ------------------------------------------------------------
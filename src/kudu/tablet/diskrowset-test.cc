@@ -32,9 +32,11 @@
 #include <gtest/gtest.h>
 
 #include "kudu/clock/clock.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
+#include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/fs/block_id.h"
@@ -47,6 +49,7 @@
 #include "kudu/tablet/delta_store.h"
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/deltamemstore.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/diskrowset-test-base.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
@@ -313,6 +316,45 @@ TEST_F(TestRowSet, TestDelete) {
 }
 
 
+// Test that a rowset's column statistics let scans whose predicates they
+// contradict skip it, unless the column may have been updated.
+TEST_F(TestRowSet, TestMayMatchScanSpec) {
+  // Write and open a DiskRowSet whose 'val' column holds 0 through 99.
+  WriteTestRowSet(100);
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  ColumnStatsPB stats;
+  ASSERT_TRUE(rs->metadata()->GetColumnStats(schema_.column_id(1), &stats));
+  ASSERT_EQ(100, stats.num_rows());
+
+  const ColumnSchema& val_col = schema_.column(1);
+  auto may_match = [&](uint32_t lower, uint32_t upper) {
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::Range(val_col, &lower, &upper));
+    return rs->MayMatchScanSpec(spec, schema_);
+  };
+  EXPECT_TRUE(may_match(50, 60));
+  EXPECT_TRUE(may_match(99, 200));
+  EXPECT_FALSE(may_match(100, 200));
+  {
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::IsNull(val_col));
+    EXPECT_FALSE(rs->MayMatchScanSpec(spec, schema_));
+  }
+
+  // Deletes don't change any values.
+  OperationResultPB result;
+  ASSERT_OK(DeleteRow(rs.get(), 1, &result));
+  EXPECT_FALSE(may_match(100, 200));
+
+  // Once the column is updated, its statistics can't be relied on, even
+  // after the updates are flushed.
+  ASSERT_OK(UpdateRow(rs.get(), 0, 150, &result));
+  EXPECT_TRUE(may_match(100, 200));
+  ASSERT_OK(rs->FlushDeltas(nullptr));
+  EXPECT_TRUE(may_match(100, 200));
+}
+
 TEST_F(TestRowSet, TestDMSFlush) {
   WriteTestRowSet();
 
@@ -18,8 +18,10 @@
 #include "kudu/tablet/diskrowset.h"
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 #include <ostream>
+#include <set>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
@@ -30,10 +32,12 @@
 #include "kudu/cfile/bloomfile.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/generic_iterators.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/common/types.h"
@@ -97,6 +101,7 @@ using fs::CreateBlockOptions;
 using fs::IOContext;
 using fs::WritableBlock;
 using log::LogAnchorRegistry;
+using std::set;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -273,6 +278,9 @@ Status DiskRowSetWriter::FinishAndReleaseBlocks(BlockCreationTransaction* transa
   std::map<ColumnId, BlockId> flushed_blocks;
   col_writer_->GetFlushedBlocksByColumnId(&flushed_blocks);
   rowset_metadata_->SetColumnDataBlocks(flushed_blocks);
+  vector<ColumnStatsPB> column_stats;
+  col_writer_->GetFlushedColumnStats(&column_stats);
+  rowset_metadata_->SetColumnStats(column_stats);
 
   if (ad_hoc_index_writer_ != nullptr) {
     Status s = ad_hoc_index_writer_->FinishAndReleaseBlock(transaction);
@@ -450,6 +458,15 @@ Status RollingDiskRowSetWriter::FinishCurrentWriter() {
     cur_undo_writer_->WriteDeltaStats(*cur_undo_delta_stats);
     cur_redo_writer_->WriteDeltaStats(*cur_redo_delta_stats);
 
+    // The column statistics only describe the base data, so drop those of
+    // any column which the deltas written alongside it may change.
+    set<ColumnId> col_ids_with_updates;
+    cur_undo_delta_stats->AddColumnIdsWithUpdates(&col_ids_with_updates);
+    cur_redo_delta_stats->AddColumnIdsWithUpdates(&col_ids_with_updates);
+    for (const ColumnId& col_id : col_ids_with_updates) {
+      cur_drs_metadata_->ClearColumnStats(col_id);
+    }
+
     // Commit the UNDO block. Status::Aborted() indicates that there
     // were no UNDOs written.
     Status s = cur_undo_writer_->FinishAndReleaseBlock(block_transaction_.get());
@@ -761,6 +778,69 @@ Status DiskRowSet::GetBounds(std::string* min_encoded_key,
   return base_data_->GetBounds(min_encoded_key, max_encoded_key);
 }
 
+namespace {
+
+// Returns false if none of the cells described by 'stats' can satisfy 'pred'.
+bool ColumnStatsMayMatch(const ColumnStatsPB& stats, const ColumnPredicate& pred) {
+  switch (pred.predicate_type()) {
+    case PredicateType::IsNull:
+      return stats.null_count() > 0;
+    case PredicateType::IsNotNull:
+      return stats.null_count() < stats.num_rows();
+    default:
+      break;
+  }
+  if (stats.null_count() == stats.num_rows()) {
+    return false;
+  }
+
+  // Decodes a bound into 'cell', returning null if it's unknown.
+  const TypeInfo* type_info = pred.column().type_info();
+  auto decode_bound = [&](bool has_value, const string& value, uint8_t* cell) -> const void* {
+    if (!has_value) return nullptr;
+    if (type_info->physical_type() == BINARY) {
+      Slice s(value);
+      memcpy(cell, &s, sizeof(s));
+    } else {
+      if (value.size() != type_info->size()) return nullptr;
+      memcpy(cell, value.data(), value.size());
+    }
+    return cell;
+  };
+  alignas(16) uint8_t min_cell[16];
+  alignas(16) uint8_t max_cell[16];
+  return pred.MayBeSatisfiedByRange(
+      decode_bound(stats.has_min_value(), stats.min_value(), min_cell),
+      decode_bound(stats.has_max_value(), stats.max_value(), max_cell));
+}
+
+} // anonymous namespace
+
+bool DiskRowSet::MayMatchScanSpec(const ScanSpec& spec, const Schema& schema) const {
+  DCHECK(open_);
+  // Hold the component lock so that a concurrent major delta compaction,
+  // which drops the statistics of the columns it rewrites before swapping
+  // out their REDO deltas, is seen either before or after the fact.
+  shared_lock<rw_spinlock> l(component_lock_);
+  for (const auto& entry : spec.predicates()) {
+    const ColumnPredicate& pred = entry.second;
+    int col_idx = schema.find_column(pred.column().name());
+    if (col_idx == Schema::kColumnNotFound) continue;
+    ColumnId col_id = schema.column_id(col_idx);
+
+    // The REDO deltas must be checked before the statistics; see above.
+    ColumnStatsPB stats;
+    if (delta_tracker_->MayHaveRedoUpdatesForColumn(col_id) ||
+        !rowset_metadata_->GetColumnStats(col_id, &stats)) {
+      continue;
+    }
+    if (!ColumnStatsMayMatch(stats, pred)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void DiskRowSet::GetDiskRowSetSpaceUsage(DiskRowSetSpace* drss) const {
   DCHECK(open_);
   shared_lock<rw_spinlock> l(component_lock_);
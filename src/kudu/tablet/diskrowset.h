@@ -55,6 +55,7 @@ class MonoTime;
 class RowBlock;
 class RowChangeList;
 class RowwiseIterator;
+class ScanSpec;
 class Timestamp;
 
 namespace cfile {
@@ -371,6 +372,9 @@ class DiskRowSet : public RowSet {
   virtual Status GetBounds(std::string* min_encoded_key,
                            std::string* max_encoded_key) const override;
 
+  // See RowSet::MayMatchScanSpec(...)
+  bool MayMatchScanSpec(const ScanSpec& spec, const Schema& schema) const override;
+
   void GetDiskRowSetSpaceUsage(DiskRowSetSpace* drss) const;
 
   uint64_t OnDiskSize() const override;
@@ -59,6 +59,11 @@ class LocalTabletWriter {
 
   ~LocalTabletWriter() {}
 
+  // Set whether subsequent writes are flagged as bulk loads.
+  void set_bulk_load(bool bulk_load) {
+    req_.set_bulk_load(bulk_load);
+  }
+
   Status Insert(const KuduPartialRow& row) {
     return Write(RowOperationsPB::INSERT, row);
   }
@@ -17,10 +17,13 @@
 
 #include "kudu/tablet/lock_manager.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <mutex>
+#include <numeric>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -30,14 +33,17 @@
 #include "kudu/gutil/hash/city.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/walltime.h"
+#include "kudu/util/debug/leakcheck_disabler.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/semaphore.h"
+#include "kudu/util/threadlocal.h"
 #include "kudu/util/trace.h"
 
 using base::subtle::NoBarrier_Load;
+using std::vector;
 
 namespace kudu {
 namespace tablet {
@@ -52,10 +58,22 @@ class TransactionState;
 // Callers should generally use ScopedRowLock (see below).
 class LockEntry {
  public:
-  explicit LockEntry(const Slice& key)
+  LockEntry()
   : sem(1),
-    recursion_(0) {
-    key_hash_ = util_hash::CityHash64(reinterpret_cast<const char *>(key.data()), key.size());
+    recursion_(0),
+    holder_(nullptr) {
+  }
+
+  static uint64_t HashKey(const Slice& key) {
+    return util_hash::CityHash64(reinterpret_cast<const char *>(key.data()), key.size());
+  }
+
+  // Prepare an unused entry to represent 'key'. Entries are recycled through
+  // the freelists below, so this must leave no trace of any previous key.
+  void Reset(const Slice& key, uint64_t hash) {
+    DCHECK_EQ(0, recursion_);
+    DCHECK(holder_ == nullptr);
+    key_hash_ = hash;
     key_ = key;
     refs_ = 1;
   }
@@ -100,6 +118,56 @@ class LockEntry {
   const TransactionState* holder_;
 };
 
+// A per-thread cache of unused LockEntry objects, so that locking a row
+// doesn't normally go through the allocator.
+//
+// Rows are usually locked on a prepare thread and unlocked on an apply thread,
+// so entries tend to pile up on one thread while another runs dry. To even
+// that out, a thread with a full freelist spills a batch of entries into the
+// depot of the LockTable it released them to, and a thread with an empty
+// freelist refills from the depot of the LockTable it is locking in. Entries
+// are interchangeable between tables.
+class LockEntryFreelist {
+ public:
+  // Number of entries moved to or from a depot at a time.
+  static const size_t kBatchSize = 128;
+
+  ~LockEntryFreelist() {
+    for (LockEntry* e : entries_) {
+      delete e;
+    }
+  }
+
+  static LockEntryFreelist* Get() {
+    // Disable leak check. LSAN sometimes gets false positives on thread locals.
+    // See: https://github.com/google/sanitizers/issues/757
+    debug::ScopedLeakCheckDisabler d;
+    BLOCK_STATIC_THREAD_LOCAL(LockEntryFreelist, freelist);
+    return freelist;
+  }
+
+  bool empty() const { return entries_.empty(); }
+  bool full() const { return entries_.size() >= 2 * kBatchSize; }
+
+  LockEntry* Pop() {
+    if (entries_.empty()) {
+      return new LockEntry();
+    }
+    LockEntry* e = entries_.back();
+    entries_.pop_back();
+    return e;
+  }
+
+  void Push(LockEntry* e) {
+    entries_.push_back(e);
+  }
+
+  vector<LockEntry*>* mutable_entries() { return &entries_; }
+
+ private:
+  vector<LockEntry*> entries_;
+};
+
 class LockTable {
  private:
   struct Bucket {
@@ -122,12 +190,33 @@ class LockTable {
         DCHECK(p == nullptr) << "The entry " << p->ToString() << " was not released";
       }
     }
+    for (LockEntry* e : depot_) {
+      delete e;
+    }
   }
 
   LockEntry *GetLockEntry(const Slice &key);
   void ReleaseLockEntry(LockEntry *entry);
 
+  // Look up or insert an entry for each of 'keys', storing it at the same
+  // index of 'entries'. Each bucket lock is taken once for the whole batch.
+  void GetLockEntries(const vector<Slice>& keys, vector<LockEntry*>* entries);
+
  private:
+  // Maximum number of unused entries kept in 'depot_'.
+  static const size_t kMaxDepotSize = 64 * LockEntryFreelist::kBatchSize;
+
+  // Return an unused entry, preferring the calling thread's freelist and
+  // then the depot over a fresh allocation.
+  LockEntry* NewEntry(LockEntryFreelist* freelist);
+
+  // Return an entry which is no longer in the table to the calling thread's
+  // freelist.
+  void RecycleEntry(LockEntryFreelist* freelist, LockEntry* entry);
+
+  // Account for 'count' new entries in the table, growing it if needed.
+  void AddItems(int64_t count);
+
   Bucket *FindBucket(uint64_t hash) const {
     return &(buckets_[hash & mask_]);
   }
@@ -168,10 +257,59 @@ class LockTable {
   gscoped_array<Bucket> buckets_;
   // number of items in the table
   base::subtle::Atomic64 item_count_;
+
+  // protects 'depot_'
+  simple_spinlock depot_lock_;
+  // unused entries shared between the threads' freelists
+  vector<LockEntry*> depot_;
 };
 
+LockEntry* LockTable::NewEntry(LockEntryFreelist* freelist) {
+  if (PREDICT_FALSE(freelist->empty())) {
+    std::lock_guard<simple_spinlock> l(depot_lock_);
+    size_t n = std::min(depot_.size(), LockEntryFreelist::kBatchSize);
+    freelist->mutable_entries()->assign(depot_.end() - n, depot_.end());
+    depot_.resize(depot_.size() - n);
+  }
+  return freelist->Pop();
+}
+
+void LockTable::RecycleEntry(LockEntryFreelist* freelist, LockEntry* entry) {
+  freelist->Push(entry);
+  if (PREDICT_TRUE(!freelist->full())) {
+    return;
+  }
+  vector<LockEntry*>* entries = freelist->mutable_entries();
+  auto spill = entries->end() - LockEntryFreelist::kBatchSize;
+  {
+    std::lock_guard<simple_spinlock> l(depot_lock_);
+    if (depot_.size() < kMaxDepotSize) {
+      depot_.insert(depot_.end(), spill, entries->end());
+      entries->erase(spill, entries->end());
+      return;
+    }
+  }
+  for (auto it = spill; it != entries->end(); ++it) {
+    delete *it;
+  }
+  entries->erase(spill, entries->end());
+}
+
+void LockTable::AddItems(int64_t count) {
+  if (base::subtle::NoBarrier_AtomicIncrement(&item_count_, count) > size_) {
+    std::unique_lock<percpu_rwlock> table_wrlock(lock_, std::try_to_lock);
+    // if we can't take the lock, means that someone else is resizing.
+    // (The percpu_rwlock try_lock waits for readers to complete)
+    if (table_wrlock.owns_lock()) {
+      Resize();
+    }
+  }
+}
+
 LockEntry *LockTable::GetLockEntry(const Slice& key) {
-  auto new_entry = new LockEntry(key);
+  LockEntryFreelist* freelist = LockEntryFreelist::Get();
+  LockEntry* new_entry = NewEntry(freelist);
+  new_entry->Reset(key, LockEntry::HashKey(key));
   LockEntry *old_entry;
 
   {
@@ -192,26 +330,74 @@ LockEntry *LockTable::GetLockEntry(const Slice& key) {
   }
 
   if (old_entry != nullptr) {
-    delete new_entry;
+    RecycleEntry(freelist, new_entry);
     return old_entry;
   }
 
-  if (base::subtle::NoBarrier_AtomicIncrement(&item_count_, 1) > size_) {
-    std::unique_lock<percpu_rwlock> table_wrlock(lock_, std::try_to_lock);
-    // if we can't take the lock, means that someone else is resizing.
-    // (The percpu_rwlock try_lock waits for readers to complete)
-    if (table_wrlock.owns_lock()) {
-      Resize();
+  AddItems(1);
+  return new_entry;
+}
+
+void LockTable::GetLockEntries(const vector<Slice>& keys, vector<LockEntry*>* entries) {
+  const size_t n = keys.size();
+  vector<uint64_t> hashes(n);
+  for (size_t i = 0; i < n; i++) {
+    hashes[i] = LockEntry::HashKey(keys[i]);
+  }
+  entries->resize(n);
+  // Set aside enough unused entries up front so that nothing is allocated
+  // while holding a bucket lock.
+  LockEntryFreelist* freelist = LockEntryFreelist::Get();
+  vector<LockEntry*> spares(n);
+  for (size_t i = 0; i < n; i++) {
+    spares[i] = NewEntry(freelist);
+  }
+  int64_t num_inserted = 0;
+
+  {
+    shared_lock<rw_spinlock> l(lock_.get_lock());
+    // Visit the keys bucket by bucket, so that each bucket lock is taken once.
+    // The mask can't change while we hold the table lock.
+    vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return (hashes[a] & mask_) < (hashes[b] & mask_);
+      });
+    size_t i = 0;
+    while (i < n) {
+      Bucket* bucket = FindBucket(hashes[order[i]]);
+      std::lock_guard<simple_spinlock> bucket_lock(bucket->lock);
+      do {
+        size_t idx = order[i];
+        LockEntry** node = FindSlot(bucket, keys[idx], hashes[idx]);
+        if (*node != nullptr) {
+          (*node)->refs_++;
+        } else {
+          LockEntry* e = spares.back();
+          spares.pop_back();
+          e->Reset(keys[idx], hashes[idx]);
+          e->ht_next_ = nullptr;
+          e->CopyKey();
+          *node = e;
+          num_inserted++;
+        }
+        (*entries)[idx] = *node;
+      } while (++i < n && FindBucket(hashes[order[i]]) == bucket);
     }
   }
 
-  return new_entry;
+  for (LockEntry* e : spares) {
+    RecycleEntry(freelist, e);
+  }
+  if (num_inserted > 0) {
+    AddItems(num_inserted);
+  }
 }
 
 void LockTable::ReleaseLockEntry(LockEntry *entry) {
   bool removed = false;
   {
-    std::lock_guard<rw_spinlock> table_rdlock(lock_.get_lock());
+    shared_lock<rw_spinlock> table_rdlock(lock_.get_lock());
     Bucket *bucket = FindBucket(entry->key_hash_);
     {
       std::lock_guard<simple_spinlock> bucket_lock(bucket->lock);
@@ -230,7 +416,7 @@ void LockTable::ReleaseLockEntry(LockEntry *entry) {
 
   DCHECK(removed) << "Unable to find LockEntry on release";
   base::subtle::NoBarrier_AtomicIncrement(&item_count_, -1);
-  delete entry;
+  RecycleEntry(LockEntryFreelist::Get(), entry);
 }
 
 void LockTable::Resize() {
@@ -337,11 +523,17 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
                                           LockManager::LockMode mode,
                                           LockEntry** entry) {
   *entry = locks_->GetLockEntry(key);
+  AcquireEntry(key, tx, *entry);
+  return LOCK_ACQUIRED;
+}
 
+void LockManager::AcquireEntry(const Slice& key,
+                               const TransactionState* tx,
+                               LockEntry* entry) {
   // We expect low contention, so just try to try_lock first. This is faster
   // than a timed_lock, since we don't have to do a syscall to get the current
   // time.
-  if (!(*entry)->sem.TryAcquire()) {
+  if (!entry->sem.TryAcquire()) {
     // If the current holder of this lock is the same transaction just return
     // a LOCK_ALREADY_ACQUIRED status without actually acquiring the mutex.
     //
@@ -351,9 +543,9 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     // obtained and released at the same time). If at any time in the future
     // we opt to perform more fine grained locking, possibly letting transactions
     // release a portion of the locks they no longer need, this no longer is OK.
-    if (ANNOTATE_UNPROTECTED_READ((*entry)->holder_) == tx) {
-      (*entry)->recursion_++;
-      return LOCK_ACQUIRED;
+    if (ANNOTATE_UNPROTECTED_READ(entry->holder_) == tx) {
+      entry->recursion_++;
+      return;
     }
 
     // If we couldn't immediately acquire the lock, do a timed lock so we can
@@ -363,8 +555,8 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     TRACE_COUNTER_INCREMENT("row_lock_wait_count", 1);
     MicrosecondsInt64 start_wait_us = GetMonoTimeMicros();
     int waited_seconds = 0;
-    while (!(*entry)->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
-      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ((*entry)->holder_);
+    while (!entry->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
+      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ(entry->holder_);
       LOG(WARNING) << "Waited " << (++waited_seconds) << " seconds to obtain row lock on key "
                    << KUDU_REDACT(key.ToDebugString()) << " cur holder: " << cur_holder;
       // TODO(unknown): would be nice to also include some info about the blocking transaction,
@@ -378,8 +570,7 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     }
   }
 
-  (*entry)->holder_ = tx;
-  return LOCK_ACQUIRED;
+  entry->holder_ = tx;
 }
 
 LockManager::LockStatus LockManager::TryLock(const Slice& key,
@@ -396,6 +587,29 @@ LockManager::LockStatus LockManager::TryLock(const Slice& key,
   return LOCK_ACQUIRED;
 }
 
+void LockManager::AcquireLocks(const vector<Slice>& keys,
+                               const TransactionState* tx,
+                               LockManager::LockMode mode,
+                               vector<ScopedRowLock>* locks) {
+  vector<LockEntry*> entries;
+  locks_->GetLockEntries(keys, &entries);
+
+  vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return keys[a].compare(keys[b]) < 0;
+    });
+  for (size_t idx : order) {
+    AcquireEntry(keys[idx], tx, entries[idx]);
+  }
+
+  locks->clear();
+  locks->reserve(keys.size());
+  for (LockEntry* entry : entries) {
+    locks->emplace_back(ScopedRowLock(this, entry));
+  }
+}
+
 void LockManager::Release(LockEntry *lock, LockStatus ls) {
   DCHECK_NOTNULL(lock)->holder_ = nullptr;
   if (ls == LOCK_ACQUIRED) {
@@ -18,6 +18,7 @@
 #define KUDU_TABLET_LOCK_MANAGER_H
 
 #include <cstddef>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/util/slice.h"
@@ -26,6 +27,7 @@ namespace kudu { namespace tablet {
 
 class LockTable;
 class LockEntry;
+class ScopedRowLock;
 class TransactionState;
 
 // Super-simple lock manager implementation. This only supports exclusive
@@ -49,6 +51,23 @@ class LockManager {
     LOCK_EXCLUSIVE
   };
 
+  // Lock every key in 'keys' on behalf of 'tx', blocking until all of the
+  // locks are held. On return, 'locks' holds one acquired ScopedRowLock per
+  // key, in the same order as 'keys'.
+  //
+  // Compared to taking a ScopedRowLock per key, this looks up all of the
+  // lock entries with a single pass over the lock table, taking each hash
+  // bucket's lock once, and then waits on the rows in key order. Since every
+  // batch waits in the same order, two batches can't deadlock each other.
+  // A key may appear more than once in the batch.
+  //
+  // As with ScopedRowLock, the data referenced by 'keys' must remain valid
+  // and unchanged for as long as the locks are held.
+  void AcquireLocks(const std::vector<Slice>& keys,
+                    const TransactionState* tx,
+                    LockMode mode,
+                    std::vector<ScopedRowLock>* locks);
+
  private:
   friend class ScopedRowLock;
   friend class LockManagerTest;
@@ -59,6 +78,10 @@ class LockManager {
                      LockMode mode, LockEntry **entry);
   void Release(LockEntry *lock, LockStatus ls);
 
+  // Wait until the lock on 'entry' is held by 'tx'. If 'tx' already holds
+  // it, the lock is taken recursively.
+  void AcquireEntry(const Slice& key, const TransactionState* tx, LockEntry* entry);
+
   LockTable *locks_;
 
   DISALLOW_COPY_AND_ASSIGN(LockManager);
@@ -116,6 +139,16 @@ class ScopedRowLock {
   ~ScopedRowLock();
 
  private:
+  friend class LockManager;
+
+  // Take ownership of 'entry', which has already been locked in 'manager'.
+  ScopedRowLock(LockManager* manager, LockEntry* entry)
+    : manager_(manager),
+      acquired_(true),
+      entry_(entry),
+      ls_(LockManager::LOCK_ACQUIRED) {
+  }
+
   void TakeState(ScopedRowLock* other);
 
   LockManager *manager_;
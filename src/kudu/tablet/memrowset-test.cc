@@ -420,6 +420,66 @@ TEST_F(TestMemRowSet, TestInsertCopiesToArena) {
   }
 }
 
+// Test inserting a batch of rows given out of key order, with enough rows to
+// split the leaves of the tree, and with keys that collide with a live row,
+// with a ghost row, and with another row in the same batch.
+TEST_F(TestMemRowSet, TestInsertBatch) {
+  shared_ptr<MemRowSet> mrs;
+  ASSERT_OK(MemRowSet::Create(0, schema_, log_anchor_registry_.get(),
+                              MemTracker::GetRootTracker(), &mrs));
+  ASSERT_OK(InsertRow(mrs.get(), "live", 1));
+  ASSERT_OK(InsertRow(mrs.get(), "ghost", 1));
+  OperationResultPB result;
+  ASSERT_OK(DeleteRow(mrs.get(), "ghost", &result));
+
+  const int kNumRows = 1000;
+  vector<string> keys;
+  for (int i = kNumRows - 1; i >= 0; i--) {
+    keys.push_back(StringPrintf("hello %d", i));
+  }
+  keys.emplace_back("live");
+  keys.emplace_back("ghost");
+  keys.emplace_back("hello 5");
+
+  vector<unique_ptr<RowBuilder>> builders;
+  vector<ConstContiguousRow> rows;
+  for (uint32_t i = 0; i < keys.size(); i++) {
+    builders.emplace_back(new RowBuilder(schema_));
+    builders.back()->AddString(keys[i]);
+    builders.back()->AddUint32(i);
+    rows.push_back(builders.back()->row());
+  }
+
+  vector<Status> statuses;
+  {
+    ScopedTransaction tx(&mvcc_, clock_->Now());
+    tx.StartApplying();
+    mrs->InsertBatch(tx.timestamp(), rows, op_id_, &statuses);
+    tx.Commit();
+  }
+  ASSERT_EQ(rows.size(), statuses.size());
+  for (int i = 0; i < kNumRows; i++) {
+    ASSERT_OK(statuses[i]);
+  }
+  ASSERT_TRUE(statuses[kNumRows].IsAlreadyPresent()) << statuses[kNumRows].ToString();
+  ASSERT_OK(statuses[kNumRows + 1]);
+  ASSERT_TRUE(statuses[kNumRows + 2].IsAlreadyPresent()) << statuses[kNumRows + 2].ToString();
+
+  // Each key keeps the value from the first insert that succeeded for it.
+  for (int i = 0; i < kNumRows; i++) {
+    NO_FATALS(CheckValue(mrs, keys[i],
+                         StringPrintf(R"((string key="%s", uint32 val=%d))", keys[i].c_str(), i)));
+  }
+  NO_FATALS(CheckValue(mrs, "live", R"((string key="live", uint32 val=1))"));
+  NO_FATALS(CheckValue(mrs, "ghost",
+                       StringPrintf(R"((string key="ghost", uint32 val=%d))", kNumRows + 1)));
+
+  RowIteratorOptions opts;
+  opts.projection = &schema_;
+  opts.snap_to_include = MvccSnapshot(mvcc_);
+  ASSERT_EQ(kNumRows + 2, ScanAndCount(mrs.get(), opts));
+}
+
 TEST_F(TestMemRowSet, TestDelete) {
   const char kRowKey[] = "hello world";
   bool present;
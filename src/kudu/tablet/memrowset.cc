@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/memrowset.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -53,6 +54,7 @@ DEFINE_bool(mrs_use_codegen, true, "whether the memrowset should use code "
             "generation for iteration");
 TAG_FLAG(mrs_use_codegen, hidden);
 
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -163,37 +165,99 @@ Status MemRowSet::Insert(Timestamp timestamp,
 
     btree::PreparedMutation<MSBTreeTraits> mutation(enc_key);
     mutation.Prepare(&tree_);
+    RETURN_NOT_OK(InsertPrepared(timestamp, row, &mutation, false));
+  }
 
-    // TODO: for now, the key ends up stored doubly --
-    // once encoded in the btree key, and again in the value
-    // (unencoded).
-    // That's not very memory-efficient!
-
-    if (mutation.exists()) {
-      // It's OK for it to exist if it's just a "ghost" row -- i.e the
-      // row is deleted.
-      MRSRow ms_row(this, mutation.current_mutable_value());
-      if (!ms_row.IsGhost()) {
-        return Status::AlreadyPresent("key already present");
-      }
+  anchorer_.AnchorIfMinimum(op_id.index());
+  return Status::OK();
+}
 
-      // Insert a "reinsert" mutation.
-      return Reinsert(timestamp, row, &ms_row);
+void MemRowSet::InsertBatch(Timestamp timestamp,
+                            const vector<ConstContiguousRow>& rows,
+                            const OpId& op_id,
+                            vector<Status>* statuses) {
+  statuses->assign(rows.size(), Status::OK());
+  if (rows.empty()) return;
+
+  // Encode all of the keys back-to-back into one buffer, then sort the
+  // row indexes by key.
+  faststring enc_key_buf;
+  faststring all_keys;
+  vector<size_t> key_ends;
+  key_ends.reserve(rows.size());
+  for (const auto& row : rows) {
+    CHECK(row.schema()->has_column_ids());
+    DCHECK_SCHEMA_EQ(schema_, *row.schema());
+    schema_.EncodeComparableKey(row, &enc_key_buf);
+    all_keys.append(enc_key_buf.data(), enc_key_buf.size());
+    key_ends.push_back(all_keys.size());
+  }
+  vector<pair<Slice, int>> keys_and_indexes;
+  keys_and_indexes.reserve(rows.size());
+  size_t key_start = 0;
+  for (int i = 0; i < rows.size(); i++) {
+    keys_and_indexes.emplace_back(
+        Slice(all_keys.data() + key_start, key_ends[i] - key_start), i);
+    key_start = key_ends[i];
+  }
+  std::stable_sort(keys_and_indexes.begin(), keys_and_indexes.end(),
+                   [](const pair<Slice, int>& a, const pair<Slice, int>& b) {
+                     return a.first.compare(b.first) < 0;
+                   });
+
+  bool any_inserted = false;
+  {
+    btree::PreparedMutation<MSBTreeTraits> mutation(keys_and_indexes[0].first);
+    mutation.Prepare(&tree_);
+    for (int i = 0; i < keys_and_indexes.size(); i++) {
+      const auto& key_and_index = keys_and_indexes[i];
+      if (i > 0) {
+        mutation.PrepareNext(key_and_index.first);
+      }
+      Status s = InsertPrepared(timestamp, rows[key_and_index.second], &mutation, true);
+      any_inserted |= s.ok();
+      (*statuses)[key_and_index.second] = std::move(s);
     }
+  }
 
-    // Copy the non-encoded key onto the stack since we need
-    // to mutate it when we relocate its Slices into our arena.
-    DEFINE_MRSROW_ON_STACK(this, mrsrow, mrsrow_slice);
-    mrsrow.header_->insertion_timestamp = timestamp;
-    mrsrow.header_->redo_head = nullptr;
-    RETURN_NOT_OK(mrsrow.CopyRow(row, arena_.get()));
+  if (any_inserted) {
+    anchorer_.AnchorIfMinimum(op_id.index());
+  }
+}
+
+Status MemRowSet::InsertPrepared(Timestamp timestamp,
+                                 const ConstContiguousRow& row,
+                                 btree::PreparedMutation<MSBTreeTraits>* mutation,
+                                 bool hold_lock) {
+  // TODO: for now, the key ends up stored doubly --
+  // once encoded in the btree key, and again in the value
+  // (unencoded).
+  // That's not very memory-efficient!
+
+  if (mutation->exists()) {
+    // It's OK for it to exist if it's just a "ghost" row -- i.e the
+    // row is deleted.
+    MRSRow ms_row(this, mutation->current_mutable_value());
+    if (!ms_row.IsGhost()) {
+      return Status::AlreadyPresent("key already present");
+    }
 
-    CHECK(mutation.Insert(mrsrow_slice))
-    << "Expected to be able to insert, since the prepared mutation "
-    << "succeeded!";
+    // Insert a "reinsert" mutation.
+    return Reinsert(timestamp, row, &ms_row);
   }
 
-  anchorer_.AnchorIfMinimum(op_id.index());
+  // Copy the non-encoded key onto the stack since we need
+  // to mutate it when we relocate its Slices into our arena.
+  DEFINE_MRSROW_ON_STACK(this, mrsrow, mrsrow_slice);
+  mrsrow.header_->insertion_timestamp = timestamp;
+  mrsrow.header_->redo_head = nullptr;
+  RETURN_NOT_OK(mrsrow.CopyRow(row, arena_.get()));
+
+  bool inserted = hold_lock ? mutation->InsertAndHold(mrsrow_slice) :
+                              mutation->Insert(mrsrow_slice);
+  CHECK(inserted)
+  << "Expected to be able to insert, since the prepared mutation "
+  << "succeeded!";
 
   debug_insert_count_++;
   return Status::OK();
@@ -315,6 +379,28 @@ Status MemRowSet::NewCompactionInput(const Schema* projection,
   return Status::OK();
 }
 
+void MemRowSet::GetSplitKeys(int num_ranges, vector<string>* split_keys) const {
+  split_keys->clear();
+  const uint64_t count = entry_count();
+  if (num_ranges <= 1 || count < num_ranges) {
+    return;
+  }
+  gscoped_ptr<MSBTIter> iter(tree_.NewIterator());
+  iter->SeekToStart();
+  uint64_t idx = 0;
+  int next_range = 1;
+  while (iter->IsValid() && next_range < num_ranges) {
+    if (idx == count * next_range / num_ranges) {
+      Slice key, val;
+      iter->GetCurrentEntry(&key, &val);
+      split_keys->push_back(key.ToString());
+      next_range++;
+    }
+    iter->Next();
+    idx++;
+  }
+}
+
 Status MemRowSet::GetBounds(string *min_encoded_key,
                             string *max_encoded_key) const {
   return Status::NotSupported("");
@@ -234,6 +234,20 @@ class MemRowSet : public RowSet,
                 const ConstContiguousRow& row,
                 const consensus::OpId& op_id);
 
+  // Insert a batch of rows into the memrowset, all at the same timestamp.
+  //
+  // The rows are sorted by encoded key once and inserted in that order, so
+  // that runs of rows landing in the same leaf of the tree share a single
+  // traversal from the root. Rows with equal keys are inserted in the order
+  // they were given.
+  //
+  // (*statuses)[i] is set to the result of inserting rows[i], with the same
+  // meaning as the return value of Insert().
+  void InsertBatch(Timestamp timestamp,
+                   const std::vector<ConstContiguousRow>& rows,
+                   const consensus::OpId& op_id,
+                   std::vector<Status>* statuses);
+
 
   // Update or delete an existing row in the memrowset.
   //
@@ -259,6 +273,12 @@ class MemRowSet : public RowSet,
     return Status::OK();
   }
 
+  // Fills 'split_keys' with up to 'num_ranges' - 1 encoded keys, in ascending
+  // order, which split the rows of this MemRowSet into ranges of about the
+  // same number of rows. Only meaningful once the MemRowSet no longer receives
+  // inserts.
+  void GetSplitKeys(int num_ranges, std::vector<std::string>* split_keys) const;
+
   virtual Status GetBounds(std::string *min_encoded_key,
                            std::string *max_encoded_key) const override;
 
@@ -424,6 +444,14 @@ class MemRowSet : public RowSet,
             log::LogAnchorRegistry* log_anchor_registry,
             std::shared_ptr<MemTracker> parent_tracker);
 
+  // Insert 'row' at the key prepared in 'mutation', or reinsert it if the
+  // key belongs to a ghost row. If 'hold_lock' is true, the mutation keeps
+  // its leaf locked afterwards (see PreparedMutation::InsertAndHold()).
+  Status InsertPrepared(Timestamp timestamp,
+                        const ConstContiguousRow& row,
+                        btree::PreparedMutation<MSBTreeTraits>* mutation,
+                        bool hold_lock);
+
   // Perform a "Reinsert" -- handle an insertion into a row which was previously
   // inserted and deleted, but still has an entry in the MemRowSet.
   Status Reinsert(Timestamp timestamp,
@@ -491,6 +519,16 @@ class MemRowSet::Iterator : public RowwiseIterator {
     return key.compare(*exclusive_upper_bound_) >= 0;
   }
 
+  // Returns whether the iterator is positioned at or past its upper bound,
+  // if it has one.
+  bool IsPastUpperBound() const {
+    DCHECK_NE(state_, kUninitialized) << "not initted";
+    if (!has_upper_bound()) return false;
+    Slice key, dummy;
+    iter_->GetCurrentEntry(&key, &dummy);
+    return out_of_bounds(key);
+  }
+
   size_t remaining_in_leaf() const {
     DCHECK_NE(state_, kUninitialized) << "not initted";
     return iter_->remaining_in_leaf();
@@ -22,6 +22,9 @@
 #include <string>
 #include <utility>
 
+#include <gflags/gflags_declare.h>
+
+#include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/common/columnblock.h"
@@ -32,6 +35,9 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/stl_util.h"
+#include "kudu/tablet/metadata.pb.h"
+
+DECLARE_bool(cfile_write_zone_maps);
 
 namespace kudu {
 namespace tablet {
@@ -77,6 +83,9 @@ Status MultiColumnWriter::Open() {
       opts.write_validx = true;
     }
 
+    // Let scans skip the blocks which can't match their predicates.
+    opts.write_zone_map = FLAGS_cfile_write_zone_maps;
+
     // Open file for write.
     unique_ptr<WritableBlock> block;
     RETURN_NOT_OK_PREPEND(fs_->CreateNewBlock(block_opts, &block),
@@ -137,6 +146,28 @@ void MultiColumnWriter::GetFlushedBlocksByColumnId(std::map<ColumnId, BlockId>*
   }
 }
 
+void MultiColumnWriter::GetFlushedColumnStats(std::vector<ColumnStatsPB>* ret) const {
+  CHECK(finished_);
+  ret->clear();
+  for (int i = 0; i < schema_->num_columns(); i++) {
+    cfile::ZoneMapEntryPB file_stats;
+    if (!cfile_writers_[i]->GetFileStats(&file_stats)) {
+      continue;
+    }
+    ColumnStatsPB stats;
+    stats.set_column_id(schema_->column_id(i));
+    stats.set_num_rows(file_stats.num_rows());
+    stats.set_null_count(file_stats.null_count());
+    if (file_stats.has_min_value()) {
+      stats.set_min_value(file_stats.min_value());
+    }
+    if (file_stats.has_max_value()) {
+      stats.set_max_value(file_stats.max_value());
+    }
+    ret->emplace_back(std::move(stats));
+  }
+}
+
 size_t MultiColumnWriter::written_size() const {
   size_t size = 0;
   for (const CFileWriter *writer : cfile_writers_) {
@@ -45,6 +45,8 @@ class BlockCreationTransaction;
 
 namespace tablet {
 
+class ColumnStatsPB;
+
 // Wrapper which writes several columns in parallel corresponding to some
 // Schema. Written blocks will fall in the tablet_id's data dir group.
 class MultiColumnWriter {
@@ -80,6 +82,12 @@ class MultiColumnWriter {
   // REQUIRES: Finish() already called.
   void GetFlushedBlocksByColumnId(std::map<ColumnId, BlockId>* ret) const;
 
+  // Return the statistics of the written columns, for those columns whose
+  // writers gathered any.
+  //
+  // REQUIRES: Finish() already called.
+  void GetFlushedColumnStats(std::vector<ColumnStatsPB>* ret) const;
+
  private:
   FsManager* const fs_;
   const Schema* const schema_;
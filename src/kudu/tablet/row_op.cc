@@ -24,6 +24,7 @@
 
 #include "kudu/common/wire_protocol.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet.pb.h"
 #include "kudu/util/pb_util.h"
 
@@ -55,6 +56,16 @@ void RowOp::SetInsertSucceeded(int mrs_id) {
   result->add_mutated_stores()->set_mrs_id(mrs_id);
 }
 
+void RowOp::SetInsertSucceededInDiskRowSet(int64_t rs_id) {
+  DCHECK(!result) << SecureDebugString(*result);
+  result.reset(new OperationResultPB());
+  MemStoreTargetPB* target = result->add_mutated_stores();
+  target->set_rs_id(rs_id);
+  // The row is in the base data, which is durable as soon as the rowset is,
+  // so no delta store will ever count as unflushed for it on replay.
+  target->set_dms_id(kNoDurableMemStore);
+}
+
 void RowOp::SetMutateSucceeded(gscoped_ptr<OperationResultPB> result) {
   DCHECK(!this->result) << SecureDebugString(*result);
   this->result = std::move(result);
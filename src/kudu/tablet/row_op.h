@@ -17,6 +17,7 @@
 #ifndef KUDU_TABLET_ROW_OP_H
 #define KUDU_TABLET_ROW_OP_H
 
+#include <cstdint>
 #include <string>
 
 #include "kudu/common/row_operations.h"
@@ -42,9 +43,12 @@ struct RowOp {
   ~RowOp();
 
   // Functions to set the result of the mutation.
-  // Only one of the following four functions must be called, at most once.
+  // Only one of the following five functions must be called, at most once.
   void SetFailed(const Status& s);
   void SetInsertSucceeded(int mrs_id);
+  // Sets the result of an insert which was bulk loaded straight into the base
+  // data of the DiskRowSet with ID 'rs_id'.
+  void SetInsertSucceededInDiskRowSet(int64_t rs_id);
   void SetMutateSucceeded(gscoped_ptr<OperationResultPB> result);
   // Sets the result of a skipped operation on bootstrap.
   // TODO(dralves) Currently this performs a copy. Might be avoided with some refactoring.
@@ -46,6 +46,7 @@ namespace kudu {
 class MonoTime; // IWYU pragma: keep
 class RowChangeList;
 class RowwiseIterator;
+class ScanSpec;
 class Schema;
 class Slice;
 struct ColumnId;
@@ -165,6 +166,14 @@ class RowSet {
   virtual Status GetBounds(std::string* min_encoded_key,
                            std::string* max_encoded_key) const = 0;
 
+  // Return false if no row of this RowSet can satisfy the predicates of
+  // 'spec', whose columns belong to 'schema'. This is decided from the
+  // RowSet's column statistics, if any, and is conservative: a true result
+  // doesn't mean that any row matches.
+  virtual bool MayMatchScanSpec(const ScanSpec& /*spec*/, const Schema& /*schema*/) const {
+    return true;
+  }
+
   // Return a displayable string for this rowset.
   virtual std::string ToString() const = 0;
 
@@ -105,6 +105,12 @@ void RowSetMetadata::LoadFromPB(const RowSetDataPB& pb) {
     blocks_by_col_id_[col_id] = BlockId::FromPB(col_pb.block());
   }
 
+  // Load column statistics.
+  stats_by_col_id_.clear();
+  for (const ColumnStatsPB& stats_pb : pb.column_stats()) {
+    stats_by_col_id_[ColumnId(stats_pb.column_id())] = stats_pb;
+  }
+
   // Load redo delta files.
   redo_delta_blocks_.clear();
   for (const DeltaDataPB& redo_delta_pb : pb.redo_deltas()) {
@@ -135,6 +141,11 @@ void RowSetMetadata::ToProtobuf(RowSetDataPB *pb) {
     col_data->set_column_id(col_id);
   }
 
+  // Write column statistics
+  for (const ColumnIdToStatsMap::value_type& e : stats_by_col_id_) {
+    *pb->add_column_stats() = e.second;
+  }
+
   // Write Delta Files
   pb->set_last_durable_dms_id(last_durable_redo_dms_id_);
 
@@ -176,6 +187,21 @@ void RowSetMetadata::SetColumnDataBlocks(const std::map<ColumnId, BlockId>& bloc
   blocks_by_col_id_ = std::move(new_map);
 }
 
+void RowSetMetadata::SetColumnStats(const vector<ColumnStatsPB>& stats) {
+  ColumnIdToStatsMap new_map;
+  new_map.reserve(stats.size());
+  for (const ColumnStatsPB& s : stats) {
+    new_map[ColumnId(s.column_id())] = s;
+  }
+  std::lock_guard<LockType> l(lock_);
+  stats_by_col_id_ = std::move(new_map);
+}
+
+void RowSetMetadata::ClearColumnStats(ColumnId col_id) {
+  std::lock_guard<LockType> l(lock_);
+  stats_by_col_id_.erase(col_id);
+}
+
 Status RowSetMetadata::CommitRedoDeltaDataBlock(int64_t dms_id,
                                                 const BlockId& block_id) {
   std::lock_guard<LockType> l(lock_);
@@ -256,11 +282,15 @@ void RowSetMetadata::CommitUpdate(const RowSetMetadataUpdate& update,
       if (UpdateReturnCopy(&blocks_by_col_id_, e.first, e.second, &old_block_id)) {
         removed->push_back(old_block_id);
       }
+      // The replacement base data was merged with deltas, so the old
+      // statistics no longer describe it.
+      stats_by_col_id_.erase(e.first);
     }
 
     for (const ColumnId& col_id : update.col_ids_to_remove_) {
       BlockId old = FindOrDie(blocks_by_col_id_, col_id);
       CHECK_EQ(1, blocks_by_col_id_.erase(col_id));
+      stats_by_col_id_.erase(col_id);
       removed->push_back(old);
     }
   }
@@ -35,6 +35,7 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/status.h"
@@ -42,8 +43,6 @@
 namespace kudu {
 
 namespace tablet {
-
-class RowSetDataPB;
 class RowSetMetadataUpdate;
 
 // Keeps track of the RowSet data blocks.
@@ -73,6 +72,7 @@ class RowSetMetadata {
   // We use a flat_map to save memory, since there are lots of these metadata
   // objects.
   typedef boost::container::flat_map<ColumnId, BlockId> ColumnIdToBlockIdMap;
+  typedef boost::container::flat_map<ColumnId, ColumnStatsPB> ColumnIdToStatsMap;
 
   // Create a new RowSetMetadata
   static Status CreateNew(TabletMetadata* tablet_metadata,
@@ -117,6 +117,20 @@ class RowSetMetadata {
 
   void SetColumnDataBlocks(const std::map<ColumnId, BlockId>& blocks_by_col_id);
 
+  // Replaces the statistics of the rowset's base data columns.
+  void SetColumnStats(const std::vector<ColumnStatsPB>& stats);
+
+  // Forgets the statistics of the given column, e.g. because deltas which
+  // update it have been written.
+  void ClearColumnStats(ColumnId col_id);
+
+  // Sets 'stats' to the statistics of the given column's base data. Returns
+  // false if there are none.
+  bool GetColumnStats(ColumnId col_id, ColumnStatsPB* stats) const {
+    std::lock_guard<LockType> l(lock_);
+    return FindCopy(stats_by_col_id_, col_id, stats);
+  }
+
   Status CommitRedoDeltaDataBlock(int64_t dms_id, const BlockId& block_id);
 
   Status CommitUndoDeltaDataBlock(const BlockId& block_id);
@@ -261,6 +275,10 @@ class RowSetMetadata {
 
   // Map of column ID to block ID.
   ColumnIdToBlockIdMap blocks_by_col_id_;
+
+  // Map of column ID to the statistics of the column's base data, for the
+  // columns which have them.
+  ColumnIdToStatsMap stats_by_col_id_;
   std::vector<BlockId> redo_delta_blocks_;
   std::vector<BlockId> undo_delta_blocks_;
 
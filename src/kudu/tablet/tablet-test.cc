@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <ctime>
+#include <functional>
 #include <map>
 #include <memory>
 #include <ostream>
@@ -76,6 +77,11 @@ DEFINE_int32(testiterator_num_inserts, 1000,
 DEFINE_int32(testcompaction_num_rows, 1000,
              "Number of rows per rowset in TestCompaction");
 
+DECLARE_int32(budgeted_compaction_target_rowset_size);
+DECLARE_int32(flush_memrowset_inject_range_failure);
+DECLARE_int32(flush_memrowset_max_threads);
+DECLARE_int32(tablet_bulk_load_min_rows);
+
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -143,6 +149,58 @@ TYPED_TEST(TestTablet, TestFlush) {
   ASSERT_EQ(dfr->delta_stats().delete_count(), max_rows);
 }
 
+// Test flushing a MemRowSet in several key ranges concurrently.
+TYPED_TEST(TestTablet, TestParallelFlush) {
+  FLAGS_flush_memrowset_max_threads = 4;
+  // Make every range large enough to be split off.
+  FLAGS_budgeted_compaction_target_rowset_size = 1;
+
+  uint64_t max_rows = this->ClampRowCount(FLAGS_testflush_num_inserts);
+  this->InsertTestRows(0, max_rows, 0);
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+  for (int i = 0; i < max_rows; i += 3) {
+    ASSERT_OK(this->UpdateTestRow(&writer, i, i + 10));
+  }
+  ASSERT_EQ(4, this->tablet()->MemRowSetFlushParallelism());
+
+  vector<string> rows_before;
+  ASSERT_OK(this->IterateToStringList(&rows_before));
+  ASSERT_OK(this->tablet()->Flush());
+  ASSERT_GE(this->tablet()->num_rowsets(), 4);
+
+  vector<string> rows_after;
+  ASSERT_OK(this->IterateToStringList(&rows_after));
+  std::sort(rows_before.begin(), rows_before.end());
+  std::sort(rows_after.begin(), rows_after.end());
+  ASSERT_EQ(rows_before, rows_after);
+}
+
+// Test that the failure of any key range of a parallel flush fails the flush,
+// and leaves the data in the MemRowSet.
+TYPED_TEST(TestTablet, TestParallelFlushRangeFailure) {
+  FLAGS_flush_memrowset_max_threads = 4;
+  FLAGS_budgeted_compaction_target_rowset_size = 1;
+
+  uint64_t max_rows = this->ClampRowCount(FLAGS_testflush_num_inserts);
+  this->InsertTestRows(0, max_rows, 0);
+  ASSERT_EQ(4, this->tablet()->MemRowSetFlushParallelism());
+  vector<string> rows_before;
+  ASSERT_OK(this->IterateToStringList(&rows_before));
+
+  // Fail a range written by the thread pool rather than by the flushing thread.
+  FLAGS_flush_memrowset_inject_range_failure = 2;
+  Status s = this->tablet()->Flush();
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "Injected failure writing key range 2");
+
+  vector<string> rows_after;
+  ASSERT_OK(this->IterateToStringList(&rows_after));
+  ASSERT_EQ(rows_before.size(), rows_after.size());
+  std::sort(rows_before.begin(), rows_before.end());
+  std::sort(rows_after.begin(), rows_after.end());
+  ASSERT_EQ(rows_before, rows_after);
+}
+
 // Test that historical data for a row is maintained even after the row
 // is flushed from the memrowset.
 TYPED_TEST(TestTablet, TestInsertsAndMutationsAreUndoneWithMVCCAfterFlush) {
@@ -726,6 +784,51 @@ TYPED_TEST(TestTablet, TestInsertsPersist) {
   // TODO: add some more data, re-flush
 }
 
+// Test that a bulk load writes its rows straight into a new DiskRowSet, which
+// hides them from earlier snapshots and persists them without a flush.
+TYPED_TEST(TestTablet, TestBulkLoad) {
+  FLAGS_tablet_bulk_load_min_rows = 10;
+  uint64_t max_rows = this->ClampRowCount(FLAGS_testiterator_num_inserts);
+
+  // Row 0 goes into the MemRowSet, so inserting it again as part of the bulk
+  // load fails.
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+  ASSERT_OK(this->InsertTestRow(&writer, 0, 0));
+  Timestamp before_load = this->tablet()->clock()->Now();
+
+  // Send the rest out of key order.
+  vector<unique_ptr<KuduPartialRow>> rows;
+  vector<LocalTabletWriter::Op> ops;
+  rows.emplace_back(new KuduPartialRow(&this->client_schema_));
+  this->setup_.BuildRow(rows.back().get(), 0, 1);
+  ops.emplace_back(RowOperationsPB::INSERT, rows.back().get());
+  for (int64_t i = max_rows - 1; i > 0; i--) {
+    rows.emplace_back(new KuduPartialRow(&this->client_schema_));
+    this->setup_.BuildRow(rows.back().get(), i, 1);
+    ops.emplace_back(RowOperationsPB::INSERT, rows.back().get());
+  }
+  writer.set_bulk_load(true);
+  Status s = writer.WriteBatch(ops);
+  ASSERT_TRUE(s.IsAlreadyPresent()) << s.ToString();
+
+  ASSERT_EQ(1, this->tablet()->num_rowsets());
+  const OperationResultPB& result = writer.last_op_result();
+  ASSERT_EQ(1, result.mutated_stores_size());
+  ASSERT_TRUE(result.mutated_stores(0).has_rs_id());
+  ASSERT_FALSE(result.mutated_stores(0).has_mrs_id());
+
+  ASSERT_EQ(max_rows, this->TabletCount());
+  NO_FATALS(this->VerifyTestRowsWithTimestampAndVerifier(0, 1, before_load, boost::none));
+  std::function<bool(int32_t, int32_t)> verifier = [](int32_t key, int32_t val) {
+    return val == (key == 0 ? 0 : 1);
+  };
+  NO_FATALS(this->VerifyTestRowsWithVerifier(0, max_rows, verifier));
+
+  // The bulk loaded rows don't need a flush to survive a restart.
+  this->TabletReOpen();
+  NO_FATALS(this->VerifyTestRows(1, max_rows - 1));
+}
+
 TYPED_TEST(TestTablet, TestUpsert) {
   vector<string> rows;
   const auto& upserts_as_updates = this->tablet()->metrics()->upserts_as_updates;
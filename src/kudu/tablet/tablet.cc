@@ -43,6 +43,7 @@
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/row_operations.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
@@ -65,6 +66,7 @@
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/diskrowset.h"
 #include "kudu/tablet/memrowset.h"
+#include "kudu/tablet/mutation.h"
 #include "kudu/tablet/row_op.h"
 #include "kudu/tablet/rowset_info.h"
 #include "kudu/tablet/rowset_metadata.h"
@@ -85,11 +87,13 @@
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/maintenance_manager.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/process_memory.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status_callback.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/throttler.h"
 #include "kudu/util/trace.h"
 #include "kudu/util/url-coding.h"
@@ -157,6 +161,33 @@ DEFINE_int32(max_encoded_key_size_bytes, 16 * 1024,
              "result in an error.");
 TAG_FLAG(max_encoded_key_size_bytes, unsafe);
 
+DEFINE_bool(tablet_batch_insert_enabled, true,
+            "Whether to apply a write batch made up mostly of new rows as a single "
+            "sorted batch insertion into the MemRowSet, rather than inserting each "
+            "row separately.");
+TAG_FLAG(tablet_batch_insert_enabled, advanced);
+TAG_FLAG(tablet_batch_insert_enabled, runtime);
+
+DEFINE_int32(tablet_bulk_load_min_rows, 1000,
+             "Minimum number of new rows a write flagged as a bulk load must contain "
+             "to be written straight into new DiskRowSets. Smaller bulk load writes "
+             "go through the MemRowSet, to avoid creating many tiny rowsets.");
+TAG_FLAG(tablet_bulk_load_min_rows, advanced);
+TAG_FLAG(tablet_bulk_load_min_rows, runtime);
+
+DEFINE_int32(flush_memrowset_max_threads, 4,
+             "Maximum number of threads used to flush a single MemRowSet. A large "
+             "MemRowSet is split into key ranges of at least the target rowset size, "
+             "which are flushed concurrently into separate DiskRowSets.");
+TAG_FLAG(flush_memrowset_max_threads, advanced);
+TAG_FLAG(flush_memrowset_max_threads, runtime);
+
+DEFINE_int32(flush_memrowset_inject_range_failure, -1,
+             "If non-negative, the index of the key range whose write fails when a "
+             "MemRowSet is flushed in several key ranges. For testing only!");
+TAG_FLAG(flush_memrowset_inject_range_failure, hidden);
+TAG_FLAG(flush_memrowset_inject_range_failure, unsafe);
+
 METRIC_DEFINE_entity(tablet);
 METRIC_DEFINE_gauge_size(tablet, memrowset_size, "MemRowSet Memory Usage",
                          kudu::MetricUnit::kBytes,
@@ -177,6 +208,7 @@ using std::ostream;
 using std::pair;
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::unordered_set;
 using std::vector;
 using strings::Substitute;
@@ -192,6 +224,46 @@ static CompactionPolicy *CreateCompactionPolicy() {
   return new BudgetedCompactionPolicy(FLAGS_tablet_compaction_budget_mb);
 }
 
+// Writes the rows of the INSERTs in 'keys_and_ops', which must be sorted by key,
+// into 'drsw', each with an UNDO that deletes it as of 'timestamp'. Sets
+// (*drs_idx_by_op)[i] to the index of the rowset written for keys_and_ops[i].
+static Status WriteBulkLoadRows(const Schema& schema,
+                                const vector<pair<Slice, RowOp*>>& keys_and_ops,
+                                Timestamp timestamp,
+                                RollingDiskRowSetWriter* drsw,
+                                vector<int64_t>* drs_idx_by_op) {
+  static const int kBlockNumRows = 100;
+  const RowChangeList undo_delete = RowChangeList::CreateDelete();
+  Arena undo_arena(1024);
+  RowBlock block(schema, kBlockNumRows, nullptr);
+  drs_idx_by_op->resize(keys_and_ops.size());
+
+  int n = 0;
+  for (int i = 0; i < keys_and_ops.size(); i++) {
+    RETURN_NOT_OK(drsw->RollIfNecessary());
+    ConstContiguousRow src_row(&schema, keys_and_ops[i].second->decoded_op.row_data);
+    RowBlockRow dst_row = block.row(n);
+    RETURN_NOT_OK(CopyRow(src_row, &dst_row, static_cast<Arena*>(nullptr)));
+
+    Mutation* undo = Mutation::CreateInArena(&undo_arena, timestamp, undo_delete);
+    rowid_t row_idx_in_drs;
+    RETURN_NOT_OK(drsw->AppendUndoDeltas(n, undo, &row_idx_in_drs));
+    (*drs_idx_by_op)[i] = drsw->drs_written_count();
+
+    if (++n == block.nrows()) {
+      RETURN_NOT_OK(drsw->AppendBlock(block));
+      // The UNDOs were encoded when they were appended.
+      undo_arena.Reset();
+      n = 0;
+    }
+  }
+  if (n > 0) {
+    block.Resize(n);
+    RETURN_NOT_OK(drsw->AppendBlock(block));
+  }
+  return drsw->Finish();
+}
+
 ////////////////////////////////////////////////////////////
 // TabletComponents
 ////////////////////////////////////////////////////////////
@@ -447,8 +519,20 @@ Status Tablet::AcquireRowLocks(WriteTransactionState* tx_state) {
   TRACE_EVENT1("tablet", "Tablet::AcquireRowLocks",
                "num_locks", tx_state->row_ops().size());
   TRACE("PREPARE: Acquiring locks for $0 operations", tx_state->row_ops().size());
-  for (RowOp* op : tx_state->row_ops()) {
-    RETURN_NOT_OK(AcquireLockForOp(tx_state, op));
+  const auto& row_ops = tx_state->row_ops();
+  vector<Slice> keys;
+  keys.reserve(row_ops.size());
+  for (RowOp* op : row_ops) {
+    ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
+    op->key_probe.reset(new tablet::RowSetKeyProbe(row_key));
+    RETURN_NOT_OK(CheckRowInTablet(row_key));
+    keys.push_back(op->key_probe->encoded_key_slice());
+  }
+
+  vector<ScopedRowLock> locks;
+  lock_manager_.AcquireLocks(keys, tx_state, LockManager::LOCK_EXCLUSIVE, &locks);
+  for (size_t i = 0; i < row_ops.size(); i++) {
+    row_ops[i]->row_lock = std::move(locks[i]);
   }
   TRACE("PREPARE: locks acquired");
   return Status::OK();
@@ -470,18 +554,6 @@ Status Tablet::CheckRowInTablet(const ConstContiguousRow& row) const {
   return Status::OK();
 }
 
-Status Tablet::AcquireLockForOp(WriteTransactionState* tx_state, RowOp* op) {
-  ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
-  op->key_probe.reset(new tablet::RowSetKeyProbe(row_key));
-  RETURN_NOT_OK(CheckRowInTablet(row_key));
-
-  op->row_lock = ScopedRowLock(&lock_manager_,
-                               tx_state,
-                               op->key_probe->encoded_key_slice(),
-                               LockManager::LOCK_EXCLUSIVE);
-  return Status::OK();
-}
-
 void Tablet::AssignTimestampAndStartTransactionForTests(WriteTransactionState* tx_state) {
   CHECK(!tx_state->has_timestamp());
   // Don't support COMMIT_WAIT for tests that don't boot a tablet server.
@@ -929,6 +1001,13 @@ Status Tablet::ApplyRowOperations(WriteTransactionState* tx_state) {
   IOContext io_context({ tablet_id() });
   RETURN_NOT_OK(BulkCheckPresence(&io_context, tx_state));
 
+  if (tx_state->request() && tx_state->request()->bulk_load()) {
+    RETURN_NOT_OK(MaybeBulkLoadInserts(&io_context, tx_state));
+  }
+  if (FLAGS_tablet_batch_insert_enabled) {
+    RETURN_NOT_OK(MaybeApplyInsertsAsBatch(tx_state));
+  }
+
   // Actually apply the ops.
   for (int op_idx = 0; op_idx < num_ops; op_idx++) {
     RowOp* row_op = tx_state->row_ops()[op_idx];
@@ -945,6 +1024,191 @@ Status Tablet::ApplyRowOperations(WriteTransactionState* tx_state) {
   return Status::OK();
 }
 
+Status Tablet::MaybeApplyInsertsAsBatch(WriteTransactionState* tx_state) {
+  const auto& row_ops = tx_state->row_ops();
+
+  // Only take the inserts that BulkCheckPresence() checked and found absent from
+  // the DiskRowSets. It checks just the first op for any key, so any other op
+  // on the same key comes later in the transaction and is still applied after
+  // the insert. Ops replayed from the log aren't checked up front, so leave the
+  // whole transaction to the op-by-op path to keep their relative order.
+  vector<RowOp*> inserts;
+  for (RowOp* op : row_ops) {
+    if (PREDICT_FALSE(op->orig_result_from_log_ != nullptr)) return Status::OK();
+    if (op->has_result() ||
+        !op->checked_present ||
+        op->present_in_rowset ||
+        op->decoded_op.type != RowOperationsPB::INSERT) {
+      continue;
+    }
+    inserts.push_back(op);
+  }
+  if (inserts.size() < 2 || inserts.size() * 2 < row_ops.size()) {
+    return Status::OK();
+  }
+
+  {
+    std::lock_guard<simple_spinlock> l(state_lock_);
+    RETURN_NOT_OK_PREPEND(CheckHasNotBeenStoppedUnlocked(),
+        Substitute("Apply of $0 exited early", tx_state->ToString()));
+    CHECK(state_ == kOpen || state_ == kBootstrapping);
+  }
+  DCHECK(tx_state->op_id().IsInitialized()) << "TransactionState OpId needed for anchoring";
+  DCHECK_EQ(tx_state->schema_at_decode_time(), schema());
+
+  vector<ConstContiguousRow> rows;
+  rows.reserve(inserts.size());
+  for (const RowOp* op : inserts) {
+    DCHECK(op->has_row_lock()) << "RowOp must hold the row lock.";
+    DCHECK(op->validated);
+    rows.emplace_back(schema(), op->decoded_op.row_data);
+  }
+
+  const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
+  vector<Status> statuses;
+  comps->memrowset->InsertBatch(tx_state->timestamp(), rows, tx_state->op_id(), &statuses);
+
+  Status first_error;
+  for (int i = 0; i < inserts.size(); i++) {
+    RowOp* op = inserts[i];
+    const Status& s = statuses[i];
+    if (s.ok()) {
+      op->SetInsertSucceeded(comps->memrowset->mrs_id());
+      continue;
+    }
+    if (s.IsAlreadyPresent()) {
+      if (metrics_) {
+        metrics_->insertions_failed_dup_key->Increment();
+      }
+    } else if (first_error.ok()) {
+      first_error = s;
+    }
+    op->SetFailed(s);
+  }
+  return first_error;
+}
+
+Status Tablet::MaybeBulkLoadInserts(const IOContext* io_context,
+                                    WriteTransactionState* tx_state) {
+  TRACE_EVENT1("tablet", "Tablet::MaybeBulkLoadInserts", "id", tablet_id());
+  const auto& row_ops = tx_state->row_ops();
+
+  // Only take a transaction made up entirely of INSERTs that were checked
+  // against the DiskRowSets up front. Any other op, including a second op on
+  // the same key, would need to see the new rows through the components
+  // captured when the transaction started applying, which don't include the
+  // rowsets written here.
+  vector<int> op_idxs;
+  for (int i = 0; i < row_ops.size(); i++) {
+    const RowOp* op = row_ops[i];
+    if (op->has_result()) continue;
+    if (op->orig_result_from_log_ != nullptr ||
+        !op->checked_present ||
+        op->decoded_op.type != RowOperationsPB::INSERT) {
+      return Status::OK();
+    }
+    op_idxs.push_back(i);
+  }
+  if (op_idxs.size() < FLAGS_tablet_bulk_load_min_rows) {
+    return Status::OK();
+  }
+
+  {
+    std::lock_guard<simple_spinlock> l(state_lock_);
+    RETURN_NOT_OK_PREPEND(CheckHasNotBeenStoppedUnlocked(),
+        Substitute("Apply of $0 exited early", tx_state->ToString()));
+    CHECK(state_ == kOpen || state_ == kBootstrapping);
+  }
+  DCHECK_EQ(tx_state->schema_at_decode_time(), schema());
+
+  // Fail the rows that already exist. BulkCheckPresence() doesn't look at the
+  // MemRowSet, so check that here.
+  const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
+  vector<pair<Slice, RowOp*>> keys_and_ops;
+  keys_and_ops.reserve(op_idxs.size());
+  for (int op_idx : op_idxs) {
+    RowOp* op = row_ops[op_idx];
+    bool present = op->present_in_rowset != nullptr;
+    if (!present) {
+      RETURN_NOT_OK_PREPEND(comps->memrowset->CheckRowPresent(*op->key_probe, io_context,
+                                                              &present,
+                                                              tx_state->mutable_op_stats(op_idx)),
+                            "Failed to check if row is present");
+    }
+    if (present) {
+      if (metrics_) {
+        metrics_->insertions_failed_dup_key->Increment();
+      }
+      op->SetFailed(Status::AlreadyPresent("key already present"));
+      continue;
+    }
+    keys_and_ops.emplace_back(op->key_probe->encoded_key_slice(), op);
+  }
+  if (keys_and_ops.empty()) {
+    return Status::OK();
+  }
+  std::sort(keys_and_ops.begin(), keys_and_ops.end(),
+            [](const pair<Slice, RowOp*>& a, const pair<Slice, RowOp*>& b) {
+              return a.first.compare(b.first) < 0;
+            });
+
+  // Write the rows out in key order, each with an UNDO that deletes it as of
+  // this transaction's timestamp. Until the transaction commits, MVCC hides
+  // the rows the same way it would hide them in the MemRowSet.
+  //
+  // If the rowsets can't be written, the rows are left for the regular write
+  // path to insert into the MemRowSet.
+  RollingDiskRowSetWriter drsw(metadata_.get(), *schema(), DefaultBloomSizing(),
+                               compaction_policy_->target_rowset_size());
+  vector<int64_t> drs_idx_by_op;
+  Status s = drsw.Open();
+  if (s.ok()) {
+    s = WriteBulkLoadRows(*schema(), keys_and_ops, tx_state->timestamp(), &drsw,
+                          &drs_idx_by_op);
+  }
+  if (!s.ok()) {
+    LOG_WITH_PREFIX(WARNING) << "Failed to bulk load rows of " << tx_state->ToString()
+                             << ", inserting them into the MemRowSet instead: "
+                             << s.ToString();
+    return Status::OK();
+  }
+
+  RowSetMetadataVector new_drs_metas;
+  drsw.GetWrittenRowSetMetadata(&new_drs_metas);
+  RowSetVector new_rowsets;
+  for (const auto& meta : new_drs_metas) {
+    shared_ptr<DiskRowSet> new_rowset;
+    s = DiskRowSet::Open(meta, log_anchor_registry_.get(), mem_trackers_, io_context,
+                         &new_rowset);
+    if (!s.ok()) {
+      LOG_WITH_PREFIX(WARNING) << "Unable to open bulk loaded rowset " << meta->ToString()
+                               << ", inserting its rows into the MemRowSet instead: "
+                               << s.ToString();
+      for (const auto& orphaned_meta : new_drs_metas) {
+        metadata_->AddOrphanedBlocks(orphaned_meta->GetAllBlocks());
+      }
+      return Status::OK();
+    }
+    new_rowsets.emplace_back(std::move(new_rowset));
+  }
+
+  // Once the new rowsets are in the durable metadata, the rows are durable too:
+  // on bootstrap, an op whose result points at one of them is skipped.
+  RETURN_NOT_OK_PREPEND(FlushMetadata({}, new_drs_metas, TabletMetadata::kNoMrsFlushed),
+                        "Failed to flush new tablet metadata");
+  AtomicSwapRowSets({}, new_rowsets);
+
+  for (int i = 0; i < keys_and_ops.size(); i++) {
+    keys_and_ops[i].second->SetInsertSucceededInDiskRowSet(
+        new_drs_metas[drs_idx_by_op[i]]->id());
+  }
+  VLOG_WITH_PREFIX(1) << Substitute("Bulk loaded $0 rows into $1 rowsets ($2 bytes)",
+                                    drsw.rows_written_count(),
+                                    drsw.drs_written_count(),
+                                    drsw.written_size());
+  return Status::OK();
+}
+
 Status Tablet::ApplyRowOperation(const IOContext* io_context,
                                  WriteTransactionState* tx_state,
                                  RowOp* row_op,
@@ -1486,39 +1750,43 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
                           "PostTakeMvccSnapshot hook failed");
   }
 
-  shared_ptr<CompactionInput> merge;
-  RETURN_NOT_OK(input.CreateCompactionInput(flush_snap, schema(), &io_context, &merge));
-
-  RollingDiskRowSetWriter drsw(metadata_.get(), merge->schema(), DefaultBloomSizing(),
-                               compaction_policy_->target_rowset_size());
-  RETURN_NOT_OK_PREPEND(drsw.Open(), "Failed to open DiskRowSet for flush");
-
   HistoryGcOpts history_gc_opts = GetHistoryGcOpts();
-  RETURN_NOT_OK_PREPEND(FlushCompactionInput(merge.get(), flush_snap, history_gc_opts, &drsw),
-                        "Flush to disk failed");
-  RETURN_NOT_OK_PREPEND(drsw.Finish(), "Failed to finish DRS writer");
+  vector<unique_ptr<RollingDiskRowSetWriter>> writers;
+  RETURN_NOT_OK(WriteSnapshot(input, mrs_being_flushed, flush_snap, history_gc_opts,
+                              &io_context, &writers));
 
   if (common_hooks_) {
     RETURN_NOT_OK_PREPEND(common_hooks_->PostWriteSnapshot(),
                           "PostWriteSnapshot hook failed");
   }
 
+  // The writers covered consecutive key ranges, so concatenating their output
+  // yields the rowsets in key order, as a single writer would have.
+  RowSetMetadataVector new_drs_metas;
+  int64_t rows_written = 0;
+  uint64_t bytes_written = 0;
+  for (const auto& writer : writers) {
+    RowSetMetadataVector metas;
+    writer->GetWrittenRowSetMetadata(&metas);
+    new_drs_metas.insert(new_drs_metas.end(), metas.begin(), metas.end());
+    rows_written += writer->rows_written_count();
+    bytes_written += writer->written_size();
+  }
+
   // Though unlikely, it's possible that no rows were written because all of
   // the input rows were GCed in this compaction. In that case, we don't
   // actually want to reopen.
-  if (drsw.rows_written_count() == 0) {
+  if (rows_written == 0) {
     LOG_WITH_PREFIX(INFO) << op_name << " resulted in no output rows (all input rows "
                           << "were GCed!)  Removing all input rowsets.";
     return HandleEmptyCompactionOrFlush(input.rowsets(), mrs_being_flushed);
   }
 
-  // The RollingDiskRowSet writer wrote out one or more RowSets as the
+  // The RollingDiskRowSet writers wrote out one or more RowSets as the
   // output. Open these into 'new_rowsets'.
   vector<shared_ptr<RowSet> > new_disk_rowsets;
-  RowSetMetadataVector new_drs_metas;
-  drsw.GetWrittenRowSetMetadata(&new_drs_metas);
 
-  if (metrics_.get()) metrics_->bytes_flushed->IncrementBy(drsw.written_size());
+  if (metrics_.get()) metrics_->bytes_flushed->IncrementBy(bytes_written);
   CHECK(!new_drs_metas.empty());
   {
     TRACE_EVENT0("tablet", "Opening compaction results");
@@ -1622,6 +1890,7 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
   LOG_WITH_PREFIX(INFO) << op_name
                         << " Phase 2: carrying over any updates which arrived during Phase 1";
   LOG_WITH_PREFIX(INFO) << "Phase 2 snapshot: " << non_duplicated_txns_snap.ToString();
+  shared_ptr<CompactionInput> merge;
   RETURN_NOT_OK_PREPEND(
       input.CreateCompactionInput(non_duplicated_txns_snap, schema(), &io_context, &merge),
           Substitute("Failed to create $0 inputs", op_name).c_str());
@@ -1671,9 +1940,9 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
 
   LOG_WITH_PREFIX(INFO) << Substitute("$0 successful on $1 rows ($2 rowsets, $3 bytes)",
                                       op_name,
-                                      drsw.rows_written_count(),
-                                      drsw.drs_written_count(),
-                                      drsw.written_size());
+                                      rows_written,
+                                      new_drs_metas.size(),
+                                      bytes_written);
 
   if (common_hooks_) {
     RETURN_NOT_OK_PREPEND(common_hooks_->PostSwapNewRowSet(),
@@ -1683,6 +1952,109 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
   return Status::OK();
 }
 
+int Tablet::MemRowSetFlushParallelism(const MemRowSet& mrs) const {
+  // Each range is expected to fill at least one target-sized rowset, so that
+  // splitting the flush doesn't produce more rowsets than rolling would.
+  const int64_t num_ranges = mrs.memory_footprint() / compaction_policy_->target_rowset_size();
+  return static_cast<int>(std::max<int64_t>(
+      1, std::min<int64_t>(num_ranges, FLAGS_flush_memrowset_max_threads)));
+}
+
+int Tablet::MemRowSetFlushParallelism() const {
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  return comps ? MemRowSetFlushParallelism(*comps->memrowset) : 1;
+}
+
+Status Tablet::WriteSnapshot(const RowSetsInCompaction& input,
+                             int64_t mrs_being_flushed,
+                             const MvccSnapshot& snap,
+                             const HistoryGcOpts& history_gc_opts,
+                             const IOContext* io_context,
+                             vector<unique_ptr<RollingDiskRowSetWriter>>* writers) {
+  // Write 'input' through 'drsw', restricted to ['lower', 'upper') if 'mrs'
+  // is set.
+  auto write = [&](const MemRowSet* mrs,
+                   const EncodedKey* lower,
+                   const EncodedKey* upper,
+                   RollingDiskRowSetWriter* drsw) {
+    shared_ptr<CompactionInput> merge;
+    if (mrs) {
+      merge.reset(CompactionInput::Create(*mrs, schema(), snap, lower, upper));
+    } else {
+      RETURN_NOT_OK(input.CreateCompactionInput(snap, schema(), io_context, &merge));
+    }
+    RETURN_NOT_OK_PREPEND(drsw->Open(), "Failed to open DiskRowSet for flush");
+    RETURN_NOT_OK_PREPEND(FlushCompactionInput(merge.get(), snap, history_gc_opts, drsw),
+                          "Flush to disk failed");
+    RETURN_NOT_OK_PREPEND(drsw->Finish(), "Failed to finish DRS writer");
+    return Status::OK();
+  };
+  auto new_writer = [&]() {
+    writers->emplace_back(new RollingDiskRowSetWriter(
+        metadata_.get(), *schema(), DefaultBloomSizing(),
+        compaction_policy_->target_rowset_size()));
+    return writers->back().get();
+  };
+
+  // Split the key space of a MemRowSet being flushed into ranges which are
+  // flushed concurrently.
+  vector<string> split_keys;
+  const MemRowSet* mrs = nullptr;
+  if (mrs_being_flushed != TabletMetadata::kNoMrsFlushed) {
+    DCHECK_EQ(1, input.num_rowsets());
+    mrs = down_cast<MemRowSet*>(input.rowsets()[0].get());
+    mrs->GetSplitKeys(MemRowSetFlushParallelism(*mrs), &split_keys);
+  }
+  if (split_keys.empty()) {
+    return write(nullptr, nullptr, nullptr, new_writer());
+  }
+
+  Arena arena(1024);
+  vector<gscoped_ptr<EncodedKey>> bounds(split_keys.size());
+  for (int i = 0; i < split_keys.size(); i++) {
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(*schema(), &arena, split_keys[i],
+                                                  &bounds[i]));
+  }
+  const int num_ranges = split_keys.size() + 1;
+  LOG_WITH_PREFIX(INFO) << "Flushing MemRowSet in " << num_ranges << " key ranges";
+
+  gscoped_ptr<ThreadPool> pool;
+  RETURN_NOT_OK(ThreadPoolBuilder("mrs-flush")
+                .set_max_threads(num_ranges - 1)
+                .Build(&pool));
+  auto write_range = [&](int i) {
+    if (PREDICT_FALSE(i == FLAGS_flush_memrowset_inject_range_failure)) {
+      return Status::IOError(Substitute("Injected failure writing key range $0", i));
+    }
+    return write(mrs, i > 0 ? bounds[i - 1].get() : nullptr,
+                 i < split_keys.size() ? bounds[i].get() : nullptr,
+                 (*writers)[i].get());
+  };
+  for (int i = 0; i < num_ranges; i++) {
+    new_writer();
+  }
+  // The results of the writes are kept apart from those of the submissions,
+  // which a task may otherwise overwrite if it completes before it's
+  // submitted. Only this thread touches 'submit_statuses'.
+  vector<Status> write_statuses(num_ranges);
+  vector<Status> submit_statuses(num_ranges);
+  // The first range is written by this thread.
+  for (int i = 1; i < num_ranges; i++) {
+    submit_statuses[i] = pool->SubmitFunc([&, i]() {
+      write_statuses[i] = write_range(i);
+    });
+  }
+  write_statuses[0] = write_range(0);
+  pool->Wait();
+  for (int i = 0; i < num_ranges; i++) {
+    RETURN_NOT_OK_PREPEND(submit_statuses[i],
+                          Substitute("Failed to submit the flush of key range $0", i));
+    RETURN_NOT_OK(write_statuses[i]);
+  }
+  return Status::OK();
+}
+
 Status Tablet::HandleEmptyCompactionOrFlush(const RowSetVector& rowsets,
                                             int mrs_being_flushed) {
   // Write out the new Tablet Metadata and remove old rowsets.
@@ -1792,7 +2164,8 @@ Status Tablet::CaptureConsistentIterators(
 
   opts.io_context = io_context;
 
-  // Cull row-sets in the case of key-range queries.
+  // Cull row-sets in the case of key-range queries. In either case, skip
+  // row-sets whose column statistics contradict the predicates.
   if (spec != nullptr && (spec->lower_bound_key() || spec->exclusive_upper_bound_key())) {
     boost::optional<Slice> lower_bound = spec->lower_bound_key() ? \
         boost::optional<Slice>(spec->lower_bound_key()->encoded_key()) : boost::none;
@@ -1801,6 +2174,9 @@ Status Tablet::CaptureConsistentIterators(
     vector<RowSet*> interval_sets;
     components_->rowsets->FindRowSetsIntersectingInterval(lower_bound, upper_bound, &interval_sets);
     for (const RowSet *rs : interval_sets) {
+      if (!rs->MayMatchScanSpec(*spec, *schema())) {
+        continue;
+      }
       gscoped_ptr<RowwiseIterator> row_it;
       RETURN_NOT_OK_PREPEND(rs->NewRowIterator(opts, &row_it),
                             Substitute("Could not create iterator for rowset $0",
@@ -1814,6 +2190,9 @@ Status Tablet::CaptureConsistentIterators(
   // If there are no encoded predicates of the primary keys, then
   // fall back to grabbing all rowset iterators.
   for (const shared_ptr<RowSet> &rs : components_->rowsets->all_rowsets()) {
+    if (spec != nullptr && !rs->MayMatchScanSpec(*spec, *schema())) {
+      continue;
+    }
     gscoped_ptr<RowwiseIterator> row_it;
     RETURN_NOT_OK_PREPEND(rs->NewRowIterator(opts, &row_it),
                           Substitute("Could not create iterator for rowset $0",
@@ -1843,6 +2222,54 @@ Status Tablet::CountRows(uint64_t *count) const {
   return Status::OK();
 }
 
+Status Tablet::SummarizeFromMetadata(bool* summarized,
+                                     uint64_t* num_rows,
+                                     string* min_encoded_key,
+                                     string* max_encoded_key) const {
+  *summarized = false;
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  if (!comps->memrowset->empty()) {
+    return Status::OK();
+  }
+
+  IOContext io_context({ tablet_id() });
+  uint64_t count = 0;
+  string min_key;
+  string max_key;
+  for (const shared_ptr<RowSet>& rowset : comps->rowsets->all_rowsets()) {
+    // Rowsets which are being compacted may be DuplicatingRowSets.
+    if (!rowset->IsAvailableForCompaction()) {
+      return Status::OK();
+    }
+    DiskRowSet* drs = down_cast<DiskRowSet*>(rowset.get());
+    if (!drs->DeltaMemStoreEmpty() ||
+        drs->delta_tracker()->CountRedoDeltaStores() > 0 ||
+        drs->delta_tracker()->CountUndoDeltaStores() > 0) {
+      return Status::OK();
+    }
+    rowid_t rs_count;
+    RETURN_NOT_OK(drs->CountRows(&io_context, &rs_count));
+    if (rs_count == 0) continue;
+    string rs_min_key;
+    string rs_max_key;
+    RETURN_NOT_OK(drs->GetBounds(&rs_min_key, &rs_max_key));
+    if (count == 0 || rs_min_key < min_key) {
+      min_key = std::move(rs_min_key);
+    }
+    if (count == 0 || rs_max_key > max_key) {
+      max_key = std::move(rs_max_key);
+    }
+    count += rs_count;
+  }
+
+  *summarized = true;
+  *num_rows = count;
+  *min_encoded_key = std::move(min_key);
+  *max_encoded_key = std::move(max_key);
+  return Status::OK();
+}
+
 size_t Tablet::MemRowSetSize() const {
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
@@ -79,6 +79,8 @@ class AlterSchemaTransactionState;
 class CompactionPolicy;
 class HistoryGcOpts;
 class MemRowSet;
+class MvccSnapshot;
+class RollingDiskRowSetWriter;
 class RowSetTree;
 class RowSetsInCompaction;
 class WriteTransactionState;
@@ -141,7 +143,8 @@ class Tablet {
   Status DecodeWriteOperations(const Schema* client_schema,
                                WriteTransactionState* tx_state);
 
-  // Acquire locks for each of the operations in the given txn.
+  // Acquire locks for each of the operations in the given txn. The locks are
+  // taken as one batch (see LockManager::AcquireLocks).
   //
   // Note that, if this fails, it's still possible that the transaction
   // state holds _some_ of the locks. In that case, we expect that
@@ -159,24 +162,6 @@ class Tablet {
   // don't boot a tablet server.
   void AssignTimestampAndStartTransactionForTests(WriteTransactionState* tx_state);
 
-  // Insert a new row into the tablet.
-  //
-  // The provided 'data' slice should have length equivalent to this
-  // tablet's Schema.byte_size().
-  //
-  // After insert, the row and any referred-to memory (eg for strings)
-  // have been copied into internal memory, and thus the provided memory
-  // buffer may safely be re-used or freed.
-  //
-  // Returns Status::AlreadyPresent() if an entry with the same key is already
-  // present in the tablet.
-  // Returns Status::OK unless allocation fails.
-  //
-  // Acquires the row lock for the given operation, setting it in the
-  // RowOp struct. This also sets the row op's RowSetKeyProbe.
-  Status AcquireLockForOp(WriteTransactionState* tx_state,
-                          RowOp* op);
-
   // Signal that the given transaction is about to Apply.
   void StartApplying(WriteTransactionState* tx_state);
 
@@ -259,6 +244,10 @@ class Tablet {
   // This method takes a read lock on component_lock_ and is thread-safe.
   bool MemRowSetEmpty() const;
 
+  // Returns the number of threads the MRS would currently be flushed with.
+  // This method takes a read lock on component_lock_ and is thread-safe.
+  int MemRowSetFlushParallelism() const;
+
   // Returns the size in bytes of WALs that would need to be replayed to restore
   // the current MRS.
   size_t MemRowSetLogReplaySize(const ReplaySizeMap& replay_size_map) const;
@@ -339,6 +328,19 @@ class Tablet {
   // memrowset in the current implementation.
   Status CountRows(uint64_t *count) const;
 
+  // Summarizes the tablet from rowset metadata alone, without reading any
+  // data blocks. This is only possible when the MemRowSet is empty and no
+  // DiskRowSet has any deltas, in which case the base data of the rowsets is
+  // exactly what every non-ancient snapshot of the tablet holds.
+  //
+  // Sets 'summarized' to whether that was the case. If so, sets 'num_rows' to
+  // the number of rows in the tablet and, if there are any, 'min_encoded_key'
+  // and 'max_encoded_key' to the bounds of their encoded primary keys.
+  Status SummarizeFromMetadata(bool* summarized,
+                               uint64_t* num_rows,
+                               std::string* min_encoded_key,
+                               std::string* max_encoded_key) const;
+
 
   // Verbosely dump this entire tablet to the logs. This is only
   // really useful when debugging unit tests failures where the tablet
@@ -529,6 +531,22 @@ class Tablet {
   // cell is being updated to an invalid (too large) value.
   Status ValidateMutateUnlocked(const RowOp& op) const;
 
+  // If 'tx_state' is a bulk load made up entirely of enough INSERTs, writes the new
+  // rows straight into new DiskRowSets and adds them to the tablet, bypassing the
+  // MemRowSet. Otherwise, or if the rowsets can't be written, leaves the ops to
+  // be applied as usual.
+  //
+  // Must be called after BulkCheckPresence().
+  Status MaybeBulkLoadInserts(const fs::IOContext* io_context,
+                              WriteTransactionState* tx_state) WARN_UNUSED_RESULT;
+
+  // If most of the ops in 'tx_state' are INSERTs of rows known to be absent from
+  // the DiskRowSets, applies all of those as a single batch insertion into the
+  // MemRowSet. The remaining ops are left to ApplyRowOperation().
+  //
+  // Must be called after BulkCheckPresence().
+  Status MaybeApplyInsertsAsBatch(WriteTransactionState* tx_state) WARN_UNUSED_RESULT;
+
   // Perform an INSERT or UPSERT operation, assuming that the transaction is already in
   // prepared state. This state ensures that:
   // - the row lock is acquired
@@ -586,6 +604,21 @@ class Tablet {
   Status DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
                                   int64_t mrs_being_flushed);
 
+  // Phase 1 of a compaction or flush: writes 'input' as of 'snap' into new
+  // rowsets through one or more writers, returned in 'writers' in key order.
+  // A large MemRowSet being flushed is split into key ranges, each of which is
+  // written concurrently by its own writer.
+  Status WriteSnapshot(const RowSetsInCompaction& input,
+                       int64_t mrs_being_flushed,
+                       const MvccSnapshot& snap,
+                       const HistoryGcOpts& history_gc_opts,
+                       const fs::IOContext* io_context,
+                       std::vector<std::unique_ptr<RollingDiskRowSetWriter>>* writers);
+
+  // Returns the number of key ranges 'mrs' should be flushed in, based on its
+  // size and --flush_memrowset_max_threads.
+  int MemRowSetFlushParallelism(const MemRowSet& mrs) const;
+
   // Handle the case in which a compaction or flush yielded no output rows.
   // In this case, we just need to remove the rowsets in 'rowsets' from the
   // metadata and flush it.
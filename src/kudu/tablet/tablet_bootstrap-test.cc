@@ -27,6 +27,7 @@
 #include <vector>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -78,6 +79,8 @@
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_int32(tablet_bootstrap_log_readahead_mb);
+
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -243,6 +246,55 @@ TEST_F(BootstrapTest, TestBootstrap) {
   ASSERT_EQ(1, results.size());
 }
 
+// Tests that every entry of a log spanning several segments is replayed when
+// the log is read ahead of replay one batch at a time.
+TEST_F(BootstrapTest, TestBootstrapWithLogReadAhead) {
+  FLAGS_tablet_bootstrap_log_readahead_mb = 0;
+  ASSERT_OK(BuildLog());
+
+  const int kNumSegments = 5;
+  const int kOpsPerSegment = 10;
+  consensus::ReplicateRefPtr replicate = consensus::make_scoped_refptr_replicate(
+      new consensus::ReplicateMsg());
+  replicate->get()->set_op_type(consensus::WRITE_OP);
+  tserver::WriteRequestPB* batch_request = replicate->get()->mutable_write_request();
+  ASSERT_OK(SchemaToPB(schema_, batch_request->mutable_schema()));
+  batch_request->set_tablet_id(log::kTestTablet);
+  for (int seg = 0; seg < kNumSegments; seg++) {
+    for (int i = 0; i < kOpsPerSegment; i++) {
+      OpId opid = MakeOpId(1, current_index_);
+      batch_request->mutable_row_operations()->Clear();
+      replicate->get()->mutable_id()->CopyFrom(opid);
+      replicate->get()->set_timestamp(clock_->Now().ToUint64());
+      AddTestRowToPB(RowOperationsPB::INSERT, schema_, current_index_, 0,
+                     "this is a test insert", batch_request->mutable_row_operations());
+      ASSERT_OK(AppendReplicateBatch(replicate));
+
+      gscoped_ptr<consensus::CommitMsg> commit(new consensus::CommitMsg);
+      commit->set_op_type(consensus::WRITE_OP);
+      commit->mutable_commited_op_id()->CopyFrom(opid);
+      commit->mutable_result()->add_ops()->add_mutated_stores()->set_mrs_id(1);
+      ASSERT_OK(AppendCommit(std::move(commit)));
+      current_index_++;
+    }
+    ASSERT_OK(RollLog());
+  }
+
+  shared_ptr<Tablet> tablet;
+  ConsensusBootstrapInfo boot_info;
+  StringVectorSink capture_logs;
+  {
+    ScopedRegisterSink reg(&capture_logs);
+    ASSERT_OK(BootstrapTestTablet(-1, -1, &tablet, &boot_info));
+  }
+  ASSERT_STRINGS_ANY_MATCH(capture_logs.logged_msgs(), "Bootstrap phase timings");
+  ASSERT_TRUE(boot_info.orphaned_replicates.empty());
+
+  vector<string> results;
+  IterateTabletRows(tablet.get(), &results);
+  ASSERT_EQ(kNumSegments * kOpsPerSegment, results.size());
+}
+
 // Test that we don't overflow opids. Regression test for KUDU-1933.
 TEST_F(BootstrapTest, TestBootstrapHighOpIdIndex) {
   // Start appending with a log index 3 under the int32 max value.
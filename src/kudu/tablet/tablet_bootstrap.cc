@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/tablet_bootstrap.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <iterator>
 #include <map>
@@ -72,12 +73,14 @@
 #include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet.pb.h"
 #include "kudu/tablet/tablet_metadata.h"
+#include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
 #include "kudu/tablet/transactions/transaction.h"
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.pb.h"
+#include "kudu/util/blocking_queue.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -90,6 +93,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/thread.h"
 
 DECLARE_int32(group_commit_queue_size_bytes);
 
@@ -99,6 +103,12 @@ DEFINE_double(fault_crash_during_log_replay, 0.0,
               "(For testing only!)");
 TAG_FLAG(fault_crash_during_log_replay, unsafe);
 
+DEFINE_int32(tablet_bootstrap_log_readahead_mb, 16,
+             "Maximum amount of WAL segment data, in MiB, that tablet bootstrap "
+             "reads and decodes ahead of log replay. Reading runs on a separate "
+             "thread so that it overlaps with applying the replayed operations.");
+TAG_FLAG(tablet_bootstrap_log_readahead_mb, advanced);
+
 DECLARE_int32(max_clock_sync_error_usec);
 
 using kudu::clock::Clock;
@@ -428,6 +438,33 @@ class TabletBootstrap {
   };
   Stats stats_;
 
+  // Wall-clock time spent in the phases of the bootstrap.
+  struct PhaseTimings {
+    PhaseTimings()
+      : open_tablet(MonoDelta::FromNanoseconds(0)),
+        log_read(MonoDelta::FromNanoseconds(0)),
+        log_read_wait(MonoDelta::FromNanoseconds(0)),
+        log_replay(MonoDelta::FromNanoseconds(0)) {
+    }
+
+    string ToString() const {
+      return Substitute("open_tablet=$0ms log_read=$1ms log_read_wait=$2ms log_replay=$3ms",
+                        open_tablet.ToMilliseconds(), log_read.ToMilliseconds(),
+                        log_read_wait.ToMilliseconds(), log_replay.ToMilliseconds());
+    }
+
+    // Time spent opening the tablet's on-disk data.
+    MonoDelta open_tablet;
+    // Time spent reading and decoding log segments. This overlaps with
+    // 'log_replay' since segments are read ahead on a separate thread.
+    MonoDelta log_read;
+    // Time log replay spent blocked waiting for entries to be read.
+    MonoDelta log_read_wait;
+    // Total time spent replaying the log.
+    MonoDelta log_replay;
+  };
+  PhaseTimings timings_;
+
   // Snapshot of which stores were flushed prior to restart.
   FlushedStoresSnapshot flushed_stores_;
 
@@ -579,7 +616,9 @@ Status TabletBootstrap::RunBootstrap(shared_ptr<Tablet>* rebuilt_tablet,
   RETURN_NOT_OK(flushed_stores_.InitFrom(*tablet_meta_.get()));
 
   bool has_blocks;
+  MonoTime open_start = MonoTime::Now();
   RETURN_NOT_OK(OpenTablet(&has_blocks));
+  timings_.open_tablet = MonoTime::Now() - open_start;
 
   bool needs_recovery;
   RETURN_NOT_OK(PrepareRecoveryDir(&needs_recovery));
@@ -621,6 +660,14 @@ Status TabletBootstrap::FinishBootstrap(const string& message,
                                       scoped_refptr<log::Log>* rebuilt_log,
                                       shared_ptr<Tablet>* rebuilt_tablet) {
   RETURN_NOT_OK(tablet_->MarkFinishedBootstrapping());
+  TabletMetrics* metrics = tablet_->metrics();
+  if (metrics) {
+    metrics->bootstrap_open_tablet_duration->set_value(timings_.open_tablet.ToMilliseconds());
+    metrics->bootstrap_log_read_duration->set_value(timings_.log_read.ToMilliseconds());
+    metrics->bootstrap_log_read_wait_duration->set_value(timings_.log_read_wait.ToMilliseconds());
+    metrics->bootstrap_log_replay_duration->set_value(timings_.log_replay.ToMilliseconds());
+  }
+  LOG_WITH_PREFIX(INFO) << "Bootstrap phase timings: " << timings_.ToString();
   SetStatusMessage(message);
   rebuilt_tablet->reset(tablet_.release());
   rebuilt_log->swap(log_);
@@ -1154,6 +1201,138 @@ void TabletBootstrap::DumpReplayStateToLog(const ReplayState& state) {
   }
 }
 
+// Reads the entries of a sequence of log segments on a separate thread, so that
+// reading and decompressing the log overlaps with replaying it. Entries are
+// handed over in batches through a queue which is bounded by the amount of
+// segment data the queued entries were read from.
+class LogReadAhead {
+ public:
+  // A run of consecutive entries read from a single segment.
+  struct Batch {
+    Batch()
+      : segment_idx(0),
+        offset(0),
+        read_up_to_offset(0),
+        bytes(0),
+        end_of_segment(false) {
+    }
+
+    // Index of the segment in the sequence being read.
+    int segment_idx;
+    vector<unique_ptr<LogEntryPB>> entries;
+    // The segment reader's offsets once 'entries' had been read.
+    int64_t offset;
+    int64_t read_up_to_offset;
+    // Number of segment bytes 'entries' were read from.
+    int64_t bytes;
+    // Whether this is the last batch read from the segment.
+    bool end_of_segment;
+    // Set if reading the segment failed after 'entries'. No batches follow a
+    // failed one.
+    Status status;
+  };
+
+  LogReadAhead(log::SegmentSequence segments, size_t max_buffered_bytes)
+      : segments_(std::move(segments)),
+        queue_(max_buffered_bytes),
+        read_nanos_(0) {
+  }
+
+  ~LogReadAhead() {
+    queue_.Shutdown();
+    if (thread_) {
+      thread_->Join();
+    }
+    Batch* batch;
+    while (queue_.BlockingGet(&batch)) {
+      delete batch;
+    }
+  }
+
+  Status Start() {
+    return Thread::Create("tablet", "bootstrap-log-reader",
+                          &LogReadAhead::ReadThread, this, &thread_);
+  }
+
+  // Waits for the next batch to be read. Returns false once every segment
+  // has been read.
+  bool NextBatch(unique_ptr<Batch>* batch) {
+    Batch* b;
+    if (!queue_.BlockingGet(&b)) {
+      return false;
+    }
+    batch->reset(b);
+    return true;
+  }
+
+  // The time spent reading segments, not counting the time spent waiting for
+  // room in the queue. Only valid once NextBatch() has returned false.
+  MonoDelta read_time() const {
+    return MonoDelta::FromNanoseconds(read_nanos_);
+  }
+
+ private:
+  // Segment data read into a single batch before handing it to replay.
+  static const int64_t kBatchBytes = 1024 * 1024;
+
+  struct BatchLogicalSize {
+    static size_t logical_size(const Batch* batch) {
+      return batch->bytes;
+    }
+  };
+
+  void ReadThread() {
+    for (int i = 0; i < segments_.size(); i++) {
+      log::LogEntryReader reader(segments_[i].get());
+      bool segment_done = false;
+      while (!segment_done) {
+        MonoTime start = MonoTime::Now();
+        unique_ptr<Batch> batch(new Batch());
+        batch->segment_idx = i;
+        int64_t start_offset = reader.offset();
+        while (reader.offset() - start_offset < kBatchBytes) {
+          unique_ptr<LogEntryPB> entry;
+          Status s = reader.ReadNextEntry(&entry);
+          if (PREDICT_FALSE(!s.ok())) {
+            if (!s.IsEndOfFile()) {
+              batch->status = s;
+            }
+            batch->end_of_segment = true;
+            segment_done = true;
+            break;
+          }
+          batch->entries.emplace_back(std::move(entry));
+        }
+        batch->offset = reader.offset();
+        batch->read_up_to_offset = reader.read_up_to_offset();
+        batch->bytes = reader.offset() - start_offset;
+        read_nanos_ += (MonoTime::Now() - start).ToNanoseconds();
+
+        bool failed = !batch->status.ok();
+        if (!queue_.BlockingPut(batch.get())) {
+          // Replay was aborted.
+          return;
+        }
+        ignore_result(batch.release());
+        if (failed) {
+          queue_.Shutdown();
+          return;
+        }
+      }
+    }
+    queue_.Shutdown();
+  }
+
+  const log::SegmentSequence segments_;
+  BlockingQueue<Batch*, BatchLogicalSize> queue_;
+  scoped_refptr<Thread> thread_;
+
+  // Written only by the reader thread.
+  int64_t read_nanos_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogReadAhead);
+};
+
 Status TabletBootstrap::PlaySegments(const IOContext* io_context,
                                      ConsensusBootstrapInfo* consensus_info) {
   ReplayState state;
@@ -1182,39 +1361,36 @@ Status TabletBootstrap::PlaySegments(const IOContext* io_context,
   auto last_status_update = MonoTime::Now();
   const auto kStatusUpdateInterval = MonoDelta::FromSeconds(5);
   int segment_count = 0;
+  int entry_count = 0;
+
+  const MonoTime replay_start = MonoTime::Now();
+  int64_t read_wait_nanos = 0;
+  // Always allow at least one batch to be read ahead.
+  LogReadAhead read_ahead(
+      segments, std::max<int64_t>(FLAGS_tablet_bootstrap_log_readahead_mb * 1024L * 1024L, 1));
+  RETURN_NOT_OK_PREPEND(read_ahead.Start(), "Failed to start log reader thread");
+
+  while (true) {
+    unique_ptr<LogReadAhead::Batch> batch;
+    MonoTime wait_start = MonoTime::Now();
+    bool got_batch = read_ahead.NextBatch(&batch);
+    read_wait_nanos += (MonoTime::Now() - wait_start).ToNanoseconds();
+    if (!got_batch) {
+      break;
+    }
+    const scoped_refptr<ReadableLogSegment>& segment = segments[batch->segment_idx];
 
-  for (const scoped_refptr<ReadableLogSegment>& segment : segments) {
-    log::LogEntryReader reader(segment.get());
+    for (unique_ptr<LogEntryPB>& entry : batch->entries) {
+      entry_count++;
 
-    int entry_count = 0;
-    while (true) {
-      {
-        unique_ptr<LogEntryPB> entry;
-        Status s = reader.ReadNextEntry(&entry);
-        if (PREDICT_FALSE(!s.ok())) {
-          if (s.IsEndOfFile()) {
-            break;
-          }
-          return Status::Corruption(
-              Substitute("Error reading Log Segment of tablet $0: $1 "
-                         "(Read up to entry $2 of segment $3, in path $4)",
-                         tablet_->tablet_id(),
-                         s.ToString(),
-                         entry_count,
-                         segment->header().sequence_number(),
-                         segment->path()));
-        }
-        entry_count++;
-
-        string entry_debug_info;
-        s = HandleEntry(io_context, &state, std::move(entry), &entry_debug_info);
-        if (!s.ok()) {
-          DumpReplayStateToLog(state);
-          RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
-                                             segment->header().sequence_number(),
-                                             entry_count, segment->path(),
-                                             entry_debug_info));
-        }
+      string entry_debug_info;
+      Status s = HandleEntry(io_context, &state, std::move(entry), &entry_debug_info);
+      if (!s.ok()) {
+        DumpReplayStateToLog(state);
+        RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
+                                           segment->header().sequence_number(),
+                                           entry_count, segment->path(),
+                                           entry_debug_info));
       }
 
       const auto now = MonoTime::Now();
@@ -1222,20 +1398,37 @@ Status TabletBootstrap::PlaySegments(const IOContext* io_context,
         SetStatusMessage(Substitute("Bootstrap replaying log segment $0/$1 "
                                     "($2/$3 this segment, stats: $4)",
                                     segment_count + 1, log_reader_->num_segments(),
-                                    HumanReadableNumBytes::ToString(reader.offset()),
-                                    HumanReadableNumBytes::ToString(reader.read_up_to_offset()),
+                                    HumanReadableNumBytes::ToString(batch->offset),
+                                    HumanReadableNumBytes::ToString(batch->read_up_to_offset),
                                     stats_.ToString()));
         last_status_update = now;
       }
     }
 
-    SetStatusMessage(Substitute("Bootstrap replayed $0/$1 log segments. "
-                                "Stats: $2. Pending: $3 replicates",
-                                segment_count + 1, log_reader_->num_segments(),
-                                stats_.ToString(),
-                                state.pending_replicates.size()));
-    segment_count++;
+    if (PREDICT_FALSE(!batch->status.ok())) {
+      return Status::Corruption(
+          Substitute("Error reading Log Segment of tablet $0: $1 "
+                     "(Read up to entry $2 of segment $3, in path $4)",
+                     tablet_->tablet_id(),
+                     batch->status.ToString(),
+                     entry_count,
+                     segment->header().sequence_number(),
+                     segment->path()));
+    }
+
+    if (batch->end_of_segment) {
+      SetStatusMessage(Substitute("Bootstrap replayed $0/$1 log segments. "
+                                  "Stats: $2. Pending: $3 replicates",
+                                  segment_count + 1, log_reader_->num_segments(),
+                                  stats_.ToString(),
+                                  state.pending_replicates.size()));
+      segment_count++;
+      entry_count = 0;
+    }
   }
+  timings_.log_read = read_ahead.read_time();
+  timings_.log_read_wait = MonoDelta::FromNanoseconds(read_wait_nanos);
+  timings_.log_replay = MonoTime::Now() - replay_start;
 
   // If we have non-applied commits they all must belong to pending operations and
   // they should only pertain to stores which are still active.
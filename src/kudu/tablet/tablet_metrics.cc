@@ -250,6 +250,28 @@ METRIC_DEFINE_histogram(tablet, undo_delta_block_gc_perform_duration,
   kudu::MetricUnit::kMilliseconds,
   "Time spent running the maintenance operation to GC ancient UNDO delta blocks.", 60000LU, 1);
 
+METRIC_DEFINE_gauge_int64(tablet, bootstrap_open_tablet_duration,
+  "Bootstrap Open Tablet Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Time spent opening the tablet's on-disk data during its last bootstrap.");
+
+METRIC_DEFINE_gauge_int64(tablet, bootstrap_log_read_duration,
+  "Bootstrap Log Read Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Time spent reading and decoding WAL segments during the tablet's last "
+  "bootstrap. Reading runs ahead of replay on a separate thread.");
+
+METRIC_DEFINE_gauge_int64(tablet, bootstrap_log_read_wait_duration,
+  "Bootstrap Log Read Wait Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Time log replay spent waiting for WAL entries to be read during the "
+  "tablet's last bootstrap. A high value means replay was bound by WAL reads.");
+
+METRIC_DEFINE_gauge_int64(tablet, bootstrap_log_replay_duration,
+  "Bootstrap Log Replay Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Total time spent replaying the WAL during the tablet's last bootstrap.");
+
 METRIC_DEFINE_counter(tablet, leader_memory_pressure_rejections,
   "Leader Memory Pressure Rejections",
   kudu::MetricUnit::kRequests,
@@ -307,6 +329,10 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(undo_delta_block_gc_init_duration),
     MINIT(undo_delta_block_gc_delete_duration),
     MINIT(undo_delta_block_gc_perform_duration),
+    GINIT(bootstrap_open_tablet_duration),
+    GINIT(bootstrap_log_read_duration),
+    GINIT(bootstrap_log_read_wait_duration),
+    GINIT(bootstrap_log_replay_duration),
     MINIT(leader_memory_pressure_rejections) {
 }
 #undef MINIT
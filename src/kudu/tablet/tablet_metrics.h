@@ -97,6 +97,12 @@ struct TabletMetrics {
   scoped_refptr<Histogram> undo_delta_block_gc_delete_duration;
   scoped_refptr<Histogram> undo_delta_block_gc_perform_duration;
 
+  // Phase timings of the tablet's last bootstrap.
+  scoped_refptr<AtomicGauge<int64_t> > bootstrap_open_tablet_duration;
+  scoped_refptr<AtomicGauge<int64_t> > bootstrap_log_read_duration;
+  scoped_refptr<AtomicGauge<int64_t> > bootstrap_log_read_wait_duration;
+  scoped_refptr<AtomicGauge<int64_t> > bootstrap_log_replay_duration;
+
   scoped_refptr<Counter> leader_memory_pressure_rejections;
 };
 
@@ -591,6 +591,12 @@ TEST_F(TabletReplicaTest, TestFlushOpsPerfImprovements) {
   ASSERT_NEAR(stats.perf_improvement(), 64, 0.01);
   stats.Clear();
 
+  // Same, but the flush is expected to run with 4 threads.
+  stats.set_ram_anchored(128 * 1024 * 1024);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 1, 4);
+  ASSERT_NEAR(stats.perf_improvement(), 4 * 64, 0.01);
+  stats.Clear();
+
   // Below the threshold but have been there a long time, closing in to 1.0.
   stats.set_ram_anchored(30 * 1024 * 1024);
   FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 60 * 50 * 1000);
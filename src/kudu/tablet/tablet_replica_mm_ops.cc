@@ -92,7 +92,8 @@ const double kFlushUpperBoundMs = 60 * 60 * 1000;
 //
 
 void FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(MaintenanceOpStats* stats,
-                                                              double elapsed_ms) {
+                                                              double elapsed_ms,
+                                                              int parallelism) {
   double anchored_mb = static_cast<double>(stats->ram_anchored()) / (1024 * 1024);
   if (anchored_mb > FLAGS_flush_threshold_mb) {
     // If we're over the user-specified flush threshold, then consider the perf
@@ -103,7 +104,8 @@ void FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(MaintenanceOpStats
     // heuristics, it will do for now.
     double extra_mb = anchored_mb - static_cast<double>(FLAGS_flush_threshold_mb);
     DCHECK_GE(extra_mb, 0);
-    stats->set_perf_improvement(extra_mb);
+    DCHECK_GE(parallelism, 1);
+    stats->set_perf_improvement(extra_mb * parallelism);
   } else if (elapsed_ms > FLAGS_flush_threshold_secs * 1000) {
     // Even if we aren't over the threshold, consider flushing if we haven't flushed
     // in a long time. But, don't give it a large perf_improvement score. We should
@@ -152,7 +154,8 @@ void FlushMRSOp::UpdateStats(MaintenanceOpStats* stats) {
   // been in the last 5 minutes.
   FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(
       stats,
-      time_since_flush_.elapsed().wall_millis());
+      time_since_flush_.elapsed().wall_millis(),
+      tablet_replica_->tablet()->MemRowSetFlushParallelism());
 }
 
 bool FlushMRSOp::Prepare() {
@@ -41,7 +41,12 @@ class FlushOpPerfImprovementPolicy {
 
   // Sets the performance improvement based on the anchored ram if it's over the threshold,
   // else it will set it based on how long it has been since the last flush.
-  static void SetPerfImprovementForFlush(MaintenanceOpStats* stats, double elapsed_ms);
+  //
+  // 'parallelism' is the number of threads the flush is expected to run with. Since a
+  // flush with more threads releases its memory sooner, the improvement from flushing
+  // anchored ram over the threshold is scaled by it.
+  static void SetPerfImprovementForFlush(MaintenanceOpStats* stats, double elapsed_ms,
+                                         int parallelism = 1);
 
  private:
   FlushOpPerfImprovementPolicy() {}
@@ -30,6 +30,7 @@
 #include <gtest/gtest_prod.h>
 
 #include "kudu/common/iterator_stats.h"
+#include "kudu/common/scan_aggregator.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
@@ -279,6 +280,16 @@ class Scanner {
   // See the note about 'set_client_projection_schema' above.
   const Schema* client_projection_schema() const { return client_projection_schema_.get(); }
 
+  // Associate the aggregates requested by the client with the Scanner. When
+  // set, row blocks are folded into the aggregator instead of being returned
+  // to the client.
+  void set_aggregator(std::unique_ptr<ScanAggregator> aggregator) {
+    aggregator_ = std::move(aggregator);
+  }
+
+  // Returns the aggregator, or nullptr if the scan has no aggregates.
+  ScanAggregator* aggregator() const { return aggregator_.get(); }
+
   // Get per-column stats for each iterator.
   void GetIteratorStats(std::vector<IteratorStats>* stats) const;
 
@@ -354,6 +365,9 @@ class Scanner {
   // schema used by the iterator.
   gscoped_ptr<Schema> client_projection_schema_;
 
+  // The aggregates requested by the client, if any.
+  std::unique_ptr<ScanAggregator> aggregator_;
+
   gscoped_ptr<RowwiseIterator> iter_;
 
   AutoReleasePool autorelease_pool_;
@@ -25,6 +25,7 @@
 #include <glog/logging.h>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_cache_warmer.h"
 #include "kudu/fs/error_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/bind.h"
@@ -101,6 +102,13 @@ Status TabletServer::Init() {
   RETURN_NOT_OK_PREPEND(tablet_manager_->Init(),
                         "Could not init Tablet Manager");
 
+  // Warm up the block cache while the tablets are bootstrapping.
+  if (FLAGS_block_cache_warmup) {
+    block_cache_warmer_.reset(new cfile::BlockCacheWarmer(fs_manager_.get(), metric_entity()));
+    RETURN_NOT_OK_PREPEND(block_cache_warmer_->Start(),
+                          "Could not start the block cache warmer");
+  }
+
   RETURN_NOT_OK_PREPEND(scanner_manager_->StartRemovalThread(),
                         "Could not start expired Scanner removal thread");
 
@@ -153,6 +161,9 @@ void TabletServer::Shutdown() {
     WARN_NOT_OK(heartbeater_->Stop(), "Failed to stop TS Heartbeat thread");
     fs_manager_->UnsetErrorNotificationCb(ErrorHandlerType::DISK_ERROR);
     fs_manager_->UnsetErrorNotificationCb(ErrorHandlerType::CFILE_CORRUPTION);
+    if (block_cache_warmer_) {
+      block_cache_warmer_->Shutdown();
+    }
     tablet_manager_->Shutdown();
 
     // 3. Shut down generic subsystems.
@@ -32,6 +32,10 @@ namespace kudu {
 
 class MaintenanceManager;
 
+namespace cfile {
+class BlockCacheWarmer;
+} // namespace cfile
+
 namespace tserver {
 
 class Heartbeater;
@@ -112,6 +116,10 @@ class TabletServer : public kserver::KuduServer {
   // The maintenance manager for this tablet server
   std::shared_ptr<MaintenanceManager> maintenance_manager_;
 
+  // Warms up the block cache after a restart. Null unless
+  // --block_cache_warmup is set.
+  gscoped_ptr<cfile::BlockCacheWarmer> block_cache_warmer_;
+
   DISALLOW_COPY_AND_ASSIGN(TabletServer);
 };
 
@@ -44,6 +44,7 @@
 #include "kudu/common/key_range.h"
 #include "kudu/common/partition.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/common/scan_aggregator.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
@@ -61,6 +62,7 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/result_tracker.h"
 #include "kudu/rpc/rpc_context.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_sidecar.h"
@@ -82,6 +84,7 @@
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.pb.h"
 #include "kudu/tserver/tserver_service.pb.h"
+#include "kudu/util/atomic.h"
 #include "kudu/util/auto_release_pool.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/debug/trace_event.h"
@@ -132,6 +135,13 @@ DEFINE_int32(scanner_inject_latency_on_each_batch_ms, 0,
              "Used for tests.");
 TAG_FLAG(scanner_inject_latency_on_each_batch_ms, unsafe);
 
+DEFINE_bool(multi_write_inject_response_failure, false,
+            "If set, MultiWrite RPCs fail once all of their write batches are done, "
+            "as if their responses were lost. Used for tests.");
+TAG_FLAG(multi_write_inject_response_failure, hidden);
+TAG_FLAG(multi_write_inject_response_failure, unsafe);
+TAG_FLAG(multi_write_inject_response_failure, runtime);
+
 DECLARE_bool(raft_prepare_replacement_before_eviction);
 DECLARE_int32(memory_limit_warn_threshold_percentage);
 DECLARE_int32(tablet_history_max_age_sec);
@@ -209,24 +219,34 @@ bool LookupTabletReplicaOrRespond(TabletReplicaLookupIf* tablet_manager,
   return true;
 }
 
-template<class RespClass>
-void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+// Returns the error to report for a request to a replica which is in state
+// 'tablet_state' rather than RUNNING, and sets 'error_code' accordingly.
+Status TabletNotRunningError(const scoped_refptr<TabletReplica>& replica,
                              tablet::TabletStatePB tablet_state,
-                             RespClass* resp,
-                             rpc::RpcContext* context) {
+                             TabletServerErrorPB::Code* error_code) {
   Status s = Status::IllegalState("Tablet not RUNNING",
                                   tablet::TabletStatePB_Name(tablet_state));
-  auto error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
+  *error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
   if (replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_TOMBSTONED ||
       replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_DELETED) {
     // Treat tombstoned tablets as if they don't exist for most purposes.
     // This takes precedence over failed, since we don't reset the failed
     // status of a TabletReplica when deleting it. Only tablet copy does that.
-    error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
+    *error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
   } else if (tablet_state == tablet::FAILED) {
     s = s.CloneAndAppend(replica->error().ToString());
-    error_code = TabletServerErrorPB::TABLET_FAILED;
+    *error_code = TabletServerErrorPB::TABLET_FAILED;
   }
+  return s;
+}
+
+template<class RespClass>
+void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+                             tablet::TabletStatePB tablet_state,
+                             RespClass* resp,
+                             rpc::RpcContext* context) {
+  TabletServerErrorPB::Code error_code;
+  Status s = TabletNotRunningError(replica, tablet_state, &error_code);
   SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
 }
 
@@ -414,6 +434,74 @@ class RpcTransactionCompletionCallback : public TransactionCompletionCallback {
   tablet::TransactionState* state_;
 };
 
+// Responds to a MultiWrite RPC once all of its write batches are done.
+//
+// Expects one call to BatchDone() per batch, plus one more once all of the
+// batches have been dispatched, so that the RPC isn't responded to while
+// batches are still being submitted. Deletes itself on the last call.
+class MultiWriteCompletion {
+ public:
+  MultiWriteCompletion(rpc::RpcContext* context, int num_batches)
+      : context_(context),
+        pending_(num_batches + 1) {
+  }
+
+  void BatchDone() {
+    if (pending_.IncrementBy(-1) == 0) {
+      if (PREDICT_FALSE(FLAGS_multi_write_inject_response_failure)) {
+        context_->RespondFailure(
+            Status::ServiceUnavailable("Injected MultiWrite response failure"));
+      } else {
+        context_->RespondSuccess();
+      }
+      delete this;
+    }
+  }
+
+ private:
+  rpc::RpcContext* const context_;
+  AtomicInt<int32_t> pending_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiWriteCompletion);
+};
+
+// A transaction completion callback for one batch of a MultiWrite RPC.
+//
+// If the batch carries a request id, its result is recorded with the result
+// tracker the same way RpcContext records the result of a Write RPC, so that
+// a retry of the batch as a Write RPC gets the same response.
+class MultiWriteBatchCompletionCallback : public TransactionCompletionCallback {
+ public:
+  MultiWriteBatchCompletionCallback(MultiWriteCompletion* completion,
+                                    WriteResponsePB* response,
+                                    const rpc::RequestIdPB* request_id,
+                                    scoped_refptr<rpc::ResultTracker> result_tracker)
+      : completion_(completion),
+        response_(response),
+        request_id_(request_id),
+        result_tracker_(std::move(result_tracker)) {
+  }
+
+  virtual void TransactionCompleted() OVERRIDE {
+    if (!status_.ok()) {
+      StatusToPB(status_, response_->mutable_error()->mutable_status());
+      response_->mutable_error()->set_code(code_);
+      if (request_id_) {
+        result_tracker_->FailAndRespond(*request_id_, response_);
+      }
+    } else if (request_id_) {
+      result_tracker_->RecordCompletionAndRespond(*request_id_, response_);
+    }
+    completion_->BatchDone();
+  }
+
+ private:
+  MultiWriteCompletion* const completion_;
+  WriteResponsePB* const response_;
+  const rpc::RequestIdPB* const request_id_;
+  const scoped_refptr<rpc::ResultTracker> result_tracker_;
+};
+
 // Generic interface to handle scan results.
 class ScanResultCollector {
  public:
@@ -460,7 +548,8 @@ void SetLastRow(const RowBlock& row_block, faststring* last_primary_key) {
 
 }  // namespace
 
-// Copies the scan result to the given row block PB and data buffers.
+// Copies the scan result into buffers which are returned to the client as
+// RPC sidecars.
 //
 // This implementation is used in the common case where a client is running
 // a scan and the data needs to be returned to the client.
@@ -468,16 +557,16 @@ void SetLastRow(const RowBlock& row_block, faststring* last_primary_key) {
 // (This is in contrast to some other ScanResultCollector implementation that
 // might do an aggregation or gather some other types of statistics via a
 // server-side scan and thus never need to return the actual data.)
+//
+// Depending on the row format flags, rows are either serialized row by row
+// (see SerializeRowBlock()) or column by column (see SerializeRowBlockColumnar()).
 class ScanResultCopier : public ScanResultCollector {
  public:
-  ScanResultCopier(RowwiseRowBlockPB* rowblock_pb,
-                   faststring* rows_data,
-                   faststring* indirect_data)
-      : rowblock_pb_(DCHECK_NOTNULL(rowblock_pb)),
-        rows_data_(DCHECK_NOTNULL(rows_data)),
-        indirect_data_(DCHECK_NOTNULL(indirect_data)),
+  explicit ScanResultCopier(size_t batch_size_bytes)
+      : batch_size_bytes_(batch_size_bytes),
         num_rows_returned_(0),
-        pad_unixtime_micros_to_16_bytes_(false) {}
+        pad_unixtime_micros_to_16_bytes_(false),
+        columnar_layout_(false) {}
 
   void HandleRowBlock(Scanner* scanner, const RowBlock& row_block) override {
     int64_t num_selected = row_block.selection_vector()->CountSelected();
@@ -487,14 +576,34 @@ class ScanResultCopier : public ScanResultCollector {
 
     num_rows_returned_ += num_selected;
     scanner->add_num_rows_returned(num_selected);
-    SerializeRowBlock(row_block, rowblock_pb_, scanner->client_projection_schema(),
-                      rows_data_, indirect_data_, pad_unixtime_micros_to_16_bytes_);
+    if (columnar_layout_) {
+      SerializeRowBlockColumnar(row_block, scanner->client_projection_schema(),
+                                &columnar_data_);
+    } else {
+      AllocateRowwiseBuffersIfNeeded();
+      SerializeRowBlock(row_block, &rowblock_pb_, scanner->client_projection_schema(),
+                        rows_data_.get(), indirect_data_.get(),
+                        pad_unixtime_micros_to_16_bytes_);
+    }
     SetLastRow(row_block, &last_primary_key_);
   }
 
   // Returns number of bytes buffered to return.
   int64_t ResponseSize() const override {
-    return rows_data_->size() + indirect_data_->size();
+    if (!columnar_layout_) {
+      return rows_data_ ? rows_data_->size() + indirect_data_->size() : 0;
+    }
+    int64_t size = 0;
+    for (const auto& col : columnar_data_.columns) {
+      size += col.data->size();
+      if (col.varlen_data) {
+        size += col.varlen_data->size();
+      }
+      if (col.non_null_bitmap) {
+        size += col.non_null_bitmap->size();
+      }
+    }
+    return size;
   }
 
   const faststring& last_primary_key() const override {
@@ -509,15 +618,82 @@ class ScanResultCopier : public ScanResultCollector {
     if (row_format_flags & RowFormatFlags::PAD_UNIX_TIME_MICROS_TO_16_BYTES) {
       pad_unixtime_micros_to_16_bytes_ = true;
     }
+    if (row_format_flags & RowFormatFlags::COLUMNAR_LAYOUT) {
+      columnar_layout_ = true;
+    }
+  }
+
+  // Moves the buffered results into sidecars of 'context', and points the
+  // data fields of 'resp' at them.
+  void SetupResponse(rpc::RpcContext* context, ScanResponsePB* resp) {
+    if (columnar_layout_) {
+      // If no rows were serialized, no columns were created either: leave the
+      // data out of the response, as a client expects either none or all of
+      // the projected columns. An empty projection has no columns either way,
+      // but its number of rows must still be sent.
+      if (columnar_data_.num_rows == 0) {
+        return;
+      }
+      ColumnarRowBlockPB* data = resp->mutable_columnar_data();
+      data->set_num_rows(columnar_data_.num_rows);
+      for (auto& col : columnar_data_.columns) {
+        ColumnarRowBlockPB::Column* col_pb = data->add_columns();
+        int idx;
+        CHECK_OK(context->AddOutboundSidecar(
+            RpcSidecar::FromFaststring(std::move(col.data)), &idx));
+        col_pb->set_data_sidecar(idx);
+        if (col.varlen_data) {
+          CHECK_OK(context->AddOutboundSidecar(
+              RpcSidecar::FromFaststring(std::move(col.varlen_data)), &idx));
+          col_pb->set_varlen_data_sidecar(idx);
+        }
+        if (col.non_null_bitmap) {
+          CHECK_OK(context->AddOutboundSidecar(
+              RpcSidecar::FromFaststring(std::move(col.non_null_bitmap)), &idx));
+          col_pb->set_non_null_bitmap_sidecar(idx);
+        }
+      }
+      return;
+    }
+
+    AllocateRowwiseBuffersIfNeeded();
+    resp->mutable_data()->CopyFrom(rowblock_pb_);
+
+    // Add sidecar data to context and record the returned indices.
+    int rows_idx;
+    CHECK_OK(context->AddOutboundSidecar(
+        RpcSidecar::FromFaststring((std::move(rows_data_))), &rows_idx));
+    resp->mutable_data()->set_rows_sidecar(rows_idx);
+
+    // Add indirect data as a sidecar, if applicable.
+    if (indirect_data_->size() > 0) {
+      int indirect_idx;
+      CHECK_OK(context->AddOutboundSidecar(
+          RpcSidecar::FromFaststring(std::move(indirect_data_)), &indirect_idx));
+      resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
+    }
   }
 
  private:
-  RowwiseRowBlockPB* const rowblock_pb_;
-  faststring* const rows_data_;
-  faststring* const indirect_data_;
+  // The row-wise buffers are only allocated when needed, so as not to waste
+  // them on columnar scans.
+  void AllocateRowwiseBuffersIfNeeded() {
+    DCHECK(!columnar_layout_);
+    if (!rows_data_) {
+      rows_data_.reset(new faststring(batch_size_bytes_ * 11 / 10));
+      indirect_data_.reset(new faststring(batch_size_bytes_ * 11 / 10));
+    }
+  }
+
+  const size_t batch_size_bytes_;
+  RowwiseRowBlockPB rowblock_pb_;
+  unique_ptr<faststring> rows_data_;
+  unique_ptr<faststring> indirect_data_;
+  ColumnarSerializedBatch columnar_data_;
   int64_t num_rows_returned_;
   faststring last_primary_key_;
   bool pad_unixtime_micros_to_16_bytes_;
+  bool columnar_layout_;
 
   DISALLOW_COPY_AND_ASSIGN(ScanResultCopier);
 };
@@ -604,6 +780,59 @@ class ScanResultChecksummer : public ScanResultCollector {
   DISALLOW_COPY_AND_ASSIGN(ScanResultChecksummer);
 };
 
+namespace {
+
+// Passes the partial aggregates of 'scanner' to 'result_collector' as a
+// single row.
+void CollectAggregates(Scanner* scanner, ScanResultCollector* result_collector) {
+  const ScanAggregator* aggregator = DCHECK_NOTNULL(scanner->aggregator());
+  result_collector->set_row_format_flags(scanner->row_format_flags());
+  Arena arena(1024);
+  RowBlock block(aggregator->result_schema(), 1, &arena);
+  aggregator->Finish(&block);
+  result_collector->HandleRowBlock(scanner, block);
+}
+
+// Evaluates the aggregates of 'scanner' from the metadata of 'tablet', without
+// reading any data blocks, if the scan covers the whole tablet and the
+// aggregates only need the number of rows and the bounds of the primary key.
+// Sets 'evaluated' to whether that was possible.
+Status AggregateFromMetadata(const Tablet& tablet, const ScanSpec& spec,
+                             Scanner* scanner, bool* evaluated) {
+  *evaluated = false;
+  const Schema& schema = *tablet.schema();
+  ScanAggregator* aggregator = scanner->aggregator();
+  if (!spec.predicates().empty() || spec.lower_bound_key() ||
+      spec.exclusive_upper_bound_key() || !aggregator->CanUseKeyBounds(schema)) {
+    return Status::OK();
+  }
+
+  bool summarized;
+  uint64_t num_rows;
+  string min_key;
+  string max_key;
+  RETURN_NOT_OK(tablet.SummarizeFromMetadata(&summarized, &num_rows, &min_key, &max_key));
+  if (!summarized) {
+    return Status::OK();
+  }
+  if (num_rows == 0) {
+    aggregator->AddKeyBounds(0, nullptr, nullptr);
+  } else {
+    Arena arena(1024);
+    gscoped_ptr<EncodedKey> min_encoded_key;
+    gscoped_ptr<EncodedKey> max_encoded_key;
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(schema, &arena, min_key, &min_encoded_key));
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(schema, &arena, max_key, &max_encoded_key));
+    aggregator->AddKeyBounds(num_rows,
+                             min_encoded_key->raw_keys()[0],
+                             max_encoded_key->raw_keys()[0]);
+  }
+  *evaluated = true;
+  return Status::OK();
+}
+
+} // anonymous namespace
+
 // Return the batch size to use for a given request, after clamping
 // the user-requested request within the server-side allowable range.
 // This is only a hint, really more of a threshold since returned bytes
@@ -828,28 +1057,94 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
                "tablet_id", req->tablet_id());
   DVLOG(3) << "Received Write RPC: " << SecureDebugString(*req);
 
-  scoped_refptr<TabletReplica> replica;
-  if (!LookupRunningTabletReplicaOrRespond(server_->tablet_manager(), req->tablet_id(), resp,
-                                           context, &replica)) {
-    return;
-  }
-
-  shared_ptr<Tablet> tablet;
   TabletServerErrorPB::Code error_code;
-  Status s = GetTabletRef(replica, &tablet, &error_code);
+  Status s = SubmitWrite(
+      req, resp, context->AreResultsTracked() ? context->request_id() : nullptr,
+      gscoped_ptr<TransactionCompletionCallback>(
+          new RpcTransactionCompletionCallback<WriteResponsePB>(context, resp)),
+      &error_code);
   if (PREDICT_FALSE(!s.ok())) {
     SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
-    return;
   }
+}
+
+void TabletServiceImpl::MultiWrite(const MultiWriteRequestPB* req,
+                                   MultiWriteResponsePB* resp,
+                                   rpc::RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::MultiWrite",
+               "num_batches", req->writes_size());
+  DVLOG(3) << "Received MultiWrite RPC: " << SecureDebugString(*req);
+
+  // Set up all of the responses before submitting anything: the batches may
+  // complete concurrently, each filling in its own response.
+  for (int i = 0; i < req->writes_size(); i++) {
+    resp->add_responses();
+  }
+
+  const scoped_refptr<rpc::ResultTracker>& result_tracker = server_->result_tracker();
+  MultiWriteCompletion* completion = new MultiWriteCompletion(context, req->writes_size());
+  for (int i = 0; i < req->writes_size(); i++) {
+    const MultiWriteRequestPB::TabletWritePB& write = req->writes(i);
+    WriteResponsePB* write_resp = resp->mutable_responses(i);
+    const rpc::RequestIdPB* request_id = write.has_request_id() ? &write.request_id() : nullptr;
+
+    if (request_id) {
+      // Track the batch as if it were a Write RPC. If another attempt at it is
+      // in progress or has completed, have the client retry the batch on its
+      // own: the retry gets that attempt's response from the result tracker.
+      rpc::ResultTracker::RpcState state = result_tracker->TrackRpc(*request_id, nullptr, nullptr);
+      if (state != rpc::ResultTracker::RpcState::NEW) {
+        StatusToPB(Status::ServiceUnavailable("Write batch is already being tracked"),
+                   write_resp->mutable_error()->mutable_status());
+        write_resp->mutable_error()->set_code(TabletServerErrorPB::UNKNOWN_ERROR);
+        completion->BatchDone();
+        continue;
+      }
+    }
+
+    TabletServerErrorPB::Code error_code;
+    Status s = SubmitWrite(
+        &write.request(), write_resp, request_id,
+        gscoped_ptr<TransactionCompletionCallback>(
+            new MultiWriteBatchCompletionCallback(completion, write_resp,
+                                                  request_id, result_tracker)),
+        &error_code);
+    if (PREDICT_FALSE(!s.ok())) {
+      StatusToPB(s, write_resp->mutable_error()->mutable_status());
+      write_resp->mutable_error()->set_code(error_code);
+      if (request_id) {
+        result_tracker->FailAndRespond(*request_id, write_resp);
+      }
+      completion->BatchDone();
+    }
+  }
+  completion->BatchDone();
+}
+
+Status TabletServiceImpl::SubmitWrite(const WriteRequestPB* req,
+                                      WriteResponsePB* resp,
+                                      const rpc::RequestIdPB* request_id,
+                                      gscoped_ptr<TransactionCompletionCallback> callback,
+                                      TabletServerErrorPB::Code* error_code) {
+  scoped_refptr<TabletReplica> replica;
+  Status s = server_->tablet_manager()->GetTabletReplica(req->tablet_id(), &replica);
+  if (PREDICT_FALSE(!s.ok())) {
+    *error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
+    return s;
+  }
+  tablet::TabletStatePB state = replica->state();
+  if (PREDICT_FALSE(state != tablet::RUNNING)) {
+    return TabletNotRunningError(replica, state, error_code);
+  }
+
+  shared_ptr<Tablet> tablet;
+  RETURN_NOT_OK(GetTabletRef(replica, &tablet, error_code));
 
   uint64_t bytes = req->row_operations().rows().size() +
       req->row_operations().indirect_data().size();
   if (!tablet->ShouldThrottleAllow(bytes)) {
-    SetupErrorAndRespond(resp->mutable_error(),
-                         Status::ServiceUnavailable("Rejecting Write request: throttled"),
-                         TabletServerErrorPB::THROTTLED,
-                         context);
-    return;
+    *error_code = TabletServerErrorPB::THROTTLED;
+    return Status::ServiceUnavailable("Rejecting Write request: throttled");
   }
 
   // Check for memory pressure; don't bother doing any additional work if we've
@@ -863,53 +1158,36 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
     } else {
       KLOG_EVERY_N_SECS(INFO, 1) << "Rejecting Write request: " << msg << THROTTLE_MSG;
     }
-    SetupErrorAndRespond(resp->mutable_error(), Status::ServiceUnavailable(msg),
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-    return;
+    *error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+    return Status::ServiceUnavailable(msg);
   }
 
+  // Any failure from here on is reported as an unknown error.
+  *error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+
   if (!server_->clock()->SupportsExternalConsistencyMode(req->external_consistency_mode())) {
-    Status s = Status::NotSupported("The configured clock does not support the"
+    return Status::NotSupported("The configured clock does not support the"
         " required consistency mode.");
-    SetupErrorAndRespond(resp->mutable_error(), s,
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-    return;
   }
 
   unique_ptr<WriteTransactionState> tx_state(new WriteTransactionState(
       replica.get(),
       req,
-      context->AreResultsTracked() ? context->request_id() : nullptr,
+      request_id,
       resp));
 
   // If the client sent us a timestamp, decode it and update the clock so that all future
   // timestamps are greater than the passed timestamp.
   if (req->has_propagated_timestamp()) {
     Timestamp ts(req->propagated_timestamp());
-    s = server_->clock()->Update(ts);
-  }
-  if (PREDICT_FALSE(!s.ok())) {
-    SetupErrorAndRespond(resp->mutable_error(), s,
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-    return;
+    RETURN_NOT_OK(server_->clock()->Update(ts));
   }
 
-  tx_state->set_completion_callback(gscoped_ptr<TransactionCompletionCallback>(
-      new RpcTransactionCompletionCallback<WriteResponsePB>(context,
-                                                            resp)));
-
-  // Submit the write. The RPC will be responded to asynchronously.
-  s = replica->SubmitWrite(std::move(tx_state));
+  tx_state->set_completion_callback(std::move(callback));
 
-  // Check that we could submit the write
-  if (PREDICT_FALSE(!s.ok())) {
-    SetupErrorAndRespond(resp->mutable_error(), s,
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-  }
+  // Submit the write. The completion callback is run once the write is done,
+  // unless submitting it fails.
+  return replica->SubmitWrite(std::move(tx_state));
 }
 
 ConsensusServiceImpl::ConsensusServiceImpl(ServerBase* server,
@@ -1300,10 +1578,7 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
   }
 
   size_t batch_size_bytes = GetMaxBatchSizeBytesHint(req);
-  unique_ptr<faststring> rows_data(new faststring(batch_size_bytes * 11 / 10));
-  unique_ptr<faststring> indirect_data(new faststring(batch_size_bytes * 11 / 10));
-  RowwiseRowBlockPB data;
-  ScanResultCopier collector(&data, rows_data.get(), indirect_data.get());
+  ScanResultCopier collector(batch_size_bytes);
 
   bool has_more_results = false;
   TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
@@ -1344,21 +1619,7 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
   }
   resp->set_has_more_results(has_more_results);
 
-  resp->mutable_data()->CopyFrom(data);
-
-  // Add sidecar data to context and record the returned indices.
-  int rows_idx;
-  CHECK_OK(context->AddOutboundSidecar(
-      RpcSidecar::FromFaststring((std::move(rows_data))), &rows_idx));
-  resp->mutable_data()->set_rows_sidecar(rows_idx);
-
-  // Add indirect data as a sidecar, if applicable.
-  if (indirect_data->size() > 0) {
-    int indirect_idx;
-    CHECK_OK(context->AddOutboundSidecar(
-        RpcSidecar::FromFaststring(std::move(indirect_data)), &indirect_idx));
-    resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
-  }
+  collector.SetupResponse(context, resp);
 
   // Set the last row found by the collector.
   //
@@ -1570,6 +1831,10 @@ bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
   switch (feature) {
     case TabletServerFeatures::COLUMN_PREDICATES:
     case TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES:
+    case TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE:
+    case TabletServerFeatures::SCAN_AGGREGATES:
+    case TabletServerFeatures::BLOOM_FILTER_PREDICATE:
+    case TabletServerFeatures::MULTI_WRITE:
       return true;
     default:
       return false;
@@ -1788,6 +2053,14 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
 
   const Schema& tablet_schema = replica->tablet_metadata()->schema();
 
+  if (PREDICT_FALSE((scan_pb.row_format_flags() & RowFormatFlags::COLUMNAR_LAYOUT) &&
+                    (scan_pb.row_format_flags() &
+                     RowFormatFlags::PAD_UNIX_TIME_MICROS_TO_16_BYTES))) {
+    *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+    return Status::InvalidArgument(
+        "COLUMNAR_LAYOUT can't be combined with PAD_UNIX_TIME_MICROS_TO_16_BYTES");
+  }
+
   SharedScanner scanner;
   server_->scanner_manager()->NewScanner(replica,
                                          rpc_context->requestor_string(),
@@ -1813,6 +2086,21 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
     return Status::InvalidArgument("User requests should not have Column IDs");
   }
 
+  if (scan_pb.aggregates_size() > 0) {
+    if (scan_pb.has_limit() || scan_pb.order_mode() == ORDERED) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return Status::InvalidArgument(
+          "Aggregates can't be combined with a limit or an ordered scan");
+    }
+    unique_ptr<ScanAggregator> aggregator;
+    s = ScanAggregator::Create(projection, scan_pb.aggregates(), &aggregator);
+    if (PREDICT_FALSE(!s.ok())) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return s;
+    }
+    scanner->set_aggregator(std::move(aggregator));
+  }
+
   if (scan_pb.order_mode() == ORDERED) {
     // Ordered scans must be at a snapshot so that we perform a serializable read (which can be
     // resumed). Otherwise, this would be read committed isolation, which is not resumable.
@@ -1841,11 +2129,16 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   if (spec->CanShortCircuit()) {
     VLOG(1) << "short-circuiting without creating a server-side scanner.";
     *has_more_results = false;
+    if (scanner->aggregator()) {
+      CollectAggregates(scanner.get(), result_collector);
+    }
     return Status::OK();
   }
 
-  // Store the original projection.
-  gscoped_ptr<Schema> orig_projection(new Schema(projection));
+  // Store the original projection or, if aggregating, the schema of the
+  // aggregates, which is what the client gets back.
+  gscoped_ptr<Schema> orig_projection(new Schema(
+      scanner->aggregator() ? scanner->aggregator()->result_schema() : projection));
   scanner->set_client_projection_schema(std::move(orig_projection));
 
   // Build a new projection with the projection columns and the missing columns. Make
@@ -1972,11 +2265,29 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
     return s;
   }
 
+  if (scanner->aggregator()) {
+    bool evaluated;
+    s = AggregateFromMetadata(*tablet, *orig_spec, scanner.get(), &evaluated);
+    if (PREDICT_FALSE(!s.ok())) {
+      *error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+      return s;
+    }
+    if (evaluated) {
+      TRACE("Evaluated aggregates from tablet metadata");
+      *has_more_results = false;
+      CollectAggregates(scanner.get(), result_collector);
+      return Status::OK();
+    }
+  }
+
   *has_more_results = iter->HasNext() && !scanner->has_fulfilled_limit();
   TRACE("has_more: $0", *has_more_results);
   if (!*has_more_results) {
     // If there are no more rows, we can short circuit some work and respond immediately.
     VLOG(1) << "No more rows, short-circuiting out without creating a server-side scanner.";
+    if (scanner->aggregator()) {
+      CollectAggregates(scanner.get(), result_collector);
+    }
     return Status::OK();
   }
 
@@ -2093,7 +2404,11 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
         DCHECK_GT(rows_left, 0);  // Guaranteed by has_fulfilled_limit()
         block.selection_vector()->ClearToSelectAtMost(static_cast<size_t>(rows_left));
       }
-      result_collector->HandleRowBlock(scanner.get(), block);
+      if (scanner->aggregator()) {
+        scanner->aggregator()->AddBlock(block);
+      } else {
+        result_collector->HandleRowBlock(scanner.get(), block);
+      }
     }
 
     int64_t response_size = result_collector->ResponseSize();
@@ -2114,6 +2429,11 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
     }
   }
 
+  // Once the whole tablet has been aggregated, return the aggregates.
+  if (scanner->aggregator() && !iter->HasNext()) {
+    CollectAggregates(scanner.get(), result_collector);
+  }
+
   scoped_refptr<TabletReplica> replica = scanner->tablet_replica();
   shared_ptr<Tablet> tablet;
   TabletServerErrorPB::Code tablet_ref_error_code;
@@ -70,12 +70,14 @@ class VoteResponsePB;
 } // namespace consensus
 
 namespace rpc {
+class RequestIdPB;
 class RpcContext;
 } // namespace rpc
 
 namespace tablet {
 class Tablet;
 class TabletReplica;
+class TransactionCompletionCallback;
 } // namespace tablet
 
 namespace tserver {
@@ -88,6 +90,8 @@ class CreateTabletRequestPB;
 class CreateTabletResponsePB;
 class DeleteTabletRequestPB;
 class DeleteTabletResponsePB;
+class MultiWriteRequestPB;
+class MultiWriteResponsePB;
 class ScanResultCollector;
 class TabletReplicaLookupIf;
 class TabletServer;
@@ -111,6 +115,10 @@ class TabletServiceImpl : public TabletServerServiceIf {
   virtual void Write(const WriteRequestPB* req, WriteResponsePB* resp,
                    rpc::RpcContext* context) OVERRIDE;
 
+  virtual void MultiWrite(const MultiWriteRequestPB* req,
+                          MultiWriteResponsePB* resp,
+                          rpc::RpcContext* context) OVERRIDE;
+
   virtual void Scan(const ScanRequestPB* req,
                     ScanResponsePB* resp,
                     rpc::RpcContext* context) OVERRIDE;
@@ -136,6 +144,18 @@ class TabletServiceImpl : public TabletServerServiceIf {
   virtual void Shutdown() OVERRIDE;
 
  private:
+  // Checks that the write in 'req' can be accepted and submits it to its
+  // tablet replica, tracking its result under 'request_id' if not null.
+  // 'callback' is run once the write completes, filling in 'resp'.
+  //
+  // If the write can't be submitted, returns the reason and sets 'error_code';
+  // 'callback' is not run in that case.
+  Status SubmitWrite(const WriteRequestPB* req,
+                     WriteResponsePB* resp,
+                     const rpc::RequestIdPB* request_id,
+                     gscoped_ptr<tablet::TransactionCompletionCallback> callback,
+                     TabletServerErrorPB::Code* error_code);
+
   Status HandleNewScanRequest(tablet::TabletReplica* tablet_replica,
                               const ScanRequestPB* req,
                               const rpc::RpcContext* rpc_context,
@@ -505,10 +505,12 @@ void IteratorStatsToJson(const ScanDescriptor& scan, EasyJson* json) {
     row["bytes_read"] = HumanReadableNumBytes::ToString(stats.bytes_read);
     row["cells_read"] = HumanReadableInt::ToString(stats.cells_read);
     row["blocks_read"] = HumanReadableInt::ToString(stats.blocks_read);
+    row["blocks_skipped"] = HumanReadableInt::ToString(stats.blocks_skipped);
 
     row["bytes_read_title"] = stats.bytes_read;
     row["cells_read_title"] = stats.cells_read;
     row["blocks_read_title"] = stats.blocks_read;
+    row["blocks_skipped_title"] = stats.blocks_skipped;
   };
 
   IteratorStats total_stats;
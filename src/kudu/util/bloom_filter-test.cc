@@ -89,4 +89,31 @@ TEST(TestBloomFilter, TestInsertAndProbe) {
   ASSERT_NEAR(fp_rate, expected_fp_rate, 0.20*expected_fp_rate);
 }
 
+TEST(TestBloomFilter, TestCacheBlockedInsertAndProbe) {
+  int n_keys = 2000;
+  BloomFilterBuilder bfb(BloomFilterSizing::ByCountAndFPRate(n_keys, 0.01),
+                         BloomFilterLayout::kCacheBlocked);
+  ASSERT_EQ(0, bfb.n_bytes() % BloomFilter::kBlockBytes);
+
+  AddRandomKeys(kRandomSeed, n_keys, &bfb);
+  BloomFilter bf(bfb.slice(), bfb.n_hashes(), BloomFilterLayout::kCacheBlocked);
+  CheckRandomKeys(kRandomSeed, n_keys, bf);
+
+  // Blocking the bits costs some accuracy, but the false positive rate should
+  // stay within a small factor of the classic layout's.
+  uint32_t num_queries = 100000;
+  uint32_t num_positives = 0;
+  for (int i = 0; i < num_queries; i++) {
+    uint64_t key = random();
+    Slice key_slice(reinterpret_cast<const uint8_t *>(&key), sizeof(key));
+    BloomKeyProbe probe(key_slice);
+    if (bf.MayContainKey(probe)) {
+      num_positives++;
+    }
+  }
+  double fp_rate = static_cast<double>(num_positives) / static_cast<double>(num_queries);
+  LOG(INFO) << "FP rate: " << fp_rate << " (" << num_positives << "/" << num_queries << ")";
+  ASSERT_LT(fp_rate, 2 * bfb.false_positive_rate());
+}
+
 } // namespace kudu
@@ -56,9 +56,21 @@ BloomFilterSizing BloomFilterSizing::BySizeAndFPRate(size_t n_bytes, double fp_r
 }
 
 
-BloomFilterBuilder::BloomFilterBuilder(const BloomFilterSizing &sizing)
-  : n_bits_(sizing.n_bytes() * 8),
-    bitmap_(new uint8_t[sizing.n_bytes()]),
+// Return the number of bytes of a filter of the given layout which needs
+// at least 'n_bytes' bytes.
+static size_t RoundUpBytes(size_t n_bytes, BloomFilterLayout layout) {
+  if (layout == BloomFilterLayout::kCacheBlocked) {
+    const size_t kBlock = BloomFilter::kBlockBytes;
+    return (n_bytes + kBlock - 1) / kBlock * kBlock;
+  }
+  return n_bytes;
+}
+
+BloomFilterBuilder::BloomFilterBuilder(const BloomFilterSizing &sizing,
+                                       BloomFilterLayout layout)
+  : layout_(layout),
+    n_bits_(RoundUpBytes(sizing.n_bytes(), layout) * 8),
+    bitmap_(new uint8_t[n_bits_ / 8]),
     n_hashes_(ComputeOptimalHashCount(n_bits_, sizing.expected_count())),
     expected_count_(sizing.expected_count()),
     n_inserted_(0) {
@@ -70,6 +82,14 @@ void BloomFilterBuilder::Clear() {
   n_inserted_ = 0;
 }
 
+void BloomFilterBuilder::CopyFrom(const BloomFilterBuilder &other) {
+  CHECK_EQ(n_bits_, other.n_bits_);
+  CHECK_EQ(n_hashes_, other.n_hashes_);
+  CHECK(layout_ == other.layout_);
+  memcpy(&bitmap_[0], &other.bitmap_[0], n_bytes());
+  n_inserted_ = other.n_inserted_;
+}
+
 double BloomFilterBuilder::false_positive_rate() const {
   CHECK_NE(expected_count_, 0)
     << "expected_count_ not initialized: can't call this function on "
@@ -78,11 +98,17 @@ double BloomFilterBuilder::false_positive_rate() const {
   return pow(1 - exp(-static_cast<double>(n_hashes_) * expected_count_ / n_bits_), n_hashes_);
 }
 
-BloomFilter::BloomFilter(const Slice &data, size_t n_hashes)
-  : n_bits_(data.size() * 8),
+const size_t BloomFilter::kBlockBytes;
+const uint32_t BloomFilter::kBlockBitMask;
+
+BloomFilter::BloomFilter(const Slice &data, size_t n_hashes, BloomFilterLayout layout)
+  : layout_(layout),
+    n_bits_(data.size() * 8),
     bitmap_(reinterpret_cast<const uint8_t *>(data.data())),
-    n_hashes_(n_hashes)
-{}
+    n_hashes_(n_hashes) {
+  DCHECK(layout != BloomFilterLayout::kCacheBlocked || data.size() % kBlockBytes == 0)
+    << "cache-blocked bloom filter of " << data.size() << " bytes";
+}
 
 
 
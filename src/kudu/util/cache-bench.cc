@@ -43,6 +43,8 @@
 
 DEFINE_int32(num_threads, 16, "The number of threads to access the cache concurrently.");
 DEFINE_int32(run_seconds, 1, "The number of seconds to run the benchmark");
+DEFINE_bool(sweep_threads, false, "Whether to run the benchmark with 1, 2, 4, etc. "
+            "threads, up to --num_threads, rather than only with --num_threads.");
 
 using std::atomic;
 using std::pair;
@@ -65,10 +67,16 @@ struct BenchSetup {
     // vast majority of lookups.
     ZIPFIAN,
     // Every item is equally likely to be looked up.
-    UNIFORM
+    UNIFORM,
+    // Zipfian lookups, interleaved one-to-one with the reads of a scan which
+    // touches each of a never-ending sequence of items exactly once. Only the
+    // zipfian lookups count towards the hit rate.
+    ZIPFIAN_WITH_SCANS
   };
   Pattern pattern;
 
+  CacheEvictionPolicy policy;
+
   // The ratio between the size of the dataset and the cache.
   //
   // A value smaller than 1 will ensure that the whole dataset fits
@@ -80,6 +88,12 @@ struct BenchSetup {
     switch (pattern) {
       case Pattern::ZIPFIAN: ret += "ZIPFIAN"; break;
       case Pattern::UNIFORM: ret += "UNIFORM"; break;
+      case Pattern::ZIPFIAN_WITH_SCANS: ret += "ZIPFIAN_WITH_SCANS"; break;
+    }
+    switch (policy) {
+      case LRU_EVICTION: ret += " LRU"; break;
+      case SLRU_EVICTION: ret += " SLRU"; break;
+      case CLOCK_EVICTION: ret += " CLOCK"; break;
     }
     ret += StringPrintf(" ratio=%.2fx n_unique=%d", dataset_cache_ratio, max_key());
     return ret;
@@ -97,7 +111,24 @@ class CacheBench : public KuduTest,
   void SetUp() override {
     KuduTest::SetUp();
 
-    cache_.reset(NewLRUCache(DRAM_CACHE, kCacheCapacity, "test-cache"));
+    cache_.reset(NewCache(DRAM_CACHE, GetParam().policy, kCacheCapacity, "test-cache"));
+    next_scan_key_ = GetParam().max_key() + 1;
+  }
+
+  // Looks up 'int_key', inserting it on a miss. Returns true on a hit.
+  bool LookupOrInsert(uint32_t int_key) {
+    char key_buf[sizeof(int_key)];
+    memcpy(key_buf, &int_key, sizeof(int_key));
+    Slice key_slice(key_buf, arraysize(key_buf));
+    Cache::Handle* h = cache_->Lookup(key_slice, Cache::EXPECT_IN_CACHE);
+    bool hit = h != nullptr;
+    if (!hit) {
+      Cache::PendingHandle* ph = cache_->Allocate(
+          key_slice, /* val_len=*/kEntrySize, /* charge=*/kEntrySize);
+      h = cache_->Insert(ph, nullptr);
+    }
+    cache_->Release(h);
+    return hit;
   }
 
   // Run queries against the cache until '*done' becomes true.
@@ -109,25 +140,21 @@ class CacheBench : public KuduTest,
     int64_t hits = 0;
     while (!*done) {
       uint32_t int_key;
-      if (setup.pattern == BenchSetup::Pattern::ZIPFIAN) {
-        int_key = r.Skewed(Bits::Log2Floor(setup.max_key()));
-      } else {
+      if (setup.pattern == BenchSetup::Pattern::UNIFORM) {
         int_key = r.Uniform(setup.max_key());
+      } else {
+        int_key = r.Skewed(Bits::Log2Floor(setup.max_key()));
       }
-      char key_buf[sizeof(int_key)];
-      memcpy(key_buf, &int_key, sizeof(int_key));
-      Slice key_slice(key_buf, arraysize(key_buf));
-      Cache::Handle* h = cache_->Lookup(key_slice, Cache::EXPECT_IN_CACHE);
-      if (h) {
+      if (LookupOrInsert(int_key)) {
         hits++;
-      } else {
-        Cache::PendingHandle* ph = cache_->Allocate(
-            key_slice, /* val_len=*/kEntrySize, /* charge=*/kEntrySize);
-        h = cache_->Insert(ph, nullptr);
       }
-
-      cache_->Release(h);
       lookups++;
+
+      if (setup.pattern == BenchSetup::Pattern::ZIPFIAN_WITH_SCANS) {
+        // The scan's keys are above the range of the lookups' keys, and are
+        // never read again.
+        LookupOrInsert(next_scan_key_++);
+      }
     }
     return {hits, lookups};
   }
@@ -156,15 +183,32 @@ class CacheBench : public KuduTest,
 
  protected:
   unique_ptr<Cache> cache_;
+
+  // The next key to be read by a scan.
+  atomic<uint32_t> next_scan_key_;
 };
 
-// Test both distributions, and for each, test both the case where the data
-// fits in the cache and where it is a bit larger.
+// Test all the patterns with both eviction policies, and for each, test both
+// the case where the data fits in the cache and where it is a bit larger.
 INSTANTIATE_TEST_CASE_P(Patterns, CacheBench, testing::ValuesIn(std::vector<BenchSetup>{
-      {BenchSetup::Pattern::ZIPFIAN, 1.0},
-      {BenchSetup::Pattern::ZIPFIAN, 3.0},
-      {BenchSetup::Pattern::UNIFORM, 1.0},
-      {BenchSetup::Pattern::UNIFORM, 3.0}
+      {BenchSetup::Pattern::ZIPFIAN, LRU_EVICTION, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN, LRU_EVICTION, 3.0},
+      {BenchSetup::Pattern::UNIFORM, LRU_EVICTION, 1.0},
+      {BenchSetup::Pattern::UNIFORM, LRU_EVICTION, 3.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCANS, LRU_EVICTION, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCANS, LRU_EVICTION, 3.0},
+      {BenchSetup::Pattern::ZIPFIAN, SLRU_EVICTION, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN, SLRU_EVICTION, 3.0},
+      {BenchSetup::Pattern::UNIFORM, SLRU_EVICTION, 1.0},
+      {BenchSetup::Pattern::UNIFORM, SLRU_EVICTION, 3.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCANS, SLRU_EVICTION, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCANS, SLRU_EVICTION, 3.0},
+      {BenchSetup::Pattern::ZIPFIAN, CLOCK_EVICTION, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN, CLOCK_EVICTION, 3.0},
+      {BenchSetup::Pattern::UNIFORM, CLOCK_EVICTION, 1.0},
+      {BenchSetup::Pattern::UNIFORM, CLOCK_EVICTION, 3.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCANS, CLOCK_EVICTION, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCANS, CLOCK_EVICTION, 3.0}
     }));
 
 TEST_P(CacheBench, RunBench) {
@@ -176,16 +220,19 @@ TEST_P(CacheBench, RunBench) {
   LOG(INFO) << "Warming up...";
   RunQueryThreads(FLAGS_num_threads, 1);
 
-  LOG(INFO) << "Running benchmark...";
-  pair<int64_t, int64_t> hits_lookups = RunQueryThreads(FLAGS_num_threads, FLAGS_run_seconds);
-  int64_t hits = hits_lookups.first;
-  int64_t lookups = hits_lookups.second;
-
-  int64_t l_per_sec = lookups / FLAGS_run_seconds;
-  double hit_rate = static_cast<double>(hits) / lookups;
-  string test_case = setup.ToString();
-  LOG(INFO) << test_case << ": " << HumanReadableNum::ToString(l_per_sec) << " lookups/sec";
-  LOG(INFO) << test_case << ": " << StringPrintf("%.1f", hit_rate * 100.0) << "% hit rate";
+  int n_threads = FLAGS_sweep_threads ? 1 : FLAGS_num_threads;
+  for (; n_threads <= FLAGS_num_threads; n_threads *= 2) {
+    LOG(INFO) << "Running benchmark with " << n_threads << " threads...";
+    pair<int64_t, int64_t> hits_lookups = RunQueryThreads(n_threads, FLAGS_run_seconds);
+    int64_t hits = hits_lookups.first;
+    int64_t lookups = hits_lookups.second;
+
+    int64_t l_per_sec = lookups / FLAGS_run_seconds;
+    double hit_rate = static_cast<double>(hits) / lookups;
+    string test_case = StringPrintf("%s threads=%d", setup.ToString().c_str(), n_threads);
+    LOG(INFO) << test_case << ": " << HumanReadableNum::ToString(l_per_sec) << " lookups/sec";
+    LOG(INFO) << test_case << ": " << StringPrintf("%.1f", hit_rate * 100.0) << "% hit rate";
+  }
 }
 
 } // namespace kudu
@@ -6,6 +6,8 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -22,6 +24,7 @@
 #include "kudu/util/faststring.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/random.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
@@ -30,8 +33,12 @@
 DECLARE_string(nvm_cache_path);
 #endif // defined(__linux__)
 
+DECLARE_bool(cache_force_single_shard);
 DECLARE_double(cache_memtracker_approximation_ratio);
 
+METRIC_DECLARE_counter(block_cache_probationary_segment_hits);
+METRIC_DECLARE_counter(block_cache_protected_segment_hits);
+
 namespace kudu {
 
 // Conversions between numeric keys/values and the types expected by Cache.
@@ -46,7 +53,8 @@ static int DecodeInt(const Slice& k) {
 }
 
 class CacheTest : public KuduTest,
-                  public ::testing::WithParamInterface<CacheType>,
+                  public ::testing::WithParamInterface<std::pair<CacheType,
+                                                                 CacheEvictionPolicy>>,
                   public Cache::EvictionCallback {
  public:
 
@@ -76,12 +84,12 @@ class CacheTest : public KuduTest,
     // assertions on the MemTracker in this test.
     FLAGS_cache_memtracker_approximation_ratio = 0;
 
-    cache_.reset(NewLRUCache(GetParam(), kCacheSize, "cache_test"));
+    cache_.reset(NewCache(GetParam().first, GetParam().second, kCacheSize, "cache_test"));
 
     MemTracker::FindTracker("cache_test-sharded_lru_cache", &mem_tracker_);
     // Since nvm cache does not have memtracker due to the use of
     // tcmalloc for this we only check for it in the DRAM case.
-    if (GetParam() == DRAM_CACHE) {
+    if (GetParam().first == DRAM_CACHE) {
       ASSERT_TRUE(mem_tracker_.get());
     }
 
@@ -114,9 +122,16 @@ class CacheTest : public KuduTest,
 };
 
 #if defined(__linux__)
-INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest, ::testing::Values(DRAM_CACHE, NVM_CACHE));
+INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest, ::testing::Values(
+    std::make_pair(DRAM_CACHE, LRU_EVICTION),
+    std::make_pair(DRAM_CACHE, SLRU_EVICTION),
+    std::make_pair(DRAM_CACHE, CLOCK_EVICTION),
+    std::make_pair(NVM_CACHE, LRU_EVICTION)));
 #else
-INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest, ::testing::Values(DRAM_CACHE));
+INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest, ::testing::Values(
+    std::make_pair(DRAM_CACHE, LRU_EVICTION),
+    std::make_pair(DRAM_CACHE, SLRU_EVICTION),
+    std::make_pair(DRAM_CACHE, CLOCK_EVICTION)));
 #endif // defined(__linux__)
 
 TEST_P(CacheTest, TrackMemory) {
@@ -216,6 +231,48 @@ TEST_P(CacheTest, EvictionPolicy) {
   ASSERT_EQ(-1, Lookup(200));
 }
 
+// Test that lookups racing with insertions, evictions and erasures only ever
+// see the values that were inserted with their keys.
+TEST_P(CacheTest, ConcurrentAccess) {
+  const int kNumThreads = 8;
+  const int kNumKeys = 1000;
+  const int kOpsPerThread = 10000;
+  const int kSizePerElem = kCacheSize / (kNumKeys / 2);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random r(t);
+      for (int i = 0; i < kOpsPerThread; i++) {
+        int key = r.Uniform(kNumKeys);
+        switch (r.Uniform(10)) {
+          case 0:
+            Erase(key);
+            break;
+          case 1:
+          case 2: {
+            // Not using Insert(), whose eviction callback isn't thread-safe.
+            std::string key_str = EncodeInt(key);
+            std::string val_str = EncodeInt(key * 2);
+            Cache::PendingHandle* handle = CHECK_NOTNULL(
+                cache_->Allocate(key_str, val_str.size(), kSizePerElem));
+            memcpy(cache_->MutableValue(handle), val_str.data(), val_str.size());
+            cache_->Release(cache_->Insert(handle, nullptr));
+            break;
+          }
+          default: {
+            int value = Lookup(key);
+            CHECK(value == -1 || value == key * 2) << key << ": " << value;
+            break;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 TEST_P(CacheTest, HeavyEntries) {
   // Add a bunch of light and heavy entries and then count the combined
   // size of items still in the cache, which must be approximately the
@@ -243,4 +300,62 @@ TEST_P(CacheTest, HeavyEntries) {
   ASSERT_LE(cached_weight, kCacheSize + kCacheSize/10);
 }
 
+// Test that, with the SLRU eviction policy, a scan which touches a lot of
+// entries only once doesn't evict entries which were hit before.
+class SLRUCacheTest : public KuduTest {};
+
+TEST_F(SLRUCacheTest, ScanResistance) {
+  // With a single shard, the cache capacity is exact.
+  FLAGS_cache_force_single_shard = true;
+  const int kCacheSize = 1000;
+  gscoped_ptr<Cache> cache(NewCache(DRAM_CACHE, SLRU_EVICTION, kCacheSize, "slru_test"));
+  MetricRegistry metric_registry;
+  scoped_refptr<MetricEntity> entity = METRIC_ENTITY_server.Instantiate(
+      &metric_registry, "test");
+  cache->SetMetrics(entity);
+
+  auto insert = [&](int key) {
+    std::string key_str = EncodeInt(key);
+    Cache::PendingHandle* handle = CHECK_NOTNULL(cache->Allocate(key_str, 0, 1));
+    cache->Release(cache->Insert(handle, nullptr));
+  };
+  auto lookup = [&](int key) {
+    Cache::Handle* handle = cache->Lookup(EncodeInt(key), Cache::EXPECT_IN_CACHE);
+    if (handle == nullptr) {
+      return false;
+    }
+    cache->Release(handle);
+    return true;
+  };
+
+  // Build a working set which is hit twice: the first hit finds the entries in
+  // the probationary segment and promotes them, the second finds them in the
+  // protected segment.
+  const int kWorkingSetSize = 100;
+  for (int i = 0; i < kWorkingSetSize; i++) {
+    insert(i);
+  }
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < kWorkingSetSize; i++) {
+      ASSERT_TRUE(lookup(i));
+    }
+  }
+  ASSERT_EQ(kWorkingSetSize,
+            METRIC_block_cache_probationary_segment_hits.Instantiate(entity)->value());
+  ASSERT_EQ(kWorkingSetSize,
+            METRIC_block_cache_protected_segment_hits.Instantiate(entity)->value());
+
+  // Scan through many more entries than the cache can hold.
+  for (int i = 0; i < kCacheSize * 10; i++) {
+    insert(kWorkingSetSize + i);
+  }
+
+  // The working set survived the scan, which only cycled through the
+  // probationary segment.
+  for (int i = 0; i < kWorkingSetSize; i++) {
+    ASSERT_TRUE(lookup(i)) << i;
+  }
+  ASSERT_FALSE(lookup(kWorkingSetSize));
+}
+
 }  // namespace kudu
@@ -33,6 +33,7 @@
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/ssd_cache.h"
 #include "kudu/util/test_util_prod.h"
 
 #if !defined(__APPLE__)
@@ -49,6 +50,12 @@ DEFINE_double(cache_memtracker_approximation_ratio, 0.01,
               "this ratio to improve performance. For tests.");
 TAG_FLAG(cache_memtracker_approximation_ratio, hidden);
 
+DEFINE_double(cache_slru_protected_ratio, 0.8,
+              "For caches using the SLRU eviction policy, the fraction of the capacity "
+              "reserved for the protected segment, which holds the entries that were "
+              "hit at least once since they were inserted.");
+TAG_FLAG(cache_slru_protected_ratio, advanced);
+
 using std::atomic;
 using std::shared_ptr;
 using std::string;
@@ -77,6 +84,8 @@ struct LRUHandle {
   uint32_t val_length;
   std::atomic<int32_t> refs;
   uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
+  bool in_protected_segment;  // Only used by the SLRU eviction policy.
+  std::atomic<bool> referenced;  // Only used by the CLOCK eviction policy.
 
   // The storage for the key/value pair itself. The data is stored as:
   //   [key bytes ...] [padding up to 8-byte boundary] [value bytes ...]
@@ -186,34 +195,31 @@ class HandleTable {
   }
 };
 
-// A single shard of sharded cache.
-class LRUCache {
+// State and bookkeeping shared by the shards of all the eviction policies:
+// reference counting, freeing of entries, memory tracking and metrics.
+class CacheShard {
  public:
-  explicit LRUCache(MemTracker* tracker);
-  ~LRUCache();
+  void SetMetrics(CacheMetrics* metrics) { metrics_ = metrics; }
 
-  // Separate from constructor so caller can easily make an array of LRUCache
+  void Release(Cache::Handle* handle);
+
+ protected:
+  explicit CacheShard(MemTracker* tracker);
+  ~CacheShard();
+
+  // Must be called with the shard's lock held, if the shard is in use.
   void SetCapacity(size_t capacity) {
     capacity_ = capacity;
     max_deferred_consumption_ = capacity * FLAGS_cache_memtracker_approximation_ratio;
   }
 
-  void SetMetrics(CacheMetrics* metrics) { metrics_ = metrics; }
-
-  Cache::Handle* Insert(LRUHandle* handle, Cache::EvictionCallback* eviction_callback);
-  // Like Cache::Lookup, but with an extra "hash" parameter.
-  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching);
-  void Release(Cache::Handle* handle);
-  void Erase(const Slice& key, uint32_t hash);
-
- private:
-  void LRU_Remove(LRUHandle* e);
-  void LRU_Append(LRUHandle* e);
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(LRUHandle* e);
   // Call the user's eviction callback, if it exists, and free the entry.
   void FreeEntry(LRUHandle* e);
+  // Frees the entries of the circular list headed by 'list'.
+  void FreeList(LRUHandle* list);
 
   // Update the memtracker's consumption by the given amount.
   //
@@ -235,57 +241,47 @@ class LRUCache {
   // Positive delta indicates an increased memory consumption.
   void UpdateMemTracker(int64_t delta);
 
+  // Updates the metrics for an insertion of 'e'.
+  void RecordInsert(LRUHandle* e);
+  // Updates the metrics for a lookup. Should be called outside of any lock.
+  void RecordLookup(bool was_hit, bool caching);
+
   // Initialized before use.
   size_t capacity_;
 
-  // mutex_ protects the following state.
-  MutexType mutex_;
-  size_t usage_;
-
-  // Dummy head of LRU list.
-  // lru.prev is newest entry, lru.next is oldest entry.
-  LRUHandle lru_;
-
-  HandleTable table_;
-
   MemTracker* mem_tracker_;
   atomic<int64_t> deferred_consumption_ { 0 };
 
   // Initialized based on capacity_ to ensure an upper bound on the error on the
   // MemTracker consumption.
-  int64_t max_deferred_consumption_;
+  atomic<int64_t> max_deferred_consumption_;
 
   CacheMetrics* metrics_;
 };
 
-LRUCache::LRUCache(MemTracker* tracker)
- : usage_(0),
-   mem_tracker_(tracker),
+CacheShard::CacheShard(MemTracker* tracker)
+ : mem_tracker_(tracker),
    metrics_(nullptr) {
-  // Make empty circular linked list
-  lru_.next = &lru_;
-  lru_.prev = &lru_;
 }
 
-LRUCache::~LRUCache() {
-  for (LRUHandle* e = lru_.next; e != &lru_; ) {
-    LRUHandle* next = e->next;
-    DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
-        << "caller has an unreleased handle";
-    if (Unref(e)) {
-      FreeEntry(e);
-    }
-    e = next;
-  }
+CacheShard::~CacheShard() {
   mem_tracker_->Consume(deferred_consumption_);
 }
 
-bool LRUCache::Unref(LRUHandle* e) {
+void CacheShard::Release(Cache::Handle* handle) {
+  LRUHandle* e = reinterpret_cast<LRUHandle*>(handle);
+  bool last_reference = Unref(e);
+  if (last_reference) {
+    FreeEntry(e);
+  }
+}
+
+bool CacheShard::Unref(LRUHandle* e) {
   DCHECK_GT(e->refs.load(std::memory_order_relaxed), 0);
   return e->refs.fetch_sub(1) == 1;
 }
 
-void LRUCache::FreeEntry(LRUHandle* e) {
+void CacheShard::FreeEntry(LRUHandle* e) {
   DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 0);
   if (e->eviction_callback) {
     e->eviction_callback->EvictedEntry(e->key(), e->value());
@@ -298,7 +294,19 @@ void LRUCache::FreeEntry(LRUHandle* e) {
   delete [] e;
 }
 
-void LRUCache::UpdateMemTracker(int64_t delta) {
+void CacheShard::FreeList(LRUHandle* list) {
+  for (LRUHandle* e = list->next; e != list; ) {
+    LRUHandle* next = e->next;
+    DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
+        << "caller has an unreleased handle";
+    if (Unref(e)) {
+      FreeEntry(e);
+    }
+    e = next;
+  }
+}
+
+void CacheShard::UpdateMemTracker(int64_t delta) {
   int64_t old_deferred = deferred_consumption_.fetch_add(delta);
   int64_t new_deferred = old_deferred + delta;
 
@@ -309,74 +317,174 @@ void LRUCache::UpdateMemTracker(int64_t delta) {
   }
 }
 
+void CacheShard::RecordInsert(LRUHandle* e) {
+  UpdateMemTracker(e->charge);
+  if (PREDICT_TRUE(metrics_)) {
+    metrics_->cache_usage->IncrementBy(e->charge);
+    metrics_->inserts->Increment();
+  }
+}
+
+void CacheShard::RecordLookup(bool was_hit, bool caching) {
+  if (!metrics_) {
+    return;
+  }
+  metrics_->lookups->Increment();
+  if (was_hit) {
+    if (caching) {
+      metrics_->cache_hits_caching->Increment();
+    } else {
+      metrics_->cache_hits->Increment();
+    }
+  } else {
+    if (caching) {
+      metrics_->cache_misses_caching->Increment();
+    } else {
+      metrics_->cache_misses->Increment();
+    }
+  }
+}
+
+// A single shard of sharded cache.
+//
+// With the SLRU eviction policy, entries are kept in two segments, each in
+// LRU order. New entries go into the probationary segment, and are promoted
+// to the protected segment when they are hit. Entries pushed out of the
+// protected segment are demoted to the most-recently-used end of the
+// probationary segment, and entries are evicted from the probationary
+// segment first. A scan which touches each entry once only cycles through the
+// probationary segment, leaving the protected working set in place.
+class LRUCache : public CacheShard {
+ public:
+  LRUCache(MemTracker* tracker, CacheEvictionPolicy policy);
+  ~LRUCache();
+
+  // Separate from constructor so caller can easily make an array of LRUCache.
+  // May also be called while the cache is in use, in which case the entries
+  // over the new capacity are evicted by the next insertion.
+  void SetCapacity(size_t capacity) {
+    std::lock_guard<MutexType> l(mutex_);
+    CacheShard::SetCapacity(capacity);
+    protected_capacity_ = capacity * FLAGS_cache_slru_protected_ratio;
+  }
+
+  Cache::Handle* Insert(LRUHandle* handle, Cache::EvictionCallback* eviction_callback);
+  // Like Cache::Lookup, but with an extra "hash" parameter.
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching);
+  void Erase(const Slice& key, uint32_t hash);
+
+ private:
+  void LRU_Remove(LRUHandle* e);
+  // Makes 'e' the newest entry of the given segment's list.
+  void LRU_Append(LRUHandle* e, bool protected_segment = false);
+
+  const CacheEvictionPolicy policy_;
+
+  // Initialized before use.
+  size_t protected_capacity_;
+
+  // mutex_ protects the following state.
+  MutexType mutex_;
+  size_t usage_;
+  size_t protected_usage_;
+
+  // Dummy head of LRU list. With the SLRU policy, this is the list of the
+  // probationary segment.
+  // lru.prev is newest entry, lru.next is oldest entry.
+  LRUHandle lru_;
+
+  // Dummy head of the list of the protected segment, with the SLRU policy.
+  LRUHandle protected_;
+
+  HandleTable table_;
+};
+
+LRUCache::LRUCache(MemTracker* tracker, CacheEvictionPolicy policy)
+ : CacheShard(tracker),
+   policy_(policy),
+   usage_(0),
+   protected_usage_(0) {
+  DCHECK_NE(CLOCK_EVICTION, policy);
+  // Make empty circular linked lists
+  lru_.next = &lru_;
+  lru_.prev = &lru_;
+  protected_.next = &protected_;
+  protected_.prev = &protected_;
+}
+
+LRUCache::~LRUCache() {
+  FreeList(&lru_);
+  FreeList(&protected_);
+}
+
 void LRUCache::LRU_Remove(LRUHandle* e) {
   e->next->prev = e->prev;
   e->prev->next = e->next;
   usage_ -= e->charge;
+  if (e->in_protected_segment) {
+    protected_usage_ -= e->charge;
+  }
 }
 
-void LRUCache::LRU_Append(LRUHandle* e) {
-  // Make "e" newest entry by inserting just before lru_
-  e->next = &lru_;
-  e->prev = lru_.prev;
+void LRUCache::LRU_Append(LRUHandle* e, bool protected_segment) {
+  // Make "e" newest entry by inserting just before the list head
+  LRUHandle* list = protected_segment ? &protected_ : &lru_;
+  e->next = list;
+  e->prev = list->prev;
   e->prev->next = e;
   e->next->prev = e;
+  e->in_protected_segment = protected_segment;
   usage_ += e->charge;
+  if (protected_segment) {
+    protected_usage_ += e->charge;
+  }
 }
 
 Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
   LRUHandle* e;
+  bool was_protected = false;
   {
     std::lock_guard<MutexType> l(mutex_);
     e = table_.Lookup(key, hash);
     if (e != nullptr) {
       e->refs.fetch_add(1, std::memory_order_relaxed);
+      was_protected = e->in_protected_segment;
       LRU_Remove(e);
-      LRU_Append(e);
+      if (policy_ == SLRU_EVICTION) {
+        // Promote the entry, making room for it in the protected segment by
+        // demoting its oldest entries.
+        LRU_Append(e, true);
+        while (protected_usage_ > protected_capacity_ && protected_.next != e) {
+          LRUHandle* old = protected_.next;
+          LRU_Remove(old);
+          LRU_Append(old);
+        }
+      } else {
+        LRU_Append(e);
+      }
     }
   }
 
   // Do the metrics outside of the lock.
-  if (metrics_) {
-    metrics_->lookups->Increment();
-    bool was_hit = (e != nullptr);
-    if (was_hit) {
-      if (caching) {
-        metrics_->cache_hits_caching->Increment();
-      } else {
-        metrics_->cache_hits->Increment();
-      }
+  RecordLookup(e != nullptr, caching);
+  if (metrics_ && e != nullptr && policy_ == SLRU_EVICTION) {
+    if (was_protected) {
+      metrics_->protected_segment_hits->Increment();
     } else {
-      if (caching) {
-        metrics_->cache_misses_caching->Increment();
-      } else {
-        metrics_->cache_misses->Increment();
-      }
+      metrics_->probationary_segment_hits->Increment();
     }
   }
 
   return reinterpret_cast<Cache::Handle*>(e);
 }
 
-void LRUCache::Release(Cache::Handle* handle) {
-  LRUHandle* e = reinterpret_cast<LRUHandle*>(handle);
-  bool last_reference = Unref(e);
-  if (last_reference) {
-    FreeEntry(e);
-  }
-}
-
 Cache::Handle* LRUCache::Insert(LRUHandle* e, Cache::EvictionCallback *eviction_callback) {
 
   // Set the remaining LRUHandle members which were not already allocated during
   // Allocate().
   e->eviction_callback = eviction_callback;
   e->refs.store(2, std::memory_order_relaxed);  // One from LRUCache, one for the returned handle
-  UpdateMemTracker(e->charge);
-  if (PREDICT_TRUE(metrics_)) {
-    metrics_->cache_usage->IncrementBy(e->charge);
-    metrics_->inserts->Increment();
-  }
+  RecordInsert(e);
 
   LRUHandle* to_remove_head = nullptr;
   {
@@ -393,8 +501,10 @@ Cache::Handle* LRUCache::Insert(LRUHandle* e, Cache::EvictionCallback *eviction_
       }
     }
 
-    while (usage_ > capacity_ && lru_.next != &lru_) {
-      LRUHandle* old = lru_.next;
+    // Evict from the probationary segment first. With the LRU policy, the
+    // protected segment is always empty.
+    while (usage_ > capacity_ && (lru_.next != &lru_ || protected_.next != &protected_)) {
+      LRUHandle* old = lru_.next != &lru_ ? lru_.next : protected_.next;
       LRU_Remove(old);
       table_.Remove(old->key(), old->hash);
       if (Unref(old)) {
@@ -433,6 +543,179 @@ void LRUCache::Erase(const Slice& key, uint32_t hash) {
   }
 }
 
+// A single shard of sharded cache, using the CLOCK eviction policy.
+//
+// The entries are kept in a circular list, swept by a clock hand. A hit sets
+// the entry's reference bit, and the hand evicts the first entry it finds
+// without the bit set, clearing the bits of the entries it passes. Since a hit
+// doesn't reorder the list, lookups only take a per-CPU reader lock, and
+// lookups running on different CPUs don't contend with each other. Insertions
+// and erasures take the lock exclusively, i.e. take every CPU's lock. That
+// makes an insertion costlier than in the LRU shard on machines with many
+// CPUs, but an insertion follows a miss, whose cost is dominated by reading
+// the missing data from disk.
+class ClockCache : public CacheShard {
+ public:
+  ClockCache(MemTracker* tracker, CacheEvictionPolicy policy);
+  ~ClockCache();
+
+  // Separate from constructor so caller can easily make an array of ClockCache.
+  // May also be called while the cache is in use, in which case the entries
+  // over the new capacity are evicted by the next insertion.
+  void SetCapacity(size_t capacity) {
+    std::lock_guard<percpu_rwlock> l(lock_);
+    CacheShard::SetCapacity(capacity);
+  }
+
+  Cache::Handle* Insert(LRUHandle* handle, Cache::EvictionCallback* eviction_callback);
+  // Like Cache::Lookup, but with an extra "hash" parameter.
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching);
+  void Erase(const Slice& key, uint32_t hash);
+
+ private:
+  // Removes 'e' from the clock, moving the hand past it if needed.
+  void Clock_Remove(LRUHandle* e);
+  // Adds 'e' to the clock, just behind the hand, so that it's the last entry
+  // the hand looks at.
+  void Clock_Insert(LRUHandle* e);
+
+  // Taken for read by lookups, and for write by anything which modifies the
+  // following state.
+  percpu_rwlock lock_;
+  size_t usage_;
+
+  // Dummy head of the circular list of entries.
+  LRUHandle clock_;
+
+  // The next entry to be looked at for eviction. May point at 'clock_'.
+  LRUHandle* hand_;
+
+  HandleTable table_;
+};
+
+ClockCache::ClockCache(MemTracker* tracker, CacheEvictionPolicy policy)
+ : CacheShard(tracker),
+   usage_(0),
+   hand_(&clock_) {
+  DCHECK_EQ(CLOCK_EVICTION, policy);
+  clock_.next = &clock_;
+  clock_.prev = &clock_;
+}
+
+ClockCache::~ClockCache() {
+  FreeList(&clock_);
+}
+
+void ClockCache::Clock_Remove(LRUHandle* e) {
+  if (hand_ == e) {
+    hand_ = e->next;
+  }
+  e->next->prev = e->prev;
+  e->prev->next = e->next;
+  usage_ -= e->charge;
+}
+
+void ClockCache::Clock_Insert(LRUHandle* e) {
+  e->next = hand_;
+  e->prev = hand_->prev;
+  e->prev->next = e;
+  e->next->prev = e;
+  usage_ += e->charge;
+}
+
+Cache::Handle* ClockCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
+  LRUHandle* e;
+  {
+    shared_lock<rw_spinlock> l(lock_.get_lock());
+    e = table_.Lookup(key, hash);
+    if (e != nullptr) {
+      e->refs.fetch_add(1, std::memory_order_relaxed);
+      // Avoid dirtying the entry's cache line if the bit is already set.
+      if (!e->referenced.load(std::memory_order_relaxed)) {
+        e->referenced.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Do the metrics outside of the lock.
+  RecordLookup(e != nullptr, caching);
+
+  return reinterpret_cast<Cache::Handle*>(e);
+}
+
+Cache::Handle* ClockCache::Insert(LRUHandle* e, Cache::EvictionCallback *eviction_callback) {
+  // Set the remaining LRUHandle members which were not already allocated during
+  // Allocate().
+  e->eviction_callback = eviction_callback;
+  e->refs.store(2, std::memory_order_relaxed);  // One from ClockCache, one for the returned handle
+  e->referenced.store(false, std::memory_order_relaxed);
+  RecordInsert(e);
+
+  LRUHandle* to_remove_head = nullptr;
+  {
+    std::lock_guard<percpu_rwlock> l(lock_);
+
+    Clock_Insert(e);
+
+    LRUHandle* old = table_.Insert(e);
+    if (old != nullptr) {
+      Clock_Remove(old);
+      if (Unref(old)) {
+        old->next = to_remove_head;
+        to_remove_head = old;
+      }
+    }
+
+    // Every entry passed by the hand loses its reference bit, so this makes
+    // at most two passes over the clock.
+    while (usage_ > capacity_ && clock_.next != &clock_) {
+      LRUHandle* candidate = hand_;
+      hand_ = candidate->next;
+      if (candidate == &clock_) {
+        continue;
+      }
+      if (candidate->referenced.load(std::memory_order_relaxed)) {
+        candidate->referenced.store(false, std::memory_order_relaxed);
+        continue;
+      }
+      Clock_Remove(candidate);
+      table_.Remove(candidate->key(), candidate->hash);
+      if (Unref(candidate)) {
+        candidate->next = to_remove_head;
+        to_remove_head = candidate;
+      }
+    }
+  }
+
+  // we free the entries here outside of the lock for
+  // performance reasons
+  while (to_remove_head != nullptr) {
+    LRUHandle* next = to_remove_head->next;
+    FreeEntry(to_remove_head);
+    to_remove_head = next;
+  }
+
+  return reinterpret_cast<Cache::Handle*>(e);
+}
+
+void ClockCache::Erase(const Slice& key, uint32_t hash) {
+  LRUHandle* e;
+  bool last_reference = false;
+  {
+    std::lock_guard<percpu_rwlock> l(lock_);
+    e = table_.Remove(key, hash);
+    if (e != nullptr) {
+      Clock_Remove(e);
+      last_reference = Unref(e);
+    }
+  }
+  // lock not held here
+  // last_reference will only be true if e != NULL
+  if (last_reference) {
+    FreeEntry(e);
+  }
+}
+
 // Determine the number of bits of the hash that should be used to determine
 // the cache shard. This, in turn, determines the number of shards.
 int DetermineShardBits() {
@@ -442,11 +725,14 @@ int DetermineShardBits() {
   return bits;
 }
 
+// A cache made of shards of type 'ShardType', each holding the entries whose
+// hashes map to it.
+template<class ShardType>
 class ShardedLRUCache : public Cache {
  private:
   shared_ptr<MemTracker> mem_tracker_;
   gscoped_ptr<CacheMetrics> metrics_;
-  vector<LRUCache*> shards_;
+  vector<ShardType*> shards_;
 
   // Number of bits of hash used to determine the shard.
   const int shard_bits_;
@@ -467,7 +753,7 @@ class ShardedLRUCache : public Cache {
   }
 
  public:
-  explicit ShardedLRUCache(size_t capacity, const string& id)
+  ShardedLRUCache(size_t capacity, const string& id, CacheEvictionPolicy policy)
       : shard_bits_(DetermineShardBits()) {
     // A cache is often a singleton, so:
     // 1. We reuse its MemTracker if one already exists, and
@@ -476,12 +762,10 @@ class ShardedLRUCache : public Cache {
         -1, strings::Substitute("$0-sharded_lru_cache", id));
 
     int num_shards = 1 << shard_bits_;
-    const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
     for (int s = 0; s < num_shards; s++) {
-      gscoped_ptr<LRUCache> shard(new LRUCache(mem_tracker_.get()));
-      shard->SetCapacity(per_shard);
-      shards_.push_back(shard.release());
+      shards_.push_back(new ShardType(mem_tracker_.get(), policy));
     }
+    SetCapacity(capacity);
   }
 
   virtual ~ShardedLRUCache() {
@@ -508,6 +792,12 @@ class ShardedLRUCache : public Cache {
   virtual Slice Value(Handle* handle) OVERRIDE {
     return reinterpret_cast<LRUHandle*>(handle)->value();
   }
+  virtual void SetCapacity(size_t capacity) OVERRIDE {
+    const size_t per_shard = (capacity + (shards_.size() - 1)) / shards_.size();
+    for (ShardType* shard : shards_) {
+      shard->SetCapacity(per_shard);
+    }
+  }
   virtual void SetMetrics(const scoped_refptr<MetricEntity>& entity) OVERRIDE {
     // TODO(KUDU-2165): reuse of the Cache singleton across multiple MiniCluster servers
     // causes TSAN errors. So, we'll ensure that metrics only get attached once, from
@@ -519,7 +809,7 @@ class ShardedLRUCache : public Cache {
       return;
     }
     metrics_.reset(new CacheMetrics(entity));
-    for (LRUCache* cache : shards_) {
+    for (ShardType* cache : shards_) {
       cache->SetMetrics(metrics_.get());
     }
   }
@@ -557,11 +847,22 @@ class ShardedLRUCache : public Cache {
 }  // end anonymous namespace
 
 Cache* NewLRUCache(CacheType type, size_t capacity, const string& id) {
+  return NewCache(type, LRU_EVICTION, capacity, id);
+}
+
+Cache* NewCache(CacheType type, CacheEvictionPolicy policy, size_t capacity,
+                const string& id) {
   switch (type) {
     case DRAM_CACHE:
-      return new ShardedLRUCache(capacity, id);
+      if (policy == CLOCK_EVICTION) {
+        return new ShardedLRUCache<ClockCache>(capacity, id, policy);
+      }
+      return new ShardedLRUCache<LRUCache>(capacity, id, policy);
+    case SSD_CACHE:
+      return NewTieredSsdCache(policy, capacity, id);
 #if defined(HAVE_LIB_VMEM)
     case NVM_CACHE:
+      CHECK_EQ(LRU_EVICTION, policy) << "NVM cache only supports LRU eviction";
       return NewLRUNvmCache(capacity, id);
 #endif
     default:
@@ -34,13 +34,34 @@ class MetricEntity;
 
 enum CacheType {
   DRAM_CACHE,
-  NVM_CACHE
+  NVM_CACHE,
+  // A DRAM cache backed by a second tier in a file on local storage.
+  // See ssd_cache.h.
+  SSD_CACHE
+};
+
+enum CacheEvictionPolicy {
+  // Least-recently-used.
+  LRU_EVICTION,
+  // Segmented LRU: entries which were hit since they were inserted are
+  // protected from eviction by entries which weren't, so that a one-time scan
+  // of many entries doesn't flush the working set.
+  SLRU_EVICTION,
+  // CLOCK approximation of LRU: a hit only sets a reference bit on the entry,
+  // so lookups don't need exclusive access to the shard and can proceed
+  // concurrently.
+  CLOCK_EVICTION
 };
 
 // Create a new cache with a fixed size capacity.  This implementation
 // of Cache uses a least-recently-used eviction policy.
 Cache* NewLRUCache(CacheType type, size_t capacity, const std::string& id);
 
+// Same as above, but with the given eviction policy. NVM caches only support
+// LRU_EVICTION.
+Cache* NewCache(CacheType type, CacheEvictionPolicy policy, size_t capacity,
+                const std::string& id);
+
 class Cache {
  public:
   // Callback interface which is called when an entry is evicted from the
@@ -132,6 +153,11 @@ class Cache {
   // Pass a metric entity in order to start recoding metrics.
   virtual void SetMetrics(const scoped_refptr<MetricEntity>& metric_entity) = 0;
 
+  // Change the capacity of the cache. If it shrinks, the entries over the new
+  // capacity are evicted as new entries are inserted. NVM caches don't support
+  // this.
+  virtual void SetCapacity(size_t capacity) = 0;
+
   // ------------------------------------------------------------
   // Insertion path
   // ------------------------------------------------------------
@@ -173,6 +173,14 @@ class Env {
   // Synchronize the entry for a specific directory.
   virtual Status SyncDir(const std::string& dirname) = 0;
 
+  // Synchronize the data and metadata of all files on the filesystem which
+  // contains 'path'. Where this isn't supported, all filesystems are synced.
+  //
+  // Note: Linux kernels older than 5.8 don't report writeback errors to
+  // syncfs(), so a failure to write back data may go unnoticed there, and
+  // other platforms report no errors at all.
+  virtual Status SyncFilesystem(const std::string& path) = 0;
+
   // Recursively delete the specified directory.
   // This should operate safely, not following any symlinks, etc.
   virtual Status DeleteRecursively(const std::string &dirname) = 0;
@@ -506,6 +514,9 @@ class WritableFile {
   // return a meaningful status.
   virtual Status Flush(FlushMode mode) = 0;
 
+  // Syncs all appended data to disk. May be called concurrently with Append()
+  // and AppendV(), in which case data appended concurrently may or may not be
+  // synced by this call, but will be synced by the next one.
   virtual Status Sync() = 0;
 
   virtual uint64_t Size() const = 0;
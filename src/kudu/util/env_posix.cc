@@ -17,6 +17,7 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstdint>
 #include <cstdio>
@@ -759,8 +760,7 @@ class PosixWritableFile : public WritableFile {
     TRACE_EVENT1("io", "PosixWritableFile::Sync", "path", filename_);
     ThreadRestrictions::AssertIOAllowed();
     LOG_SLOW_EXECUTION(WARNING, 1000, Substitute("sync call for $0", filename_)) {
-      if (pending_sync_) {
-        pending_sync_ = false;
+      if (pending_sync_.exchange(false)) {
         RETURN_NOT_OK(DoSync(fd_, filename_));
       }
     }
@@ -780,7 +780,8 @@ class PosixWritableFile : public WritableFile {
 
   uint64_t filesize_;
   uint64_t pre_allocated_size_;
-  bool pending_sync_;
+  // Atomic since the WAL may sync a file while appending to it.
+  std::atomic<bool> pending_sync_;
   bool closed_;
 };
 
@@ -1256,6 +1257,27 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  virtual Status SyncFilesystem(const string& path) OVERRIDE {
+    TRACE_EVENT1("io", "SyncFilesystem", "path", path);
+    MAYBE_RETURN_EIO(path, IOError(Env::kInjectedFailureStatusMsg, EIO));
+    ThreadRestrictions::AssertIOAllowed();
+    if (FLAGS_never_fsync) return Status::OK();
+#if defined(__linux__)
+    int fd;
+    RETRY_ON_EINTR(fd, open(path.c_str(), O_RDONLY));
+    if (fd < 0) {
+      return IOError(path, errno);
+    }
+    ScopedFdCloser fd_closer(fd);
+    if (syncfs(fd) != 0) {
+      return IOError(path, errno);
+    }
+#else
+    sync();
+#endif
+    return Status::OK();
+  }
+
   virtual Status DeleteRecursively(const string &name) OVERRIDE {
     return Walk(name, POST_ORDER, Bind(&PosixEnv::DeleteRecursivelyCb,
                                        Unretained(this)));
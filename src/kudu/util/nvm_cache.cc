@@ -518,6 +518,10 @@ class ShardedLRUCache : public Cache {
     return reinterpret_cast<LRUHandle*>(handle)->val_ptr();
   }
 
+  virtual void SetCapacity(size_t /*capacity*/) OVERRIDE {
+    // The capacity is that of the vmem pool, which can't change.
+    LOG(FATAL) << "Changing the capacity of an NVM cache is not supported";
+  }
   virtual void SetMetrics(const scoped_refptr<MetricEntity>& entity) OVERRIDE {
     metrics_.reset(new CacheMetrics(entity));
     for (NvmLRUCache* cache : shards_) {
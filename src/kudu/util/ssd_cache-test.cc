@@ -0,0 +1,192 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/ssd_cache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/env.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/path_util.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_bool(cache_force_single_shard);
+DECLARE_int32(ssd_cache_slab_size_mb);
+DECLARE_int64(ssd_cache_capacity_mb);
+DECLARE_string(ssd_cache_path);
+
+METRIC_DECLARE_counter(block_cache_ssd_demotions);
+METRIC_DECLARE_counter(block_cache_ssd_hits);
+METRIC_DECLARE_entity(server);
+
+using std::string;
+using std::unique_ptr;
+using strings::Substitute;
+
+namespace kudu {
+
+class SsdCacheTest : public KuduTest {
+ public:
+  // The DRAM tier holds 16 values, the SSD tier 32.
+  static const int kValueSize = 64 * 1024;
+  static const int kDramCapacity = 16 * kValueSize;
+
+  void SetUp() override {
+    KuduTest::SetUp();
+    // With a single shard, the DRAM tier's capacity is exact.
+    FLAGS_cache_force_single_shard = true;
+    FLAGS_ssd_cache_path = GetTestPath("ssd-cache");
+    FLAGS_ssd_cache_capacity_mb = 2;
+    FLAGS_ssd_cache_slab_size_mb = 1;
+    cache_.reset(NewCache(SSD_CACHE, LRU_EVICTION, kDramCapacity, "ssd_cache_test"));
+    entity_ = METRIC_ENTITY_server.Instantiate(&metric_registry_, "test");
+    cache_->SetMetrics(entity_);
+  }
+
+  void Insert(int key) {
+    string key_str = Substitute("key-$0", key);
+    Cache::PendingHandle* ph = cache_->Allocate(key_str, kValueSize, kValueSize);
+    memset(cache_->MutableValue(ph), key % 256, kValueSize);
+    cache_->Release(cache_->Insert(ph, nullptr));
+  }
+
+  // Returns true if 'key' is cached, checking its value.
+  bool Lookup(int key) {
+    Cache::Handle* h = cache_->Lookup(Substitute("key-$0", key), Cache::EXPECT_IN_CACHE);
+    if (h == nullptr) {
+      return false;
+    }
+    Slice value = cache_->Value(h);
+    CHECK_EQ(kValueSize, value.size());
+    for (int i = 0; i < kValueSize; i++) {
+      CHECK_EQ(key % 256, value[i]) << key;
+    }
+    cache_->Release(h);
+    return true;
+  }
+
+  // Values are demoted in the background, and aren't found in the SSD tier
+  // until they're written.
+  void AssertEventuallyCached(int key) {
+    ASSERT_EVENTUALLY([&]() {
+      ASSERT_TRUE(Lookup(key)) << key;
+    });
+  }
+
+  void WaitForDemotions(int64_t num_demotions) {
+    ASSERT_EVENTUALLY([&]() {
+      ASSERT_EQ(num_demotions, METRIC_block_cache_ssd_demotions.Instantiate(entity_)->value());
+    });
+  }
+
+  int64_t ssd_hits() {
+    return METRIC_block_cache_ssd_hits.Instantiate(entity_)->value();
+  }
+
+ protected:
+  MetricRegistry metric_registry_;
+  scoped_refptr<MetricEntity> entity_;
+  unique_ptr<Cache> cache_;
+};
+
+// Values evicted from the DRAM tier are found in the SSD tier, and promoted.
+TEST_F(SsdCacheTest, TestDemoteAndPromote) {
+  for (int i = 0; i < 24; i++) {
+    Insert(i);
+  }
+  NO_FATALS(WaitForDemotions(8));
+  // The oldest values only are in the SSD tier.
+  ASSERT_TRUE(Lookup(0));
+  ASSERT_EQ(1, ssd_hits());
+  // ... and now they're back in the DRAM tier too.
+  ASSERT_TRUE(Lookup(0));
+  ASSERT_EQ(1, ssd_hits());
+
+  for (int i = 0; i < 24; i++) {
+    NO_FATALS(AssertEventuallyCached(i));
+  }
+}
+
+// Erased values are gone from both tiers, and aren't demoted later.
+TEST_F(SsdCacheTest, TestErase) {
+  for (int i = 0; i < 24; i++) {
+    Insert(i);
+  }
+  NO_FATALS(WaitForDemotions(8));
+  // Key 0 is only in the SSD tier, key 23 only in the DRAM tier.
+  cache_->Erase("key-0");
+  cache_->Erase("key-23");
+  for (int i = 24; i < 30; i++) {
+    Insert(i);
+  }
+  // Key 23 left room for one of the new values, the others evicted keys 8 to 12.
+  NO_FATALS(WaitForDemotions(13));
+  ASSERT_FALSE(Lookup(0));
+  ASSERT_FALSE(Lookup(23));
+  ASSERT_TRUE(Lookup(1));
+}
+
+// Once the SSD tier is full, its oldest slabs are recycled.
+TEST_F(SsdCacheTest, TestSlabRecycling) {
+  const int kNumValues = 100;
+  for (int i = 0; i < kNumValues; i++) {
+    Insert(i);
+    // A slab isn't recycled while writes to it are pending, so let the
+    // demotions keep up.
+    if (i >= 16) {
+      NO_FATALS(WaitForDemotions(i - 15));
+    }
+  }
+  ASSERT_FALSE(Lookup(0));
+  // The most recent values are in one tier or the other. The slabs hold 15
+  // values each, with their headers.
+  for (int i = kNumValues - 30; i < kNumValues; i++) {
+    NO_FATALS(AssertEventuallyCached(i));
+  }
+}
+
+// A value corrupted in the file isn't returned.
+TEST_F(SsdCacheTest, TestCorruption) {
+  for (int i = 0; i < 24; i++) {
+    Insert(i);
+  }
+  NO_FATALS(WaitForDemotions(8));
+
+  // Overwrite part of the value of key 0, the first in the file.
+  RWFileOptions opts;
+  opts.mode = Env::OPEN_EXISTING;
+  unique_ptr<RWFile> file;
+  ASSERT_OK(env_->NewRWFile(opts, JoinPathSegments(FLAGS_ssd_cache_path, "ssd_cache_test.cache"),
+                            &file));
+  ASSERT_OK(file->Write(100, "corrupt"));
+
+  ASSERT_FALSE(Lookup(0));
+  ASSERT_TRUE(Lookup(1));
+}
+
+}  // namespace kudu
@@ -0,0 +1,667 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// A two-tier cache which backs a DRAM cache with a file on local storage,
+// meant to be an SSD.
+//
+// The file is laid out as a ring of fixed-size slabs, written in a
+// log-structured way: values demoted from the DRAM tier are appended to the
+// current slab, and when it's full the next slab is recycled, dropping all of
+// the values it held. The index mapping keys to their location in the file is
+// kept in memory, so the file's contents don't survive a restart.
+//
+// Space for a demoted value is reserved synchronously, when the value is freed
+// from the DRAM tier, but the value is written to the file by a background
+// thread. A slab isn't recycled while writes to it are still pending, so that
+// a slow write can't land on top of values written after the recycling.
+//
+// Reads of the file aren't done under the tier's lock. Instead, every slab has
+// a generation, bumped when it is recycled, and a value read from the file is
+// only used if the generation of its slab didn't change while it was read.
+// Every value is also written along with its key and a checksum, which are
+// verified when it's read back.
+
+#include "kudu/util/ssd_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/array_view.h"
+#include "kudu/util/crc.h"
+#include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/path_util.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_string(ssd_cache_path, "",
+              "The directory in which the SSD block cache creates the file backing its "
+              "second tier. This should be on a local SSD.");
+TAG_FLAG(ssd_cache_path, experimental);
+
+DEFINE_int64(ssd_cache_capacity_mb, 100 * 1024,
+             "The size of the file backing the second tier of the SSD block cache.");
+TAG_FLAG(ssd_cache_capacity_mb, experimental);
+
+DEFINE_int32(ssd_cache_slab_size_mb, 64,
+             "The size of the slabs the file backing the second tier of the SSD block "
+             "cache is divided into. Space in the file is reclaimed one slab at a time.");
+TAG_FLAG(ssd_cache_slab_size_mb, advanced);
+TAG_FLAG(ssd_cache_slab_size_mb, experimental);
+
+DEFINE_int32(ssd_cache_max_pending_demotions_mb, 64,
+             "The maximum amount of memory held by copies of the values evicted from "
+             "the DRAM tier of the SSD block cache that are waiting to be written to "
+             "its second tier. Values evicted beyond that aren't written.");
+TAG_FLAG(ssd_cache_max_pending_demotions_mb, advanced);
+TAG_FLAG(ssd_cache_max_pending_demotions_mb, experimental);
+
+METRIC_DEFINE_counter(server, block_cache_ssd_hits,
+                      "Block Cache SSD Tier Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that missed the DRAM tier of the block cache "
+                      "but found the block in its SSD tier");
+METRIC_DEFINE_counter(server, block_cache_ssd_misses,
+                      "Block Cache SSD Tier Misses", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that found the block in neither tier of the "
+                      "block cache");
+METRIC_DEFINE_counter(server, block_cache_ssd_demotions,
+                      "Block Cache SSD Tier Demotions", kudu::MetricUnit::kBlocks,
+                      "Number of blocks evicted from the DRAM tier of the block cache "
+                      "that were written to its SSD tier");
+METRIC_DEFINE_counter(server, block_cache_ssd_evictions,
+                      "Block Cache SSD Tier Evictions", kudu::MetricUnit::kBlocks,
+                      "Number of blocks dropped from the SSD tier of the block cache "
+                      "when their slab was recycled");
+
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// The second tier of the cache, in a file.
+class FileTier {
+ public:
+  FileTier(unique_ptr<RWFile> file, int64_t capacity, int64_t slab_size,
+           shared_ptr<MemTracker> mem_tracker);
+  ~FileTier();
+
+  // The location of a value in the file.
+  struct Entry {
+    int slab;
+    // The generation of the slab when the value was written.
+    int64_t generation;
+    // The offset of the value's record: a RecordHeader, the key, then the value.
+    int64_t offset;
+    // The length of the value.
+    int64_t length;
+    int charge;
+    // Whether the value is yet to be written.
+    bool pending;
+  };
+
+  // Reserves space for a value of 'length' bytes, unless 'key' is already in
+  // the file, the value doesn't fit in a slab, or there's no slab that can be
+  // recycled. 'charge' is the charge the value was allocated with. The value
+  // must then be written with FinishDemotion(), or the reservation dropped with
+  // AbortDemotion(). Until then, Lookup() doesn't find 'key', and Erase()
+  // cancels the demotion. Returns true if space was reserved.
+  bool ReserveDemotion(const Slice& key, int64_t length, int charge, Entry* entry);
+
+  // Writes 'value' at the location reserved for it in 'entry'.
+  void FinishDemotion(const Slice& key, const Slice& value, const Entry& entry);
+
+  // Drops the reservation of 'entry'.
+  void AbortDemotion(const Slice& key, const Entry& entry);
+
+  // Sets '*entry' to the location of the value of 'key', to be passed to
+  // Read(). Returns false if the key isn't in the file.
+  bool Lookup(const Slice& key, Entry* entry);
+
+  // Reads the value of 'key' at 'entry' into 'dst'. Returns false if it could
+  // not be read, was overwritten while being read, or doesn't match its key or
+  // checksum.
+  bool Read(const Slice& key, const Entry& entry, uint8_t* dst);
+
+  void Erase(const Slice& key);
+
+  void SetMetrics(const scoped_refptr<MetricEntity>& entity) {
+    demotions_ = METRIC_block_cache_ssd_demotions.Instantiate(entity);
+    evictions_ = METRIC_block_cache_ssd_evictions.Instantiate(entity);
+  }
+
+ private:
+  struct Slab {
+    // Bumped every time the slab is recycled.
+    int64_t generation;
+    // The number of values reserved in the slab that are yet to be written.
+    // The slab can't be recycled until it drops to zero.
+    int pending_writes;
+    // The keys written to the slab since it was last recycled. Some may have
+    // been erased or rewritten elsewhere since.
+    vector<string> keys;
+  };
+
+  // Written before the key and the value of every record.
+  struct RecordHeader {
+    // CRC32C of the lengths, the key and the value.
+    uint32_t checksum;
+    uint32_t key_length;
+    uint32_t value_length;
+  };
+  static_assert(sizeof(RecordHeader) == 12, "RecordHeader should be 12 bytes");
+
+  static uint32_t RecordChecksum(const RecordHeader& header, const Slice& key,
+                                 const Slice& value) {
+    uint32_t crc = crc::Crc32c(&header.key_length,
+                               sizeof(header) - offsetof(RecordHeader, key_length));
+    crc = crc::Crc32c(key.data(), key.size(), crc);
+    return crc::Crc32c(value.data(), value.size(), crc);
+  }
+
+  // The approximate memory used by an entry of 'index_', and by a key in
+  // Slab::keys.
+  static int64_t IndexEntryMemory(const string& key) {
+    return sizeof(std::pair<const string, Entry>) + 2 * sizeof(void*) + key.size();
+  }
+  static int64_t SlabKeyMemory(const string& key) {
+    return sizeof(string) + key.size();
+  }
+
+  // Makes 'slab' the current slab, dropping all of the values it held.
+  void RecycleSlabUnlocked(int slab);
+
+  // Ends the pending write of 'entry', which succeeded if 'written' is true.
+  void EndWrite(const Slice& key, const Entry& entry, bool written);
+
+  void EraseUnlocked(std::unordered_map<string, Entry>::iterator it);
+
+  void UpdateMemTrackerUnlocked(int64_t delta) {
+    memory_consumption_ += delta;
+    if (delta > 0) {
+      mem_tracker_->Consume(delta);
+    } else {
+      mem_tracker_->Release(-delta);
+    }
+  }
+
+  // Returns true if the slab of 'entry' wasn't recycled since 'entry' was
+  // reserved.
+  bool IsValidUnlocked(const Entry& entry) const {
+    return slabs_[entry.slab].generation == entry.generation;
+  }
+
+  const unique_ptr<RWFile> file_;
+  const int64_t slab_size_;
+  // Charged with the memory used by 'index_' and the slabs' keys.
+  const shared_ptr<MemTracker> mem_tracker_;
+
+  // Protects the following state.
+  simple_spinlock lock_;
+  std::unordered_map<string, Entry> index_;
+  vector<Slab> slabs_;
+  int cur_slab_;
+  int64_t cur_slab_offset_;
+  int64_t next_generation_;
+  int64_t memory_consumption_;
+
+  scoped_refptr<Counter> demotions_;
+  scoped_refptr<Counter> evictions_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileTier);
+};
+
+FileTier::FileTier(unique_ptr<RWFile> file, int64_t capacity, int64_t slab_size,
+                   shared_ptr<MemTracker> mem_tracker)
+    : file_(std::move(file)),
+      slab_size_(slab_size),
+      mem_tracker_(std::move(mem_tracker)),
+      slabs_(std::max<int64_t>(1, capacity / slab_size)),
+      cur_slab_(0),
+      cur_slab_offset_(0),
+      next_generation_(1),
+      memory_consumption_(0) {
+  for (auto& slab : slabs_) {
+    slab.generation = next_generation_++;
+    slab.pending_writes = 0;
+  }
+}
+
+FileTier::~FileTier() {
+  mem_tracker_->Release(memory_consumption_);
+}
+
+void FileTier::RecycleSlabUnlocked(int slab_idx) {
+  Slab* slab = &slabs_[slab_idx];
+  DCHECK_EQ(0, slab->pending_writes);
+  for (const string& k : slab->keys) {
+    auto it = index_.find(k);
+    if (it != index_.end() && it->second.slab == slab_idx &&
+        it->second.generation == slab->generation) {
+      EraseUnlocked(it);
+      if (evictions_) {
+        evictions_->Increment();
+      }
+    }
+    UpdateMemTrackerUnlocked(-SlabKeyMemory(k));
+  }
+  slab->keys.clear();
+  slab->generation = next_generation_++;
+  cur_slab_ = slab_idx;
+  cur_slab_offset_ = 0;
+}
+
+bool FileTier::ReserveDemotion(const Slice& key, int64_t length, int charge, Entry* entry) {
+  const int64_t record_length = sizeof(RecordHeader) + key.size() + length;
+  if (record_length > slab_size_) {
+    return false;
+  }
+  string key_str = key.ToString();
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (ContainsKey(index_, key_str)) {
+    return false;
+  }
+  if (cur_slab_offset_ + record_length > slab_size_) {
+    int next_slab = (cur_slab_ + 1) % slabs_.size();
+    if (slabs_[next_slab].pending_writes > 0) {
+      // The writes could land on top of the values written after the
+      // recycling, so the demotion is dropped instead.
+      return false;
+    }
+    RecycleSlabUnlocked(next_slab);
+  }
+  Slab* slab = &slabs_[cur_slab_];
+  slab->pending_writes++;
+  *entry = { cur_slab_, slab->generation, cur_slab_ * slab_size_ + cur_slab_offset_,
+             length, charge, true };
+  cur_slab_offset_ += record_length;
+  UpdateMemTrackerUnlocked(SlabKeyMemory(key_str) + IndexEntryMemory(key_str));
+  slab->keys.push_back(key_str);
+  index_.emplace(std::move(key_str), *entry);
+  return true;
+}
+
+void FileTier::FinishDemotion(const Slice& key, const Slice& value, const Entry& entry) {
+  DCHECK_EQ(entry.length, value.size());
+  RecordHeader header;
+  header.key_length = key.size();
+  header.value_length = value.size();
+  header.checksum = RecordChecksum(header, key, value);
+  Slice data[] = { Slice(reinterpret_cast<const uint8_t*>(&header), sizeof(header)),
+                   key, value };
+  Status s = file_->WriteV(entry.offset, data);
+  if (PREDICT_FALSE(!s.ok())) {
+    KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to write to the SSD cache: " << s.ToString()
+                                   << THROTTLE_MSG;
+  }
+  EndWrite(key, entry, s.ok());
+}
+
+void FileTier::AbortDemotion(const Slice& key, const Entry& entry) {
+  EndWrite(key, entry, false);
+}
+
+void FileTier::EndWrite(const Slice& key, const Entry& entry, bool written) {
+  string key_str = key.ToString();
+  std::lock_guard<simple_spinlock> l(lock_);
+  DCHECK(IsValidUnlocked(entry));
+  slabs_[entry.slab].pending_writes--;
+  // The key may have been erased since the space was reserved, and maybe
+  // reserved again elsewhere.
+  auto it = index_.find(key_str);
+  if (it == index_.end() || it->second.generation != entry.generation ||
+      it->second.offset != entry.offset) {
+    return;
+  }
+  if (!written) {
+    EraseUnlocked(it);
+    return;
+  }
+  it->second.pending = false;
+  if (demotions_) {
+    demotions_->Increment();
+  }
+}
+
+bool FileTier::Lookup(const Slice& key, Entry* entry) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  auto it = index_.find(key.ToString());
+  if (it == index_.end() || it->second.pending) {
+    return false;
+  }
+  *entry = it->second;
+  return true;
+}
+
+bool FileTier::Read(const Slice& key, const Entry& entry, uint8_t* dst) {
+  RecordHeader header;
+  faststring key_buf;
+  key_buf.resize(key.size());
+  Slice value(dst, entry.length);
+  Slice results[] = { Slice(reinterpret_cast<uint8_t*>(&header), sizeof(header)),
+                      Slice(key_buf.data(), key_buf.size()), value };
+  Status s = file_->ReadV(entry.offset, results);
+  if (PREDICT_FALSE(!s.ok())) {
+    KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to read from the SSD cache: " << s.ToString()
+                                   << THROTTLE_MSG;
+    return false;
+  }
+  {
+    // Any write to the slab after it's recycled is preceded by a bump of its
+    // generation, so if the generation is unchanged, the read wasn't torn.
+    std::lock_guard<simple_spinlock> l(lock_);
+    if (!IsValidUnlocked(entry)) {
+      return false;
+    }
+  }
+  if (PREDICT_FALSE(header.key_length != key.size() ||
+                    header.value_length != entry.length ||
+                    Slice(key_buf) != key ||
+                    header.checksum != RecordChecksum(header, key, value))) {
+    KLOG_EVERY_N_SECS(WARNING, 60) << Substitute("Corrupt value in the SSD cache at offset $0",
+                                                 entry.offset) << THROTTLE_MSG;
+    // Drop the value, so that the key can be demoted again.
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto it = index_.find(key.ToString());
+    if (it != index_.end() && it->second.generation == entry.generation &&
+        it->second.offset == entry.offset) {
+      EraseUnlocked(it);
+    }
+    return false;
+  }
+  return true;
+}
+
+void FileTier::Erase(const Slice& key) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  auto it = index_.find(key.ToString());
+  if (it != index_.end()) {
+    EraseUnlocked(it);
+  }
+}
+
+void FileTier::EraseUnlocked(std::unordered_map<string, Entry>::iterator it) {
+  UpdateMemTrackerUnlocked(-IndexEntryMemory(it->first));
+  index_.erase(it);
+}
+
+// The two-tier cache. The values stored in the DRAM tier are prefixed with a
+// ValueHeader, which is hidden from the users of the cache.
+class TieredSsdCache : public Cache, public Cache::EvictionCallback {
+ public:
+  TieredSsdCache(unique_ptr<Cache> dram, unique_ptr<FileTier> file_tier,
+                 gscoped_ptr<ThreadPool> demotion_pool, shared_ptr<MemTracker> mem_tracker)
+      : file_tier_(std::move(file_tier)),
+        demotion_pool_(std::move(demotion_pool)),
+        mem_tracker_(std::move(mem_tracker)),
+        dram_(std::move(dram)),
+        shutting_down_(false),
+        pending_demotion_bytes_(0) {
+  }
+
+  virtual ~TieredSsdCache() {
+    // Don't demote the entries freed by the destruction of the DRAM tier, and
+    // drop the demotions still queued.
+    shutting_down_ = true;
+    dram_.reset();
+    demotion_pool_->Shutdown();
+  }
+
+  virtual Handle* Insert(PendingHandle* handle,
+                         Cache::EvictionCallback* eviction_callback) OVERRIDE {
+    DCHECK(eviction_callback == nullptr) << "eviction callbacks are not supported";
+    return dram_->Insert(handle, this);
+  }
+
+  virtual Handle* Lookup(const Slice& key, CacheBehavior caching) OVERRIDE {
+    Handle* h = dram_->Lookup(key, caching);
+    if (h != nullptr) {
+      return h;
+    }
+
+    FileTier::Entry entry;
+    PendingHandle* ph = nullptr;
+    if (file_tier_->Lookup(key, &entry)) {
+      // Promote the value back into the DRAM tier.
+      ph = Allocate(key, entry.length, entry.charge);
+      if (file_tier_->Read(key, entry, MutableValue(ph))) {
+        h = dram_->Insert(ph, this);
+      } else {
+        Free(ph);
+      }
+    }
+    if (ssd_hits_) {
+      if (h != nullptr) {
+        ssd_hits_->Increment();
+      } else {
+        ssd_misses_->Increment();
+      }
+    }
+    return h;
+  }
+
+  virtual void Release(Handle* handle) OVERRIDE {
+    dram_->Release(handle);
+  }
+
+  virtual Slice Value(Handle* handle) OVERRIDE {
+    Slice value = dram_->Value(handle);
+    value.remove_prefix(sizeof(ValueHeader));
+    return value;
+  }
+
+  virtual void Erase(const Slice& key) OVERRIDE {
+    // Keep the entry from being demoted when it is freed, which may be after
+    // this returns if there are outstanding handles to it.
+    Handle* h = dram_->Lookup(key, NO_EXPECT_IN_CACHE);
+    if (h != nullptr) {
+      GetHeader(dram_->Value(h))->erased = true;
+      dram_->Release(h);
+    }
+    dram_->Erase(key);
+    file_tier_->Erase(key);
+  }
+
+  virtual void SetCapacity(size_t capacity) OVERRIDE {
+    // Only the DRAM tier changes size.
+    dram_->SetCapacity(capacity);
+  }
+
+  virtual void SetMetrics(const scoped_refptr<MetricEntity>& entity) OVERRIDE {
+    // See ShardedLRUCache::SetMetrics() for why this only happens once.
+    std::lock_guard<simple_spinlock> l(metrics_lock_);
+    dram_->SetMetrics(entity);
+    if (ssd_hits_) {
+      return;
+    }
+    file_tier_->SetMetrics(entity);
+    ssd_misses_ = METRIC_block_cache_ssd_misses.Instantiate(entity);
+    ssd_hits_ = METRIC_block_cache_ssd_hits.Instantiate(entity);
+  }
+
+  virtual PendingHandle* Allocate(Slice key, int val_len, int charge) OVERRIDE {
+    PendingHandle* ph = dram_->Allocate(key, val_len + sizeof(ValueHeader), charge);
+    if (ph != nullptr) {
+      new (dram_->MutableValue(ph)) ValueHeader(charge);
+    }
+    return ph;
+  }
+
+  virtual uint8_t* MutableValue(PendingHandle* handle) OVERRIDE {
+    return dram_->MutableValue(handle) + sizeof(ValueHeader);
+  }
+
+  virtual void Free(PendingHandle* handle) OVERRIDE {
+    dram_->Free(handle);
+  }
+
+  // Called when an entry is freed from the DRAM tier: it was either evicted,
+  // replaced, or erased.
+  virtual void EvictedEntry(Slice key, Slice value) OVERRIDE {
+    const ValueHeader* header = GetHeader(value);
+    if (shutting_down_ || header->erased) {
+      return;
+    }
+    value.remove_prefix(sizeof(ValueHeader));
+
+    // The value is freed once this returns, so it's copied to be written by
+    // 'demotion_pool_' rather than by whichever thread freed it.
+    const int64_t bytes = key.size() + value.size();
+    if (pending_demotion_bytes_.fetch_add(bytes) + bytes >
+        static_cast<int64_t>(FLAGS_ssd_cache_max_pending_demotions_mb) * 1024 * 1024) {
+      pending_demotion_bytes_ -= bytes;
+      return;
+    }
+    FileTier::Entry entry;
+    if (!file_tier_->ReserveDemotion(key, value.size(), header->charge, &entry)) {
+      pending_demotion_bytes_ -= bytes;
+      return;
+    }
+    shared_ptr<PendingDemotion> demotion(new PendingDemotion(this, key, value, entry));
+    Status s = demotion_pool_->SubmitFunc([this, demotion]() {
+        file_tier_->FinishDemotion(demotion->key, demotion->value, demotion->entry);
+      });
+    if (PREDICT_FALSE(!s.ok())) {
+      file_tier_->AbortDemotion(key, entry);
+    }
+  }
+
+ private:
+  // Kept 8-byte aligned so that the values stay aligned.
+  struct ValueHeader {
+    explicit ValueHeader(int charge) : erased(false), charge(charge) {}
+    std::atomic<bool> erased;
+    // The charge the entry was allocated with, restored on promotion.
+    int32_t charge;
+  };
+  static_assert(sizeof(ValueHeader) == 8, "ValueHeader should be 8 bytes");
+
+  // A copy of a value evicted from the DRAM tier, waiting to be written to
+  // the file. If the demotion is dropped because the cache is being destroyed,
+  // the space reserved for it is never released, which doesn't matter then.
+  struct PendingDemotion {
+    PendingDemotion(TieredSsdCache* cache, const Slice& key, const Slice& value,
+                    const FileTier::Entry& entry)
+        : cache(cache),
+          key(key.ToString()),
+          value(value.ToString()),
+          entry(entry) {
+      cache->mem_tracker_->Consume(memory());
+    }
+
+    ~PendingDemotion() {
+      cache->mem_tracker_->Release(memory());
+      cache->pending_demotion_bytes_ -= memory();
+    }
+
+    int64_t memory() const {
+      return key.size() + value.size();
+    }
+
+    TieredSsdCache* const cache;
+    const string key;
+    const string value;
+    const FileTier::Entry entry;
+  };
+
+  static ValueHeader* GetHeader(const Slice& value) {
+    return reinterpret_cast<ValueHeader*>(const_cast<uint8_t*>(value.data()));
+  }
+
+  // Destroyed after 'dram_', whose destruction frees its entries.
+  const unique_ptr<FileTier> file_tier_;
+  // Writes the values demoted to 'file_tier_'.
+  gscoped_ptr<ThreadPool> demotion_pool_;
+  // Charged with the memory used by the pending demotions.
+  const shared_ptr<MemTracker> mem_tracker_;
+  unique_ptr<Cache> dram_;
+  std::atomic<bool> shutting_down_;
+  // The memory used by the pending demotions, bounded by
+  // --ssd_cache_max_pending_demotions_mb.
+  std::atomic<int64_t> pending_demotion_bytes_;
+
+  simple_spinlock metrics_lock_;
+  scoped_refptr<Counter> ssd_hits_;
+  scoped_refptr<Counter> ssd_misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(TieredSsdCache);
+};
+
+}  // anonymous namespace
+
+Cache* NewTieredSsdCache(CacheEvictionPolicy policy, size_t capacity, const string& id) {
+  CHECK(!FLAGS_ssd_cache_path.empty()) << "--ssd_cache_path must be set to use an SSD cache";
+  Env* env = Env::Default();
+  Status s = env->CreateDir(FLAGS_ssd_cache_path);
+  if (!s.IsAlreadyPresent()) {
+    CHECK_OK_PREPEND(s, "Could not create the SSD cache directory");
+  }
+
+  // The file's contents are useless after a restart, so it's truncated.
+  string path = JoinPathSegments(FLAGS_ssd_cache_path, Substitute("$0.cache", id));
+  unique_ptr<RWFile> file;
+  CHECK_OK_PREPEND(env->NewRWFile(RWFileOptions(), path, &file),
+                   Substitute("Could not create the SSD cache file $0", path));
+
+  // Like the DRAM tier's, the MemTracker is reused if it already exists.
+  shared_ptr<MemTracker> mem_tracker = MemTracker::FindOrCreateGlobalTracker(
+      -1, Substitute("$0-ssd_cache", id));
+  gscoped_ptr<ThreadPool> demotion_pool;
+  CHECK_OK(ThreadPoolBuilder("ssd-cache-demote")
+           .set_max_threads(1)
+           .Build(&demotion_pool));
+
+  unique_ptr<Cache> dram(NewCache(DRAM_CACHE, policy, capacity, id));
+  unique_ptr<FileTier> file_tier(new FileTier(std::move(file),
+                                              FLAGS_ssd_cache_capacity_mb * 1024 * 1024,
+                                              static_cast<int64_t>(
+                                                  FLAGS_ssd_cache_slab_size_mb) * 1024 * 1024,
+                                              mem_tracker));
+  return new TieredSsdCache(std::move(dram), std::move(file_tier), std::move(demotion_pool),
+                            std::move(mem_tracker));
+}
+
+}  // namespace kudu
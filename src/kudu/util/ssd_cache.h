@@ -0,0 +1,40 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef KUDU_UTIL_SSD_CACHE_H_
+#define KUDU_UTIL_SSD_CACHE_H_
+
+#include <cstddef>
+#include <string>
+
+#include "kudu/util/cache.h"
+
+namespace kudu {
+
+// Create a two-tier cache: a DRAM cache of the given capacity and eviction
+// policy, backed by a larger second tier in a file on local storage
+// (see --ssd_cache_path and --ssd_cache_capacity_mb).
+//
+// Entries evicted from the DRAM tier are written to the file by a background
+// thread, and entries found in the file are promoted back into the DRAM tier. The values of a
+// given key must never change, which is the case for the block cache.
+// Eviction callbacks are not supported.
+Cache* NewTieredSsdCache(CacheEvictionPolicy policy, size_t capacity, const std::string& id);
+
+}  // namespace kudu
+
+#endif